@@ -39,6 +39,9 @@ CTString sam_strGameName = "serioussam";
 
 CTimerValue _tvLastLevelEnd((__int64) -1);
 
+// demo to play in headless timedemo mode (if any)
+static CTString _strTimeDemo = "";
+
 // Not used; dummy declaration only needed by
 // Engine/Base/ErrorReporting.o
 HWND _hwndMain = NULL;
@@ -219,10 +222,26 @@ BOOL Init(int argc, char* argv[])
 {
   _bDedicatedServer = TRUE;
 
+  // if timedemo is requested
+  if (argc>1 && strcmp(argv[1], "-timedemo")==0) {
+    if (argc!=2+1 && argc!=3+1) {
+      printf("Usage: DedicatedServer -timedemo <demofile> [<modname>]\n");
+      DelayBeforeExit();
+      exit(0);
+    }
+    // remember the demo and shift the mod name into its usual place
+    _strTimeDemo = argv[2];
+    argv[1] = (char *) "timedemo";
+    argv[2] = argv[argc-1];
+    argc--;
+  }
+
   if (argc!=1+1 && argc!=2+1) {
     // NOTE: this cannot be translated - translations are not loaded yet
     printf("Usage: DedicatedServer <configname> [<modname>]\n"
-      "This starts a server reading configs from directory 'Scripts\\Dedicated\\<configname>\\'\n");
+      "       DedicatedServer -timedemo <demofile> [<modname>]\n"
+      "This starts a server reading configs from directory 'Scripts\\Dedicated\\<configname>\\'\n"
+      "or plays a demo headless as fast as possible and reports simulation performance.\n");
 
     DelayBeforeExit();
     exit(0);
@@ -440,6 +459,86 @@ void DoGame(void)
   LimitFrameRate();
 }
 
+// play the demo with no rendering nor sound, as fast as possible, and report the results
+BOOL TimeDemo(const CTFileName &fnmDemo)
+{
+  // demos are always played locally
+  _pGame->gm_strNetworkProvider = "Local";
+  if (!_pGame->StartDemoPlay(fnmDemo)) {
+    return FALSE;
+  }
+
+  // step the demo by exactly one tick in each main loop
+  const FLOAT fOldSyncRate = _pNetwork->ga_fDemoSyncRate;
+  _pNetwork->ga_fDemoSyncRate = 1.0f/_pTimer->TickQuantum;
+
+  // measure all profiling timers, even if not compiled with TIMER_PROFILING
+  const BOOL bWasProfiling = CProfileForm::GetProfilingActive();
+  CProfileForm::SetProfilingActive(TRUE);
+  _pfNetworkProfile.Reset();
+  _pfPhysicsProfile.Reset();
+  _pfMemoryProfile.Reset();
+  _pfJobProfile.Reset();
+
+  const TIME tmFirstTick = _pNetwork->ga_sesSessionState.ses_tmLastProcessedTick;
+  INDEX ctLoops = 0;
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  // run the simulation until the demo ends (or the user breaks)
+  while (_bRunning && !_pNetwork->IsDemoPlayFinished()) {
+    _pNetwork->MainLoop();
+    ctLoops++;
+  }
+
+  CTimerValue tvStop = _pTimer->GetHighPrecisionTimer();
+  const DOUBLE dSeconds = (tvStop-tvStart).GetSeconds();
+  const TIME tmLastTick = _pNetwork->ga_sesSessionState.ses_tmLastProcessedTick;
+  const INDEX ctTicks = (INDEX) floor((tmLastTick-tmFirstTick)/_pTimer->TickQuantum+0.5f);
+
+  // checksum the whole final game state, for comparing determinism between builds
+  ULONG ulCRC;
+  CRC_Start(ulCRC);
+  _pNetwork->ga_World.LockAll();
+  _pNetwork->ga_sesSessionState.ChecksumForSync(ulCRC, 2);
+  _pNetwork->ga_World.UnlockAll();
+  CRC_Finish(ulCRC);
+
+  // gather profiles of the simulation
+  CTString strNetworkReport, strPhysicsReport, strMemoryReport, strJobReport;
+  _pfNetworkProfile.Report(strNetworkReport);
+  _pfPhysicsProfile.Report(strPhysicsReport);
+  _pfMemoryProfile.Report(strMemoryReport);
+  _pfJobProfile.Report(strJobReport);
+  CProfileForm::SetProfilingActive(bWasProfiling);
+  _pNetwork->ga_fDemoSyncRate = fOldSyncRate;
+
+  CTString strResult;
+  strResult.PrintF(
+    "\nTimedemo: %s\n"
+    "  ticks simulated: %d (%.1f game seconds) in %d loops\n"
+    "  real time:       %.3f s\n"
+    "  ticks/second:    %.1f (%.3f ms/tick)\n"
+    "  memory peak:     %d KB\n"
+    "  final sync CRC:  0x%08X\n\n",
+    (const char *) fnmDemo, ctTicks, ctTicks*_pTimer->TickQuantum, ctLoops, dSeconds,
+    dSeconds>0 ? ctTicks/dSeconds : 0.0, ctTicks>0 ? dSeconds*1000.0/ctTicks : 0.0,
+    GetMemoryHighWaterMark(), ulCRC);
+  CPutString(strResult);
+
+  // dump the detailed breakdown next to the log
+  try {
+    CTString strProfile = "===========================================================\n";
+    strProfile += strResult+strNetworkReport+strPhysicsReport+strMemoryReport+strJobReport;
+    CTFileStream strmProfile;
+    strmProfile.Create_t(CTString("TimeDemo.profile"));
+    strmProfile.Write_t((const char *) strProfile, strlen(strProfile));
+    CPrintF(TRANSV("Profile breakdown saved to 'TimeDemo.profile'.\n"));
+  } catch (char *strError) {
+    CPutString(strError);
+  }
+  return TRUE;
+}
+
 int SubMain(int argc, char* argv[])
 {
 
@@ -452,6 +551,14 @@ int SubMain(int argc, char* argv[])
   // initialy, application is running
   _bRunning = TRUE;
 
+  // if only timing a demo
+  if (_strTimeDemo!="") {
+    BOOL bOK = TimeDemo(CTFileName(_strTimeDemo));
+    _pGame->StopGame();
+    End();
+    return bOK ? 0 : -1;
+  }
+
   // execute dedicated server startup script
   ExecScript(CTFILENAME("Scripts\\Dedicated_startup.ini"));
   // execute startup script for this config
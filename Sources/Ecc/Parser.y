@@ -395,6 +395,8 @@ class_declaration
     fprintf(_fTables, "#define ENTITYCLASS %s\n\n", _strCurrentClass);
     fprintf(_fDeclaration, "extern \"C\" DECL_DLL CDLLEntityClass %s_DLLClass;\n",
       _strCurrentClass);
+    fprintf(_fDeclaration, "#define %s_ClassID (%s_DLLClass.dec_iInternedID)\n",
+      _strCurrentClass, _strCurrentClass);
     fprintf(_fDeclaration, "%s %s : public %s {\npublic:\n",
       $1.strString, _strCurrentClass, _strCurrentBase);
 
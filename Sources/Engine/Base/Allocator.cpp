@@ -0,0 +1,411 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/Allocator.h>
+#include <Engine/Base/MemoryProfile.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/ErrorReporting.h>
+#include <Engine/Base/Threading.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Math/Functions.h>
+#include <Engine/Base/ListIterator.inl>
+
+// header in front of every tagged block (keeps the payload 16-byte aligned)
+struct MemoryHeader {
+  SLONG mh_slSize;      // size requested by the caller
+  UWORD mh_uwTag;       // tag the block is accounted to
+  UWORD mh_uwPool;      // size class the block came from, or MEMPOOL_NONE
+  ULONG mh_ulMagic;     // for catching frees of foreign or corrupted blocks
+  ULONG mh_ulReserved;
+};
+
+#define MEMHEADER_MAGIC 0x4D454D42UL  // "MEMB"
+#define MEMPOOL_NONE    0xFFFF
+#define MEMPOOL_MINSIZE 16
+#define MEMPOOL_CLASSES 8             // 16, 32, ... 2048
+#define MEMPOOL_PAGESIZE (64*1024)
+
+// statistics for one tag
+struct MemoryTagStats {
+  __int64 mts_llLiveBytes;      // bytes currently allocated
+  INDEX   mts_ctLiveBlocks;     // blocks currently allocated
+  __int64 mts_llTotalBytes;     // bytes allocated since start
+  __int64 mts_llTotalBlocks;    // blocks allocated since start
+};
+
+// one size-class pool
+struct MemoryPool {
+  void *mp_pvFree;      // first free chunk (chunks are linked through their payload)
+  INDEX mp_ctPages;     // pages carved so far
+  INDEX mp_ctUsed;      // chunks handed out
+  INDEX mp_ctFree;      // chunks on the free list
+};
+
+// each thread counts into its own slot so that counting needs no locking
+// (a block freed on another thread is subtracted there, the sums stay right)
+#define MEMSTATS_MAXTHREADS 64
+static MemoryTagStats _aamtsStats[MEMSTATS_MAXTHREADS][MTG_COUNT];
+static volatile SLONG _ctStatsThreads = 0;
+static THREAD_LOCAL MemoryTagStats *_pamtsThreadStats = NULL;
+
+static MemoryPool _ampPools[MEMPOOL_CLASSES];
+static __int64 _llPooledBlocks = 0;
+static volatile SLONG _slAllocatorLock = 0;
+
+// tag for untagged allocations of each thread
+static THREAD_LOCAL INDEX _iMemoryTag = MTG_GENERAL;
+
+static const char *_astrTagNames[MTG_COUNT] = {
+  "general", "world", "network", "sound", "stock",
+};
+
+
+static inline void LockAllocator(void)
+{
+  while (AtomicCompareExchange(&_slAllocatorLock, 1, 0)!=0) {
+    ThreadYield();
+  }
+}
+
+static inline void UnlockAllocator(void)
+{
+  AtomicRelease(&_slAllocatorLock);
+}
+
+static inline SLONG PoolChunkSize(INDEX iPool)
+{
+  return (MEMPOOL_MINSIZE<<iPool) + (SLONG)sizeof(MemoryHeader);
+}
+
+// find the smallest size class that can hold a block
+static inline INDEX PoolForSize(SLONG slSize)
+{
+  INDEX iPool = 0;
+  while ((MEMPOOL_MINSIZE<<iPool)<slSize) {
+    iPool++;
+  }
+  return iPool;
+}
+
+static inline MemoryTagStats *ThreadStats(void)
+{
+  if (_pamtsThreadStats==NULL) {
+    SLONG iSlot = AtomicAdd(&_ctStatsThreads, 1)-1;
+    // threads beyond the table share the last slot (and may lose a count or two)
+    if (iSlot>=MEMSTATS_MAXTHREADS) {
+      iSlot = MEMSTATS_MAXTHREADS-1;
+    }
+    _pamtsThreadStats = _aamtsStats[iSlot];
+  }
+  return _pamtsThreadStats;
+}
+
+static inline void CountAllocation(INDEX iTag, SLONG slSize)
+{
+  MemoryTagStats &mts = ThreadStats()[iTag];
+  mts.mts_llLiveBytes += slSize;
+  mts.mts_ctLiveBlocks++;
+  mts.mts_llTotalBytes += slSize;
+  mts.mts_llTotalBlocks++;
+}
+
+static inline void CountFree(INDEX iTag, SLONG slSize)
+{
+  MemoryTagStats &mts = ThreadStats()[iTag];
+  mts.mts_llLiveBytes -= slSize;
+  mts.mts_ctLiveBlocks--;
+}
+
+static inline MemoryHeader *HeaderOf(void *pv)
+{
+  MemoryHeader *pmh = ((MemoryHeader*)pv)-1;
+  ASSERTMSG(pmh->mh_ulMagic==MEMHEADER_MAGIC, "Freeing memory not allocated by AllocMemory()!");
+  return pmh;
+}
+
+static inline void *InitHeader(void *pvRaw, SLONG slSize, INDEX iTag, UWORD uwPool)
+{
+  MemoryHeader *pmh = (MemoryHeader*)pvRaw;
+  pmh->mh_slSize = slSize;
+  pmh->mh_uwTag = (UWORD)iTag;
+  pmh->mh_uwPool = uwPool;
+  pmh->mh_ulMagic = MEMHEADER_MAGIC;
+  pmh->mh_ulReserved = 0;
+  return pmh+1;
+}
+
+static void *AllocHeap(SLONG slSize, INDEX iTag, void *pvRaw)
+{
+  // memory handler asures no null results here?!
+  if (pvRaw==NULL) {
+    _CrtCheckMemory();
+    FatalError(TRANS("Not enough memory (%d bytes needed)!"), slSize);
+  }
+  CountAllocation(iTag, slSize);
+  return InitHeader(pvRaw, slSize, iTag, MEMPOOL_NONE);
+}
+
+
+void *AllocMemoryTagged( SLONG slSize, INDEX iTag)
+{
+  ASSERTMSG(slSize>0, "AllocMemory: Block size is less or equal zero.");
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  return AllocHeap(slSize, iTag, malloc(slSize+sizeof(MemoryHeader)));
+}
+
+#ifdef _MSC_VER
+#ifndef NDEBUG
+void *_debug_AllocMemoryTagged( SLONG slSize, INDEX iTag, int iType, const char *strFile, int iLine)
+{
+  ASSERTMSG(slSize>0, "AllocMemory: Block size is less or equal zero.");
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  return AllocHeap(slSize, iTag, _malloc_dbg(slSize+sizeof(MemoryHeader), iType, strFile, iLine));
+}
+#endif
+#endif
+
+void *AllocMemoryPooled( SLONG slSize, INDEX iTag)
+{
+  ASSERTMSG(slSize>0, "AllocMemory: Block size is less or equal zero.");
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  // big blocks go to the heap
+  if (slSize>MEMPOOL_MAXSIZE) {
+    return AllocMemoryTagged(slSize, iTag);
+  }
+
+  const INDEX iPool = PoolForSize(slSize);
+  MemoryPool &mp = _ampPools[iPool];
+  LockAllocator();
+  // if the free list is empty
+  if (mp.mp_pvFree==NULL) {
+    // carve a new page into chunks (pages are never returned to the system)
+    const SLONG slChunk = PoolChunkSize(iPool);
+    const INDEX ctChunks = MEMPOOL_PAGESIZE/slChunk;
+    UBYTE *pubPage = (UBYTE*)malloc(ctChunks*slChunk);
+    if (pubPage==NULL) {
+      UnlockAllocator();
+      FatalError(TRANS("Not enough memory (%d bytes needed)!"), ctChunks*slChunk);
+    }
+    for (INDEX iChunk=ctChunks-1; iChunk>=0; iChunk--) {
+      void **ppvLink = (void**)(pubPage+iChunk*slChunk+sizeof(MemoryHeader));
+      *ppvLink = mp.mp_pvFree;
+      mp.mp_pvFree = ppvLink;
+    }
+    mp.mp_ctPages++;
+    mp.mp_ctFree += ctChunks;
+  }
+  // take the first free chunk
+  void *pv = mp.mp_pvFree;
+  mp.mp_pvFree = *(void**)pv;
+  mp.mp_ctFree--;
+  mp.mp_ctUsed++;
+  _llPooledBlocks++;
+  UnlockAllocator();
+  CountAllocation(iTag, slSize);
+
+  return InitHeader(((MemoryHeader*)pv)-1, slSize, iTag, (UWORD)iPool);
+}
+
+void FreeMemoryTagged( void *pv)
+{
+  ASSERTMSG(pv!=NULL, "FreeMemory: NULL pointer input.");
+  MemoryHeader *pmh = HeaderOf(pv);
+  const INDEX iPool = pmh->mh_uwPool;
+  pmh->mh_ulMagic = 0;
+  CountFree(pmh->mh_uwTag, pmh->mh_slSize);
+
+  // if from the heap
+  if (iPool==MEMPOOL_NONE) {
+    free(pmh);
+    return;
+  }
+  // put the chunk back on its free list
+  MemoryPool &mp = _ampPools[iPool];
+  LockAllocator();
+  *(void**)pv = mp.mp_pvFree;
+  mp.mp_pvFree = pv;
+  mp.mp_ctFree++;
+  mp.mp_ctUsed--;
+  UnlockAllocator();
+}
+
+void ResizeMemoryTagged( void **ppv, SLONG slSize)
+{
+  // resizing nothing is allocating
+  if (*ppv==NULL) {
+    *ppv = AllocMemoryTagged(slSize, _iMemoryTag);
+    return;
+  }
+
+  MemoryHeader *pmh = HeaderOf(*ppv);
+  const INDEX iTag = pmh->mh_uwTag;
+  const SLONG slOldSize = pmh->mh_slSize;
+
+  // if pooled
+  if (pmh->mh_uwPool!=MEMPOOL_NONE) {
+    // keep it in place while it fits its size class
+    if (slSize<=(MEMPOOL_MINSIZE<<pmh->mh_uwPool)) {
+      ThreadStats()[iTag].mts_llLiveBytes += slSize-slOldSize;
+      pmh->mh_slSize = slSize;
+      return;
+    }
+    // otherwise move it to the heap
+    void *pvNew = AllocMemoryTagged(slSize, iTag);
+    memcpy(pvNew, *ppv, slOldSize);
+    FreeMemoryTagged(*ppv);
+    *ppv = pvNew;
+    return;
+  }
+
+  void *pvRaw = realloc(pmh, slSize+sizeof(MemoryHeader));
+  // memory handler asures no null results here?!
+  if (pvRaw==NULL) {
+    _CrtCheckMemory();
+    FatalError(TRANS("Not enough memory (%d bytes needed)!"), slSize);
+  }
+  pmh = (MemoryHeader*)pvRaw;
+  pmh->mh_slSize = slSize;
+  ThreadStats()[iTag].mts_llLiveBytes += slSize-slOldSize;
+  *ppv = pmh+1;
+}
+
+
+INDEX GetMemoryTag(void)
+{
+  return _iMemoryTag;
+}
+
+INDEX SetMemoryTag(INDEX iTag)
+{
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  INDEX iOldTag = _iMemoryTag;
+  _iMemoryTag = iTag;
+  return iOldTag;
+}
+
+
+/////////////////////////////////////////////////////////////////////
+// Statistics
+
+// sum statistics of all threads
+static void SumStats(MemoryTagStats *pmts)
+{
+  memset(pmts, 0, sizeof(MemoryTagStats)*MTG_COUNT);
+  const INDEX ctThreads = Min(INDEX(AtomicLoad(&_ctStatsThreads)), INDEX(MEMSTATS_MAXTHREADS));
+  for (INDEX iThread=0; iThread<ctThreads; iThread++) {
+    for (INDEX iTag=0; iTag<MTG_COUNT; iTag++) {
+      const MemoryTagStats &mtsThread = _aamtsStats[iThread][iTag];
+      MemoryTagStats &mts = pmts[iTag];
+      mts.mts_llLiveBytes   += mtsThread.mts_llLiveBytes;
+      mts.mts_ctLiveBlocks  += mtsThread.mts_ctLiveBlocks;
+      mts.mts_llTotalBytes  += mtsThread.mts_llTotalBytes;
+      mts.mts_llTotalBlocks += mtsThread.mts_llTotalBlocks;
+    }
+  }
+}
+
+__int64 GetTaggedMemory(INDEX iTag)
+{
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  MemoryTagStats amts[MTG_COUNT];
+  SumStats(amts);
+  return amts[iTag].mts_llLiveBytes;
+}
+
+INDEX GetTaggedBlocks(INDEX iTag)
+{
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  MemoryTagStats amts[MTG_COUNT];
+  SumStats(amts);
+  return amts[iTag].mts_ctLiveBlocks;
+}
+
+const char *GetMemoryTagName(INDEX iTag)
+{
+  ASSERT(iTag>=0 && iTag<MTG_COUNT);
+  return _astrTagNames[iTag];
+}
+
+void UpdateMemoryProfile(void)
+{
+  static MemoryTagStats _amtsLast[MTG_COUNT];
+  static __int64 _llLastPooled = 0;
+
+  MemoryTagStats amts[MTG_COUNT];
+  SumStats(amts);
+  const __int64 llPooled = _llPooledBlocks;
+
+  // counters are in pairs, one pair for each tag
+  ASSERT(CMemoryProfile::PCI_POOLED_ALLOCATIONS==CMemoryProfile::PCI_GENERAL_ALLOCATIONS+MTG_COUNT*2);
+  _pfMemoryProfile.IncrementAveragingCounter();
+  for (INDEX iTag=0; iTag<MTG_COUNT; iTag++) {
+    const INDEX ctBlocks = (INDEX)(amts[iTag].mts_llTotalBlocks-_amtsLast[iTag].mts_llTotalBlocks);
+    const INDEX ctBytes  = (INDEX)(amts[iTag].mts_llTotalBytes -_amtsLast[iTag].mts_llTotalBytes);
+    _pfMemoryProfile.IncrementCounter(CMemoryProfile::PCI_GENERAL_ALLOCATIONS+iTag*2,   ctBlocks);
+    _pfMemoryProfile.IncrementCounter(CMemoryProfile::PCI_GENERAL_ALLOCATIONS+iTag*2+1, ctBytes);
+  }
+  _pfMemoryProfile.IncrementCounter(CMemoryProfile::PCI_POOLED_ALLOCATIONS, (INDEX)(llPooled-_llLastPooled));
+
+  memcpy(_amtsLast, amts, sizeof(amts));
+  _llLastPooled = llPooled;
+}
+
+void MemoryStats(void)
+{
+  static MemoryTagStats _amtsLast[MTG_COUNT];
+  static CTimerValue _tvLast((__int64)0);
+
+  MemoryTagStats amts[MTG_COUNT];
+  SumStats(amts);
+  const __int64 llPooled = _llPooledBlocks;
+
+  // rates are since the previous call
+  const CTimerValue tvNow = _pTimer->GetHighPrecisionTimer();
+  const BOOL bRates = _tvLast.tv_llValue!=0;
+  DOUBLE dSeconds = bRates ? (tvNow-_tvLast).GetSeconds() : 0.0;
+  if (dSeconds<=0.0) dSeconds = 1.0;
+
+  CPrintF("tag        live KB    blocks  allocs/s      KB/s\n");
+  __int64 llTotal = 0;
+  for (INDEX iTag=0; iTag<MTG_COUNT; iTag++) {
+    const MemoryTagStats &mts = amts[iTag];
+    llTotal += mts.mts_llLiveBytes;
+    if (bRates) {
+      CPrintF("%-8s %9.1f %9d %9.1f %9.1f\n", _astrTagNames[iTag],
+        mts.mts_llLiveBytes/1024.0, mts.mts_ctLiveBlocks,
+        (mts.mts_llTotalBlocks-_amtsLast[iTag].mts_llTotalBlocks)/dSeconds,
+        (mts.mts_llTotalBytes -_amtsLast[iTag].mts_llTotalBytes)/1024.0/dSeconds);
+    } else {
+      CPrintF("%-8s %9.1f %9d         -         -\n", _astrTagNames[iTag],
+        mts.mts_llLiveBytes/1024.0, mts.mts_ctLiveBlocks);
+    }
+  }
+  CPrintF("total    %9.1f\n", llTotal/1024.0);
+
+  CPrintF("pool   chunks used   free  pages\n");
+  LockAllocator();
+  for (INDEX iPool=0; iPool<MEMPOOL_CLASSES; iPool++) {
+    const MemoryPool &mp = _ampPools[iPool];
+    if (mp.mp_ctPages==0) continue;
+    CPrintF("%5d %11d %6d %6d\n", MEMPOOL_MINSIZE<<iPool, mp.mp_ctUsed, mp.mp_ctFree, mp.mp_ctPages);
+  }
+  UnlockAllocator();
+
+  memcpy(_amtsLast, amts, sizeof(amts));
+  _tvLast = tvNow;
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_ALLOCATOR_H
+#define SE_INCL_ALLOCATOR_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Base/Types.h>
+#include <Engine/Base/Memory.h>
+
+#include <stddef.h>
+
+/*
+ * Tagged memory allocator.
+ *
+ * Every block obtained through AllocMemory() carries a small header that tells
+ * which subsystem (tag) it is accounted to and whether it came from one of the
+ * size-class pools, so FreeMemory() and ResizeMemory() work for all of them.
+ * Blocks that are not explicitly tagged are accounted to the tag of the
+ * innermost CMemoryTagScope on the current thread.
+ */
+
+// subsystems that memory is accounted to
+enum MemoryTag {
+  MTG_GENERAL = 0,  // everything not covered by other tags
+  MTG_WORLD,        // world, brushes, entities and their relations
+  MTG_NETWORK,      // messages, packets and network buffers
+  MTG_SOUND,        // sound data and mixer buffers
+  MTG_STOCK,        // resources loaded through stocks
+  MTG_COUNT,
+};
+
+// largest block that can be served from the size-class pools
+#define MEMPOOL_MAXSIZE 2048
+
+/* Allocate a block accounted to the given tag - fatal error if not enough memory. */
+ENGINE_API extern void *AllocMemoryTagged( SLONG slSize, INDEX iTag);
+/* Allocate a block from the size-class pools (falls back to tagged heap if too big). */
+ENGINE_API extern void *AllocMemoryPooled( SLONG slSize, INDEX iTag);
+/* Resize a block keeping its tag (pooled blocks move to the heap when they outgrow the pool). */
+ENGINE_API extern void ResizeMemoryTagged( void **ppv, SLONG slSize);
+/* Free a block obtained from any of the above (same as FreeMemory()). */
+ENGINE_API extern void FreeMemoryTagged( void *pv);
+#ifdef _MSC_VER
+#ifndef NDEBUG
+ENGINE_API extern void *_debug_AllocMemoryTagged( SLONG slSize, INDEX iTag, int iType, const char *strFile, int iLine);
+#endif
+#endif
+
+/* Get/set the tag that untagged allocations on this thread are accounted to. */
+ENGINE_API extern INDEX GetMemoryTag(void);
+ENGINE_API extern INDEX SetMemoryTag(INDEX iTag);
+
+/* Get live bytes and live block count for a tag. */
+ENGINE_API extern __int64 GetTaggedMemory(INDEX iTag);
+ENGINE_API extern INDEX GetTaggedBlocks(INDEX iTag);
+/* Get name of a tag. */
+ENGINE_API extern const char *GetMemoryTagName(INDEX iTag);
+
+/* Accumulate allocations done since last call into the memory profile form. */
+ENGINE_API extern void UpdateMemoryProfile(void);
+/* Console command that prints live memory and allocation rates per tag. */
+ENGINE_API extern void MemoryStats(void);
+
+
+/*
+ * Accounts all untagged allocations of the current thread to a tag while in scope.
+ */
+class CMemoryTagScope {
+public:
+  INDEX mts_iOldTag;
+  inline CMemoryTagScope(INDEX iTag) { mts_iOldTag = SetMemoryTag(iTag); };
+  inline ~CMemoryTagScope(void) { SetMemoryTag(mts_iOldTag); };
+};
+
+
+/*
+ * Base for small objects that are frequently created and deleted, makes
+ * 'new' and 'delete' use the size-class pools under the given tag.
+ */
+// the debug version of operator new is a macro, don't let it mangle declarations below
+#ifdef _MSC_VER
+#pragma push_macro("new")
+#undef new
+#endif
+
+template<INDEX iTag>
+class CPooledObject {
+public:
+  inline void *operator new(size_t size) {
+    return AllocMemoryPooled((SLONG)size, iTag);
+  };
+  inline void operator delete(void *pv) {
+    if (pv!=NULL) FreeMemoryTagged(pv);
+  };
+#ifdef _MSC_VER
+#ifndef NDEBUG
+  inline void *operator new(size_t size, int iType, const char *strFile, int iLine) {
+    return AllocMemoryPooled((SLONG)size, iTag);
+  };
+  inline void operator delete(void *pv, int iType, const char *strFile, int iLine) {
+    if (pv!=NULL) FreeMemoryTagged(pv);
+  };
+#endif
+#endif
+};
+
+#ifdef _MSC_VER
+#pragma pop_macro("new")
+#endif
+
+
+#endif  /* include-once check. */
@@ -0,0 +1,84 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_BENCHMARKUTIL_H
+#define SE_INCL_BENCHMARKUTIL_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Math/Functions.h>
+#include <Engine/Templates/StaticArray.h>
+
+// helpers shared by the console benchmark commands
+
+/*
+ * Stopwatch for timing benchmark steps.
+ */
+class CBenchmarkTimer {
+public:
+  DOUBLE bt_dStart;
+  /* Constructor starts timing. */
+  inline CBenchmarkTimer(void) { Start(); };
+  /* Start (or restart) timing. */
+  inline void Start(void) {
+    bt_dStart = _pTimer->GetHighPrecisionTimer().GetSeconds();
+  };
+  /* Get seconds elapsed since start. */
+  inline DOUBLE Stop(void) {
+    return _pTimer->GetHighPrecisionTimer().GetSeconds()-bt_dStart;
+  };
+  /* Print time per operation elapsed since start. */
+  inline void Print(const char *strTest, INDEX ctOperations) {
+    const DOUBLE dSeconds = Stop();
+    CPrintF("  %-28s %9.1f ns/op  (%.3f s)\n", strTest, dSeconds*1E9/ctOperations, dSeconds);
+  };
+};
+
+/*
+ * Repeatable pseudo-random sequence for benchmark data.
+ */
+class CBenchmarkRandom {
+public:
+  ULONG br_ulSeed;
+  /* Constructor starts the sequence from the same seed each time. */
+  inline CBenchmarkRandom(void) : br_ulSeed(0x12345678) {};
+  /* Get next random value (24 bits). */
+  inline ULONG Next(void) {
+    br_ulSeed = br_ulSeed*1103515245+12345;
+    return br_ulSeed>>8;
+  };
+  /* Get next random value in 0..1 range. */
+  inline FLOAT NextFloat(void) {
+    return (Next()&0xFFFF)/65535.0f;
+  };
+};
+
+/* Shuffle array elements in a repeatable order. */
+template<class Type>
+inline void BenchmarkShuffle(CStaticArray<Type> &aItems)
+{
+  CBenchmarkRandom rnd;
+  for (INDEX i=aItems.Count()-1; i>0; i--) {
+    INDEX j = rnd.Next()%(i+1);
+    Swap(aItems[i], aItems[j]);
+  }
+}
+
+
+#endif  /* include-once check. */
+
@@ -23,6 +23,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/CTString.h>
 #include <Engine/Base/FileName.h>
 #include <Engine/Base/Memory.h>
+#include <Engine/Base/Threading.h>
 
 #include <Engine/Math/Functions.h>
 
@@ -31,6 +32,26 @@ CConsole *_pConsole = NULL;
 extern INDEX con_iLastLines;
 BOOL con_bCapture = FALSE;
 CTString con_strCapture = "";
+// number of strings that didn't fit in the log queue
+INDEX con_ctDroppedLines = 0;
+
+extern BOOL _bDedicatedServer;
+
+// background thread that writes the log queue
+static void ConsoleLogThread(void *pvConsole)
+{
+  CConsole *pcon = (CConsole *)pvConsole;
+  pcon->con_ulLogThreadID = ThreadGetID();
+  while (!AtomicLoad(&pcon->con_bLogStop)) {
+    // if there was nothing to write
+    if (pcon->FlushLog()==0) {
+      // wait for more
+      ThreadSleep(CONSOLE_LOGFLUSHDELAY);
+    }
+  }
+  // write out what is left
+  pcon->FlushLog();
+}
 
 
 // Constructor.
@@ -38,23 +59,39 @@ CConsole::CConsole(void)
 {
   con_strBuffer  = NULL;
   con_strLineBuffer = NULL;
+  con_strLinearBuffer = NULL;
+  con_bLinearChanged = TRUE;
   con_atmLines = NULL;
   con_fLog = NULL;
+  con_aclsLog = NULL;
+  con_slLogWrite = 0;
+  con_slLogRead = 0;
+  con_bLogStop = FALSE;
+  con_pvLogThread = NULL;
+  con_ulLogThreadID = 0;
+  con_ctDroppedReported = 0;
 }
 // Destructor.
 CConsole::~CConsole(void)
 {
   ASSERT(this!=NULL);
+  StopLogThread();
   if (con_fLog!=NULL) {
     fclose(con_fLog);
     con_fLog = NULL;
   }
+  if (con_aclsLog!=NULL) {
+    FreeMemory(con_aclsLog);
+  }
   if (con_strBuffer!=NULL) {
     FreeMemory(con_strBuffer);
   }
   if (con_strLineBuffer!=NULL) {
     FreeMemory(con_strLineBuffer);
   }
+  if (con_strLinearBuffer!=NULL) {
+    FreeMemory(con_strLinearBuffer);
+  }
   if (con_atmLines!=NULL) {
     FreeMemory(con_atmLines);
   }
@@ -71,8 +108,10 @@ void CConsole::Initialize(const CTFileName &fnmLog, INDEX ctCharsPerLine, INDEX
   con_ctCharsPerLine = ctCharsPerLine;
   con_ctLines        = ctLines;
   con_ctLinesPrinted = 0;
+  con_iFirstLine = 0;
   // note: we add +1 for '\n' perline and +1 '\0' at the end of buffer
   con_strBuffer = (char *)AllocMemory((ctCharsPerLine+1)*ctLines+1);
+  con_strLinearBuffer = (char *)AllocMemory((ctCharsPerLine+1)*ctLines+1);
   con_strLineBuffer = (char *)AllocMemory(ctCharsPerLine+2); // includes '\n' and '\0'
   con_atmLines = (TIME*)AllocMemory((ctLines+1)*sizeof(TIME));
   // make it empty
@@ -81,9 +120,10 @@ void CConsole::Initialize(const CTFileName &fnmLog, INDEX ctCharsPerLine, INDEX
   }
   // add string terminator at the end
   con_strBuffer[(ctCharsPerLine+1)*ctLines] = 0;
+  con_strLinearBuffer[(ctCharsPerLine+1)*ctLines] = 0;
 
   // start printing in last line
-  con_strLastLine = con_strBuffer+(ctCharsPerLine+1)*(ctLines-1);
+  con_strLastLine = con_strBuffer+(ctCharsPerLine+1)*LineIndex(ctLines-1);
   con_strCurrent = con_strLastLine;
 
   // open console file
@@ -93,6 +133,18 @@ void CConsole::Initialize(const CTFileName &fnmLog, INDEX ctCharsPerLine, INDEX
     FatalError("%s", strerror(errno));
   }
 
+  // prepare the log queue, all slots free
+  con_aclsLog = (ConsoleLogSlot *)AllocMemory(CONSOLE_LOGSLOTS*sizeof(ConsoleLogSlot));
+  for(INDEX iSlot=0; iSlot<CONSOLE_LOGSLOTS; iSlot++) {
+    con_aclsLog[iSlot].cls_slSequence = iSlot;
+    con_aclsLog[iSlot].cls_ctChars = 0;
+  }
+  con_slLogWrite = 0;
+  con_slLogRead = 0;
+  con_bLogStop = FALSE;
+  // start the writer thread (if it fails, log is written while printing)
+  con_pvLogThread = ThreadCreate(&ConsoleLogThread, this);
+
   // print one dummy line on start
   CPrintF("\n");
 }
@@ -101,7 +153,18 @@ void CConsole::Initialize(const CTFileName &fnmLog, INDEX ctCharsPerLine, INDEX
 const char *CConsole::GetBuffer(void)
 {
   ASSERT(this!=NULL);
-  return con_strBuffer+(con_ctLines-con_ctLinesPrinted)*(con_ctCharsPerLine+1);
+  // synchronize access to console
+  CTSingleLock slConsole(&con_csConsole, TRUE);
+
+  // unroll the circular buffer, oldest line first (if not already done)
+  const INDEX ctLineBytes = con_ctCharsPerLine+1;
+  if (con_bLinearChanged) {
+    const INDEX ctFirstPart = (con_ctLines-con_iFirstLine)*ctLineBytes;
+    memcpy(con_strLinearBuffer, con_strBuffer+con_iFirstLine*ctLineBytes, ctFirstPart);
+    memcpy(con_strLinearBuffer+ctFirstPart, con_strBuffer, con_iFirstLine*ctLineBytes);
+    con_bLinearChanged = FALSE;
+  }
+  return con_strLinearBuffer+(con_ctLines-con_ctLinesPrinted)*ctLineBytes;
 }
 INDEX CConsole::GetBufferSize(void)
 {
@@ -126,7 +189,7 @@ INDEX CConsole::NumberOfLinesAfter(TIME tmLast)
   con_iLastLines = Clamp( con_iLastLines, 0, (INDEX)CONSOLE_MAXLASTLINES);
   // find number of last console lines to be displayed on screen
   for(INDEX i=0; i<con_iLastLines; i++) {
-    if (con_atmLines[con_ctLines-1-i]<tmLast) {
+    if (con_atmLines[LineIndex(con_ctLines-1-i)]<tmLast) {
       return i;
     }
   }
@@ -141,8 +204,8 @@ CTString CConsole::GetLastLine(INDEX iLine)
     return "";
   }
   ASSERT(iLine>=0 && iLine<con_ctLines);
-  // get line number from the start of buffer
-  iLine = con_ctLines-1-iLine;
+  // get line number in the buffer
+  iLine = LineIndex(con_ctLines-1-iLine);
   // copy line
   memcpy(con_strLineBuffer, con_strBuffer+iLine*(con_ctCharsPerLine+1), con_ctCharsPerLine);
   // put terminator at the end
@@ -151,7 +214,7 @@ CTString CConsole::GetLastLine(INDEX iLine)
   return con_strLineBuffer;
 }
 
-// clear one given line in buffer
+// clear one given line in buffer (index in circular buffer)
 void CConsole::ClearLine(INDEX iLine)
 {
   ASSERT(this!=NULL);
@@ -163,6 +226,7 @@ void CConsole::ClearLine(INDEX iLine)
   memset(pchLine, ' ', con_ctCharsPerLine);
   // add return at the end of line
   pchLine[con_ctCharsPerLine] = '\n';
+  con_bLinearChanged = TRUE;
   con_atmLines[iLine] = _pTimer!=NULL?_pTimer->GetRealTimeTick():0.0f;
 }
 
@@ -171,49 +235,139 @@ void CConsole::ScrollBufferUp(INDEX ctLines)
 {
   ASSERT(this!=NULL);
   ASSERT(ctLines>0 && ctLines<con_ctLines);
-  // move buffer up
-  memmove(
-    con_strBuffer, 
-    con_strBuffer+ctLines*(con_ctCharsPerLine+1),
-    (con_ctLines-ctLines)*(con_ctCharsPerLine+1));
-  // move buffer up
-  memmove(
-    con_atmLines, 
-    con_atmLines+ctLines,
-    (con_ctLines-ctLines)*sizeof(TIME));
+  // oldest lines become the newest
+  con_iFirstLine = (con_iFirstLine+ctLines)%con_ctLines;
   con_ctLinesPrinted = ClampUp(con_ctLinesPrinted+1, con_ctLines);
   // clear lines at the end
   for(INDEX iLine=con_ctLines-ctLines; iLine<con_ctLines; iLine++) {
-    ClearLine(iLine);
+    ClearLine(LineIndex(iLine));
+  }
+  con_strLastLine = con_strBuffer+(con_ctCharsPerLine+1)*LineIndex(con_ctLines-1);
+}
+
+// add a string to log queue
+void CConsole::QueueLog(const char *strString)
+{
+  ASSERT(this!=NULL && con_aclsLog!=NULL);
+  INDEX ctChars = strlen(strString);
+  while (ctChars>0) {
+    // reserve enough consecutive slots for the string (or its part)
+    const INDEX ctSlots = ClampUp((ctChars+CONSOLE_LOGSLOTSIZE-1)/CONSOLE_LOGSLOTSIZE, (INDEX)CONSOLE_LOGMAXRESERVE);
+    SLONG slFirst;
+    FOREVER {
+      slFirst = AtomicLoad(&con_slLogWrite);
+      // slots are freed in order, so if the last one is free, all of them are
+      const SLONG slLast = slFirst+ctSlots-1;
+      ConsoleLogSlot &clsLast = con_aclsLog[slLast&(CONSOLE_LOGSLOTS-1)];
+      const SLONG slDiff = (SLONG)((ULONG)AtomicLoad(&clsLast.cls_slSequence)-(ULONG)slLast);
+      // if free
+      if (slDiff==0) {
+        // try to take them
+        if (AtomicCompareExchange(&con_slLogWrite, slFirst+ctSlots, slFirst)==slFirst) {
+          break;
+        }
+      // if queue is full
+      } else if (slDiff<0) {
+        // drop the rest of the string, writer will note that
+        AtomicAdd((volatile SLONG *)&con_ctDroppedLines, 1);
+        return;
+      }
+      // someone else was faster, try again
+    }
+    // fill the slots and mark them as written
+    for(INDEX iSlot=0; iSlot<ctSlots; iSlot++) {
+      ConsoleLogSlot &cls = con_aclsLog[(slFirst+iSlot)&(CONSOLE_LOGSLOTS-1)];
+      cls.cls_ctChars = ClampUp(ctChars, (INDEX)CONSOLE_LOGSLOTSIZE);
+      memcpy(cls.cls_achText, strString, cls.cls_ctChars);
+      strString += cls.cls_ctChars;
+      ctChars -= cls.cls_ctChars;
+      AtomicStore(&cls.cls_slSequence, slFirst+iSlot+1);
+    }
+  }
+}
+
+// write out all queued strings, returns number of slots written
+INDEX CConsole::FlushLog(void)
+{
+  ASSERT(this!=NULL);
+  if (con_aclsLog==NULL) {
+    return 0;
+  }
+  INDEX ctWritten = 0;
+  FOREVER {
+    ConsoleLogSlot &cls = con_aclsLog[con_slLogRead&(CONSOLE_LOGSLOTS-1)];
+    // stop at first slot that is not written yet
+    if (AtomicLoad(&cls.cls_slSequence)!=con_slLogRead+1) {
+      break;
+    }
+    if (con_fLog!=NULL) {
+      fwrite(cls.cls_achText, 1, cls.cls_ctChars, con_fLog);
+    }
+    if (_bDedicatedServer) {
+      fwrite(cls.cls_achText, 1, cls.cls_ctChars, stdout);
+    }
+    // free the slot for next round
+    AtomicStore(&cls.cls_slSequence, con_slLogRead+CONSOLE_LOGSLOTS);
+    con_slLogRead++;
+    ctWritten++;
+  }
+  // note if anything was lost since last time
+  const INDEX ctDropped = con_ctDroppedLines;
+  if (ctDropped!=con_ctDroppedReported) {
+    if (con_fLog!=NULL) {
+      fprintf(con_fLog, "\n<console log overloaded: %d lines dropped>\n", ctDropped-con_ctDroppedReported);
+    }
+    con_ctDroppedReported = ctDropped;
+    ctWritten++;
+  }
+  // flush a whole batch at once
+  if (ctWritten>0) {
+    if (con_fLog!=NULL) {
+      fflush(con_fLog);
+    }
+    if (_bDedicatedServer) {
+      fflush(stdout);
+    }
+  }
+  return ctWritten;
+}
+
+// stop the writer thread and write out everything that is left
+void CConsole::StopLogThread(void)
+{
+  ASSERT(this!=NULL);
+  if (con_pvLogThread==NULL) {
+    FlushLog();
+    return;
   }
+  AtomicStore(&con_bLogStop, TRUE);
+  ThreadJoin(con_pvLogThread);
+  con_pvLogThread = NULL;
 }
 
 // Add a line of text to console
 void CConsole::PutString(const char *strString)
 {
   ASSERT(this!=NULL);
+  // if in debug version, report it to output window
+  _RPT1(_CRT_WARN, "%s", strString);
+  // first queue that string for the console output file (and output on dedicated server)
+  if (con_aclsLog!=NULL) {
+    QueueLog(strString);
+  }
+
   // synchronize access to console
   CTSingleLock slConsole(&con_csConsole, TRUE);
 
-  // if in debug version, report it to output window
-  _RPT1(_CRT_WARN, "%s", strString);
-  // first append that string to the console output file
-  if (con_fLog!=NULL) {
-    fprintf(con_fLog, "%s", strString);
-    fflush(con_fLog);
+  // if there is no writer thread, write the log right away
+  if (con_pvLogThread==NULL) {
+    FlushLog();
   }
   // if needed, append to capture string
   if (con_bCapture) {
     con_strCapture+=strString;
   }
 
-  // if dedicated server
-  extern BOOL _bDedicatedServer;
-  if (_bDedicatedServer) {
-    // print to output
-    printf("%s", strString);
-  }
-
   // start at the beginning of the string
   const char *pch=strString;
   // while not end of string
@@ -241,6 +395,7 @@ void CConsole::PutString(const char *strString)
     }
     // otherwise, add the char to buffer
     *con_strCurrent++ = c;
+    con_bLinearChanged = TRUE;
   }
 }
 
@@ -248,6 +403,13 @@ void CConsole::PutString(const char *strString)
 void CConsole::CloseLog(void)
 {
   ASSERT(this!=NULL);
+  // if called from the writer thread itself (crashed while writing), just close the file
+  if (con_pvLogThread!=NULL && ThreadGetID()==con_ulLogThreadID) {
+    AtomicStore(&con_bLogStop, TRUE);
+  } else {
+    // write out everything that was printed
+    StopLogThread();
+  }
   if (con_fLog!=NULL) {
     fclose(con_fLog);
   }
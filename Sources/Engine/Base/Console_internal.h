@@ -23,20 +23,48 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 // Object that takes care of game console.
 #define CONSOLE_MAXLASTLINES 15 // how many last-line times to remember
+
+#define CONSOLE_LOGSLOTS      2048  // number of slots in log queue (must be power of 2)
+#define CONSOLE_LOGSLOTSIZE   244   // max number of chars in one slot
+#define CONSOLE_LOGMAXRESERVE 64    // max slots reserved at once (longer strings are split)
+#define CONSOLE_LOGFLUSHDELAY 10    // how long the writer sleeps when there is nothing to write [ms]
+
+// one slot of the log queue
+struct ConsoleLogSlot {
+  volatile SLONG cls_slSequence;  // tells if the slot is free or written to
+  INDEX cls_ctChars;              // number of chars in the slot
+  char cls_achText[CONSOLE_LOGSLOTSIZE];
+};
+
 class CConsole {
 public:
 // implementation:
   CTCriticalSection con_csConsole; // critical section for access to console data
-  char *con_strBuffer;        // the allocated buffer
+  char *con_strBuffer;        // the allocated buffer (circular, one line after another)
   char *con_strCurrent;       // next char to print
   char *con_strLastLine;      // start of last line in buffer
   char *con_strLineBuffer;    // one-line-sized buffer for temp usage
+  char *con_strLinearBuffer;  // buffer where lines are put in order for GetBuffer()
+  BOOL con_bLinearChanged;    // set if buffer changed since linear buffer was made
   INDEX con_ctCharsPerLine;   // number of characters per line
   INDEX con_ctLines;          // number of total lines
+  INDEX con_iFirstLine;       // index of the oldest line in circular buffer
   TIME *con_atmLines;         // time stamp for each line
   INDEX con_ctLinesPrinted;   // number of lines printed
   FILE *con_fLog;   // log file for streaming the console to
 
+  // queue of strings to be written to log file and standard output
+  // (any thread can add to it without locking, only the writer thread reads it)
+  ConsoleLogSlot *con_aclsLog;
+  volatile SLONG con_slLogWrite;  // next slot to be reserved
+  SLONG con_slLogRead;            // next slot to be written out
+  volatile SLONG con_bLogStop;    // set when writer thread should finish
+  void *con_pvLogThread;          // writer thread, NULL if log is written synchronously
+  ULONG con_ulLogThreadID;
+  INDEX con_ctDroppedReported;    // dropped lines already noted in the log
+
+  // get index in circular buffer for given line (0 is the oldest)
+  inline INDEX LineIndex(INDEX iLine) const { return (con_iFirstLine+iLine)%con_ctLines; };
   // clear line buffer
   void ClearLineBuffer();
   // clear one given line in buffer
@@ -45,6 +73,12 @@ public:
   void ScrollBufferUp(INDEX ctBytesToFree);
   // Move last line times one place back and add new time
   void NewLastTime(TIME tmNew);
+  // add a string to log queue
+  void QueueLog(const char *strString);
+  // write out all queued strings, returns number of slots written
+  INDEX FlushLog(void);
+  // stop the writer thread and write out everything that is left
+  void StopLogThread(void);
 
 // interface:
 
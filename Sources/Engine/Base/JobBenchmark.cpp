@@ -0,0 +1,204 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Jobs.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Math/Functions.h>
+
+// node of a job tree, each node starts its children and waits for them
+struct JobTreeNode {
+  INDEX jtn_iDepth;
+  INDEX jtn_iValue;
+  SLONG jtn_slSum;    // sum of values of all leaves under this node
+};
+
+#define TREE_FANOUT 4
+
+static void JobTreeNodeJob(void *pvParam)
+{
+  JobTreeNode &jtn = *(JobTreeNode *)pvParam;
+  if (jtn.jtn_iDepth==0) {
+    jtn.jtn_slSum = jtn.jtn_iValue;
+    return;
+  }
+  JobTreeNode ajtnChildren[TREE_FANOUT];
+  CJobCounter jc;
+  for (INDEX i=0; i<TREE_FANOUT; i++) {
+    ajtnChildren[i].jtn_iDepth = jtn.jtn_iDepth-1;
+    ajtnChildren[i].jtn_iValue = jtn.jtn_iValue*TREE_FANOUT+i;
+    ajtnChildren[i].jtn_slSum = 0;
+    _pJobs->Run(JobTreeNodeJob, &ajtnChildren[i], &jc);
+  }
+  _pJobs->Wait(jc);
+  jtn.jtn_slSum = 0;
+  for (INDEX i=0; i<TREE_FANOUT; i++) {
+    jtn.jtn_slSum += ajtnChildren[i].jtn_slSum;
+  }
+}
+
+// some floating point work for each item
+struct JobWorkload {
+  FLOAT *jw_pfInput;
+  FLOAT *jw_pfOutput;
+  INDEX jw_ctIterations;
+};
+
+static void JobWorkloadRange(void *pvParam, INDEX iFirst, INDEX iLast)
+{
+  const JobWorkload &jw = *(JobWorkload *)pvParam;
+  for (INDEX i=iFirst; i<iLast; i++) {
+    FLOAT f = jw.jw_pfInput[i];
+    for (INDEX iIteration=0; iIteration<jw.jw_ctIterations; iIteration++) {
+      f = Sqrt(f*f+1.0f)*0.5f+0.25f;
+    }
+    jw.jw_pfOutput[i] = f;
+  }
+}
+
+static void FillInput(FLOAT *pf, INDEX ct)
+{
+  ULONG ulSeed = 0x1234567;
+  for (INDEX i=0; i<ct; i++) {
+    ulSeed = ulSeed*1103515245+12345;
+    pf[i] = (FLOAT)((ulSeed>>8)&0xFFFF)/256.0f;
+  }
+}
+
+// run nested jobs and parallel-for many times and check results against serial runs
+void JobStressTest(void *pArgs)
+{
+  INDEX ctRounds = NEXTARGUMENT(INDEX);
+  ctRounds = Clamp(ctRounds, (INDEX)1, (INDEX)10000);
+  if (_pJobs==NULL) {
+    return;
+  }
+  CPrintF("Job stress test with %d rounds on %d threads:\n", ctRounds, _pJobs->GetThreadCount());
+
+  // expected sum of leaves of a tree is sum of all values on the last level
+  const INDEX iDepth = 5;
+  INDEX ctLeaves = 1;
+  for (INDEX i=0; i<iDepth; i++) {
+    ctLeaves *= TREE_FANOUT;
+  }
+  const SLONG slExpected = (SLONG)ctLeaves*(ctLeaves-1)/2;
+
+  const INDEX ctItems = 10000;
+  FLOAT *pfInput    = (FLOAT*)AllocMemory(ctItems*sizeof(FLOAT));
+  FLOAT *pfSerial   = (FLOAT*)AllocMemory(ctItems*sizeof(FLOAT));
+  FLOAT *pfParallel = (FLOAT*)AllocMemory(ctItems*sizeof(FLOAT));
+  FillInput(pfInput, ctItems);
+  JobWorkload jw;
+  jw.jw_pfInput = pfInput;
+  jw.jw_ctIterations = 8;
+
+  // reference result in serial mode
+  const INDEX bOldSerial = job_bSerial;
+  job_bSerial = TRUE;
+  jw.jw_pfOutput = pfSerial;
+  _pJobs->ParallelFor(JobWorkloadRange, &jw, ctItems, 64);
+  JobTreeNode jtnSerial = {iDepth, 0, 0};
+  JobTreeNodeJob(&jtnSerial);
+  job_bSerial = bOldSerial;
+
+  INDEX ctErrors = 0;
+  if (jtnSerial.jtn_slSum!=slExpected) {
+    ctErrors++;
+  }
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  for (INDEX iRound=0; iRound<ctRounds; iRound++) {
+    // a tree of nested jobs, started from a job itself
+    JobTreeNode jtn = {iDepth, 0, 0};
+    CJobCounter jc;
+    _pJobs->Run(JobTreeNodeJob, &jtn, &jc);
+    // parallel-for with varying grain while the tree runs
+    memset(pfParallel, 0, ctItems*sizeof(FLOAT));
+    jw.jw_pfOutput = pfParallel;
+    _pJobs->ParallelFor(JobWorkloadRange, &jw, ctItems, 16+(iRound%7)*37);
+    _pJobs->Wait(jc);
+
+    if (jtn.jtn_slSum!=slExpected) {
+      ctErrors++;
+    }
+    if (memcmp(pfSerial, pfParallel, ctItems*sizeof(FLOAT))!=0) {
+      ctErrors++;
+    }
+  }
+  const DOUBLE dSeconds = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+
+  FreeMemory(pfInput);
+  FreeMemory(pfSerial);
+  FreeMemory(pfParallel);
+
+  CPrintF("  %.2f ms per round\n", dSeconds*1000.0/ctRounds);
+  if (ctErrors>0) {
+    CPrintF("  ERROR: %d rounds gave wrong results!\n", ctErrors);
+  } else {
+    CPrintF("  all results match\n");
+  }
+}
+
+// time parallel-for over given number of items with different numbers of workers
+void JobBenchmark(void *pArgs)
+{
+  INDEX ctItems = NEXTARGUMENT(INDEX);
+  ctItems = Clamp(ctItems, (INDEX)1000, (INDEX)10000000);
+  if (_pJobs==NULL) {
+    return;
+  }
+  const INDEX ctOldWorkers = _pJobs->js_ctWorkers;
+  const INDEX ctMaxWorkers = Max(ThreadGetCPUCount()-1, (INDEX)1);
+  CPrintF("Job benchmark with %d items, up to %d workers:\n", ctItems, ctMaxWorkers);
+
+  FLOAT *pfInput  = (FLOAT*)AllocMemory(ctItems*sizeof(FLOAT));
+  FLOAT *pfOutput = (FLOAT*)AllocMemory(ctItems*sizeof(FLOAT));
+  FillInput(pfInput, ctItems);
+  JobWorkload jw;
+  jw.jw_pfInput = pfInput;
+  jw.jw_pfOutput = pfOutput;
+  jw.jw_ctIterations = 16;
+
+  const INDEX ctGrain = Max(ctItems/256, (INDEX)64);
+  const INDEX ctRepeats = 5;
+  DOUBLE dSingle = 0;
+  for (INDEX ctWorkers=0; ctWorkers<=ctMaxWorkers; ctWorkers = (ctWorkers==0) ? 1 : ctWorkers*2) {
+    _pJobs->StopWorkers();
+    _pJobs->StartWorkers(Min(ctWorkers, ctMaxWorkers));
+    // warm up the threads
+    _pJobs->ParallelFor(JobWorkloadRange, &jw, ctItems, ctGrain);
+
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    for (INDEX iRepeat=0; iRepeat<ctRepeats; iRepeat++) {
+      _pJobs->ParallelFor(JobWorkloadRange, &jw, ctItems, ctGrain);
+    }
+    const DOUBLE dSeconds = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds()/ctRepeats;
+    if (_pJobs->js_ctWorkers==0) {
+      dSingle = dSeconds;
+    }
+    CPrintF("  %2d threads: %8.3f ms  (%.2fx)\n", _pJobs->GetThreadCount(), dSeconds*1000.0,
+      dSingle>0 ? dSingle/dSeconds : 1.0);
+    if (ctWorkers>=ctMaxWorkers) {
+      break;
+    }
+  }
+
+  _pJobs->StopWorkers();
+  _pJobs->StartWorkers(ctOldWorkers);
+  FreeMemory(pfInput);
+  FreeMemory(pfOutput);
+}
@@ -0,0 +1,36 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/JobProfile.h>
+
+// profile form for profiling the job system
+CJobProfile jpJobProfile;
+CProfileForm &_pfJobProfile = jpJobProfile;
+
+CJobProfile::CJobProfile(void)
+ : CProfileForm("Jobs", "ticks",
+    CJobProfile::PCI_COUNT, CJobProfile::PTI_COUNT)
+{
+  SETCOUNTERNAME(CJobProfile::PCI_JOBS_STARTED,      "jobs started");
+  SETCOUNTERNAME(CJobProfile::PCI_JOBS_RUN,          "jobs run");
+  SETCOUNTERNAME(CJobProfile::PCI_JOBS_STOLEN,       "jobs stolen");
+  SETCOUNTERNAME(CJobProfile::PCI_JOBS_HELPED,       "jobs run while waiting");
+  SETCOUNTERNAME(CJobProfile::PCI_JOBS_INLINE,       "jobs run inline");
+  SETCOUNTERNAME(CJobProfile::PCI_RANGES,            "parallel-for ranges");
+  SETCOUNTERNAME(CJobProfile::PCI_WAIT_MICROSECONDS, "microseconds waited");
+  SETCOUNTERNAME(CJobProfile::PCI_WAKEUPS,           "worker wake-ups");
+}
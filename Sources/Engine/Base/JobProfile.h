@@ -0,0 +1,48 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_JOBPROFILE_H
+#define SE_INCL_JOBPROFILE_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#ifndef __ENGINE_BASE_PROFILING_H__
+#include <Engine/Base/Profiling.h>
+#endif
+
+/* Class for holding profiling information for the job system. */
+class CJobProfile : public CProfileForm {
+public:
+  // indices for profiling counters and timers
+  enum ProfileTimerIndex {
+    PTI_COUNT
+  };
+  enum ProfileCounterIndex {
+    PCI_JOBS_STARTED,     // jobs started (including parallel-for ranges)
+    PCI_JOBS_RUN,         // jobs run on any thread
+    PCI_JOBS_STOLEN,      // jobs taken from deque of another thread
+    PCI_JOBS_HELPED,      // jobs run by a thread while waiting for a counter
+    PCI_JOBS_INLINE,      // jobs run right away (serial mode or full deque)
+    PCI_RANGES,           // parallel-for ranges started
+    PCI_WAIT_MICROSECONDS,// time spent waiting for counters
+    PCI_WAKEUPS,          // sleeping workers woken up
+    PCI_COUNT
+  };
+  // constructor
+  CJobProfile(void);
+};
+
+#endif  // include-once blocker.
@@ -0,0 +1,455 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/Jobs.h>
+#include <Engine/Base/JobProfile.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Math/Functions.h>
+
+// pointer to global job system object
+CJobSystem *_pJobs = NULL;
+
+INDEX job_iWorkerThreads = 0;
+INDEX job_bSerial = FALSE;
+
+// deque size must be a power of two
+#define JOBQUEUE_SIZE 256
+#define JOBQUEUE_MASK (JOBQUEUE_SIZE-1)
+// most threads the system will run jobs on
+#define JOB_MAXTHREADS 64
+// number of times an idle worker looks for jobs before going to sleep
+#define JOB_IDLESPINS 64
+
+// deque of jobs; owner takes from bottom, other threads steal from top
+class CJobQueue {
+public:
+  volatile SLONG jq_slLock;
+  volatile SLONG jq_iTop;
+  volatile SLONG jq_iBottom;
+  SLONG jq_aslPad[13];  // keep locks of different deques in different cache lines
+  CJob jq_ajbJobs[JOBQUEUE_SIZE];
+
+  CJobQueue(void) { jq_slLock = 0; jq_iTop = 0; jq_iBottom = 0; };
+
+  inline void Lock(void) {
+    while (AtomicCompareExchange(&jq_slLock, 1, 0)!=0) {
+      ThreadYield();
+    }
+  };
+  inline void Unlock(void) {
+    AtomicRelease(&jq_slLock);
+  };
+  // check without locking if there might be something to take
+  inline BOOL IsEmpty(void) {
+    return jq_iBottom==jq_iTop;
+  };
+};
+
+// statistics of one thread, only that thread writes them (except thread 0,
+// which is shared by all non-worker threads, so all writes are atomic)
+struct JobThreadStats {
+  volatile SLONG jts_ctStarted;
+  volatile SLONG jts_ctRun;
+  volatile SLONG jts_ctStolen;
+  volatile SLONG jts_ctHelped;
+  volatile SLONG jts_ctInline;
+  volatile SLONG jts_ctRanges;
+  volatile SLONG jts_ctWaitMicroseconds;
+  volatile SLONG jts_ctWakeUps;
+  SLONG jts_aslPad[8];
+};
+#define JTS_COUNT 8
+
+static JobThreadStats _ajtsStats[JOB_MAXTHREADS];
+// index of current thread in the job system (0 for all but worker threads)
+static THREAD_LOCAL INDEX _iJobThread = 0;
+
+static inline void AddStat(volatile SLONG &slStat, SLONG slAdd=1)
+{
+  AtomicAdd(&slStat, slAdd);
+}
+
+static void JobWorkerThread(void *pvParam)
+{
+  ((CJobSystem *)pvParam)->WorkerLoop();
+}
+
+// get number of workers to run for given setting
+static INDEX GetWorkerCount(INDEX iSetting)
+{
+  // thread that waits for jobs runs them too
+  return (iSetting>0) ? iSetting : ThreadGetCPUCount()-1;
+}
+
+static void JobsPostFunc(void *pvVar)
+{
+  if (_pJobs!=NULL) {
+    _pJobs->SetWorkerCount(job_iWorkerThreads);
+  }
+}
+
+
+CJobSystem::CJobSystem(void)
+{
+  js_ctWorkers = 0;
+  js_ctQueues = 0;
+  js_ctStarted = 0;
+  js_apvThreads = NULL;
+  js_ajqQueues = NULL;
+  js_ctSleeping = 0;
+  js_bQuit = FALSE;
+  js_pvWakeUp = SemaphoreCreate(0);
+
+  _pShell->DeclareSymbol("void JobsPostFunc(INDEX);", (void *) &JobsPostFunc);
+  _pShell->DeclareSymbol("persistent user INDEX job_iWorkerThreads post:JobsPostFunc;", (void *) &job_iWorkerThreads);
+  _pShell->DeclareSymbol("user INDEX job_bSerial;", (void *) &job_bSerial);
+
+  StartWorkers(GetWorkerCount(job_iWorkerThreads));
+}
+
+CJobSystem::~CJobSystem(void)
+{
+  StopWorkers();
+  SemaphoreDestroy(js_pvWakeUp);
+}
+
+void CJobSystem::StartWorkers(INDEX ctWorkers)
+{
+  ASSERT(js_ajqQueues==NULL);
+  ctWorkers = Clamp(ctWorkers, (INDEX)0, (INDEX)JOB_MAXTHREADS-1);
+
+  js_ctQueues = ctWorkers+1;
+  js_ajqQueues = new CJobQueue[js_ctQueues];
+  js_apvThreads = new void*[js_ctQueues];
+  js_bQuit = FALSE;
+  js_ctStarted = 0;
+  js_ctWorkers = 0;
+  for (INDEX i=0; i<ctWorkers; i++) {
+    void *pvThread = ThreadCreate(JobWorkerThread, this);
+    if (pvThread==NULL) {
+      // the queues of workers that did not start stay empty, nothing is lost
+      CPrintF(TRANS("Cannot start job worker thread %d!\n"), i+1);
+      break;
+    }
+    js_apvThreads[js_ctWorkers++] = pvThread;
+  }
+}
+
+void CJobSystem::StopWorkers(void)
+{
+  if (js_ajqQueues==NULL) {
+    return;
+  }
+  AtomicStore(&js_bQuit, TRUE);
+  if (js_ctWorkers>0) {
+    SemaphoreSignal(js_pvWakeUp, js_ctWorkers);
+  }
+  for (INDEX i=0; i<js_ctWorkers; i++) {
+    ThreadJoin(js_apvThreads[i]);
+  }
+  // nothing may be waiting for jobs now, but run whatever was left
+  while (RunPending(0)) {
+    NOTHING;
+  }
+  // drop wake-ups that nobody consumed
+  js_ctSleeping = 0;
+  SemaphoreDestroy(js_pvWakeUp);
+  js_pvWakeUp = SemaphoreCreate(0);
+
+  delete[] js_apvThreads;  js_apvThreads = NULL;
+  delete[] js_ajqQueues;   js_ajqQueues = NULL;
+  js_ctWorkers = 0;
+  js_ctQueues = 0;
+}
+
+void CJobSystem::SetWorkerCount(INDEX ctWorkers)
+{
+  StopWorkers();
+  StartWorkers(GetWorkerCount(ctWorkers));
+  CPrintF(TRANS("Job system running on %d worker threads.\n"), js_ctWorkers);
+}
+
+INDEX CJobSystem::GetThreadCount(void)
+{
+  return js_ctWorkers+1;
+}
+
+BOOL CJobSystem::IsSerial(void)
+{
+  return job_bSerial || js_ctWorkers==0;
+}
+
+INDEX CJobSystem::GetThreadIndex(void)
+{
+  return _iJobThread;
+}
+
+
+BOOL CJobSystem::Push(const CJob &jb)
+{
+  CJobQueue &jq = js_ajqQueues[_iJobThread];
+  jq.Lock();
+  if (jq.jq_iBottom-jq.jq_iTop>=JOBQUEUE_SIZE) {
+    jq.Unlock();
+    return FALSE;
+  }
+  jq.jq_ajbJobs[jq.jq_iBottom&JOBQUEUE_MASK] = jb;
+  jq.jq_iBottom++;
+  jq.Unlock();
+
+  // wake one sleeping worker, if any; the fence pairs with the one a worker
+  // does between announcing it will sleep and looking at the deques again
+  AtomicFence();
+  FOREVER {
+    const SLONG ctSleeping = js_ctSleeping;
+    if (ctSleeping<=0) {
+      break;
+    }
+    if (AtomicCompareExchange(&js_ctSleeping, ctSleeping-1, ctSleeping)==ctSleeping) {
+      AddStat(_ajtsStats[_iJobThread].jts_ctWakeUps);
+      SemaphoreSignal(js_pvWakeUp, 1);
+      break;
+    }
+  }
+  return TRUE;
+}
+
+BOOL CJobSystem::Pop(INDEX iThread, CJob &jb)
+{
+  // own jobs first, newest one
+  CJobQueue &jqOwn = js_ajqQueues[iThread];
+  if (!jqOwn.IsEmpty()) {
+    jqOwn.Lock();
+    if (jqOwn.jq_iBottom>jqOwn.jq_iTop) {
+      jqOwn.jq_iBottom--;
+      jb = jqOwn.jq_ajbJobs[jqOwn.jq_iBottom&JOBQUEUE_MASK];
+      jqOwn.Unlock();
+      return TRUE;
+    }
+    jqOwn.Unlock();
+  }
+  // then steal oldest job of some other thread
+  for (INDEX i=1; i<js_ctQueues; i++) {
+    CJobQueue &jq = js_ajqQueues[(iThread+i)%js_ctQueues];
+    if (jq.IsEmpty()) {
+      continue;
+    }
+    jq.Lock();
+    if (jq.jq_iBottom>jq.jq_iTop) {
+      jb = jq.jq_ajbJobs[jq.jq_iTop&JOBQUEUE_MASK];
+      jq.jq_iTop++;
+      jq.Unlock();
+      AddStat(_ajtsStats[iThread].jts_ctStolen);
+      return TRUE;
+    }
+    jq.Unlock();
+  }
+  return FALSE;
+}
+
+void CJobSystem::Execute(INDEX iThread, CJob &jb)
+{
+  if (jb.j_pRangeFunction!=NULL) {
+    jb.j_pRangeFunction(jb.j_pvParam, jb.j_iFirst, jb.j_iLast);
+  } else {
+    jb.j_pFunction(jb.j_pvParam);
+  }
+  AddStat(_ajtsStats[iThread].jts_ctRun);
+  if (jb.j_pjcCounter!=NULL) {
+    AtomicAdd(&jb.j_pjcCounter->jc_ctPending, -1);
+  }
+}
+
+BOOL CJobSystem::RunPending(INDEX iThread)
+{
+  CJob jb;
+  if (!Pop(iThread, jb)) {
+    return FALSE;
+  }
+  Execute(iThread, jb);
+  return TRUE;
+}
+
+void CJobSystem::WorkerLoop(void)
+{
+  const INDEX iThread = AtomicAdd(&js_ctStarted, 1);
+  ASSERT(iThread>0 && iThread<js_ctQueues);
+  _iJobThread = iThread;
+
+  INDEX ctIdle = 0;
+  while (!AtomicLoad(&js_bQuit)) {
+    if (RunPending(iThread)) {
+      ctIdle = 0;
+      continue;
+    }
+    // stay awake for a while, new jobs usually come in bursts
+    if (ctIdle<JOB_IDLESPINS) {
+      ctIdle++;
+      ThreadYield();
+      continue;
+    }
+
+    // announce going to sleep, then look once more so no push is missed
+    AtomicAdd(&js_ctSleeping, 1);
+    BOOL bWork = js_bQuit;
+    for (INDEX i=0; i<js_ctQueues && !bWork; i++) {
+      bWork = !js_ajqQueues[i].IsEmpty();
+    }
+    if (bWork) {
+      // take the announcement back, unless a pusher already did - then its
+      // wake-up stays in the semaphore and just makes someone look again later
+      FOREVER {
+        const SLONG ctSleeping = js_ctSleeping;
+        if (ctSleeping<=0 || AtomicCompareExchange(&js_ctSleeping, ctSleeping-1, ctSleeping)==ctSleeping) {
+          break;
+        }
+      }
+    } else {
+      SemaphoreWait(js_pvWakeUp);
+    }
+    ctIdle = 0;
+  }
+}
+
+
+void CJobSystem::Run(JobFunction_t pFunction, void *pvParam, CJobCounter *pjc)
+{
+  CJob jb;
+  jb.j_pFunction = pFunction;
+  jb.j_pRangeFunction = NULL;
+  jb.j_pvParam = pvParam;
+  jb.j_iFirst = 0;
+  jb.j_iLast = 0;
+  jb.j_pjcCounter = pjc;
+
+  const INDEX iThread = _iJobThread;
+  AddStat(_ajtsStats[iThread].jts_ctStarted);
+  if (pjc!=NULL) {
+    AtomicAdd(&pjc->jc_ctPending, 1);
+  }
+  if (IsSerial() || !Push(jb)) {
+    AddStat(_ajtsStats[iThread].jts_ctInline);
+    Execute(iThread, jb);
+  }
+}
+
+void CJobSystem::RunRange(JobRangeFunction_t pFunction, void *pvParam, INDEX ctItems, INDEX ctGrain, CJobCounter *pjc)
+{
+  ASSERT(ctGrain>0);
+  ctGrain = Max(ctGrain, (INDEX)1);
+
+  CJob jb;
+  jb.j_pFunction = NULL;
+  jb.j_pRangeFunction = pFunction;
+  jb.j_pvParam = pvParam;
+  jb.j_pjcCounter = pjc;
+
+  // ranges depend only on the grain, so results do not depend on number of threads
+  const INDEX iThread = _iJobThread;
+  const BOOL bSerial = IsSerial();
+  for (INDEX iFirst=0; iFirst<ctItems; iFirst+=ctGrain) {
+    jb.j_iFirst = iFirst;
+    jb.j_iLast = Min(iFirst+ctGrain, ctItems);
+    AddStat(_ajtsStats[iThread].jts_ctStarted);
+    AddStat(_ajtsStats[iThread].jts_ctRanges);
+    if (pjc!=NULL) {
+      AtomicAdd(&pjc->jc_ctPending, 1);
+    }
+    if (bSerial || !Push(jb)) {
+      AddStat(_ajtsStats[iThread].jts_ctInline);
+      Execute(iThread, jb);
+    }
+  }
+}
+
+void CJobSystem::Wait(CJobCounter &jc)
+{
+  if (jc.IsDone()) {
+    return;
+  }
+  const INDEX iThread = _iJobThread;
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  // run other jobs while waiting, those we wait for might be among them
+  while (!jc.IsDone()) {
+    if (RunPending(iThread)) {
+      AddStat(_ajtsStats[iThread].jts_ctHelped);
+    } else {
+      ThreadYield();
+    }
+  }
+  CTimerValue tvWaited = _pTimer->GetHighPrecisionTimer()-tvStart;
+  AddStat(_ajtsStats[iThread].jts_ctWaitMicroseconds, (SLONG)(tvWaited.GetSeconds()*1E6));
+}
+
+void CJobSystem::ParallelFor(JobRangeFunction_t pFunction, void *pvParam, INDEX ctItems, INDEX ctGrain)
+{
+  CJobCounter jc;
+  RunRange(pFunction, pvParam, ctItems, ctGrain, &jc);
+  Wait(jc);
+}
+
+
+// sum statistics of all threads
+static void SumJobStats(SLONG aslTotals[JTS_COUNT])
+{
+  for (INDEX iStat=0; iStat<JTS_COUNT; iStat++) {
+    aslTotals[iStat] = 0;
+  }
+  for (INDEX iThread=0; iThread<JOB_MAXTHREADS; iThread++) {
+    const volatile SLONG *pslStats = &_ajtsStats[iThread].jts_ctStarted;
+    for (INDEX iStat=0; iStat<JTS_COUNT; iStat++) {
+      aslTotals[iStat] += pslStats[iStat];
+    }
+  }
+}
+
+void CJobSystem::UpdateProfile(void)
+{
+  static SLONG _aslLast[JTS_COUNT] = {0};
+  SLONG aslTotals[JTS_COUNT];
+  SumJobStats(aslTotals);
+
+  // statistics are in the same order as the profile counters
+  _pfJobProfile.IncrementAveragingCounter();
+  for (INDEX iStat=0; iStat<JTS_COUNT; iStat++) {
+    _pfJobProfile.IncrementCounter(CJobProfile::PCI_JOBS_STARTED+iStat, aslTotals[iStat]-_aslLast[iStat]);
+    _aslLast[iStat] = aslTotals[iStat];
+  }
+}
+
+void CJobSystem::PrintStats(void)
+{
+  CPrintF(TRANS("Job system: %d workers%s\n"), js_ctWorkers, IsSerial() ? " (serial)" : "");
+  CPrintF("  thread   started       run    stolen    helped    inline    ranges   wait ms   wakeups\n");
+  for (INDEX iThread=0; iThread<js_ctQueues; iThread++) {
+    const JobThreadStats &jts = _ajtsStats[iThread];
+    CPrintF("  %6d %9d %9d %9d %9d %9d %9d %9d %9d\n", iThread,
+      jts.jts_ctStarted, jts.jts_ctRun, jts.jts_ctStolen, jts.jts_ctHelped,
+      jts.jts_ctInline, jts.jts_ctRanges, jts.jts_ctWaitMicroseconds/1000, jts.jts_ctWakeUps);
+  }
+}
+
+// console command that prints job statistics
+void JobStats(void)
+{
+  if (_pJobs!=NULL) {
+    _pJobs->PrintStats();
+  }
+}
@@ -0,0 +1,133 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_JOBS_H
+#define SE_INCL_JOBS_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Base/Threading.h>
+
+/*
+ * Engine job system.
+ *
+ * A fixed pool of worker threads (one less than there are processors, as the
+ * thread that waits for jobs runs them too) takes jobs from per-thread deques;
+ * a thread runs its own jobs newest first and steals the oldest ones from
+ * other threads when it runs out. Jobs report completion to a CJobCounter,
+ * and waiting on a counter runs other jobs meanwhile, so jobs may start and
+ * wait for child jobs of their own.
+ *
+ * Jobs must not throw and must not touch the world, shell or console unless
+ * the caller guarantees nothing else does so at the same time.
+ *
+ * In serial mode (job_bSerial) each job runs right when it is started, on the
+ * starting thread, in the order of starting. Results of parallel-for do not
+ * depend on number of workers either way, as ranges are split by grain size
+ * only, so serial mode is also good for checking sync problems.
+ */
+
+// function that a job runs
+typedef void (*JobFunction_t)(void *pvParam);
+// function that a parallel-for job runs for indices [iFirst, iLast)
+typedef void (*JobRangeFunction_t)(void *pvParam, INDEX iFirst, INDEX iLast);
+
+// counter of jobs that have not finished yet
+class CJobCounter {
+public:
+  volatile SLONG jc_ctPending;
+  inline CJobCounter(void) { jc_ctPending = 0; };
+  inline ~CJobCounter(void) { ASSERT(jc_ctPending==0); };
+  inline BOOL IsDone(void) { return AtomicLoad(&jc_ctPending)==0; };
+};
+
+// one job in a deque
+class CJob {
+public:
+  JobFunction_t j_pFunction;            // either this one,
+  JobRangeFunction_t j_pRangeFunction;  // or this one is set
+  void *j_pvParam;
+  INDEX j_iFirst;
+  INDEX j_iLast;
+  CJobCounter *j_pjcCounter;            // counter to decrement when done (may be NULL)
+};
+
+class CJobQueue;
+
+class ENGINE_API CJobSystem {
+public:
+// implementation:
+  INDEX js_ctWorkers;             // number of worker threads running
+  INDEX js_ctQueues;              // number of deques (workers and one for other threads)
+  volatile SLONG js_ctStarted;    // workers that have taken their index
+  void **js_apvThreads;           // worker thread handles
+  CJobQueue *js_ajqQueues;        // deques of all threads (0 is for non-worker threads)
+  void *js_pvWakeUp;              // semaphore sleeping workers wait on
+  volatile SLONG js_ctSleeping;   // number of workers sleeping
+  volatile SLONG js_bQuit;        // set when workers should end
+
+  // start given number of worker threads, stop all of them
+  void StartWorkers(INDEX ctWorkers);
+  void StopWorkers(void);
+  // put a job in a deque and wake a worker if needed (FALSE if the deque is full)
+  BOOL Push(const CJob &jb);
+  // try to get a job, from own deque first, then steal from others
+  BOOL Pop(INDEX iThread, CJob &jb);
+  // run one job and mark it done
+  void Execute(INDEX iThread, CJob &jb);
+  // try to run one pending job, returns FALSE if there was nothing to do
+  BOOL RunPending(INDEX iThread);
+  // loop of a worker thread
+  void WorkerLoop(void);
+
+// interface:
+  CJobSystem(void);
+  ~CJobSystem(void);
+
+  // Start a job, counter (if given) is increased now and decreased when it finishes.
+  void Run(JobFunction_t pFunction, void *pvParam, CJobCounter *pjc);
+  // Start jobs for range [0, ctItems) split into pieces of given size.
+  void RunRange(JobRangeFunction_t pFunction, void *pvParam, INDEX ctItems, INDEX ctGrain, CJobCounter *pjc);
+  // Wait for all jobs counted in the counter, running pending jobs meanwhile.
+  void Wait(CJobCounter &jc);
+  // Run range [0, ctItems) in pieces of given size and wait for all of them.
+  void ParallelFor(JobRangeFunction_t pFunction, void *pvParam, INDEX ctItems, INDEX ctGrain);
+
+  // Change number of workers, 0 for automatic (only while no jobs are running).
+  void SetWorkerCount(INDEX ctWorkers);
+  // Get number of threads that run jobs (workers and the waiting thread).
+  INDEX GetThreadCount(void);
+  // Check if jobs are run serially.
+  BOOL IsSerial(void);
+  // Get index of current thread in the job system (0 for non-worker threads).
+  INDEX GetThreadIndex(void);
+
+  // Accumulate job statistics since last call into the jobs profile form.
+  void UpdateProfile(void);
+  // Print statistics of all threads.
+  void PrintStats(void);
+};
+
+// pointer to global job system object
+ENGINE_API extern CJobSystem *_pJobs;
+
+// number of worker threads (0 for one less than there are processors)
+ENGINE_API extern INDEX job_iWorkerThreads;
+// run all jobs serially on the thread that starts them
+ENGINE_API extern INDEX job_bSerial;
+
+
+#endif  /* include-once check. */
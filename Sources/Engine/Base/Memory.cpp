@@ -16,6 +16,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "Engine/StdH.h"
 
 #include <Engine/Base/Memory.h>
+#include <Engine/Base/Allocator.h>
 #include <Engine/Base/Translation.h>
 
 #include <Engine/Base/ErrorReporting.h>
@@ -27,6 +28,13 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <new>
 #endif
 
+#ifdef PLATFORM_WIN32
+#include <psapi.h>
+#pragma comment (lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
 FLOAT _bCheckAllAllocations = FALSE;
 
 #ifdef PLATFORM_WIN32
@@ -91,37 +99,24 @@ CMemHandlerInit::CMemHandlerInit(void)
 
 void *AllocMemory( SLONG memsize )
 {
-  void *pmem;
   ASSERTMSG(memsize>0, "AllocMemory: Block size is less or equal zero.");
   if (_bCheckAllAllocations) {
     _CrtCheckMemory();
   }
-  pmem = malloc( memsize);
-  // memory handler asures no null results here?!
-  if (pmem==NULL) {
-    _CrtCheckMemory();
-    FatalError(TRANS("Not enough memory (%d bytes needed)!"), memsize);
-  }
-  return pmem;
+  // account it to the tag of current scope
+  return AllocMemoryTagged(memsize, GetMemoryTag());
 }
 
 #ifdef _MSC_VER
 #ifndef NDEBUG
 void *_debug_AllocMemory( SLONG memsize, int iType, const char *strFile, int iLine)
 {
-  void *pmem;
   ASSERTMSG(memsize>0, "AllocMemory: Block size is less or equal zero.");
 
   if (_bCheckAllAllocations) {
     _CrtCheckMemory();
   }
-  pmem = _malloc_dbg( memsize, iType, strFile, iLine);
-  // memory handler asures no null results here?!
-  if (pmem==NULL) {
-    _CrtCheckMemory();
-    FatalError(TRANS("Not enough memory (%d bytes needed)!"), memsize);
-  }
-  return pmem;
+  return _debug_AllocMemoryTagged(memsize, GetMemoryTag(), iType, strFile, iLine);
 }
 #endif
 #endif
@@ -142,7 +137,7 @@ void FreeMemoryAligned( void *memory)
 void FreeMemory( void *memory )
 {
   ASSERTMSG(memory!=NULL, "FreeMemory: NULL pointer input.");
-  free( (char *)memory);
+  FreeMemoryTagged(memory);
 }
 
 void ResizeMemory( void **ppv, SLONG slSize )
@@ -150,13 +145,7 @@ void ResizeMemory( void **ppv, SLONG slSize )
   if (_bCheckAllAllocations) {
     _CrtCheckMemory();
   }
-  void *pv = realloc(*ppv, slSize);
-  // memory handler asures no null results here?!
-  if (pv==NULL) {
-    _CrtCheckMemory();
-    FatalError(TRANS("Not enough memory (%d bytes needed)!"), slSize);
-  }
-  *ppv = pv;
+  ResizeMemoryTagged(ppv, slSize);
 }
 
 void GrowMemory( void **ppv, SLONG newSize )
@@ -192,3 +181,29 @@ INDEX FindZero( UBYTE *pubMemory, INDEX iBytes)
   for( INDEX i=0; i<iBytes; i++) if( pubMemory[i]==0) return i;
   return iBytes;
 }
+
+
+/*
+ * Get peak amount of memory used by the process so far (in kilobytes).
+ */
+SLONG GetMemoryHighWaterMark(void)
+{
+#ifdef PLATFORM_WIN32
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+    return 0;
+  }
+  return (SLONG)(pmc.PeakWorkingSetSize/1024);
+#else
+  struct rusage ru;
+  if (getrusage(RUSAGE_SELF, &ru)!=0) {
+    return 0;
+  }
+  #ifdef PLATFORM_MACOSX
+  // darwin reports this one in bytes
+  return (SLONG)(ru.ru_maxrss/1024);
+  #else
+  return (SLONG)ru.ru_maxrss;
+  #endif
+#endif
+}
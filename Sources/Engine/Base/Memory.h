@@ -25,6 +25,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 /* Get amount of free memory in system. */
 ENGINE_API extern SLONG GetFreeMemory( void );
+/* Get peak amount of memory used by the process so far (in kilobytes). */
+ENGINE_API extern SLONG GetMemoryHighWaterMark( void );
 
 /* Allocate a block of memory - fatal error if not enough memory. */
 ENGINE_API extern void *AllocMemory( SLONG memsize );
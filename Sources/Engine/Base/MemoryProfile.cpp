@@ -0,0 +1,39 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/MemoryProfile.h>
+
+// profile form for profiling memory allocations
+CMemoryProfile mpMemoryProfile;
+CProfileForm &_pfMemoryProfile = mpMemoryProfile;
+
+CMemoryProfile::CMemoryProfile(void)
+ : CProfileForm("Memory", "ticks",
+    CMemoryProfile::PCI_COUNT, CMemoryProfile::PTI_COUNT)
+{
+  SETCOUNTERNAME(CMemoryProfile::PCI_GENERAL_ALLOCATIONS, "general allocations");
+  SETCOUNTERNAME(CMemoryProfile::PCI_GENERAL_BYTES,       "general bytes allocated");
+  SETCOUNTERNAME(CMemoryProfile::PCI_WORLD_ALLOCATIONS,   "world allocations");
+  SETCOUNTERNAME(CMemoryProfile::PCI_WORLD_BYTES,         "world bytes allocated");
+  SETCOUNTERNAME(CMemoryProfile::PCI_NETWORK_ALLOCATIONS, "network allocations");
+  SETCOUNTERNAME(CMemoryProfile::PCI_NETWORK_BYTES,       "network bytes allocated");
+  SETCOUNTERNAME(CMemoryProfile::PCI_SOUND_ALLOCATIONS,   "sound allocations");
+  SETCOUNTERNAME(CMemoryProfile::PCI_SOUND_BYTES,         "sound bytes allocated");
+  SETCOUNTERNAME(CMemoryProfile::PCI_STOCK_ALLOCATIONS,   "stock allocations");
+  SETCOUNTERNAME(CMemoryProfile::PCI_STOCK_BYTES,         "stock bytes allocated");
+  SETCOUNTERNAME(CMemoryProfile::PCI_POOLED_ALLOCATIONS,  "pooled allocations");
+}
@@ -0,0 +1,53 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_MEMORYPROFILE_H
+#define SE_INCL_MEMORYPROFILE_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#ifndef __ENGINE_BASE_PROFILING_H__
+#include <Engine/Base/Profiling.h>
+#endif
+
+/* Class for holding profiling information for memory allocations. */
+class CMemoryProfile : public CProfileForm {
+public:
+  // indices for profiling counters and timers
+  enum ProfileTimerIndex {
+    PTI_COUNT
+  };
+  // per tag pairs of counters, in order of MemoryTag
+  enum ProfileCounterIndex {
+    PCI_GENERAL_ALLOCATIONS, // blocks allocated under general tag
+    PCI_GENERAL_BYTES,       // bytes allocated under general tag
+    PCI_WORLD_ALLOCATIONS,   // blocks allocated under world tag
+    PCI_WORLD_BYTES,         // bytes allocated under world tag
+    PCI_NETWORK_ALLOCATIONS, // blocks allocated under network tag
+    PCI_NETWORK_BYTES,       // bytes allocated under network tag
+    PCI_SOUND_ALLOCATIONS,   // blocks allocated under sound tag
+    PCI_SOUND_BYTES,         // bytes allocated under sound tag
+    PCI_STOCK_ALLOCATIONS,   // blocks allocated under stock tag
+    PCI_STOCK_BYTES,         // bytes allocated under stock tag
+    PCI_POOLED_ALLOCATIONS,  // blocks served from size-class pools
+    PCI_COUNT
+  };
+  // constructor
+  CMemoryProfile(void);
+};
+
+#endif  // include-once blocker.
+
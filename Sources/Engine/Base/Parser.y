@@ -74,6 +74,9 @@ void Declaration(
   ULONG ulQualifiers, INDEX istType, CShellSymbol &ssNew,
   INDEX (*pPreFunc)(INDEX), void (*pPostFunc)(INDEX))
 {
+  // invalidate compiled commands
+  _shell_ulDeclarations++;
+
   // if external
   if (ulQualifiers&SSF_EXTERNAL) {
     // get it a new value
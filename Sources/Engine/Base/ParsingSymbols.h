@@ -54,6 +54,8 @@ extern CDynamicStackArray<FLOAT> _shell_afExtFloats;
 // all types are allocated here
 extern CAllocationArray<ShellType> _shell_ast;
 extern INDEX _shell_istUndeclared;
+// incremented on each declaration, so that compiled commands know when to recompile
+extern ULONG _shell_ulDeclarations;
 
 // make a new type for a basic type
 INDEX ShellTypeNewVoid(void);
@@ -16,15 +16,18 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "Engine/StdH.h"
 
 #include <Engine/Base/Profiling.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/Threading.h>
+#include <Engine/Math/Functions.h>
 
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 template class CStaticArray<CProfileCounter>;
 template class CStaticArray<CProfileTimer>;
 
-#if (defined PLATFORM_UNIX) && !defined(__GNU_INLINE_X86_32__)
-#include <sys/time.h>
-#endif
-
 static inline __int64 ReadTSC_profile(void)
 {
 #if (defined __MSVC_INLINE__)
@@ -49,15 +52,8 @@ static inline __int64 ReadTSC_profile(void)
   return(mmRet);
 
 #else
-  #ifdef __arm__
-  struct timespec tv;
-  clock_gettime(CLOCK_MONOTONIC, &tv);
-  return( (((__int64) tv.tv_sec) * 1000) + (((__int64) tv.tv_nsec) / 1000000) );
-  #else
-  struct timeval tv;
-  gettimeofday(&tv, NULL);
-  return( (((__int64) tv.tv_sec) * 1000) + (((__int64) tv.tv_usec) / 1000) );
-  #endif
+  // must tick at the same rate as the high precision timer, for GetSeconds() to work
+  return _pTimer->GetHighPrecisionTimer().tv_llValue;
 
 #endif
 }
@@ -75,6 +71,23 @@ CTimerValue _tvStartStopEpsilon;
 // total sum of all timing offsets induced by all Starts and Stops so far
 CTimerValue _tvCurrentProfilingEpsilon;
 
+// set while timers are measured in builds without TIMER_PROFILING
+BOOL _bProfilingActive = FALSE;
+
+// set/test profiling activation flag
+void CProfileForm::SetProfilingActive(BOOL bActive)
+{
+  _bProfilingActive = bActive;
+}
+BOOL CProfileForm::GetProfilingActive(void)
+{
+#if TIMER_PROFILING
+  return TRUE;
+#else
+  return _bProfilingActive;
+#endif
+}
+
 // Measure profiling errors and set epsilon corrections.
 static CTimerValue _tvTest;
 void CProfileForm::CalibrateProfilingTimers(void)
@@ -409,3 +422,249 @@ void CProfileForm::Report(CTString &strReport)
   // return the buffer
   strReport = aBuffer;
 }
+
+
+/////////////////////////////////////////////////////////////////////
+// Profiling trace
+//
+// Each thread records timer and counter events into its own ring buffer,
+// so recording needs no locking. Only the dump reads all buffers, and it
+// pauses recording and waits for events being written before it does.
+
+#define PROFILETRACE_EVENTS     65536   // events per thread (must be power of 2)
+#define PROFILETRACE_MAXTHREADS 32
+
+INDEX prf_bTrace = FALSE;
+
+struct ProfileTraceEvent_t {
+  __int64 pte_llTime;       // high precision timer value
+  CProfileForm *pte_ppf;    // form of the timer or counter (NULL for frames)
+  INDEX pte_iType;          // event type
+  INDEX pte_iIndex;         // timer or counter index
+  INDEX pte_iValue;         // counter increment
+};
+
+struct ProfileTraceBuffer {
+  ULONG ptb_ulThreadID;
+  volatile SLONG ptb_slWritten;   // total number of events written
+  volatile SLONG ptb_bWriting;    // set while an event is being written
+  ProfileTraceEvent_t ptb_apte[PROFILETRACE_EVENTS];
+};
+
+static ProfileTraceBuffer *_aptbThreads[PROFILETRACE_MAXTHREADS];
+static volatile SLONG _ctTraceThreads = 0;
+static volatile SLONG _bTraceDumping = FALSE;  // no events are recorded while set
+static THREAD_LOCAL ProfileTraceBuffer *_ptbThisThread = NULL;
+static THREAD_LOCAL BOOL _bTraceThreadFull = FALSE;
+
+// get trace buffer of current thread, creating it on first use
+static ProfileTraceBuffer *GetThreadTraceBuffer(void)
+{
+  if (_ptbThisThread!=NULL || _bTraceThreadFull) {
+    return _ptbThisThread;
+  }
+  const SLONG iThread = AtomicAdd(&_ctTraceThreads, 1)-1;
+  if (iThread>=PROFILETRACE_MAXTHREADS) {
+    // too many threads, this one is not traced
+    _bTraceThreadFull = TRUE;
+    return NULL;
+  }
+  ProfileTraceBuffer *ptb = (ProfileTraceBuffer *)AllocMemory(sizeof(ProfileTraceBuffer));
+  ptb->ptb_ulThreadID = ThreadGetID();
+  ptb->ptb_slWritten = 0;
+  ptb->ptb_bWriting = FALSE;
+  _ptbThisThread = ptb;
+  AtomicFence();
+  _aptbThreads[iThread] = ptb;
+  return ptb;
+}
+
+// Record one event in the trace buffer of current thread.
+void ProfileTraceEvent(CProfileForm *ppf, INDEX iType, INDEX iIndex, INDEX iValue)
+{
+  ProfileTraceBuffer *ptb = GetThreadTraceBuffer();
+  if (ptb==NULL || _pTimer==NULL) {
+    return;
+  }
+  // mark the buffer as being written before checking for the dump (full fence in between)
+  AtomicExchange(&ptb->ptb_bWriting, TRUE);
+  if (AtomicLoad(&_bTraceDumping)) {
+    AtomicStore(&ptb->ptb_bWriting, FALSE);
+    return;
+  }
+  const SLONG slWritten = ptb->ptb_slWritten;
+  ProfileTraceEvent_t &pte = ptb->ptb_apte[slWritten&(PROFILETRACE_EVENTS-1)];
+  pte.pte_llTime = _pTimer->GetHighPrecisionTimer().tv_llValue;
+  pte.pte_ppf = ppf;
+  pte.pte_iType = iType;
+  pte.pte_iIndex = iIndex;
+  pte.pte_iValue = iValue;
+  AtomicStore(&ptb->ptb_slWritten, slWritten+1);
+  AtomicStore(&ptb->ptb_bWriting, FALSE);
+}
+
+// Mark start of a new frame in the trace.
+void ProfileTraceFrame(void)
+{
+  if (prf_bTrace) {
+    ProfileTraceEvent(NULL, PTE_FRAME, 0, 0);
+  }
+}
+
+// cumulative value of one counter while dumping
+struct ProfileTraceCounter {
+  CProfileForm *ptc_ppf;
+  INDEX ptc_iCounter;
+  SLONG ptc_slValue;
+};
+
+static int qsort_CompareTimes(const void *pv0, const void *pv1)
+{
+  const __int64 ll0 = *(const __int64 *)pv0;
+  const __int64 ll1 = *(const __int64 *)pv1;
+  if (ll0<ll1) return -1;
+  if (ll0>ll1) return +1;
+  return 0;
+}
+
+// write last frames from trace buffers of given number of threads, returns number of events written
+static INDEX WriteTrace_t(const CTFileName &fnmTrace, INDEX ctFrames, INDEX ctThreads) // throw char *
+{
+  // find when the requested number of last frames started
+  CStaticStackArray<__int64> allFrames;
+  for (INDEX iThread=0; iThread<ctThreads; iThread++) {
+    ProfileTraceBuffer *ptb = _aptbThreads[iThread];
+    if (ptb==NULL) continue;
+    const SLONG slWritten = ptb->ptb_slWritten;
+    for (SLONG sl=Max(slWritten-PROFILETRACE_EVENTS, 0); sl<slWritten; sl++) {
+      const ProfileTraceEvent_t &pte = ptb->ptb_apte[sl&(PROFILETRACE_EVENTS-1)];
+      if (pte.pte_iType==PTE_FRAME) {
+        allFrames.Push() = pte.pte_llTime;
+      }
+    }
+  }
+  __int64 llFrom = 0;
+  if (ctFrames>0 && allFrames.Count()>ctFrames) {
+    qsort(&allFrames[0], allFrames.Count(), sizeof(__int64), qsort_CompareTimes);
+    llFrom = allFrames[allFrames.Count()-ctFrames];
+  }
+  const __int64 llFrequency = _pTimer->tm_llPerformanceCounterFrequency;
+
+  CTFileStream strm;
+  strm.Create_t(fnmTrace, CTStream::CM_TEXT);
+  strm.FPrintF_t("{\"traceEvents\":[\n");
+  BOOL bFirst = TRUE;
+  INDEX ctEvents = 0;
+  CStaticStackArray<ProfileTraceCounter> aptc;
+
+  for (INDEX iThread=0; iThread<ctThreads; iThread++) {
+    ProfileTraceBuffer *ptb = _aptbThreads[iThread];
+    if (ptb==NULL) continue;
+    const SLONG slWritten = ptb->ptb_slWritten;
+    INDEX ctOpen = 0;   // number of begun timers (skip ends without a begin)
+    // name the thread
+    strm.FPrintF_t("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %08X\"}}\n",
+      bFirst ? "" : ",", iThread, ptb->ptb_ulThreadID);
+    bFirst = FALSE;
+    for (SLONG sl=Max(slWritten-PROFILETRACE_EVENTS, 0); sl<slWritten; sl++) {
+      const ProfileTraceEvent_t &pte = ptb->ptb_apte[sl&(PROFILETRACE_EVENTS-1)];
+      if (pte.pte_llTime<llFrom) {
+        continue;
+      }
+      const DOUBLE dMicroSeconds = (DOUBLE)pte.pte_llTime*1E6/llFrequency;
+      CTString strEvent;
+      switch (pte.pte_iType) {
+      case PTE_BEGIN:
+        ctOpen++;
+        strEvent.PrintF("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+          (const char *)pte.pte_ppf->GetTimerName(pte.pte_iIndex), (const char *)pte.pte_ppf->pf_strTitle,
+          dMicroSeconds, iThread);
+        break;
+      case PTE_END:
+        if (ctOpen==0) {
+          continue;
+        }
+        ctOpen--;
+        strEvent.PrintF("{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}", dMicroSeconds, iThread);
+        break;
+      case PTE_COUNTER: {
+        // find the counter and accumulate it
+        ProfileTraceCounter *pptc = NULL;
+        for (INDEX i=0; i<aptc.Count(); i++) {
+          if (aptc[i].ptc_ppf==pte.pte_ppf && aptc[i].ptc_iCounter==pte.pte_iIndex) {
+            pptc = &aptc[i];
+            break;
+          }
+        }
+        if (pptc==NULL) {
+          pptc = &aptc.Push();
+          pptc->ptc_ppf = pte.pte_ppf;
+          pptc->ptc_iCounter = pte.pte_iIndex;
+          pptc->ptc_slValue = 0;
+        }
+        pptc->ptc_slValue += pte.pte_iValue;
+        strEvent.PrintF("{\"name\":\"%s: %s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"value\":%d}}",
+          (const char *)pte.pte_ppf->pf_strTitle, (const char *)pte.pte_ppf->GetCounterName(pte.pte_iIndex),
+          dMicroSeconds, pptc->ptc_slValue);
+                        } break;
+      case PTE_FRAME:
+        strEvent.PrintF("{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+          dMicroSeconds, iThread);
+        break;
+      default:
+        continue;
+      }
+      strm.FPrintF_t("%s%s\n", bFirst ? "" : ",", (const char *)strEvent);
+      bFirst = FALSE;
+      ctEvents++;
+    }
+  }
+  strm.FPrintF_t("]}\n");
+  strm.Close();
+  return ctEvents;
+}
+
+// Write last frames of the trace to a file in Chrome trace (JSON) format.
+void ProfileTraceDump_t(const CTFileName &fnmTrace, INDEX ctFrames) // throw char *
+{
+  // stop recording and wait for events that are being written
+  const INDEX bWasTracing = prf_bTrace;
+  prf_bTrace = FALSE;
+  AtomicExchange(&_bTraceDumping, TRUE);
+  const INDEX ctThreads = ClampUp((INDEX)AtomicLoad(&_ctTraceThreads), (INDEX)PROFILETRACE_MAXTHREADS);
+  for (INDEX iThread=0; iThread<ctThreads; iThread++) {
+    ProfileTraceBuffer *ptb = _aptbThreads[iThread];
+    while (ptb!=NULL && AtomicLoad(&ptb->ptb_bWriting)) {
+      ThreadYield();
+    }
+  }
+
+  INDEX ctEvents = 0;
+  try {
+    ctEvents = WriteTrace_t(fnmTrace, ctFrames, ctThreads);
+  } catch (char *) {
+    // continue recording even if the trace could not be written
+    AtomicStore(&_bTraceDumping, FALSE);
+    prf_bTrace = bWasTracing;
+    throw;
+  }
+  AtomicStore(&_bTraceDumping, FALSE);
+  prf_bTrace = bWasTracing;
+  CPrintF(TRANS("Profiling trace: %d events from %d threads written to '%s'\n"),
+    ctEvents, ctThreads, (const char *)fnmTrace);
+}
+
+// console command for dumping the trace
+void DumpProfileTrace(void *pArgs)
+{
+  CTString strFile = *NEXTARGUMENT(CTString*);
+  INDEX ctFrames = NEXTARGUMENT(INDEX);
+  if (strFile=="") {
+    strFile = "Temp\\ProfileTrace.json";
+  }
+  try {
+    ProfileTraceDump_t(strFile, ctFrames);
+  } catch (char *strError) {
+    CPrintF(TRANS("Cannot dump profiling trace: %s\n"), strError);
+  }
+}
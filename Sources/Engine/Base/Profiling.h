@@ -60,6 +60,25 @@ private:
 // this file just defines TIMER_PROFILING as 1 or 0
 #include <Engine/Base/ProfilingEnabled.h>
 
+// types of events in profiling trace
+enum ProfileTraceEventType {
+  PTE_BEGIN,    // timer started
+  PTE_END,      // timer stopped
+  PTE_COUNTER,  // counter incremented
+  PTE_FRAME,    // new frame started
+};
+
+// set while profiling trace is being recorded
+extern INDEX prf_bTrace;
+// set while timers are measured in builds without TIMER_PROFILING
+extern BOOL _bProfilingActive;
+// Record one event in the trace buffer of current thread.
+void ProfileTraceEvent(class CProfileForm *ppf, INDEX iType, INDEX iIndex, INDEX iValue);
+// Mark start of a new frame in the trace.
+ENGINE_API void ProfileTraceFrame(void);
+// Write last frames of the trace to a file in Chrome trace (JSON) format.
+void ProfileTraceDump_t(const CTFileName &fnmTrace, INDEX ctFrames); // throw char *
+
 #endif //ENGINE_INTERNAL
 
 /*
@@ -99,10 +118,6 @@ public:
     INDEX ctCounters, INDEX ctTimers);
   void Clear(void);
 
-  // set/test profiling activation flag
-  static void SetProfilingActive(BOOL bActive);
-  static BOOL GetProfilingActive(void);
-
   // Measure profiling errors and set epsilon corrections.
   static void CalibrateProfilingTimers(void);
 
@@ -114,6 +129,7 @@ public:
   /* Increment counter by given count. */
   inline void IncrementCounter(INDEX iCounter, INDEX ctAdd=1) {
     pf_apcCounters[iCounter].pc_ctCount += ctAdd;
+    if (prf_bTrace) ProfileTraceEvent(this, PTE_COUNTER, iCounter, ctAdd);
   };
   /* Get current value of a counter. */
   INDEX GetCounterCount(INDEX iCounter);
@@ -124,11 +140,13 @@ public:
 #if TIMER_PROFILING
   /* Start a timer. */
   inline void StartTimer(INDEX iTimer) {
+    if (prf_bTrace) ProfileTraceEvent(this, PTE_BEGIN, iTimer, 0);
     StartTimer_internal(iTimer);
   };
   /* Stop a timer. */
   inline void StopTimer(INDEX iTimer) {
     StopTimer_internal(iTimer);
+    if (prf_bTrace) ProfileTraceEvent(this, PTE_END, iTimer, 0);
   };
   /* Increment averaging counter for a timer by given count. */
   inline void IncrementTimerAveragingCounter(INDEX iTimer, INDEX ctAdd=1) {
@@ -149,13 +167,30 @@ public:
   #define SETTIMERNAME(a,b,c) SetTimerName_internal(a,b,c)
 
 #else //TIMER_PROFILING
-  inline void StartTimer(INDEX iTimer) {};
-  inline void StopTimer(INDEX iTimer) {};
-  inline void IncrementTimerAveragingCounter(INDEX iTimer, INDEX ctAdd=1) {};
-  inline void SetCounterName_internal(INDEX iCounter, const CTString &strName) {};
-  inline void SetTimerName_internal(INDEX iTimer, const CTString &strName, const CTString &strAveragingName) {};
-  #define SETCOUNTERNAME(a,b) SetCounterName_internal(a,"")
-  #define SETTIMERNAME(a,b,c) SetTimerName_internal(a,"","")
+  // timers are measured only while profiling is activated, but they can always be traced
+  inline void StartTimer(INDEX iTimer) {
+    if (prf_bTrace) ProfileTraceEvent(this, PTE_BEGIN, iTimer, 0);
+    if (_bProfilingActive) StartTimer_internal(iTimer);
+  };
+  inline void StopTimer(INDEX iTimer) {
+    if (_bProfilingActive) StopTimer_internal(iTimer);
+    if (prf_bTrace) ProfileTraceEvent(this, PTE_END, iTimer, 0);
+  };
+  inline void IncrementTimerAveragingCounter(INDEX iTimer, INDEX ctAdd=1) {
+    pf_aptTimers[iTimer].pt_ctAveraging += ctAdd;
+  };
+  // names are kept for the trace and for activated profiling
+  void SetCounterName_internal(INDEX iCounter, const CTString &strName)
+  {
+    pf_apcCounters[iCounter].pc_strName = strName;
+  }
+  void SetTimerName_internal(INDEX iTimer, const CTString &strName, const CTString &strAveragingName)
+  {
+    pf_aptTimers[iTimer].pt_strName = strName;
+    pf_aptTimers[iTimer].pt_strAveragingName = strAveragingName;
+  }
+  #define SETCOUNTERNAME(a,b) SetCounterName_internal(a,b)
+  #define SETTIMERNAME(a,b,c) SetTimerName_internal(a,b,c)
 #endif
 
   /* Get current value of a timer in seconds or in percentage of module time. */
@@ -190,6 +225,12 @@ public:
   /* Reset all profiling values. */
   ENGINE_API void  Reset(void);
 
+  /* Set/test profiling activation flag (measures timers even without TIMER_PROFILING).
+   * NOTE: must be changed only while no timers are running (i.e. between frames)!
+   */
+  ENGINE_API static void SetProfilingActive(BOOL bActive);
+  ENGINE_API static BOOL GetProfilingActive(void);
+
   /* Report profiling results. */
   ENGINE_API void Report(CTString &strReport);
 };
@@ -208,6 +249,10 @@ ENGINE_API extern CProfileForm &_pfRenderProfile;
 ENGINE_API extern CProfileForm &_pfWorldEditingProfile;
 // profile form for profiling phisics
 ENGINE_API extern CProfileForm &_pfPhysicsProfile;
+// profile form for profiling memory allocations
+ENGINE_API extern CProfileForm &_pfMemoryProfile;
+// profile form for profiling the job system
+ENGINE_API extern CProfileForm &_pfJobProfile;
 
 
 #endif  /* include-once check. */
@@ -0,0 +1,179 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/BenchmarkUtil.h>
+#include <Engine/Base/Relations.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/ListIterator.inl>
+#include <Engine/Templates/StaticArray.cpp>
+
+// stand-ins for sectors and entities, related like bsc_rsEntities and en_rdSectors
+class CBenchmarkSector {
+public:
+  CRelationSrc bs_rsEntities;
+  CRelationLnk *bs_prlLink;
+  INDEX bs_iValue;
+  CBenchmarkSector(void) { bs_prlLink = NULL; bs_iValue = 0; };
+};
+class CBenchmarkEntity {
+public:
+  CRelationDst be_rdSectors;
+  INDEX be_iValue;
+  INDEX be_iFirstSector;  // entity is in this and following sectors
+  CBenchmarkEntity(void) { be_iValue = 1; be_iFirstSector = 0; };
+};
+
+#define SECTORS_PER_ENTITY 3
+
+// move entities to neighbouring sectors in a repeatable order
+static void MoveEntities(CStaticArray<CBenchmarkEntity> &aben, INDEX ctSectors, CBenchmarkRandom &rnd)
+{
+  for (INDEX i=0; i<aben.Count(); i++) {
+    // most entities stay where they are, some move one sector
+    const INDEX iMove = (rnd.Next()%4==0) ? 1 : 0;
+    aben[i].be_iFirstSector = (aben[i].be_iFirstSector+iMove)%(ctSectors-SECTORS_PER_ENTITY);
+  }
+}
+
+// time linking, relinking and iterating of entity-sector style relations
+void RelationBenchmark(void *pArgs)
+{
+  INDEX ctEntities = NEXTARGUMENT(INDEX);
+  ctEntities = Clamp(ctEntities, (INDEX)100, (INDEX)200000);
+  const INDEX ctSectors = Max(ctEntities/16, (INDEX)16);
+  const INDEX ctLinks = ctEntities*SECTORS_PER_ENTITY;
+  CPrintF("Relation benchmark with %d entities in %d sectors:\n", ctEntities, ctSectors);
+  CBenchmarkTimer bt;
+
+  CStaticArray<CBenchmarkSector> absc;
+  CStaticArray<CBenchmarkEntity> aben;
+  absc.New(ctSectors);
+  aben.New(ctEntities);
+  CBenchmarkRandom rnd;
+  for (INDEX i=0; i<ctEntities; i++) {
+    aben[i].be_iFirstSector = rnd.Next()%(ctSectors-SECTORS_PER_ENTITY);
+  }
+  INDEX iSum = 0;
+
+  // link all entities
+  bt.Start();
+  for (INDEX i=0; i<ctEntities; i++) {
+    CBenchmarkEntity &ben = aben[i];
+    for (INDEX iSector=0; iSector<SECTORS_PER_ENTITY; iSector++) {
+      AddRelationPairTailTail(absc[ben.be_iFirstSector+iSector].bs_rsEntities, ben.be_rdSectors);
+    }
+  }
+  bt.Print("link", ctLinks);
+
+  // iterate entities of all sectors, as collision and rendering do
+  bt.Start();
+  const INDEX ctIterations = 10;
+  for (INDEX iIteration=0; iIteration<ctIterations; iIteration++) {
+    for (INDEX iSector=0; iSector<ctSectors; iSector++) {
+      {FOREACHDSTOFSRC(absc[iSector].bs_rsEntities, CBenchmarkEntity, be_rdSectors, pben)
+        iSum += pben->be_iValue;
+      ENDFOR}
+    }
+  }
+  bt.Print("iterate sector entities", ctLinks*ctIterations);
+
+  // iterate sectors of all entities
+  bt.Start();
+  for (INDEX iIteration=0; iIteration<ctIterations; iIteration++) {
+    for (INDEX i=0; i<ctEntities; i++) {
+      {FOREACHSRCOFDST(aben[i].be_rdSectors, CBenchmarkSector, bs_rsEntities, pbsc)
+        iSum += pbsc->bs_iValue;
+      ENDFOR}
+    }
+  }
+  bt.Print("iterate entity sectors", ctLinks*ctIterations);
+
+  // relink by clearing and adding again
+  MoveEntities(aben, ctSectors, rnd);
+  bt.Start();
+  for (INDEX i=0; i<ctEntities; i++) {
+    CBenchmarkEntity &ben = aben[i];
+    ben.be_rdSectors.Clear();
+    for (INDEX iSector=0; iSector<SECTORS_PER_ENTITY; iSector++) {
+      AddRelationPairTailTail(absc[ben.be_iFirstSector+iSector].bs_rsEntities, ben.be_rdSectors);
+    }
+  }
+  bt.Print("relink (clear and add)", ctLinks);
+
+  // relink reusing links, as FindSectorsAroundEntity() does
+  MoveEntities(aben, ctSectors, rnd);
+  bt.Start();
+  for (INDEX i=0; i<ctEntities; i++) {
+    CBenchmarkEntity &ben = aben[i];
+    {FOREACHSRCOFDST(ben.be_rdSectors, CBenchmarkSector, bs_rsEntities, pbsc)
+      pbsc->bs_prlLink = pbsc_iter;
+    ENDFOR}
+    for (INDEX iSector=0; iSector<SECTORS_PER_ENTITY; iSector++) {
+      CBenchmarkSector &bsc = absc[ben.be_iFirstSector+iSector];
+      if (bsc.bs_prlLink!=NULL) {
+        MoveRelationPairTailTail(*bsc.bs_prlLink);
+        bsc.bs_prlLink = NULL;
+      } else {
+        AddRelationPairTailTail(bsc.bs_rsEntities, ben.be_rdSectors);
+      }
+    }
+    {FORDELETELIST(CRelationLnk, rl_lnDst, ben.be_rdSectors, itlnk) {
+      CBenchmarkSector *pbsc = SRC(itlnk, CBenchmarkSector, bs_rsEntities);
+      if (pbsc->bs_prlLink==&*itlnk) {
+        pbsc->bs_prlLink = NULL;
+        delete &*itlnk;
+      }
+    }}
+  }
+  bt.Print("relink (reuse links)", ctLinks);
+
+  // check that every entity is still in exactly its sectors
+  BOOL bOk = TRUE;
+  for (INDEX i=0; i<ctEntities; i++) {
+    INDEX iExpected = aben[i].be_iFirstSector;
+    {FOREACHSRCOFDST(aben[i].be_rdSectors, CBenchmarkSector, bs_rsEntities, pbsc)
+      bOk = bOk && pbsc==&absc[iExpected];
+      iExpected++;
+    ENDFOR}
+    bOk = bOk && iExpected==aben[i].be_iFirstSector+SECTORS_PER_ENTITY;
+  }
+
+  INDEX ctUsed, ctAllocated;
+  GetRelationPoolStats(ctUsed, ctAllocated);
+
+  // unlink all
+  bt.Start();
+  for (INDEX i=0; i<ctEntities; i++) {
+    aben[i].be_rdSectors.Clear();
+  }
+  bt.Print("unlink", ctLinks);
+
+  // what a link would cost if it came from the heap
+  bt.Start();
+  for (INDEX i=0; i<ctLinks; i++) {
+    void *pv = AllocMemory(sizeof(CRelationLnk));
+    iSum += *(UBYTE*)&pv;
+    FreeMemory(pv);
+  }
+  bt.Print("heap alloc+free (reference)", ctLinks);
+
+  CPrintF("  link pool: %d used of %d allocated\n", ctUsed, ctAllocated);
+  if (!bOk) {
+    CPrintF("  ERROR: relinking lost or reordered links!\n");
+  }
+  CPrintF("  (checksum %d)\n", iSum);
+}
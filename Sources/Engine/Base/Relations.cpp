@@ -16,9 +16,58 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "Engine/StdH.h"
 
 #include <Engine/Base/Relations.h>
+#include <Engine/Base/Allocator.h>
 
 #include <Engine/Base/ListIterator.inl>
 
+/////////////////////////////////////////////////////////////////////
+// Link pool
+
+/*
+ * Entities relink to sectors on every move, so links are recycled through
+ * a free list instead of going to the heap. They are allocated in blocks,
+ * so links created together also lie together in memory. Relations are only
+ * changed by the main thread, so the pool is not locked.
+ */
+#define RELATIONPOOL_BLOCKSIZE 256
+
+static void *_pvFreeLinks = NULL;   // free links, chained through their first bytes
+static INDEX _ctLinksUsed = 0;
+static INDEX _ctLinksAllocated = 0;
+
+static inline void *AllocLink(void)
+{
+  // if no free links
+  if (_pvFreeLinks==NULL) {
+    // allocate a new block and chain all its links as free (blocks are never freed)
+    UBYTE *pubBlock = (UBYTE*)AllocMemoryTagged(RELATIONPOOL_BLOCKSIZE*sizeof(CRelationLnk), MTG_WORLD);
+    for (INDEX iLink=RELATIONPOOL_BLOCKSIZE-1; iLink>=0; iLink--) {
+      void **ppvLink = (void**)(pubBlock+iLink*sizeof(CRelationLnk));
+      *ppvLink = _pvFreeLinks;
+      _pvFreeLinks = ppvLink;
+    }
+    _ctLinksAllocated += RELATIONPOOL_BLOCKSIZE;
+  }
+  void *pv = _pvFreeLinks;
+  _pvFreeLinks = *(void**)pv;
+  _ctLinksUsed++;
+  return pv;
+}
+
+static inline void FreeLink(void *pv)
+{
+  *(void**)pv = _pvFreeLinks;
+  _pvFreeLinks = pv;
+  _ctLinksUsed--;
+}
+
+// Get number of links in use and allocated in the pool.
+void GetRelationPoolStats(INDEX &ctUsed, INDEX &ctAllocated)
+{
+  ctUsed = _ctLinksUsed;
+  ctAllocated = _ctLinksAllocated;
+}
+
 
 /////////////////////////////////////////////////////////////////////
 // CRelationSrc
@@ -77,6 +126,42 @@ CRelationLnk::~CRelationLnk(void)
   rl_lnDst.Remove();
 }
 
+#ifdef _MSC_VER
+#pragma push_macro("new")
+#undef new
+#endif
+
+void *CRelationLnk::operator new(size_t size)
+{
+  ASSERT(size==sizeof(CRelationLnk));
+  return AllocLink();
+}
+
+void CRelationLnk::operator delete(void *pv)
+{
+  if (pv!=NULL) {
+    FreeLink(pv);
+  }
+}
+
+#ifdef _MSC_VER
+#ifndef NDEBUG
+void *CRelationLnk::operator new(size_t size, int iType, const char *strFile, int iLine)
+{
+  ASSERT(size==sizeof(CRelationLnk));
+  return AllocLink();
+}
+
+void CRelationLnk::operator delete(void *pv, int iType, const char *strFile, int iLine)
+{
+  if (pv!=NULL) {
+    FreeLink(pv);
+  }
+}
+#endif
+#pragma pop_macro("new")
+#endif
+
 // Get the domain member of this pair.
 CRelationSrc &CRelationLnk::GetSrc(void)
 {
@@ -120,3 +205,19 @@ void  AddRelationPairHeadHead(CRelationSrc &rsSrc, CRelationDst &rdDst)
   rsSrc.AddHead(lnk.rl_lnSrc);
   rdDst.AddHead(lnk.rl_lnDst);
 }
+
+// Move an existing link as if it was deleted and added again (reuses the link).
+void MoveRelationPairTailTail(CRelationLnk &lnk)
+{
+  lnk.rl_lnSrc.Remove();
+  lnk.rl_lnDst.Remove();
+  lnk.rl_prsSrc->AddTail(lnk.rl_lnSrc);
+  lnk.rl_prdDst->AddTail(lnk.rl_lnDst);
+}
+void MoveRelationPairHeadHead(CRelationLnk &lnk)
+{
+  lnk.rl_lnSrc.Remove();
+  lnk.rl_lnDst.Remove();
+  lnk.rl_prsSrc->AddHead(lnk.rl_lnSrc);
+  lnk.rl_prdDst->AddHead(lnk.rl_lnDst);
+}
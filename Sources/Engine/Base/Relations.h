@@ -43,6 +43,12 @@ public:
   void Clear(void);
 };
 
+// the debug version of operator new is a macro, don't let it mangle declarations below
+#ifdef _MSC_VER
+#pragma push_macro("new")
+#undef new
+#endif
+
 // Object representing a link between a domain member and a codomain member.
 class CRelationLnk {
 public:
@@ -59,12 +65,30 @@ public:
   ENGINE_API CRelationSrc &GetSrc(void);
   // Get the codomain member of this pair.
   ENGINE_API CRelationDst &GetDst(void);
+  // Links are allocated from a dedicated pool.
+  ENGINE_API void *operator new(size_t size);
+  ENGINE_API void operator delete(void *pv);
+#ifdef _MSC_VER
+#ifndef NDEBUG
+  ENGINE_API void *operator new(size_t size, int iType, const char *strFile, int iLine);
+  ENGINE_API void operator delete(void *pv, int iType, const char *strFile, int iLine);
+#endif
+#endif
 };
 
+#ifdef _MSC_VER
+#pragma pop_macro("new")
+#endif
+
 // Global functions for creating relations.
 void ENGINE_API AddRelationPair(CRelationSrc &rsSrc, CRelationDst &rdDst);
 void ENGINE_API AddRelationPairTailTail(CRelationSrc &rsSrc, CRelationDst &rdDst);
 void ENGINE_API AddRelationPairHeadHead(CRelationSrc &rsSrc, CRelationDst &rdDst);
+// Move an existing link as if it was deleted and added again (reuses the link).
+void ENGINE_API MoveRelationPairTailTail(CRelationLnk &lnk);
+void ENGINE_API MoveRelationPairHeadHead(CRelationLnk &lnk);
+// Get number of links in use and allocated in the pool.
+void ENGINE_API GetRelationPoolStats(INDEX &ctUsed, INDEX &ctAllocated);
 
 // make 'for' construct for walking a list in domain member
 #define FOREACHSRCLINK(head, iter) \
@@ -22,6 +22,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicStackArray.h>
 #include <Engine/Base/Console.h>
 #include <Engine/Base/Stream.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Math/Functions.h>
+#include <Engine/Templates/NameTable_CShellSymbol.h>
 
 #include <Engine/Templates/AllocationArray.cpp>
 #include <Engine/Templates/DynamicArray.cpp>
@@ -38,6 +41,15 @@ void *_pvNextToDeclare=NULL; // != NULL if declaring external symbol defined in
 
 // define console variable for number of last console lines
 INDEX con_iLastLines    = 5;
+extern INDEX con_ctDroppedLines;
+// set to cache simple commands in compiled form instead of parsing them each time
+INDEX sh_bCacheCommands = TRUE;
+
+// incremented on each declaration, so that compiled commands know when to recompile
+ULONG _shell_ulDeclarations = 0;
+
+// nametable for fast finding of symbols by name
+static CNameTable_CShellSymbol _ntSymbols;
 
 extern void yy_switch_to_buffer(YY_BUFFER_STATE);
 
@@ -143,15 +155,279 @@ CTString CShellSymbol::GetCompletionString(void) const
   }
 }
 
+// max number of simple statements in one compiled command
+#define SHELL_MAXCOMMANDOPS 8
+// command cache is flushed when it grows over this
+#define SHELL_MAXCACHEDCOMMANDS 256
+
+// operations that commands can be compiled to
+enum ShellOpType {
+  SOT_SETINDEX,   // assign a constant to an INDEX variable
+  SOT_SETFLOAT,   // assign a constant to a FLOAT variable
+  SOT_CALLVOID,   // call a void function without arguments
+};
+
+struct ShellOp {
+  enum ShellOpType so_sotType;
+  CShellSymbol *so_pss;   // symbol that is assigned or called
+  INDEX so_iValue;        // value to assign
+  FLOAT so_fValue;
+};
+
+// A command string compiled to a list of simple operations.
+class CShellCommand {
+public:
+  CTString sc_strCommand;   // original text of the command
+  BOOL sc_bCompiled;        // set if compiled, otherwise it must be parsed each time
+  INDEX sc_ctOps;
+  ShellOp sc_aso[SHELL_MAXCOMMANDOPS];
+
+  // command text is its name (used for storing in nametable)
+  inline const CTString &GetName(void) const { return sc_strCommand; };
+  void Clear(void)
+  {
+    sc_strCommand.Clear();
+    sc_bCompiled = FALSE;
+    sc_ctOps = 0;
+  }
+};
+
+#define NAMETABLE_CASESENSITIVE 1
+#define TYPE CShellCommand
+#define CNameTable_TYPE CNameTable_CShellCommand
+#define CNameTableSlot_TYPE CNameTableSlot_CShellCommand
+#include <Engine/Templates/NameTable.h>
+#include <Engine/Templates/NameTable.cpp>
+#undef CNameTableSlot_TYPE
+#undef CNameTable_TYPE
+#undef TYPE
+
+static CDynamicStackArray<CShellCommand> _ascCommands;
+static CNameTable_CShellCommand _ntCommands;
+// number of declarations when the cache was last flushed
+static ULONG _ulCommandsDeclarations = 0;
+
+static void FlushCommandCache(void)
+{
+  _ntCommands.Reset();
+  _ascCommands.PopAll();
+  _ulCommandsDeclarations = _shell_ulDeclarations;
+}
+
+static const char *SkipBlanks(const char *pch)
+{
+  while (*pch==' ' || *pch=='\t' || *pch=='\n') {
+    pch++;
+  }
+  return pch;
+}
+
+// check if a type can be called with empty argument list, without a result
+static BOOL IsVoidFunction(INDEX istType)
+{
+  if (_shell_ast[istType].st_sttType!=STT_FUNCTION) {
+    return FALSE;
+  }
+  // make same type that parser makes for an empty argument list
+  INDEX istCall = ShellTypeNewFunction(ShellTypeNewVoid());
+  ShellTypeAddFunctionArgument(istCall, ShellTypeNewVoid());
+  BOOL bSame = ShellTypeIsSame(istCall, istType);
+  ShellTypeDelete(istCall);
+  return bSame;
+}
+
+// Compile a command to simple operations if possible.
+// Only constant assignments to numeric variables and calls of void(void) functions
+// are compiled, everything else (returns FALSE) goes through the parser.
+static BOOL CompileCommand(CShellCommand &sc)
+{
+  sc.sc_ctOps = 0;
+  const char *pch = SkipBlanks(sc.sc_strCommand);
+  while (*pch!=0) {
+    // skip empty statements
+    if (*pch==';') {
+      pch = SkipBlanks(pch+1);
+      continue;
+    }
+    if (sc.sc_ctOps>=SHELL_MAXCOMMANDOPS) {
+      return FALSE;
+    }
+
+    // statement must begin with a name of a declared symbol
+    if (!isalpha(*pch) && *pch!='_') {
+      return FALSE;
+    }
+    char strName[256];
+    INDEX ctName = 0;
+    while ((isalnum(*pch) || *pch=='_') && ctName<(INDEX)sizeof(strName)-1) {
+      strName[ctName++] = *pch++;
+    }
+    strName[ctName] = 0;
+    if (isalnum(*pch) || *pch=='_') {
+      return FALSE;
+    }
+    CShellSymbol *pss = _pShell->GetSymbol(strName, TRUE);
+    if (pss==NULL || !pss->IsDeclared()) {
+      return FALSE;
+    }
+    ShellOp &so = sc.sc_aso[sc.sc_ctOps];
+    so.so_pss = pss;
+    const ShellTypeType stt = _shell_ast[pss->ss_istType].st_sttType;
+
+    pch = SkipBlanks(pch);
+    // if function call
+    if (*pch=='(') {
+      pch = SkipBlanks(pch+1);
+      if (*pch!=')' || !IsVoidFunction(pss->ss_istType)) {
+        return FALSE;
+      }
+      pch++;
+      so.so_sotType = SOT_CALLVOID;
+
+    // if assignment
+    } else if (*pch=='=' && pch[1]!='=') {
+      if ((stt!=STT_INDEX && stt!=STT_FLOAT) || (pss->ss_ulFlags&SSF_CONSTANT)) {
+        return FALSE;
+      }
+      pch = SkipBlanks(pch+1);
+      BOOL bNegative = FALSE;
+      if (*pch=='-') {
+        bNegative = TRUE;
+        pch = SkipBlanks(pch+1);
+      }
+      // read a decimal number the same way the scanner would
+      if (!isdigit(*pch)) {
+        return FALSE;
+      }
+      const char *pchNumber = pch;
+      while (isdigit(*pch)) {
+        pch++;
+      }
+      BOOL bFloat = FALSE;
+      if (*pch=='.') {
+        bFloat = TRUE;
+        pch++;
+        while (isdigit(*pch)) {
+          pch++;
+        }
+        if (*pch=='f' || *pch=='F') {
+          pch++;
+        }
+      }
+      // hex numbers, exponents and such are left to the parser
+      if (isalnum(*pch) || *pch=='_' || *pch=='.') {
+        return FALSE;
+      }
+      if (stt==STT_INDEX && !bFloat) {
+        so.so_sotType = SOT_SETINDEX;
+        so.so_iValue = atoi(pchNumber);
+        if (bNegative) {
+          so.so_iValue = -so.so_iValue;
+        }
+      } else if (stt==STT_FLOAT) {
+        so.so_sotType = SOT_SETFLOAT;
+        so.so_fValue = bFloat ? (FLOAT)atof(pchNumber) : (FLOAT)atoi(pchNumber);
+        if (bNegative) {
+          so.so_fValue = -so.so_fValue;
+        }
+      } else {
+        return FALSE;
+      }
+
+    // anything else needs parsing
+    } else {
+      return FALSE;
+    }
+
+    // statement must be terminated
+    pch = SkipBlanks(pch);
+    if (*pch!=';') {
+      return FALSE;
+    }
+    pch = SkipBlanks(pch+1);
+    sc.sc_ctOps++;
+  }
+  return TRUE;
+}
+
+// execute compiled operations with same semantics as the parser
+static void ExecuteCompiled(const ShellOp *aso, INDEX ctOps)
+{
+  for (INDEX iOp=0; iOp<ctOps; iOp++) {
+    const ShellOp &so = aso[iOp];
+    CShellSymbol &ss = *so.so_pss;
+    if (so.so_sotType==SOT_CALLVOID) {
+#ifdef PLATFORM_WIN32
+      ((void (*)(void))ss.ss_pvValue)();
+#else
+      ((void (*)(void*, void*, void*, void*, void*))ss.ss_pvValue)(NULL, NULL, NULL, NULL, NULL);
+#endif
+    } else {
+      // if it can be changed
+      if (ss.ss_pPreFunc==NULL || ss.ss_pPreFunc(ss.ss_pvValue)) {
+        if (so.so_sotType==SOT_SETINDEX) {
+          *(INDEX*)ss.ss_pvValue = so.so_iValue;
+        } else {
+          *(FLOAT*)ss.ss_pvValue = so.so_fValue;
+        }
+        // call post-change function
+        if (ss.ss_pPostFunc!=NULL) {
+          ss.ss_pPostFunc(ss.ss_pvValue);
+        }
+      }
+    }
+  }
+}
+
+// try to execute a command from the cache, returns FALSE if it must be parsed
+static BOOL ExecuteCachedCommand(const CTString &strCommand)
+{
+  // if anything was declared since the cache was filled, compiled commands may be stale
+  if (_ulCommandsDeclarations!=_shell_ulDeclarations) {
+    FlushCommandCache();
+  }
+
+  // find the command, or compile it if not found
+  CShellCommand *psc = _ntCommands.Find(strCommand);
+  if (psc==NULL) {
+    if (_ascCommands.Count()>=SHELL_MAXCACHEDCOMMANDS) {
+      FlushCommandCache();
+    }
+    psc = &_ascCommands.Push();
+    psc->Clear();
+    psc->sc_strCommand = strCommand;
+    psc->sc_bCompiled = CompileCommand(*psc);
+    _ntCommands.Add(psc);
+  }
+  if (!psc->sc_bCompiled) {
+    return FALSE;
+  }
+
+  // copy the operations, since called functions might flush the cache
+  ShellOp aso[SHELL_MAXCOMMANDOPS];
+  const INDEX ctOps = psc->sc_ctOps;
+  memcpy(aso, psc->sc_aso, ctOps*sizeof(ShellOp));
+  ExecuteCompiled(aso, ctOps);
+  return TRUE;
+}
+
 // Constructor.
 CShell::CShell(void)
 {
   // allocate undefined symbol
   _shell_istUndeclared = _shell_ast.Allocate();
   pwoCurrentWorld = NULL;
+  // prepare nametables for symbols and compiled commands
+  _ntSymbols.Clear();
+  _ntSymbols.SetAllocationParameters(512, 4, 4);
+  _ntCommands.Clear();
+  _ntCommands.SetAllocationParameters(64, 4, 4);
 };
 CShell::~CShell(void)
 {
+  FlushCommandCache();
+  _ntCommands.Clear();
+  _ntSymbols.Clear();
   _shell_astrExtStrings.Clear();
   _shell_afExtFloats.Clear();
 };
@@ -391,6 +667,66 @@ static void ListSymbols(void)
   ListSymbolsByPattern("*");
 }
 
+// Measure speed of symbol lookup and command execution.
+static void ShellBenchmark(void* pArgs)
+{
+  INDEX ctIterations = NEXTARGUMENT(INDEX);
+  ctIterations = ClampDn(ctIterations, (INDEX)1);
+
+  // gather names of all symbols
+  CDynamicStackArray<CTString> astrNames;
+  {FOREACHINDYNAMICARRAY(_pShell->sh_assSymbols, CShellSymbol, itss) {
+    astrNames.Push() = itss->ss_strName;
+  }}
+  const INDEX ctNames = astrNames.Count();
+  if (ctNames==0) {
+    return;
+  }
+  INDEX ctFound = 0;
+
+  // lookup by linear search through all symbols (the old way)
+  CTimerValue tv0 = _pTimer->GetHighPrecisionTimer();
+  for (INDEX iIter=0; iIter<ctIterations; iIter++) {
+    const CTString &strName = astrNames[iIter%ctNames];
+    FOREACHINDYNAMICARRAY(_pShell->sh_assSymbols, CShellSymbol, itss) {
+      if (itss->ss_strName==strName) {
+        ctFound++;
+        break;
+      }
+    }
+  }
+  CTimerValue tv1 = _pTimer->GetHighPrecisionTimer();
+  // lookup through the nametable
+  for (INDEX iIter=0; iIter<ctIterations; iIter++) {
+    if (_pShell->GetSymbol(astrNames[iIter%ctNames], TRUE)!=NULL) {
+      ctFound++;
+    }
+  }
+  CTimerValue tv2 = _pTimer->GetHighPrecisionTimer();
+
+  // execute a simple command through the parser and through the cache
+  const INDEX bOldCache = sh_bCacheCommands;
+  const CTString strCommand = "tmp_i=1; tmp_fAdd=-0.5;";
+  sh_bCacheCommands = FALSE;
+  for (INDEX iIter=0; iIter<ctIterations; iIter++) {
+    _pShell->Execute(strCommand);
+  }
+  CTimerValue tv3 = _pTimer->GetHighPrecisionTimer();
+  sh_bCacheCommands = TRUE;
+  for (INDEX iIter=0; iIter<ctIterations; iIter++) {
+    _pShell->Execute(strCommand);
+  }
+  CTimerValue tv4 = _pTimer->GetHighPrecisionTimer();
+  sh_bCacheCommands = bOldCache;
+
+  const DOUBLE dNs = 1E9/ctIterations;
+  CPrintF(TRANS("Shell benchmark: %d symbols, %d iterations (%d found)\n"), ctNames, ctIterations, ctFound);
+  CPrintF(TRANS("  linear lookup:   %8.1f ns\n"), (tv1-tv0).GetSeconds()*dNs);
+  CPrintF(TRANS("  hashed lookup:   %8.1f ns\n"), (tv2-tv1).GetSeconds()*dNs);
+  CPrintF(TRANS("  parsed command:  %8.1f ns\n"), (tv3-tv2).GetSeconds()*dNs);
+  CPrintF(TRANS("  cached command:  %8.1f ns\n"), (tv4-tv3).GetSeconds()*dNs);
+}
+
 
 // output any string to console
 void Echo(void* pArgs)
@@ -553,6 +889,9 @@ void CShell::Initialize(void)
   DeclareSymbol("user void MakeStackOverflow(INDEX);",   (void *)&MakeStackOverflow);
   DeclareSymbol("user void MakeFatalError(INDEX);",      (void *)&MakeFatalError);
   DeclareSymbol("persistent user INDEX con_iLastLines;", (void *)&con_iLastLines);
+  DeclareSymbol("const user INDEX con_ctDroppedLines;", (void *)&con_ctDroppedLines);
+  DeclareSymbol("persistent user INDEX sh_bCacheCommands;", (void *)&sh_bCacheCommands);
+  DeclareSymbol("user void ShellBenchmark(INDEX);", (void *)&ShellBenchmark);
   DeclareSymbol("persistent user FLOAT tmp_af[10];", (void *)&tmp_af);
   DeclareSymbol("persistent user INDEX tmp_ai[10];", (void *)&tmp_ai);
   DeclareSymbol("persistent user INDEX tmp_i;", (void *)&tmp_i);
@@ -611,6 +950,11 @@ void CShell::Execute(const CTString &strCommands)
   // synchronize access to shell
   CTSingleLock slShell(&sh_csShell, TRUE);
 
+  // simple commands are executed precompiled
+  if (sh_bCacheCommands && ExecuteCachedCommand(strCommands)) {
+    return;
+  }
+
 //  ASSERT(_iParsing==0);
   _iParsing++;
 
@@ -636,13 +980,10 @@ CShellSymbol *CShell::GetSymbol(const CTString &strName, BOOL bDeclaredOnly)
   // synchronize access to shell
   CTSingleLock slShell(&sh_csShell, TRUE);
 
-  // for each of symbols in the shell
-  FOREACHINDYNAMICARRAY(sh_assSymbols, CShellSymbol, itss) {
-    // if it is the right one
-    if (itss->ss_strName==strName) {
-      // return it
-      return itss;
-    }
+  // find it in the nametable
+  CShellSymbol *pss = _ntSymbols.Find(strName);
+  if (pss!=NULL) {
+    return pss;
   }
   // if none is found...
 
@@ -661,6 +1002,7 @@ CShellSymbol *CShell::GetSymbol(const CTString &strName, BOOL bDeclaredOnly)
     ssNew.ss_ulFlags = 0;
     ssNew.ss_pPreFunc = NULL;
     ssNew.ss_pPostFunc = NULL;
+    _ntSymbols.Add(&ssNew);
     return &ssNew;
   }
 };
@@ -723,6 +1065,24 @@ void CShell::SetINDEX(const CTString &strName, INDEX iValue)
   *(INDEX*)pss->ss_pvValue = iValue;
 }
 
+INDEX *CShell::GetINDEXPointer(const CTString &strName)
+{
+  CShellSymbol *pss = GetSymbol(strName, TRUE);
+  if (pss==NULL || _shell_ast[pss->ss_istType].st_sttType!=STT_INDEX) {
+    return NULL;
+  }
+  return (INDEX*)pss->ss_pvValue;
+}
+
+CTString *CShell::GetStringPointer(const CTString &strName)
+{
+  CShellSymbol *pss = GetSymbol(strName, TRUE);
+  if (pss==NULL || _shell_ast[pss->ss_istType].st_sttType!=STT_STRING) {
+    return NULL;
+  }
+  return (CTString*)pss->ss_pvValue;
+}
+
 CTString CShell::GetString(const CTString &strName)
 {
   // get the symbol
@@ -65,6 +65,9 @@ public:
   void SetINDEX(const CTString &strName, INDEX iValue);
   CTString GetString(const CTString &strName);
   void SetString(const CTString &strName, const CTString &strValue);
+  // get pointers to variables, for reading them often without lookups (NULL if not declared)
+  INDEX *GetINDEXPointer(const CTString &strName);
+  CTString *GetStringPointer(const CTString &strName);
 
   CTString GetValue(const CTString &strName);
   void SetValue(const CTString &strName, const CTString &strValue);
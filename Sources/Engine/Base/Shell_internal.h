@@ -80,6 +80,8 @@ public:
   void Clear(void);
   // check if declared
   BOOL IsDeclared(void);
+  // get name (for the symbol nametable)
+  inline const CTString &GetName(void) const { return ss_strName; };
 // interface:
   // get string for 'tab' completion in console 
   ENGINE_API CTString GetCompletionString(void) const;
@@ -0,0 +1,207 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/Threading.h>
+
+#ifdef PLATFORM_WIN32
+  #include <process.h>
+#else
+  #include <pthread.h>
+  #include <sched.h>
+  #include <unistd.h>
+#endif
+
+// thread function and its parameter, passed to the platform thread
+struct ThreadStart {
+  ThreadFunction_t ts_pFunction;
+  void *ts_pvParam;
+#ifdef PLATFORM_WIN32
+  HANDLE ts_hThread;
+#else
+  pthread_t ts_thread;
+#endif
+};
+
+#ifdef PLATFORM_WIN32
+static unsigned __stdcall ThreadEntry(void *pvStart)
+{
+  ThreadStart *pts = (ThreadStart *)pvStart;
+  pts->ts_pFunction(pts->ts_pvParam);
+  return 0;
+}
+#else
+static void *ThreadEntry(void *pvStart)
+{
+  ThreadStart *pts = (ThreadStart *)pvStart;
+  pts->ts_pFunction(pts->ts_pvParam);
+  return NULL;
+}
+#endif
+
+// Start a new thread, returns NULL if it cannot be started.
+void *ThreadCreate(ThreadFunction_t pFunction, void *pvParam)
+{
+  ThreadStart *pts = new ThreadStart;
+  pts->ts_pFunction = pFunction;
+  pts->ts_pvParam = pvParam;
+#ifdef PLATFORM_WIN32
+  pts->ts_hThread = (HANDLE)_beginthreadex(NULL, 0, &ThreadEntry, pts, 0, NULL);
+  if (pts->ts_hThread==NULL) {
+    delete pts;
+    return NULL;
+  }
+#else
+  if (pthread_create(&pts->ts_thread, NULL, &ThreadEntry, pts)!=0) {
+    delete pts;
+    return NULL;
+  }
+#endif
+  return pts;
+}
+
+// Wait for a thread to finish and free its handle.
+void ThreadJoin(void *pvThread)
+{
+  if (pvThread==NULL) {
+    return;
+  }
+  ThreadStart *pts = (ThreadStart *)pvThread;
+#ifdef PLATFORM_WIN32
+  WaitForSingleObject(pts->ts_hThread, INFINITE);
+  CloseHandle(pts->ts_hThread);
+#else
+  pthread_join(pts->ts_thread, NULL);
+#endif
+  delete pts;
+}
+
+// Put current thread to sleep for given number of milliseconds.
+void ThreadSleep(INDEX ctMilliseconds)
+{
+#ifdef PLATFORM_WIN32
+  Sleep(ctMilliseconds);
+#else
+  usleep(ctMilliseconds*1000);
+#endif
+}
+
+// Give up rest of the time slice of current thread.
+void ThreadYield(void)
+{
+#ifdef PLATFORM_WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+// Get an identifier of current thread.
+ULONG ThreadGetID(void)
+{
+#ifdef PLATFORM_WIN32
+  return GetCurrentThreadId();
+#else
+  return (ULONG)(size_t)pthread_self();
+#endif
+}
+
+// Get number of processors available to the process.
+INDEX ThreadGetCPUCount(void)
+{
+#ifdef PLATFORM_WIN32
+  SYSTEM_INFO si;
+  GetSystemInfo(&si);
+  return si.dwNumberOfProcessors>0 ? (INDEX)si.dwNumberOfProcessors : 1;
+#else
+  long ctCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+  return ctCPUs>0 ? (INDEX)ctCPUs : 1;
+#endif
+}
+
+#ifndef PLATFORM_WIN32
+// semaphore built from a mutex and a condition (unnamed POSIX semaphores are not everywhere)
+struct Semaphore {
+  pthread_mutex_t sem_mutex;
+  pthread_cond_t sem_cond;
+  INDEX sem_ctCount;
+};
+#endif
+
+// Create a counting semaphore with given initial count.
+void *SemaphoreCreate(INDEX ctInitial)
+{
+#ifdef PLATFORM_WIN32
+  return CreateSemaphore(NULL, ctInitial, 0x7FFFFFFF, NULL);
+#else
+  Semaphore *psem = new Semaphore;
+  pthread_mutex_init(&psem->sem_mutex, NULL);
+  pthread_cond_init(&psem->sem_cond, NULL);
+  psem->sem_ctCount = ctInitial;
+  return psem;
+#endif
+}
+
+// Destroy a semaphore (no thread may be waiting on it).
+void SemaphoreDestroy(void *pvSemaphore)
+{
+  if (pvSemaphore==NULL) {
+    return;
+  }
+#ifdef PLATFORM_WIN32
+  CloseHandle((HANDLE)pvSemaphore);
+#else
+  Semaphore *psem = (Semaphore *)pvSemaphore;
+  pthread_cond_destroy(&psem->sem_cond);
+  pthread_mutex_destroy(&psem->sem_mutex);
+  delete psem;
+#endif
+}
+
+// Increase the count, releasing that many waiting threads.
+void SemaphoreSignal(void *pvSemaphore, INDEX ctCount)
+{
+  ASSERT(ctCount>0);
+#ifdef PLATFORM_WIN32
+  ReleaseSemaphore((HANDLE)pvSemaphore, ctCount, NULL);
+#else
+  Semaphore *psem = (Semaphore *)pvSemaphore;
+  pthread_mutex_lock(&psem->sem_mutex);
+  psem->sem_ctCount += ctCount;
+  if (ctCount==1) {
+    pthread_cond_signal(&psem->sem_cond);
+  } else {
+    pthread_cond_broadcast(&psem->sem_cond);
+  }
+  pthread_mutex_unlock(&psem->sem_mutex);
+#endif
+}
+
+// Wait until the count is above zero and decrease it.
+void SemaphoreWait(void *pvSemaphore)
+{
+#ifdef PLATFORM_WIN32
+  WaitForSingleObject((HANDLE)pvSemaphore, INFINITE);
+#else
+  Semaphore *psem = (Semaphore *)pvSemaphore;
+  pthread_mutex_lock(&psem->sem_mutex);
+  while (psem->sem_ctCount<=0) {
+    pthread_cond_wait(&psem->sem_cond, &psem->sem_mutex);
+  }
+  psem->sem_ctCount--;
+  pthread_mutex_unlock(&psem->sem_mutex);
+#endif
+}
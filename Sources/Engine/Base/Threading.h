@@ -0,0 +1,128 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_THREADING_H
+#define SE_INCL_THREADING_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+/*
+ * Portable worker threads and atomic operations, for background tasks
+ * that must not block the main loop.
+ */
+
+// storage class for variables that each thread has its own copy of
+#ifdef _MSC_VER
+  #define THREAD_LOCAL __declspec(thread)
+#else
+  #define THREAD_LOCAL __thread
+#endif
+
+// function that a thread runs
+typedef void (*ThreadFunction_t)(void *pvParam);
+
+// Start a new thread, returns NULL if it cannot be started.
+ENGINE_API void *ThreadCreate(ThreadFunction_t pFunction, void *pvParam);
+// Wait for a thread to finish and free its handle.
+ENGINE_API void ThreadJoin(void *pvThread);
+// Put current thread to sleep for given number of milliseconds.
+ENGINE_API void ThreadSleep(INDEX ctMilliseconds);
+// Give up rest of the time slice of current thread.
+ENGINE_API void ThreadYield(void);
+// Get an identifier of current thread.
+ENGINE_API ULONG ThreadGetID(void);
+// Get number of processors available to the process.
+ENGINE_API INDEX ThreadGetCPUCount(void);
+
+// Create a counting semaphore with given initial count.
+ENGINE_API void *SemaphoreCreate(INDEX ctInitial);
+// Destroy a semaphore (no thread may be waiting on it).
+ENGINE_API void SemaphoreDestroy(void *pvSemaphore);
+// Increase the count, releasing that many waiting threads.
+ENGINE_API void SemaphoreSignal(void *pvSemaphore, INDEX ctCount);
+// Wait until the count is above zero and decrease it.
+ENGINE_API void SemaphoreWait(void *pvSemaphore);
+
+// Atomically add to a value, returns the new value.
+inline SLONG AtomicAdd(volatile SLONG *pslValue, SLONG slAdd)
+{
+#ifdef _MSC_VER
+  return _InterlockedExchangeAdd((volatile long *)pslValue, slAdd)+slAdd;
+#else
+  return __sync_add_and_fetch(pslValue, slAdd);
+#endif
+}
+
+// Atomically replace a value if it equals the comparand, returns the old value.
+inline SLONG AtomicCompareExchange(volatile SLONG *pslValue, SLONG slExchange, SLONG slComparand)
+{
+#ifdef _MSC_VER
+  return _InterlockedCompareExchange((volatile long *)pslValue, slExchange, slComparand);
+#else
+  return __sync_val_compare_and_swap(pslValue, slComparand, slExchange);
+#endif
+}
+
+// Atomically replace a value, returns the old value.
+inline SLONG AtomicExchange(volatile SLONG *pslValue, SLONG slExchange)
+{
+#ifdef _MSC_VER
+  return _InterlockedExchange((volatile long *)pslValue, slExchange);
+#else
+  __sync_synchronize();
+  return __sync_lock_test_and_set(pslValue, slExchange);
+#endif
+}
+
+// Full memory barrier.
+inline void AtomicFence(void)
+{
+#ifdef _MSC_VER
+  MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+}
+
+// Read a value written by another thread.
+inline SLONG AtomicLoad(volatile SLONG *pslValue)
+{
+  SLONG slValue = *pslValue;
+  AtomicFence();
+  return slValue;
+}
+
+// Write a value that will be read by another thread.
+inline void AtomicStore(volatile SLONG *pslValue, SLONG slValue)
+{
+  AtomicFence();
+  *pslValue = slValue;
+}
+
+// Clear a lock word taken with AtomicCompareExchange() (cheaper than a full fence).
+inline void AtomicRelease(volatile SLONG *pslValue)
+{
+#ifdef _MSC_VER
+  _ReadWriteBarrier();
+  *pslValue = 0;
+#else
+  __sync_lock_release(pslValue);
+#endif
+}
+
+
+#endif  /* include-once check. */
+
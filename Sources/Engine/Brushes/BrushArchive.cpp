@@ -28,6 +28,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/BSP.h>
 #include <Engine/Templates/BSP_internal.h>
 #include <Engine/Templates/DynamicArray.cpp>
+#include <Engine/Templates/SlotMap.cpp>
 #include <Engine/Templates/StaticArray.cpp>
 
 // !!! FIXME: This confuses GCC, since CDynamicArray is a #included
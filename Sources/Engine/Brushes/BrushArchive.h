@@ -21,14 +21,14 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/Lists.h>
 #include <Engine/Templates/StaticArray.h>
-#include <Engine/Templates/DynamicArray.h>
+#include <Engine/Templates/SlotMap.h>
 
 /*
  * Brush archive class -- a collection of brushes used by a level.
  */
 class ENGINE_API CBrushArchive : public CSerial {
 public:
-  CDynamicArray<CBrush3D> ba_abrBrushes;    // all the brushes in archive
+  CSlotMap<CBrush3D> ba_abrBrushes;         // all the brushes in archive
   // lists of all shadow maps that need calculation
   CListHead ba_lhUncalculatedShadowMaps;
   CWorld *ba_pwoWorld;  // the world
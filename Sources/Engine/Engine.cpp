@@ -27,6 +27,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/CRCTable.h>
 #include <Engine/Base/ProgressHook.h>
 #include <Engine/Base/FileSystem.h>
+#include <Engine/Base/Jobs.h>
 #include <Engine/Sound/SoundListener.h>
 #include <Engine/Sound/SoundLibrary.h>
 #include <Engine/Graphics/GfxLibrary.h>
@@ -577,6 +578,7 @@ ENGINE_API void SE_InitEngine(const char *argv0, CTString strGameID)
   _pShell->Initialize();
 
   _pTimer = new CTimer;
+  _pJobs  = new CJobSystem;
   _pGfx   = new CGfxLibrary;
   _pSound = new CSoundLibrary;
   _pInput = new CInput;
@@ -661,6 +663,11 @@ ENGINE_API void SE_InitEngine(const char *argv0, CTString strGameID)
   // Stock clearing
   extern void FreeUnusedStock(void);
   _pShell->DeclareSymbol("user void FreeUnusedStock(void);", (void *) &FreeUnusedStock);
+
+  // profiling trace
+  extern void DumpProfileTrace(void *pArgs);
+  _pShell->DeclareSymbol("user INDEX prf_bTrace;", (void *) &prf_bTrace);
+  _pShell->DeclareSymbol("user void DumpProfileTrace(CTString, INDEX);", (void *) &DumpProfileTrace);
   
   // Timer tick quantum
   _pShell->DeclareSymbol("user const FLOAT fTickQuantum;", (FLOAT*)&_pTimer->TickQuantum);
@@ -770,6 +777,7 @@ ENGINE_API void SE_EndEngine(void)
   delete _pInput;    _pInput   = NULL;  
   delete _pSound;    _pSound   = NULL;  
   delete _pGfx;      _pGfx     = NULL;    
+  delete _pJobs;     _pJobs    = NULL;
   delete _pTimer;    _pTimer   = NULL;  
   delete _pShell;    _pShell   = NULL;  
   delete _pConsole;  _pConsole = NULL;
@@ -793,6 +801,10 @@ ENGINE_API void SE_EndEngine(void)
   _pfWorldEditingProfile  .TimersClear();
   _pfPhysicsProfile       .CountersClear();
   _pfPhysicsProfile       .TimersClear();
+  _pfMemoryProfile        .CountersClear();
+  _pfMemoryProfile        .TimersClear();
+  _pfJobProfile           .CountersClear();
+  _pfJobProfile           .TimersClear();
 
   // remove default fonts if needed
   if( _pfdDisplayFont != NULL) { delete _pfdDisplayFont;  _pfdDisplayFont=NULL; }
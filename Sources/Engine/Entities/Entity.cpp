@@ -32,6 +32,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/CRC.h>
 #include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
 #include <Engine/Base/Statistics_Internal.h>
 #include <Engine/Network/Network.h>
 #include <Engine/Network/PlayerTarget.h>
@@ -66,6 +68,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/Stock_CTextureData.h>
 #include <Engine/Templates/Stock_CModelData.h>
 #include <Engine/Templates/Stock_CSoundData.h>
+#include <Engine/Templates/SlotMap.cpp>
 
 // a reference to a void event for use as default parameter
 const EVoid _evVoid;
@@ -82,11 +85,15 @@ BOOL IsOfClass(CEntity *pen, const char *pstrClassName)
   if (pen==NULL || pstrClassName==NULL) {
     return FALSE;
   }
-  if (strcmp(pen->GetClass()->ec_pdecDLLClass->dec_strName, pstrClassName)==0) {
-    return TRUE;
-  } else {
+  return IsOfClass(pen, GetEntityClassID(pstrClassName));
+}
+BOOL IsOfClass(CEntity *pen, INDEX iClassID)
+{
+  if (pen==NULL || iClassID==0) {
     return FALSE;
   }
+  ASSERT(pen->GetClass()->ec_pdecDLLClass->dec_iInternedID!=0);
+  return pen->GetClass()->ec_pdecDLLClass->dec_iInternedID==iClassID;
 }
 BOOL IsOfSameClass(CEntity *pen1, CEntity *pen2)
 {
@@ -106,20 +113,115 @@ BOOL IsDerivedFromClass(CEntity *pen, const char *pstrClassName)
   if (pen==NULL || pstrClassName==NULL) {
     return FALSE;
   }
+  return IsDerivedFromClass(pen, GetEntityClassID(pstrClassName));
+}
+BOOL IsDerivedFromClass(CEntity *pen, INDEX iClassID)
+{
+  if (pen==NULL || iClassID<=0) {
+    return FALSE;
+  }
+  CDLLEntityClass *pdecDLLClass = pen->GetClass()->ec_pdecDLLClass;
+  ASSERT(pdecDLLClass->dec_iInternedID!=0);
+  // most classes are found in the ancestor bitset
+  if (iClassID<ENTITYCLASS_ANCESTORBITS) {
+    return (pdecDLLClass->dec_aulAncestors[iClassID>>5]>>(iClassID&31))&1;
+  }
   // for all classes in hierarchy of the entity
+  for(; pdecDLLClass!=NULL; pdecDLLClass = pdecDLLClass->dec_pdecBase) {
+    // if it is the wanted class
+    if (pdecDLLClass->dec_iInternedID==iClassID) {
+      // it is derived
+      return TRUE;
+    }
+  }
+  // otherwise, it is not derived
+  return FALSE;
+}
+
+// old string comparing class checks, kept for the benchmark
+static BOOL IsOfClass_strcmp(CEntity *pen, const char *pstrClassName)
+{
+  return strcmp(pen->GetClass()->ec_pdecDLLClass->dec_strName, pstrClassName)==0;
+}
+static BOOL IsDerivedFromClass_strcmp(CEntity *pen, const char *pstrClassName)
+{
   for(CDLLEntityClass *pdecDLLClass = pen->GetClass()->ec_pdecDLLClass;
       pdecDLLClass!=NULL;
       pdecDLLClass = pdecDLLClass->dec_pdecBase) {
-    // if it is the wanted class
     if (strcmp(pdecDLLClass->dec_strName, pstrClassName)==0) {
-      // it is derived
       return TRUE;
     }
   }
-  // otherwise, it is not derived
   return FALSE;
 }
 
+// time class checks of all entities in current world by name and by interned ID
+void ClassCheckBenchmark(void *pArgs)
+{
+  INDEX ctRounds = NEXTARGUMENT(INDEX);
+  ctRounds = Clamp(ctRounds, (INDEX)1, (INDEX)10000);
+
+  CWorld &wo = _pNetwork->ga_World;
+  const INDEX ctEntities = wo.wo_cenEntities.Count();
+  if (ctEntities==0) {
+    CPrintF("No entities in current world.\n");
+    return;
+  }
+  // names most often checked by game code
+  static const char *astrNames[] = {
+    "Player", "Enemy Base", "Projectile", "ModelHolder2", "Twister", "Moving Brush", "MovableEntity",
+  };
+  const INDEX ctNames = ARRAYCOUNT(astrNames);
+  INDEX aiIDs[ARRAYCOUNT(astrNames)];
+  {for (INDEX iName=0; iName<ctNames; iName++) {
+    aiIDs[iName] = GetEntityClassID(astrNames[iName]);
+  }}
+
+  INDEX ctStrcmp = 0;
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  {for (INDEX iRound=0; iRound<ctRounds; iRound++) {
+    {FOREACHINDYNAMICCONTAINER(wo.wo_cenEntities, CEntity, iten) {
+      for (INDEX iName=0; iName<ctNames; iName++) {
+        ctStrcmp += IsOfClass_strcmp(iten, astrNames[iName]);
+        ctStrcmp += IsDerivedFromClass_strcmp(iten, astrNames[iName]);
+      }
+    }}
+  }}
+  CTimerValue tvStrcmp = _pTimer->GetHighPrecisionTimer()-tvStart;
+
+  INDEX ctNamed = 0;
+  tvStart = _pTimer->GetHighPrecisionTimer();
+  {for (INDEX iRound=0; iRound<ctRounds; iRound++) {
+    {FOREACHINDYNAMICCONTAINER(wo.wo_cenEntities, CEntity, iten) {
+      for (INDEX iName=0; iName<ctNames; iName++) {
+        ctNamed += IsOfClass(iten, astrNames[iName]);
+        ctNamed += IsDerivedFromClass(iten, astrNames[iName]);
+      }
+    }}
+  }}
+  CTimerValue tvNamed = _pTimer->GetHighPrecisionTimer()-tvStart;
+
+  INDEX ctInterned = 0;
+  tvStart = _pTimer->GetHighPrecisionTimer();
+  {for (INDEX iRound=0; iRound<ctRounds; iRound++) {
+    {FOREACHINDYNAMICCONTAINER(wo.wo_cenEntities, CEntity, iten) {
+      for (INDEX iName=0; iName<ctNames; iName++) {
+        ctInterned += IsOfClass(iten, aiIDs[iName]);
+        ctInterned += IsDerivedFromClass(iten, aiIDs[iName]);
+      }
+    }}
+  }}
+  CTimerValue tvInterned = _pTimer->GetHighPrecisionTimer()-tvStart;
+
+  const DOUBLE dChecks = DOUBLE(ctRounds)*ctEntities*ctNames*2;
+  CPrintF("Class checks on %d entities: %.1f ns strcmp, %.1f ns by name, %.1f ns by ID (per check)\n",
+    ctEntities, tvStrcmp.GetSeconds()*1E9/dChecks, tvNamed.GetSeconds()*1E9/dChecks,
+    tvInterned.GetSeconds()*1E9/dChecks);
+  if (ctStrcmp!=ctNamed || ctStrcmp!=ctInterned) {
+    CPrintF("  MISMATCH: %d strcmp, %d by name, %d by ID matches\n", ctStrcmp, ctNamed, ctInterned);
+  }
+}
+
 /////////////////////////////////////////////////////////////////////
 // CEntity
 
@@ -138,6 +240,8 @@ CEntity::CEntity(void)
   en_ulCollisionFlags = 0;
   en_ctReferences = 0;
   en_ulID = 0;
+  en_aiWorldSlots[0] = -1;
+  en_aiWorldSlots[1] = -1;
   en_RenderType = RT_NONE;
   en_fSpatialClassificationRadius = -1.0f;
   en_penParent = NULL;
@@ -156,6 +260,7 @@ CEntity::~CEntity(void)
   // remove it from container in its world
   ASSERT(!en_pwoWorld->wo_cenEntities.IsMember(this));
   en_pwoWorld->wo_cenAllEntities.Remove(this);
+  en_pwoWorld->wo_htEntitiesByID.Remove(this);
 
   // unset spatial clasification
   en_rdSectors.Clear();
@@ -1827,8 +1932,13 @@ void CEntity::FindSectorsAroundEntity(void)
   FLOATobbox3D boxEntity = FLOATobbox3D(en_boxSpatialClassification, 
     en_plPlacement.pl_PositionVector, en_mRotation);
 
-  // unset spatial clasification
-  en_rdSectors.Clear();
+  // mark sectors the entity was in, links to those that still contain it are reused
+  {FOREACHSRCOFDST(en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+    pbsc->bsc_prlLink = pbsc_iter;
+  ENDFOR}
+  const BOOL bBrushesFirst = en_RenderType==RT_BRUSH
+    ||en_RenderType==RT_FIELDBRUSH
+    ||en_RenderType==RT_TERRAIN;
 
   // for each brush in the world
   FOREACHINDYNAMICARRAY(en_pwoWorld->wo_baBrushes.ba_abrBrushes, CBrush3D, itbr) {
@@ -1853,13 +1963,22 @@ void CEntity::FindSectorsAroundEntity(void)
 
             // if the box is inside the sector
             if (itbsc->bsc_bspBSPTree.TestBox(boxEntity)>=0) {
-              // relate the entity to the sector
-              if (en_RenderType==RT_BRUSH
-                ||en_RenderType==RT_FIELDBRUSH
-                ||en_RenderType==RT_TERRAIN) {  // brushes first
-                AddRelationPairHeadHead(itbsc->bsc_rsEntities, en_rdSectors);
+              // relate the entity to the sector (moving an existing link keeps
+              // the same order as if it was removed and added again)
+              CRelationLnk *prlOld = itbsc->bsc_prlLink;
+              itbsc->bsc_prlLink = NULL;
+              if (bBrushesFirst) {  // brushes first
+                if (prlOld!=NULL) {
+                  MoveRelationPairHeadHead(*prlOld);
+                } else {
+                  AddRelationPairHeadHead(itbsc->bsc_rsEntities, en_rdSectors);
+                }
               } else {
-                AddRelationPairTailTail(itbsc->bsc_rsEntities, en_rdSectors);
+                if (prlOld!=NULL) {
+                  MoveRelationPairTailTail(*prlOld);
+                } else {
+                  AddRelationPairTailTail(itbsc->bsc_rsEntities, en_rdSectors);
+                }
               }
             }
           }
@@ -1867,6 +1986,15 @@ void CEntity::FindSectorsAroundEntity(void)
       }
     }
   }
+
+  // remove links to sectors the entity has left
+  {FORDELETELIST(CRelationLnk, rl_lnDst, en_rdSectors, itlnk) {
+    CBrushSector *pbsc = SRC(itlnk, CBrushSector, bsc_rsEntities);
+    if (pbsc->bsc_prlLink==&*itlnk) {
+      pbsc->bsc_prlLink = NULL;
+      delete &*itlnk;
+    }
+  }}
 }
 
 void CEntity::FindSectorsAroundEntityNear(void)
@@ -2157,6 +2285,7 @@ void CEntity::SendEventInRange(const CEntityEvent &ee, const FLOATaabbox3D &boxR
 void CEntity::HandleSentEvents(void)
 {
   CSetFPUPrecision FPUPrecision(FPT_24BIT);
+  _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_HANDLESENTEVENTS);
 
   // while there are any unhandled events
   INDEX iFirstEvent = 0;
@@ -2172,6 +2301,7 @@ void CEntity::HandleSentEvents(void)
     if (!(se.se_penEntity->en_ulFlags&ENF_DELETED)) {
       // handle the current event
       se.se_penEntity->HandleEvent(*se.se_peeEvent);
+      _pfPhysicsProfile.IncrementCounter(CPhysicsProfile::PCI_SENTEVENTS);
     }
     // go to next event
     iFirstEvent++;
@@ -2186,8 +2316,10 @@ void CEntity::HandleSentEvents(void)
     se.se_peeEvent = NULL;
   }
 
+  _pfPhysicsProfile.IncrementTimerAveragingCounter(CPhysicsProfile::PTI_HANDLESENTEVENTS, _aseSentEvents.Count());
   // flush all events
   _aseSentEvents.PopAll();
+  _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_HANDLESENTEVENTS);
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -181,6 +181,7 @@ public:
   ULONG en_ulSpawnFlags;          // in what game types is this entity active
   INDEX en_ctReferences;          // reference counter for delayed destruction
   ULONG en_ulID;                  // unique entity identifier
+  INDEX en_aiWorldSlots[2];       // indices in containers of world entities (see CWorldEntityContainer)
 
   CPlacement3D en_plPlacement;      // placement in world space
   FLOATmatrix3D en_mRotation;       // precalc. matrix for object rotation
@@ -662,11 +663,15 @@ public:
   void TerrainChangeNotify(void);
 };
 
+// get interned ID of an entity class descriptive name (0 if no loaded class has that name)
+INDEX ENGINE_API GetEntityClassID(const char *pstrClassName);
 // check if entity is of given class
 BOOL ENGINE_API IsOfClass(CEntity *pen, const char *pstrClassName);
+BOOL ENGINE_API IsOfClass(CEntity *pen, INDEX iClassID);
 BOOL ENGINE_API IsOfSameClass(CEntity *pen1, CEntity *pen2);
 // check if entity is of given class or derived from
 BOOL ENGINE_API IsDerivedFromClass(CEntity *pen, const char *pstrClassName);
+BOOL ENGINE_API IsDerivedFromClass(CEntity *pen, INDEX iClassID);
 
 // all standard smart pointer functions are here as inlines
 inline CEntityPointer::CEntityPointer(void) : ep_pen(NULL) {};
@@ -30,6 +30,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/Stock_CEntityClass.h>
 
 #include <Engine/Templates/Stock_CEntityClass.h>
+#include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 
 /////////////////////////////////////////////////////////////////////
 // CEntityClass
@@ -49,6 +51,7 @@ CEntityClass::CEntityClass(void)
 CEntityClass::CEntityClass(class CDLLEntityClass *pdecDLLClass)
 {
   ec_pdecDLLClass = pdecDLLClass;
+  ec_pdecDLLClass->InternClassID();
   ec_hiClassDLL = NULL;
   ec_fnmClassDLL.Clear();
 }
@@ -274,6 +277,9 @@ void CEntityClass::Read_t( CTStream *istr) // throw char *
     ThrowF_t(TRANS("Class '%s' not found in entity class package file '%s'"), (const char *) strClassName, dllName);
   }
 
+  // give the class and its bases interned IDs for fast class checks
+  ec_pdecDLLClass->InternClassID();
+
   // obtain all components needed by the DLL
   {
     CTmpPrecachingNow tpn;
@@ -357,6 +363,92 @@ const char *CEntityPropertyEnumType::NameForValue(INDEX iValue)
   return "";
 }
 
+/////////////////////////////////////////////////////////////////////
+// Interned entity class names
+
+// names by interned ID (ID 0 is reserved for 'no class')
+static CStaticStackArray<CTString> _astrInternedNames;
+// open addressed hash table of interned IDs (0 marks an empty slot)
+static CStaticArray<INDEX> _aiInternedSlots;
+
+static ULONG HashClassName(const char *strName)
+{
+  ULONG ulHash = 2166136261UL;
+  for (; *strName!=0; strName++) {
+    ulHash = (ulHash^(UBYTE)*strName)*16777619UL;
+  }
+  return ulHash;
+}
+
+// find the slot holding given name, or the empty slot where it belongs
+static INDEX FindNameSlot(const char *strName)
+{
+  const INDEX iMask = _aiInternedSlots.Count()-1;
+  INDEX iSlot = HashClassName(strName)&iMask;
+  FOREVER {
+    const INDEX iID = _aiInternedSlots[iSlot];
+    if (iID==0 || strcmp(_astrInternedNames[iID], strName)==0) {
+      return iSlot;
+    }
+    iSlot = (iSlot+1)&iMask;
+  }
+}
+
+// get interned ID of an entity class descriptive name (0 if no loaded class has that name)
+INDEX GetEntityClassID(const char *pstrClassName)
+{
+  if (pstrClassName==NULL || _aiInternedSlots.Count()==0) {
+    return 0;
+  }
+  return _aiInternedSlots[FindNameSlot(pstrClassName)];
+}
+
+static INDEX InternClassName(const char *strName)
+{
+  const INDEX iID = GetEntityClassID(strName);
+  if (iID!=0) {
+    return iID;
+  }
+  if (_astrInternedNames.Count()==0) {
+    _astrInternedNames.Push() = "<none>";
+  }
+  // keep the table at most half full
+  if (_astrInternedNames.Count()*2>=_aiInternedSlots.Count()) {
+    const INDEX ctSlots = Max(_aiInternedSlots.Count()*2, (INDEX)256);
+    _aiInternedSlots.Clear();
+    _aiInternedSlots.New(ctSlots);
+    memset(&_aiInternedSlots[0], 0, ctSlots*sizeof(INDEX));
+    for (INDEX iOld=1; iOld<_astrInternedNames.Count(); iOld++) {
+      _aiInternedSlots[FindNameSlot(_astrInternedNames[iOld])] = iOld;
+    }
+  }
+  const INDEX iNewID = _astrInternedNames.Count();
+  _astrInternedNames.Push() = strName;
+  _aiInternedSlots[FindNameSlot(strName)] = iNewID;
+  return iNewID;
+}
+
+/*
+ * Intern the class name and build the ancestor bitset (bases first).
+ */
+void CDLLEntityClass::InternClassID(void)
+{
+  // IDs survive reloading of the class DLL, since names are kept
+  if (dec_iInternedID!=0) {
+    return;
+  }
+  memset(dec_aulAncestors, 0, sizeof(dec_aulAncestors));
+  if (dec_pdecBase!=NULL) {
+    dec_pdecBase->InternClassID();
+    memcpy(dec_aulAncestors, dec_pdecBase->dec_aulAncestors, sizeof(dec_aulAncestors));
+  }
+  const INDEX iID = InternClassName(dec_strName);
+  if (iID<ENTITYCLASS_ANCESTORBITS) {
+    dec_aulAncestors[iID>>5] |= 1UL<<(iID&31);
+  }
+  dec_iInternedID = iID;
+}
+
 /*
  * Get pointer to entity property from its name.
  */
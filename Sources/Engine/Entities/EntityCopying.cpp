@@ -38,6 +38,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicContainer.cpp>
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/Selection.cpp>
+#include <Engine/Templates/SlotMap.cpp>
 
 class CPointerRemapping {
 public:
@@ -49,6 +50,7 @@ public:
 
 static CStaticArray<CPointerRemapping> _aprRemaps;
 static BOOL _bRemapPointersToNULLs = TRUE;
+static BOOL _bRemapToPredictors = FALSE;
 BOOL _bReinitEntitiesWhileCopying = TRUE;
 static BOOL _bMirrorAndStretch = FALSE;
 static FLOAT _fStretch = 1.0f;
@@ -106,6 +108,11 @@ CEntity *CEntity::FindRemappedEntityPointer(CEntity *penOriginal)
     return NULL;
   }
 
+  // when making predictors, predicted entities already point to their predictors
+  if (_bRemapToPredictors) {
+    return penOriginal->IsPredicted() ? penOriginal->GetPredictionPair() : penOriginal;
+  }
+
   // try to find valid remap
   {FOREACHINSTATICARRAY(_aprRemaps, CPointerRemapping, itpr) {
     if (itpr->pr_penOriginal==penOriginal) {
@@ -668,8 +675,15 @@ void CWorld::CopyEntitiesToPredictors(CDynamicContainer<CEntity> &cenToCopy)
     iRemap++;
     _ctPredictorEntities++;
   }}
+  // link all pairs before copying, so pointers are remapped without searching
+  {FOREACHINSTATICARRAY(_aprRemaps, CPointerRemapping, itpr) {
+    itpr->pr_penCopy->SetPredictionPair(itpr->pr_penOriginal);
+    itpr->pr_penOriginal->SetPredictionPair(itpr->pr_penCopy);
+    itpr->pr_penOriginal->en_ulFlags |= ENF_PREDICTED;
+  }}
   // unfound pointers must be kept unremapped
   _bRemapPointersToNULLs = FALSE;
+  _bRemapToPredictors = TRUE;
 
   // PASS 2: copy properties
 
@@ -741,6 +755,7 @@ void CWorld::CopyEntitiesToPredictors(CDynamicContainer<CEntity> &cenToCopy)
   _aprRemaps.Clear();
 
   _bRemapPointersToNULLs = TRUE;
+  _bRemapToPredictors = FALSE;
 
   // return current tick
   _pTimer->SetCurrentTick(tmCurrentTickOld);
@@ -189,6 +189,9 @@ public:
 /////////////////////////////////////////////////////////////////////
 // The class defining an entity class DLL itself
 
+// interned class IDs below this have a bit in the ancestor bitset, others are found by walking bases
+#define ENTITYCLASS_ANCESTORBITS 512
+
 class ENGINE_API CDLLEntityClass {
 public:
   CEntityProperty *dec_aepProperties; // array of properties
@@ -215,6 +218,12 @@ public:
   void (*dec_OnWorldRender)(CWorld *pwoWorld);  // function called for each rendering
   void (*dec_OnWorldEnd)(CWorld *pwoWorld);     // function called on world cleanup
 
+  INDEX dec_iInternedID;              // interned ID of the descriptive name (0 until class is loaded)
+  ULONG dec_aulAncestors[ENTITYCLASS_ANCESTORBITS/32];  // bitset of interned IDs of this class and its bases
+
+  /* Intern the class name and build the ancestor bitset (bases first). */
+  void InternClassID(void);
+
   /* Get pointer to entity property from its name. */
   class CEntityProperty *PropertyForName(const CTString &strPropertyName);
   /* Get pointer to entity property from its packed identifier. */
@@ -265,14 +274,16 @@ public:
     &classname##_OnWorldInit,                                         \
     &classname##_OnWorldTick,                                         \
     &classname##_OnWorldRender,                                       \
-    &classname##_OnWorldEnd                                           \
+    &classname##_OnWorldEnd,                                          \
+    0, {0}                                                            \
   }
 
 #define ENTITY_CLASSDEFINITION_BASE(classname, id)                    \
   extern "C" DECLSPEC_DLLEXPORT CDLLEntityClass classname##_DLLClass; \
   CDLLEntityClass classname##_DLLClass = {                            \
     NULL,0, NULL,0, NULL,0, "", "", id,                               \
-    NULL, NULL,NULL,NULL,NULL, NULL,NULL,NULL,NULL                    \
+    NULL, NULL,NULL,NULL,NULL, NULL,NULL,NULL,NULL,                   \
+    0, {0}                                                            \
   }
 
 inline ENGINE_API void ClearToDefault(FLOAT &f) { f = 0.0f; };
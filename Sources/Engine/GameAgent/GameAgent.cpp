@@ -26,6 +26,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/SessionState.h>
 #include <GameMP/SessionProperties.h>
 #include <Engine/GameAgent/GameAgent.h>
+#include <Engine/Base/Threading.h>
+#include <Engine/Base/Timer.h>
 
 #if defined(PLATFORM_WIN32)
 #pragma comment(lib, "wsock32.lib")
@@ -155,14 +157,16 @@ CTString ga_strMSLegacy = "42amsterdam.net";
 BOOL ga_bMSLegacy = TRUE;
 //BOOL ga_bMSLegacy = FALSE;
 
+INDEX ga_iQueryRateLimit = 20;    // max queries per second from one address (0 for no limit)
+
 void _uninitWinsock();
 void _initializeWinsock(void)
 {
-#ifdef PLATFORM_WIN32
-  if(_wsaData != NULL && _socket != INVALID_SOCKET) {
+  // the query thread may be reading from the socket, so never replace it while it is open
+  if(_socket != INVALID_SOCKET) {
     return;
   }
-
+#ifdef PLATFORM_WIN32
   _wsaData = new WSADATA;
   _socket = INVALID_SOCKET;
 
@@ -249,8 +253,13 @@ void _initializeWinsock(void)
 #endif
 }
 
+static void _startQueryThread(void);
+static void _stopQueryThread(void);
+
 void _uninitWinsock()
 {
+  // query thread must not be left waiting on a closed (and maybe reused) socket
+  _stopQueryThread();
   if (_socket != INVALID_SOCKET) {
     closesocket(_socket);
     _socket = INVALID_SOCKET;
@@ -358,6 +367,8 @@ extern void GameAgent_ServerInit(void)
     strPacket.PrintF("\\heartbeat\\%hu\\gamename\\serioussamse", (_pShell->GetINDEX("net_iPort") + 1));
     _sendPacket(strPacket);
   }
+  // answer queries in background
+  _startQueryThread();
 }
 
 /// Let GameAgent know that the server has stopped.
@@ -373,198 +384,376 @@ extern void GameAgent_ServerEnd(void)
     _sendPacket(strPacket);
   }
 
+  _stopQueryThread();
   _uninitWinsock();
   _bInitialized = FALSE;
 }
 
-/// GameAgent server update call which responds to enumeration pings and sends pings to masterserver.
-extern void GameAgent_ServerUpdate(void)
+/////////////////////////////////////////////////////////////////////
+// Query responder
+
+// queries are answered on a thread of their own, from a snapshot of server status
+// that the game thread rebuilds once per tick
+
+enum GameAgentQuery {
+  GAQ_HEARTBEAT = 0,  // heartbeat fields following the master server challenge
+  GAQ_STATUS,
+  GAQ_PLAYERS,
+  GAQ_PING,
+  GAQ_LEGACYSTATUS,
+  GAQ_LEGACYINFO,
+  GAQ_LEGACYBASIC,
+  GAQ_LEGACYPLAYERS,
+};
+
+#define GA_SNAPSHOTDATA     32768
+#define GA_SNAPSHOTPACKETS  64
+
+// all response packets, ready to be sent
+struct GameAgentSnapshot {
+  INDEX gas_ctPackets;
+  INDEX gas_ctData;
+  UBYTE gas_aubQuery[GA_SNAPSHOTPACKETS];   // which query each packet answers
+  INDEX gas_aiOffset[GA_SNAPSHOTPACKETS];
+  INDEX gas_aiLength[GA_SNAPSHOTPACKETS];
+  char  gas_achData[GA_SNAPSHOTDATA];
+};
+
+// triple buffered snapshots, the published one is exchanged atomically
+static GameAgentSnapshot _agasSnapshots[3];
+static INDEX _iSnapshotWrite = 0;             // being built by the game thread
+static INDEX _iSnapshotRead = 1;              // being answered from by the query thread
+static volatile SLONG _slSnapshotLatest = 2;  // newest complete one, bit 4 set until taken
+static TIME _tmLastSnapshot = -1.0f;
+
+static void *_pvQueryThread = NULL;
+static volatile SLONG _bQueryStop = FALSE;
+static volatile SLONG _bChallengeAnswered = FALSE;  // heartbeat was sent from the query thread
+
+// per address query counters for rate limiting
+#define GA_RATESLOTS 256
+struct GameAgentRate {
+  ULONG gar_ulAddress;
+  SLONG gar_slSecond;
+  INDEX gar_ctQueries;
+};
+static GameAgentRate _agarRates[GA_RATESLOTS];
+
+static void _addSnapshotPacket(GameAgentSnapshot &gas, GameAgentQuery gaq, const char *strPacket)
 {
-  if((_socket == INVALID_SOCKET) || (!_bInitialized)) {
+  const INDEX ctLen = strlen(strPacket);
+  if (gas.gas_ctPackets>=GA_SNAPSHOTPACKETS || gas.gas_ctData+ctLen>GA_SNAPSHOTDATA) {
+    ASSERT(FALSE);
     return;
   }
+  gas.gas_aubQuery[gas.gas_ctPackets] = (UBYTE)gaq;
+  gas.gas_aiOffset[gas.gas_ctPackets] = gas.gas_ctData;
+  gas.gas_aiLength[gas.gas_ctPackets] = ctLen;
+  memcpy(gas.gas_achData+gas.gas_ctData, strPacket, ctLen);
+  gas.gas_ctData += ctLen;
+  gas.gas_ctPackets++;
+}
 
-  int iLen = _recvPacket();
-  if(iLen > 0) {
-    if (!ga_bMSLegacy) {
-    // check the received packet ID
-    switch(_szBuffer[0]) {
-    case 1: // server join response
-      {
-        int iChallenge = *(INDEX*)(_szBuffer + 1);
-        // send the challenge
-        _sendHeartbeat(iChallenge);
-        break;
+// add info of all players, split in packets that are not too large
+static void _addSnapshotPlayers(GameAgentSnapshot &gas, GameAgentQuery gaq, CTString &strPacket, BOOL bLegacy)
+{
+  for(INDEX i=0; i<_pNetwork->ga_srvServer.GetPlayersCount(); i++) {
+    CPlayerBuffer &plb = _pNetwork->ga_srvServer.srv_aplbPlayers[i];
+    CPlayerTarget &plt = _pNetwork->ga_sesSessionState.ses_apltPlayers[i];
+    if(plt.plt_bActive) {
+      CTString strPlayer;
+      if (bLegacy) {
+        plt.plt_penPlayerEntity->GetMSLegacyPlayerInf(plb.plb_Index, strPlayer);
+      } else {
+        plt.plt_penPlayerEntity->GetGameAgentPlayerInfo(plb.plb_Index, strPlayer);
       }
-
-    case 2: // server status request
-      {
-        // send the status response
-        CTString strPacket;
-        strPacket.PrintF("0;players;%d;maxplayers;%d;level;%s;gametype;%s;version;%s;gamename;%s;sessionname;%s",
-          _pNetwork->ga_srvServer.GetPlayersCount(),
-          _pNetwork->ga_sesSessionState.ses_ctMaxPlayers,
-          (const char *) _pNetwork->ga_World.wo_strName,
-          (const char *) _getGameModeName(_getSP()->sp_gmGameMode),
-          _SE_VER_STRING,
-          (const char *) _pShell->GetString("sam_strGameName"),
-          (const char *) _pShell->GetString("gam_strSessionName"));
-        _sendPacketTo(strPacket, &_sinFrom);
-        break;
+      // if we don't have enough space left for the next player
+      if(strlen(strPacket) + strlen(strPlayer) > 2048) {
+        _addSnapshotPacket(gas, gaq, strPacket);
+        strPacket = "";
       }
+      strPacket += strPlayer;
+    }
+  }
+}
 
-    case 3: // player status request
-      {
-        // send the player status response
-        CTString strPacket;
-        strPacket.PrintF("\x01players\x02%d\x03", _pNetwork->ga_srvServer.GetPlayersCount());
-        for(INDEX i=0; i<_pNetwork->ga_srvServer.GetPlayersCount(); i++) {
-          CPlayerBuffer &plb = _pNetwork->ga_srvServer.srv_aplbPlayers[i];
-          CPlayerTarget &plt = _pNetwork->ga_sesSessionState.ses_apltPlayers[i];
-          if(plt.plt_bActive) {
-            CTString strPlayer;
-            plt.plt_penPlayerEntity->GetGameAgentPlayerInfo(plb.plb_Index, strPlayer);
-
-            // if we don't have enough space left for the next player
-            if(strlen(strPacket) + strlen(strPlayer) > 2048) {
-              // send the packet
-              _sendPacketTo(strPacket, &_sinFrom);
-              strPacket = "";
-            }
+// shell variables put in responses, looked up only once
+static CTString *_pstrGameName = NULL;
+static CTString *_pstrSessionName = NULL;
+static CTString *_pstrLocalHost = NULL;
+static INDEX *_piPort = NULL;
 
-            strPacket += strPlayer;
-          }
-        }
+static const char *_getCachedString(CTString *&pstr, const char *strName)
+{
+  if (pstr==NULL) {
+    pstr = _pShell->GetStringPointer(strName);
+  }
+  return pstr!=NULL ? (const char *)*pstr : "";
+}
+static INDEX _getCachedINDEX(INDEX *&pi, const char *strName)
+{
+  if (pi==NULL) {
+    pi = _pShell->GetINDEXPointer(strName);
+  }
+  return pi!=NULL ? *pi : 0;
+}
 
-        strPacket += "\x04";
-        _sendPacketTo(strPacket, &_sinFrom);
-        break;
-      }
+// rebuild all responses and publish them to the query thread
+static void _publishSnapshot(void)
+{
+  GameAgentSnapshot &gas = _agasSnapshots[_iSnapshotWrite];
+  gas.gas_ctPackets = 0;
+  gas.gas_ctData = 0;
+
+  const INDEX ctPlayers = _pNetwork->ga_srvServer.GetPlayersCount();
+  const INDEX ctMaxPlayers = _pNetwork->ga_sesSessionState.ses_ctMaxPlayers;
+  const char *strLevel = _pNetwork->ga_World.wo_strName;
+  const CSessionProperties *psp = _getSP();
+  const CTString strGameMode = _getGameModeName(psp->sp_gmGameMode);
+  const char *strGameName = _getCachedString(_pstrGameName, "sam_strGameName");
+  const char *strSessionName = _getCachedString(_pstrSessionName, "gam_strSessionName");
+  const INDEX iPort = _getCachedINDEX(_piPort, "net_iPort");
 
-    case 4: // ping
-      {
-        // just send back 1 byte and the amount of players in the server (this could be useful in some cases for external scripts)
-        CTString strPacket;
-        strPacket.PrintF("\x04%d", _pNetwork->ga_srvServer.GetPlayersCount());
-        _sendPacketTo(strPacket, &_sinFrom);
-        break;
-      }
-     }
-   } else {
-
-      _szBuffer[iLen] = 0;
-      char *sPch1 = NULL, *sPch2 = NULL, *sPch3 = NULL, *sPch4 = NULL;
-      sPch1 = strstr(_szBuffer, "\\status\\");
-      sPch2 = strstr(_szBuffer, "\\info\\");
-      sPch3 = strstr(_szBuffer, "\\basic\\");
-      sPch4 = strstr(_szBuffer, "\\players\\");
-      if(sPch1) {
-        CTString strPacket;
-        CTString strLocation;
-        strLocation = _pShell->GetString("net_strLocalHost");
-        if ( strLocation == ""){
-          strLocation = "Heartland";
-        }
-        strPacket.PrintF( PCKQUERY,
-          (const char *) _pShell->GetString("sam_strGameName"),
-          _SE_VER_STRING,
-          //(const char *) _pShell->GetString("net_strLocalHost"),
-          (const char *) strLocation,
-          (const char *) _pShell->GetString("gam_strSessionName"),
-          _pShell->GetINDEX("net_iPort"),
-          (const char *) _pNetwork->ga_World.wo_strName,
-          (const char *) _getGameModeName(_getSP()->sp_gmGameMode),
-          _pNetwork->ga_srvServer.GetPlayersCount(),
-          _pNetwork->ga_sesSessionState.ses_ctMaxPlayers,
-          _pShell->GetINDEX("gam_bFriendlyFire"),
-          _pShell->GetINDEX("gam_bWeaponsStay"),
-          _pShell->GetINDEX("gam_bAmmoStays"),
-          _pShell->GetINDEX("gam_bHealthArmorStays"),
-          _pShell->GetINDEX("gam_bAllowHealth"),
-          _pShell->GetINDEX("gam_bAllowArmor"),
-          _pShell->GetINDEX("gam_bInfiniteAmmo"),
-          _pShell->GetINDEX("gam_bRespawnInPlace"));
-
-          for(INDEX i=0; i<_pNetwork->ga_srvServer.GetPlayersCount(); i++) {
-            CPlayerBuffer &plb = _pNetwork->ga_srvServer.srv_aplbPlayers[i];
-            CPlayerTarget &plt = _pNetwork->ga_sesSessionState.ses_apltPlayers[i];
-            if(plt.plt_bActive) {
-              CTString strPlayer;
-              plt.plt_penPlayerEntity->GetMSLegacyPlayerInf(plb.plb_Index, strPlayer);
-
-              // if we don't have enough space left for the next player
-              if(strlen(strPacket) + strlen(strPlayer) > 2048) {
-                // send the packet
-                _sendPacketTo(strPacket, &_sinFrom);
-                strPacket = "";
-              }
-              strPacket += strPlayer;
-            }
-          }
+  CTString strPacket;
+  if (!ga_bMSLegacy) {
+    strPacket.PrintF("players;%d;maxplayers;%d;level;%s;gametype;%s;version;%s;product;%s",
+      ctPlayers, ctMaxPlayers, strLevel, (const char *) strGameMode, _SE_VER_STRING, strGameName);
+    _addSnapshotPacket(gas, GAQ_HEARTBEAT, strPacket);
 
-        strPacket += "\\final\\\\queryid\\333.1";
-        _sendPacketTo(strPacket, &_sinFrom);
+    strPacket.PrintF("0;players;%d;maxplayers;%d;level;%s;gametype;%s;version;%s;gamename;%s;sessionname;%s",
+      ctPlayers, ctMaxPlayers, strLevel, (const char *) strGameMode, _SE_VER_STRING, strGameName, strSessionName);
+    _addSnapshotPacket(gas, GAQ_STATUS, strPacket);
 
-      } else if (sPch2){
+    strPacket.PrintF("\x01players\x02%d\x03", ctPlayers);
+    _addSnapshotPlayers(gas, GAQ_PLAYERS, strPacket, FALSE);
+    strPacket += "\x04";
+    _addSnapshotPacket(gas, GAQ_PLAYERS, strPacket);
 
-        CTString strPacket;
-        strPacket.PrintF( PCKINFO,
-          (const char *) _pShell->GetString("gam_strSessionName"),
-          _pShell->GetINDEX("net_iPort"),
-          (const char *) _pNetwork->ga_World.wo_strName,
-          (const char *) _getGameModeName(_getSP()->sp_gmGameMode),
-          _pNetwork->ga_srvServer.GetPlayersCount(),
-          _pNetwork->ga_sesSessionState.ses_ctMaxPlayers);
-        _sendPacketTo(strPacket, &_sinFrom);
+    // just 1 byte and the amount of players in the server (this could be useful in some cases for external scripts)
+    strPacket.PrintF("\x04%d", ctPlayers);
+    _addSnapshotPacket(gas, GAQ_PING, strPacket);
 
-      } else if (sPch3){
+  } else {
+    CTString strLocation = _getCachedString(_pstrLocalHost, "net_strLocalHost");
+    if (strLocation == "") {
+      strLocation = "Heartland";
+    }
+    // game rules are read by name, they are declared by the game and may change after startup
+    strPacket.PrintF( PCKQUERY,
+      strGameName,
+      _SE_VER_STRING,
+      (const char *) strLocation,
+      strSessionName,
+      iPort,
+      strLevel,
+      (const char *) strGameMode,
+      ctPlayers,
+      ctMaxPlayers,
+      _pShell->GetINDEX("gam_bFriendlyFire"),
+      _pShell->GetINDEX("gam_bWeaponsStay"),
+      _pShell->GetINDEX("gam_bAmmoStays"),
+      _pShell->GetINDEX("gam_bHealthArmorStays"),
+      _pShell->GetINDEX("gam_bAllowHealth"),
+      _pShell->GetINDEX("gam_bAllowArmor"),
+      _pShell->GetINDEX("gam_bInfiniteAmmo"),
+      _pShell->GetINDEX("gam_bRespawnInPlace"));
+    _addSnapshotPlayers(gas, GAQ_LEGACYSTATUS, strPacket, TRUE);
+    strPacket += "\\final\\\\queryid\\333.1";
+    _addSnapshotPacket(gas, GAQ_LEGACYSTATUS, strPacket);
+
+    strPacket.PrintF( PCKINFO, strSessionName, iPort, strLevel, (const char *) strGameMode, ctPlayers, ctMaxPlayers);
+    _addSnapshotPacket(gas, GAQ_LEGACYINFO, strPacket);
+
+    strPacket.PrintF( PCKBASIC, strGameName, _SE_VER_STRING, (const char *) strLocation);
+    _addSnapshotPacket(gas, GAQ_LEGACYBASIC, strPacket);
+
+    strPacket = "";
+    _addSnapshotPlayers(gas, GAQ_LEGACYPLAYERS, strPacket, TRUE);
+    strPacket += "\\final\\\\queryid\\6.1";
+    _addSnapshotPacket(gas, GAQ_LEGACYPLAYERS, strPacket);
+  }
 
-        CTString strPacket;
-        CTString strLocation;
-        strLocation = _pShell->GetString("net_strLocalHost");
-        if ( strLocation == ""){
-          strLocation = "Heartland";
-        }
-        strPacket.PrintF( PCKBASIC,
-          (const char *) _pShell->GetString("sam_strGameName"),
-          _SE_VER_STRING,
-          //(const char *) _pShell->GetString("net_strLocalHost"));
-          (const char *) strLocation);
-        _sendPacketTo(strPacket, &_sinFrom);
+  // swap it with the published one
+  _iSnapshotWrite = AtomicExchange(&_slSnapshotLatest, _iSnapshotWrite|4)&3;
+}
 
-      } else if (sPch4){
+// get the newest published snapshot
+static GameAgentSnapshot &_takeSnapshot(void)
+{
+  if (AtomicLoad(&_slSnapshotLatest)&4) {
+    _iSnapshotRead = AtomicExchange(&_slSnapshotLatest, _iSnapshotRead)&3;
+  }
+  return _agasSnapshots[_iSnapshotRead];
+}
 
-        // send the player status response
-        CTString strPacket;
-        strPacket = "";
-        for(INDEX i=0; i<_pNetwork->ga_srvServer.GetPlayersCount(); i++) {
-          CPlayerBuffer &plb = _pNetwork->ga_srvServer.srv_aplbPlayers[i];
-          CPlayerTarget &plt = _pNetwork->ga_sesSessionState.ses_apltPlayers[i];
-          if(plt.plt_bActive) {
-            CTString strPlayer;
-            plt.plt_penPlayerEntity->GetMSLegacyPlayerInf(plb.plb_Index, strPlayer);
-
-            // if we don't have enough space left for the next player
-            if(strlen(strPacket) + strlen(strPlayer) > 2048) {
-              // send the packet
-              _sendPacketTo(strPacket, &_sinFrom);
-              strPacket = "";
-            }
+// check if the address is not sending too many queries
+static BOOL _allowQuery(ULONG ulAddress, SLONG slSecond)
+{
+  const INDEX ctLimit = ga_iQueryRateLimit;
+  if (ctLimit<=0) {
+    return TRUE;
+  }
+  GameAgentRate &gar = _agarRates[(ULONG(ulAddress*2654435761UL))>>24];
+  if (gar.gar_ulAddress!=ulAddress || gar.gar_slSecond!=slSecond) {
+    gar.gar_ulAddress = ulAddress;
+    gar.gar_slSecond = slSecond;
+    gar.gar_ctQueries = 0;
+  }
+  gar.gar_ctQueries++;
+  return gar.gar_ctQueries<=ctLimit;
+}
+
+// find which legacy query a packet holds, by the first of its keys in order of precedence
+static INDEX _getLegacyQuery(const char *strPacket)
+{
+  INDEX iBest = -1;
+  for (const char *pch = strchr(strPacket, '\\'); pch!=NULL; pch = strchr(pch+1, '\\')) {
+    INDEX iQuery = -1;
+    if (strncmp(pch, "\\status\\", 8)==0) {
+      return GAQ_LEGACYSTATUS;
+    } else if (strncmp(pch, "\\info\\", 6)==0) {
+      iQuery = GAQ_LEGACYINFO;
+    } else if (strncmp(pch, "\\basic\\", 7)==0) {
+      iQuery = GAQ_LEGACYBASIC;
+    } else if (strncmp(pch, "\\players\\", 9)==0) {
+      iQuery = GAQ_LEGACYPLAYERS;
+    }
+    if (iQuery>=0 && (iBest<0 || iQuery<iBest)) {
+      iBest = iQuery;
+    }
+  }
+  return iBest;
+}
+
+// answer all received queries from given snapshot
+static void _drainQueries(SOCKET sock, GameAgentSnapshot &gas)
+{
+  char achBuffer[2050];
+  const SLONG slSecond = (SLONG)_pTimer->GetHighPrecisionTimer().GetSeconds();
+  FOREVER {
+    sockaddr_in sinFrom;
+    socklen_t fromLength = sizeof(sinFrom);
+    int iLen = recvfrom(sock, achBuffer, 2048, 0, (sockaddr*)&sinFrom, &fromLength);
+    if (iLen<=0) {
+      return;
+    }
+    achBuffer[iLen] = 0;
 
-            strPacket += strPlayer;
+    INDEX iQuery = -1;
+    if (!ga_bMSLegacy) {
+      switch (achBuffer[0]) {
+      case 1: { // server join response, send the challenge back with the heartbeat
+        if (iLen<1+(int)sizeof(INDEX)) {
+          break;
+        }
+        INDEX iChallenge;
+        memcpy(&iChallenge, achBuffer+1, sizeof(iChallenge));
+        for (INDEX iPacket=0; iPacket<gas.gas_ctPackets; iPacket++) {
+          if (gas.gas_aubQuery[iPacket]==GAQ_HEARTBEAT) {
+            char strHeartbeat[2100];
+            INDEX ctLen = _snprintf(strHeartbeat, sizeof(strHeartbeat), "0;challenge;%d;%.*s", iChallenge,
+              (int)gas.gas_aiLength[iPacket], gas.gas_achData+gas.gas_aiOffset[iPacket]);
+            _sendPacketTo(strHeartbeat, Clamp(ctLen, (INDEX)0, (INDEX)sizeof(strHeartbeat)-1), _sin);
+            AtomicStore(&_bChallengeAnswered, TRUE);
           }
         }
+        continue;
+      }
+      case 2: iQuery = GAQ_STATUS;  break; // server status request
+      case 3: iQuery = GAQ_PLAYERS; break; // player status request
+      case 4: iQuery = GAQ_PING;    break; // ping
+      }
+    } else {
+      iQuery = _getLegacyQuery(achBuffer);
+    }
+    if (iQuery<0) {
+      continue;
+    }
+    if (!_allowQuery(sinFrom.sin_addr.s_addr, slSecond)) {
+      continue;
+    }
+    for (INDEX iPacket=0; iPacket<gas.gas_ctPackets; iPacket++) {
+      if (gas.gas_aubQuery[iPacket]==iQuery) {
+        _sendPacketTo(gas.gas_achData+gas.gas_aiOffset[iPacket], gas.gas_aiLength[iPacket], &sinFrom);
+      }
+    }
+  }
+}
 
-        strPacket += "\\final\\\\queryid\\6.1";
-        _sendPacketTo(strPacket, &_sinFrom);
+static void _QueryThread(void *pvSocket)
+{
+  SOCKET sock = *(SOCKET*)pvSocket;
+  delete (SOCKET*)pvSocket;
+  while (!AtomicLoad(&_bQueryStop)) {
+    // wait for queries, but wake up now and then to check for stopping
+    fd_set fdsRead;
+    FD_ZERO(&fdsRead);
+    FD_SET(sock, &fdsRead);
+    timeval tvTimeout;
+    tvTimeout.tv_sec = 0;
+    tvTimeout.tv_usec = 50000;
+    const int iSelect = select((int)sock+1, &fdsRead, NULL, NULL, &tvTimeout);
+    if (iSelect==0) {
+      continue;
+    }
+    // on error, don't spin while waiting to be stopped
+    if (iSelect<0) {
+      ThreadSleep(50);
+      continue;
+    }
+    _drainQueries(sock, _takeSnapshot());
+  }
+}
 
-      } else {
-        CPrintF("Unknown query server response!\n");
-        return;
-      }
-   }
- }
+static void _startQueryThread(void)
+{
+  if (_pvQueryThread!=NULL || _socket==INVALID_SOCKET) {
+    return;
+  }
+  _publishSnapshot();
+  _tmLastSnapshot = _pTimer->GetRealTimeTick();
+  AtomicStore(&_bQueryStop, FALSE);
+  SOCKET *psock = new SOCKET;
+  *psock = _socket;
+  _pvQueryThread = ThreadCreate(&_QueryThread, psock);
+  // if no thread, queries are answered in updates
+  if (_pvQueryThread==NULL) {
+    delete psock;
+  }
+}
+
+static void _stopQueryThread(void)
+{
+  if (_pvQueryThread==NULL) {
+    return;
+  }
+  AtomicStore(&_bQueryStop, TRUE);
+  ThreadJoin(_pvQueryThread);
+  _pvQueryThread = NULL;
+}
+
+/// GameAgent server update call which responds to enumeration pings and sends pings to masterserver.
+extern void GameAgent_ServerUpdate(void)
+{
+  if((_socket == INVALID_SOCKET) || (!_bInitialized)) {
+    return;
+  }
 
+  // refresh the responses once per tick
+  const TIME tmNow = _pTimer->GetRealTimeTick();
+  if (tmNow-_tmLastSnapshot >= _pTimer->TickQuantum || tmNow<_tmLastSnapshot) {
+    _publishSnapshot();
+    _tmLastSnapshot = tmNow;
+  }
+  // if queries are not answered in background, do it here
+  if (_pvQueryThread==NULL) {
+    _drainQueries(_socket, _takeSnapshot());
+  }
+
+ // answering a challenge counts as a heartbeat
+ if (AtomicExchange(&_bChallengeAnswered, FALSE)) {
+   _tmLastHeartbeat = _pTimer->GetRealTimeTick();
+ }
  // send a heartbeat every 150 seconds
  if(_pTimer->GetRealTimeTick() - _tmLastHeartbeat >= 150.0f) {
     _sendHeartbeat(0);
@@ -877,6 +1066,10 @@ extern void GameAgent_EnumUpdate(void)
   if((_socket == INVALID_SOCKET) || (!_bInitialized)) {
     return;
   }
+  // socket is owned by the query thread while serving
+  if(_pvQueryThread != NULL) {
+    return;
+  }
 
   if (!ga_bMSLegacy) {
    int iLen = _recvPacket();
@@ -1509,4 +1702,110 @@ void*        _LocalNet_Thread(void *arg) {
     return 0;
 }
 
+/// Send queries to a server as fast as possible and count the responses.
+void QueryLoadTest(void *pArgs)
+{
+  CTString strHost = *NEXTARGUMENT(CTString*);
+  INDEX iPort = NEXTARGUMENT(INDEX);
+  INDEX ctSeconds = NEXTARGUMENT(INDEX);
+  ctSeconds = Clamp(ctSeconds, (INDEX)1, (INDEX)600);
+
+#ifdef PLATFORM_WIN32
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+    CPrintF("Error initializing winsock!\n");
+    return;
+  }
+#endif
+
+  sockaddr_in sinServer;
+  memset(&sinServer, 0, sizeof(sinServer));
+  sinServer.sin_family = AF_INET;
+  sinServer.sin_port = htons(iPort);
+  sinServer.sin_addr.s_addr = inet_addr(strHost);
+  if (sinServer.sin_addr.s_addr == INADDR_NONE) {
+    PHOSTENT phe = gethostbyname(strHost);
+    if (phe == NULL) {
+      CPrintF("Cannot resolve '%s'!\n", (const char *) strHost);
+      WSACleanup();
+      return;
+    }
+    memcpy(&sinServer.sin_addr, phe->h_addr_list[0], sizeof(sinServer.sin_addr));
+  }
+
+  SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock == INVALID_SOCKET) {
+    CPrintF("Error creating socket!\n");
+    WSACleanup();
+    return;
+  }
+#ifdef PLATFORM_WIN32
+  u_long ulNonBlocking = 1;
+  ioctlsocket(sock, FIONBIO, &ulNonBlocking);
+#else
+  fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+#endif
+
+  // queries in the protocol the server is configured for
+  static const char *astrLegacy[] = { "\\status\\", "\\info\\", "\\basic\\", "\\players\\" };
+  static const char achQueries[] = { 2, 3, 4 };
 
+  CPrintF("Querying %s:%d for %d seconds...\n", (const char *) strHost, iPort, ctSeconds);
+  // don't let this server limit the test, remote ones will still do it
+  const INDEX iRateLimitOld = ga_iQueryRateLimit;
+  if (iRateLimitOld>0) {
+    CPrintF("  (ga_iQueryRateLimit=%d disabled for the test, remote servers may still drop queries)\n", iRateLimitOld);
+    ga_iQueryRateLimit = 0;
+  }
+
+  __int64 ctSent = 0, ctReceived = 0, ctBytes = 0;
+  char achBuffer[2048];
+  const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  FOREVER {
+    const DOUBLE dElapsed = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+    if (dElapsed >= ctSeconds) {
+      break;
+    }
+    // send a batch of queries
+    for (INDEX i=0; i<64; i++) {
+      int iLen;
+      if (ga_bMSLegacy) {
+        const char *strQuery = astrLegacy[ctSent%ARRAYCOUNT(astrLegacy)];
+        iLen = sendto(sock, strQuery, strlen(strQuery), 0, (sockaddr*)&sinServer, sizeof(sinServer));
+      } else {
+        iLen = sendto(sock, &achQueries[ctSent%ARRAYCOUNT(achQueries)], 1, 0, (sockaddr*)&sinServer, sizeof(sinServer));
+      }
+      if (iLen <= 0) {
+        break;
+      }
+      ctSent++;
+    }
+    // take all responses that arrived meanwhile
+    FOREVER {
+      int iLen = recvfrom(sock, achBuffer, sizeof(achBuffer), 0, NULL, NULL);
+      if (iLen <= 0) {
+        break;
+      }
+      ctReceived++;
+      ctBytes += iLen;
+    }
+    ThreadSleep(1);
+  }
+  // wait a bit for late responses
+  ThreadSleep(250);
+  FOREVER {
+    int iLen = recvfrom(sock, achBuffer, sizeof(achBuffer), 0, NULL, NULL);
+    if (iLen <= 0) {
+      break;
+    }
+    ctReceived++;
+    ctBytes += iLen;
+  }
+  closesocket(sock);
+  WSACleanup();
+  ga_iQueryRateLimit = iRateLimitOld;
+
+  CPrintF("  sent:      %d queries (%.0f/s)\n", (INDEX)ctSent, DOUBLE(ctSent)/ctSeconds);
+  CPrintF("  received:  %d responses (%.0f/s)\n", (INDEX)ctReceived, DOUBLE(ctReceived)/ctSeconds);
+  CPrintF("  data:      %.1f KB (%.1f KB/s)\n", ctBytes/1024.0, ctBytes/1024.0/ctSeconds);
+}
@@ -22,6 +22,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 extern CTString ga_strServer;
 extern CTString ga_strMSLegacy;
 extern BOOL ga_bMSLegacy;
+extern INDEX ga_iQueryRateLimit;
 
 /// Initialize GameAgent.
 extern void GameAgent_ServerInit(void);
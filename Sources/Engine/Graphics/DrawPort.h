@@ -195,6 +195,9 @@ ENGINE_API CProjection3D *Particle_GetProjection(void);
 void ENGINE_API Particle_PrepareTexture( CTextureObject *pto, enum ParticleBlendType pbt);
 void ENGINE_API Particle_SetTexturePart( MEX mexWidth, MEX mexHeight, INDEX iCol, INDEX iRow);
 void ENGINE_API Particle_RenderSquare( const FLOAT3D &vPos, FLOAT fSize, ANGLE aRotation, COLOR col, FLOAT fYRatio=1.0f);
+// add many squares at once, given as arrays of positions, sizes, rotations (can be NULL) and colors
+void ENGINE_API Particle_RenderSquares( INDEX ctParticles, const FLOAT *pfX, const FLOAT *pfY, const FLOAT *pfZ,
+                                        const FLOAT *pfSize, const ANGLE *paRotation, const COLOR *pcol, FLOAT fYRatio=1.0f);
 void ENGINE_API Particle_RenderQuad3D( const FLOAT3D &vPos0, const FLOAT3D &vPos1, const FLOAT3D &vPos2,
                                        const FLOAT3D &vPos3, COLOR col);
 void ENGINE_API Particle_RenderLine( const FLOAT3D &vPos0, const FLOAT3D &vPos1, FLOAT fWidth, COLOR col);
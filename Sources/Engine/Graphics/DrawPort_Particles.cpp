@@ -26,7 +26,16 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/StaticStackArray.cpp>
-
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/BenchmarkUtil.h>
+
+// batched squares are projected and expanded four at a time where SSE is available
+#if !defined(USE_PORTABLE_C) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=1))
+  #define PARTICLES_SSE 1
+  #include <xmmintrin.h>
+#endif
 
 extern const FLOAT *pfSinTable;
 extern const FLOAT *pfCosTable;
@@ -51,6 +60,7 @@ static CDrawPort *_pDP;
 static CStaticStackArray<GFXTexCoord> _atexFogHaze;
 static CTextureData *_ptd = NULL;
 static INDEX _iFrame = 0;
+static BOOL _bPerspective = FALSE;
 
 
 
@@ -65,7 +75,8 @@ void Particle_PrepareSystem( CDrawPort *pdpDrawPort, CAnyProjection3D &prProject
   
   // prepare projection and scale factor
   pdpDrawPort->SetProjection(prProjection);
-  if( prProjection.IsPerspective()) _fPerspectiveFactor = ((CPerspectiveProjection3D*)&*prProjection)->ppr_PerspectiveRatios(1);
+  _bPerspective = prProjection.IsPerspective();
+  if( _bPerspective) _fPerspectiveFactor = ((CPerspectiveProjection3D*)&*prProjection)->ppr_PerspectiveRatios(1);
   
   // setup rendering mode
   gfxEnableDepthTest();
@@ -285,6 +296,291 @@ void Particle_RenderSquare( const FLOAT3D &vPos, FLOAT fSize, ANGLE aRotation, C
 
 
 
+// BATCHED SQUARES
+
+// batched squares are projected and expanded in chunks of this many
+#define PARTICLE_CHUNK 256
+
+// perspective projection and view frustum, taken out of the projection object
+struct ParticleFrustum {
+  FLOAT pf_afRotation[3][3];
+  FLOAT pf_afTranslation[3];
+  FLOAT pf_fNear, pf_fFar;     // z of near and far plane (far is used only if pf_bFar)
+  BOOL  pf_bFar;
+  FLOAT pf_afL[3], pf_afR[3], pf_afU[3], pf_afD[3];  // used plane components and distances
+  FLOAT pf_fPerspective;
+};
+
+// projected centers of one chunk, and results of frustum test (-1 outside, 0 needs clipping, +1 inside)
+static FLOAT _afProjI[PARTICLE_CHUNK], _afProjJ[PARTICLE_CHUNK], _afProjK[PARTICLE_CHUNK];
+static INDEX _aiProjTest[PARTICLE_CHUNK];
+// visible squares of one chunk
+static FLOAT _afQuadI[PARTICLE_CHUNK], _afQuadJ[PARTICLE_CHUNK], _afQuadK[PARTICLE_CHUNK];
+static FLOAT _afQuadRX[PARTICLE_CHUNK], _afQuadRY[PARTICLE_CHUNK];
+static FLOAT _afQuadSin[PARTICLE_CHUNK], _afQuadCos[PARTICLE_CHUNK], _afQuadRotated[PARTICLE_CHUNK];
+static GFXColor _acolQuad[PARTICLE_CHUNK];
+
+
+static void PrepareFrustum( ParticleFrustum &pf)
+{
+  const CProjection3D &pr = *_pprProjection;
+  for( INDEX i=0; i<3; i++) {
+    for( INDEX j=0; j<3; j++) pf.pf_afRotation[i][j] = pr.pr_RotationMatrix(i+1,j+1);
+    pf.pf_afTranslation[i] = pr.pr_TranslationVector(i+1);
+  }
+  pf.pf_fNear = -pr.pr_NearClipDistance;
+  pf.pf_fFar  = -pr.pr_FarClipDistance;
+  pf.pf_bFar  = pr.pr_FarClipDistance>0;
+  pf.pf_afL[0] = pr.pr_plClipL(1);  pf.pf_afL[1] = pr.pr_plClipL(3);  pf.pf_afL[2] = pr.pr_plClipL.Distance();
+  pf.pf_afR[0] = pr.pr_plClipR(1);  pf.pf_afR[1] = pr.pr_plClipR(3);  pf.pf_afR[2] = pr.pr_plClipR.Distance();
+  pf.pf_afU[0] = pr.pr_plClipU(2);  pf.pf_afU[1] = pr.pr_plClipU(3);  pf.pf_afU[2] = pr.pr_plClipU.Distance();
+  pf.pf_afD[0] = pr.pr_plClipD(2);  pf.pf_afD[1] = pr.pr_plClipD(3);  pf.pf_afD[2] = pr.pr_plClipD.Distance();
+  pf.pf_fPerspective = _fPerspectiveFactor;
+}
+
+
+// project one square and test it as PreClip() and TestSphereToFrustum() would
+static inline void ProjectSquare( const ParticleFrustum &pf, FLOAT fX, FLOAT fY, FLOAT fZ, FLOAT fR, INDEX i)
+{
+  const FLOAT (&m)[3][3] = pf.pf_afRotation;
+  const FLOAT fI = m[0][0]*fX + m[0][1]*fY + m[0][2]*fZ + pf.pf_afTranslation[0];
+  const FLOAT fJ = m[1][0]*fX + m[1][1]*fY + m[1][2]*fZ + pf.pf_afTranslation[1];
+  const FLOAT fK = m[2][0]*fX + m[2][1]*fY + m[2][2]*fZ + pf.pf_afTranslation[2];
+  _afProjI[i] = fI;
+  _afProjJ[i] = fJ;
+  _afProjK[i] = fK;
+
+  INDEX iPass = +1;
+  if( fR<0.0001f) iPass = -1;
+  else {
+    if( fK-fR>pf.pf_fNear) iPass = -1; else if( fK+fR>pf.pf_fNear) iPass = 0;
+    if( pf.pf_bFar) {
+      if( fK+fR<pf.pf_fFar) iPass = -1; else if( fK-fR<pf.pf_fFar && iPass>0) iPass = 0;
+    }
+    const FLOAT fDL = fI*pf.pf_afL[0] + fK*pf.pf_afL[1] - pf.pf_afL[2];
+    const FLOAT fDR = fI*pf.pf_afR[0] + fK*pf.pf_afR[1] - pf.pf_afR[2];
+    const FLOAT fDU = fJ*pf.pf_afU[0] + fK*pf.pf_afU[1] - pf.pf_afU[2];
+    const FLOAT fDD = fJ*pf.pf_afD[0] + fK*pf.pf_afD[1] - pf.pf_afD[2];
+    if( fDL<-fR || fDR<-fR || fDU<-fR || fDD<-fR) iPass = -1;
+    else if( iPass>0 && (fDL<fR || fDR<fR || fDU<fR || fDD<fR)) iPass = 0;
+    if( fR*pf.pf_fPerspective/fK<0.5f) iPass = -1;
+  }
+  _aiProjTest[i] = iPass;
+}
+
+
+// expand one visible square to its four vertices
+static inline void ExpandSquare( GFXVertex *pvtx, INDEX i)
+{
+  const FLOAT fI0  = _afQuadI[i];
+  const FLOAT fJ0  = _afQuadJ[i];
+  const FLOAT fOoK = _afQuadK[i];
+  const FLOAT fRX  = _afQuadRX[i];
+  const FLOAT fRY  = _afQuadRY[i];
+  // offsets of corners (see Particle_RenderSquare())
+  FLOAT fA, fB, fC, fD;
+  if( _afQuadRotated[i]==0) {
+    fA = fRX;  fB = -fRX;  fC = fRY;  fD = -fRY;
+  } else {
+    const FLOAT fSinPCos = _afQuadCos[i]*fRX+_afQuadSin[i]*fRY;
+    const FLOAT fSinMCos = _afQuadSin[i]*fRX-_afQuadCos[i]*fRY;
+    fA = fSinPCos;  fB = fSinMCos;  fC = fSinMCos;  fD = fSinPCos;
+  }
+  pvtx[0].x = fI0-fA;  pvtx[0].y = fJ0-fC;  pvtx[0].z = fOoK;
+  pvtx[1].x = fI0+fB;  pvtx[1].y = fJ0-fD;  pvtx[1].z = fOoK;
+  pvtx[2].x = fI0+fA;  pvtx[2].y = fJ0+fC;  pvtx[2].z = fOoK;
+  pvtx[3].x = fI0-fB;  pvtx[3].y = fJ0+fD;  pvtx[3].z = fOoK;
+}
+
+
+#if PARTICLES_SSE
+
+// project and test four squares at once
+static inline void ProjectSquares4( const ParticleFrustum &pf, const FLOAT *pfX, const FLOAT *pfY, const FLOAT *pfZ,
+                                    const FLOAT *pfR, INDEX i)
+{
+  const FLOAT (&m)[3][3] = pf.pf_afRotation;
+  const __m128 mX = _mm_loadu_ps(pfX+i);
+  const __m128 mY = _mm_loadu_ps(pfY+i);
+  const __m128 mZ = _mm_loadu_ps(pfZ+i);
+  const __m128 mR = _mm_loadu_ps(pfR+i);
+  #define ROW(r) _mm_add_ps( _mm_add_ps( _mm_add_ps( \
+    _mm_mul_ps( _mm_set1_ps(m[r][0]), mX), _mm_mul_ps( _mm_set1_ps(m[r][1]), mY)), \
+    _mm_mul_ps( _mm_set1_ps(m[r][2]), mZ)), _mm_set1_ps(pf.pf_afTranslation[r]))
+  const __m128 mI = ROW(0);
+  const __m128 mJ = ROW(1);
+  const __m128 mK = ROW(2);
+  #undef ROW
+  _mm_storeu_ps( _afProjI+i, mI);
+  _mm_storeu_ps( _afProjJ+i, mJ);
+  _mm_storeu_ps( _afProjK+i, mK);
+
+  const __m128 mNegR = _mm_sub_ps( _mm_setzero_ps(), mR);
+  __m128 mOut  = _mm_cmplt_ps( mR, _mm_set1_ps(0.0001f));
+  __m128 mClip = _mm_setzero_ps();
+  // near and far
+  const __m128 mNear = _mm_set1_ps(pf.pf_fNear);
+  mOut  = _mm_or_ps( mOut,  _mm_cmpgt_ps( _mm_sub_ps( mK, mR), mNear));
+  mClip = _mm_or_ps( mClip, _mm_cmpgt_ps( _mm_add_ps( mK, mR), mNear));
+  if( pf.pf_bFar) {
+    const __m128 mFar = _mm_set1_ps(pf.pf_fFar);
+    mOut  = _mm_or_ps( mOut,  _mm_cmplt_ps( _mm_add_ps( mK, mR), mFar));
+    mClip = _mm_or_ps( mClip, _mm_cmplt_ps( _mm_sub_ps( mK, mR), mFar));
+  }
+  // side planes
+  #define PLANE(afPlane, mA) { \
+    const __m128 mDist = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( mA, _mm_set1_ps(afPlane[0])), \
+      _mm_mul_ps( mK, _mm_set1_ps(afPlane[1]))), _mm_set1_ps(afPlane[2])); \
+    mOut  = _mm_or_ps( mOut,  _mm_cmplt_ps( mDist, mNegR)); \
+    mClip = _mm_or_ps( mClip, _mm_cmplt_ps( mDist, mR)); }
+  PLANE( pf.pf_afL, mI);
+  PLANE( pf.pf_afR, mI);
+  PLANE( pf.pf_afU, mJ);
+  PLANE( pf.pf_afD, mJ);
+  #undef PLANE
+  // too small on screen
+  const __m128 mPixSize = _mm_div_ps( _mm_mul_ps( mR, _mm_set1_ps(pf.pf_fPerspective)), mK);
+  mOut = _mm_or_ps( mOut, _mm_cmplt_ps( mPixSize, _mm_set1_ps(0.5f)));
+
+  const int iOut  = _mm_movemask_ps(mOut);
+  const int iClip = _mm_movemask_ps(mClip);
+  for( INDEX j=0; j<4; j++) {
+    _aiProjTest[i+j] = (iOut&(1<<j)) ? -1 : ((iClip&(1<<j)) ? 0 : +1);
+  }
+}
+
+
+// expand four visible squares at once
+static inline void ExpandSquares4( GFXVertex *pvtx, INDEX i)
+{
+  const __m128 mI   = _mm_loadu_ps(_afQuadI+i);
+  const __m128 mJ   = _mm_loadu_ps(_afQuadJ+i);
+  const __m128 mRX  = _mm_loadu_ps(_afQuadRX+i);
+  const __m128 mRY  = _mm_loadu_ps(_afQuadRY+i);
+  const __m128 mSin = _mm_loadu_ps(_afQuadSin+i);
+  const __m128 mCos = _mm_loadu_ps(_afQuadCos+i);
+  const __m128 mRot = _mm_cmpneq_ps( _mm_loadu_ps(_afQuadRotated+i), _mm_setzero_ps());
+  const __m128 mSinPCos = _mm_add_ps( _mm_mul_ps( mCos, mRX), _mm_mul_ps( mSin, mRY));
+  const __m128 mSinMCos = _mm_sub_ps( _mm_mul_ps( mSin, mRX), _mm_mul_ps( mCos, mRY));
+  const __m128 mZero = _mm_setzero_ps();
+  // offsets of corners for rotated and not rotated squares (see ExpandSquare())
+  #define SELECT(mRotated, mStraight) _mm_or_ps( _mm_and_ps( mRot, mRotated), _mm_andnot_ps( mRot, mStraight))
+  const __m128 mA = SELECT( mSinPCos, mRX);
+  const __m128 mB = SELECT( mSinMCos, _mm_sub_ps( mZero, mRX));
+  const __m128 mC = SELECT( mSinMCos, mRY);
+  const __m128 mD = SELECT( mSinPCos, _mm_sub_ps( mZero, mRY));
+  #undef SELECT
+  FLOAT afX[4][4], afY[4][4];
+  _mm_storeu_ps( afX[0], _mm_sub_ps( mI, mA));  _mm_storeu_ps( afY[0], _mm_sub_ps( mJ, mC));
+  _mm_storeu_ps( afX[1], _mm_add_ps( mI, mB));  _mm_storeu_ps( afY[1], _mm_sub_ps( mJ, mD));
+  _mm_storeu_ps( afX[2], _mm_add_ps( mI, mA));  _mm_storeu_ps( afY[2], _mm_add_ps( mJ, mC));
+  _mm_storeu_ps( afX[3], _mm_sub_ps( mI, mB));  _mm_storeu_ps( afY[3], _mm_add_ps( mJ, mD));
+  for( INDEX j=0; j<4; j++) {
+    const FLOAT fOoK = _afQuadK[i+j];
+    for( INDEX iCorner=0; iCorner<4; iCorner++) {
+      GFXVertex &vtx = pvtx[j*4+iCorner];
+      vtx.x = afX[iCorner][j];
+      vtx.y = afY[iCorner][j];
+      vtx.z = fOoK;
+    }
+  }
+}
+
+#endif // PARTICLES_SSE
+
+
+// add many particle squares to rendering queue
+void Particle_RenderSquares( INDEX ctParticles, const FLOAT *pfX, const FLOAT *pfY, const FLOAT *pfZ,
+                             const FLOAT *pfSize, const ANGLE *paRotation, const COLOR *pcol, FLOAT fYRatio/*=1.0f*/)
+{
+  // fog and haze are applied per particle, and other projections are used only in editor
+  if( !_bPerspective || _Particle_bHasFog || _Particle_bHasHaze) {
+    // so render those one by one
+    for( INDEX i=0; i<ctParticles; i++) {
+      const ANGLE aRotation = (paRotation!=NULL) ? paRotation[i] : 0.0f;
+      Particle_RenderSquare( FLOAT3D(pfX[i], pfY[i], pfZ[i]), pfSize[i], aRotation, pcol[i], fYRatio);
+    }
+    return;
+  }
+
+  ParticleFrustum pf;
+  PrepareFrustum(pf);
+  // most effects use few colors, so adjust each only once
+  COLOR colLast = 0;
+  GFXColor glcolLast(0);
+  BOOL bHasLast = FALSE;
+
+  // for each chunk
+  for( INDEX iFirst=0; iFirst<ctParticles; iFirst+=PARTICLE_CHUNK)
+  {
+    const INDEX ctChunk = Min( ctParticles-iFirst, INDEX(PARTICLE_CHUNK));
+    // project and test against frustum
+    INDEX i=0;
+#if PARTICLES_SSE
+    for( ; i+4<=ctChunk; i+=4) ProjectSquares4( pf, pfX+iFirst, pfY+iFirst, pfZ+iFirst, pfSize+iFirst, i);
+#endif
+    for( ; i<ctChunk; i++) ProjectSquare( pf, pfX[iFirst+i], pfY[iFirst+i], pfZ[iFirst+i], pfSize[iFirst+i], i);
+
+    // gather visible ones
+    INDEX ctVisible = 0;
+    for( i=0; i<ctChunk; i++) {
+      const INDEX iTest = _aiProjTest[i];
+      const COLOR col = pcol[iFirst+i];
+      if( iTest<0 || ((col&CT_AMASK)>>CT_ASHIFT)<2) continue;
+      if( iTest==0) _bNeedsClipping = TRUE;
+      const FLOAT fSize = pfSize[iFirst+i];
+      _afQuadI[ctVisible]  = _afProjI[i];
+      _afQuadJ[ctVisible]  = _afProjJ[i];
+      _afQuadK[ctVisible]  = _afProjK[i];
+      _afQuadRX[ctVisible] = fSize;
+      _afQuadRY[ctVisible] = fSize*fYRatio;
+      const ANGLE aRotation = (paRotation!=NULL) ? paRotation[iFirst+i] : 0.0f;
+      if( aRotation==0) {
+        _afQuadSin[ctVisible] = 0.0f;
+        _afQuadCos[ctVisible] = 0.0f;
+        _afQuadRotated[ctVisible] = 0.0f;
+      } else {
+        const INDEX iRot256 = FloatToInt(aRotation*0.7111f) & 255; // *256/360
+        _afQuadSin[ctVisible] = pfSinTable[iRot256];
+        _afQuadCos[ctVisible] = pfCosTable[iRot256];
+        _afQuadRotated[ctVisible] = 1.0f;
+      }
+      if( !bHasLast || col!=colLast) {
+        colLast = col;
+        glcolLast = GFXColor( AdjustColor( col, _slTexHueShift, _slTexSaturation));
+        bHasLast = TRUE;
+      }
+      _acolQuad[ctVisible] = glcolLast;
+      ctVisible++;
+    }
+    if( ctVisible==0) continue;
+
+    // add to vertex arrays
+    GFXVertex   *pvtx = _avtxCommon.Push(ctVisible*4);
+    GFXTexCoord *ptex = _atexCommon.Push(ctVisible*4);
+    GFXColor    *pcolOut = _acolCommon.Push(ctVisible*4);
+    // expand to quads
+    i=0;
+#if PARTICLES_SSE
+    for( ; i+4<=ctVisible; i+=4) ExpandSquares4( pvtx+i*4, i);
+#endif
+    for( ; i<ctVisible; i++) ExpandSquare( pvtx+i*4, i);
+    // texture coords and colors
+    for( i=0; i<ctVisible; i++) {
+      ptex[i*4+0] = _atex[1];
+      ptex[i*4+1] = _atex[0];
+      ptex[i*4+2] = _atex[3];
+      ptex[i*4+3] = _atex[2];
+      pcolOut[i*4+0] = _acolQuad[i];
+      pcolOut[i*4+1] = _acolQuad[i];
+      pcolOut[i*4+2] = _acolQuad[i];
+      pcolOut[i*4+3] = _acolQuad[i];
+    }
+  }
+}
+
+
+
 // add one particle line to rendering queue
 void Particle_RenderLine( const FLOAT3D &vPos0, const FLOAT3D &vPos1, FLOAT fWidth, COLOR col)
 {
@@ -560,6 +856,26 @@ void Particle_Flush(void)
 
 // SORTING ROUTINES
 
+// particles are sorted by radix sort on depth keys, in three passes of 11 bits
+#define SORT_BITS    11
+#define SORT_BUCKETS (1<<SORT_BITS)
+#define SORT_PASSES  3
+
+static CStaticStackArray<ULONG> _aulSortKeys[2];
+static CStaticStackArray<INDEX> _aiSortIndices[2];
+static CStaticStackArray<GFXVertex>   _avtxSorted;
+static CStaticStackArray<GFXTexCoord> _atexSorted;
+static CStaticStackArray<GFXColor>    _acolSorted;
+
+// make a key that sorts ascending as float sorts descending
+static inline ULONG DescendingKey( FLOAT f)
+{
+  ULONG ul = (ULONG&)f;
+  ul = (ul&0x80000000) ? ~ul : (ul|0x80000000);
+  return ~ul;
+}
+
+// reference comparator (used only for benchmark)
 static int qsort_CompareZ( const void *pI0, const void *pI1) {
   const INDEX i0 = (*(INDEX*)pI0) *4;
   const INDEX i1 = (*(INDEX*)pI1) *4;
@@ -570,74 +886,220 @@ static int qsort_CompareZ( const void *pI0, const void *pI1) {
   else              return  0;
 }
 
-static int qsort_CompareZ3D( const void *pI0, const void *pI1) {
-  const INDEX i0 = (*(INDEX*)pI0) *4;
-  const INDEX i1 = (*(INDEX*)pI1) *4;
-  const FLOAT fZ0 = (_avtxCommon[i0].z + _avtxCommon[i0+1].z + _avtxCommon[i0+2].z + _avtxCommon[i0+3].z) / 4.0f;
-  const FLOAT fZ1 = (_avtxCommon[i1].z + _avtxCommon[i1+1].z + _avtxCommon[i1+2].z + _avtxCommon[i1+3].z) / 4.0f;
-       if( fZ0<fZ1) return +1;
-  else if( fZ0>fZ1) return -1;
-  else              return  0;
-}
-
 
 // sorts particles by distance
 void Particle_Sort( BOOL b3D/*=FALSE*/)
 {
   INDEX i;
   const INDEX ctParticles = _avtxCommon.Count()/4; 
-  if( ctParticles<=0) return; // nothing to do!
+  if( ctParticles<=1) return; // nothing to do!
+
+  // make sort keys
+  _aulSortKeys[0].PopAll();    _aulSortKeys[1].PopAll();
+  _aiSortIndices[0].PopAll();  _aiSortIndices[1].PopAll();
+  ULONG *pulKeys    = _aulSortKeys[0].Push(ctParticles);
+  ULONG *pulKeysTmp = _aulSortKeys[1].Push(ctParticles);
+  INDEX *piIndices    = _aiSortIndices[0].Push(ctParticles);
+  INDEX *piIndicesTmp = _aiSortIndices[1].Push(ctParticles);
+  const GFXVertex *pvtx = &_avtxCommon[0];
+  for( i=0; i<ctParticles; i++) {
+    const FLOAT fZ = b3D ? (pvtx[i*4+0].z + pvtx[i*4+1].z + pvtx[i*4+2].z + pvtx[i*4+3].z) / 4.0f : pvtx[i*4].z;
+    pulKeys[i]   = DescendingKey(fZ);
+    piIndices[i] = i;
+  }
 
-  // generate sort array
-  CStaticArray<INDEX> aiIndices;
-  aiIndices.New(ctParticles);
-  for( i=0; i<ctParticles; i++) aiIndices[i] = i;
+  // count digits of all passes at once
+  static INDEX aiCounts[SORT_PASSES][SORT_BUCKETS];
+  memset( aiCounts, 0, sizeof(aiCounts));
+  for( i=0; i<ctParticles; i++) {
+    const ULONG ulKey = pulKeys[i];
+    aiCounts[0][ ulKey             &(SORT_BUCKETS-1)]++;
+    aiCounts[1][(ulKey>>SORT_BITS)  &(SORT_BUCKETS-1)]++;
+    aiCounts[2][(ulKey>>SORT_BITS*2)&(SORT_BUCKETS-1)]++;
+  }
 
-  // bubble sort indices by vertex Z coord
-  if(b3D) qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ3D);
-  else    qsort( &aiIndices[0], ctParticles, sizeof(INDEX), qsort_CompareZ);
+  // for each pass
+  for( INDEX iPass=0; iPass<SORT_PASSES; iPass++)
+  { // skip it if all keys have same digit there (particles are often at similar depths)
+    INDEX *piCounts = aiCounts[iPass];
+    const INDEX iShift = iPass*SORT_BITS;
+    if( piCounts[(pulKeys[0]>>iShift)&(SORT_BUCKETS-1)]==ctParticles) continue;
+    // make offsets
+    INDEX iOffset = 0;
+    for( INDEX iBucket=0; iBucket<SORT_BUCKETS; iBucket++) {
+      const INDEX ct = piCounts[iBucket];
+      piCounts[iBucket] = iOffset;
+      iOffset += ct;
+    }
+    // distribute (stable, so previous passes stay in order)
+    for( i=0; i<ctParticles; i++) {
+      const ULONG ulKey = pulKeys[i];
+      const INDEX iDst = piCounts[(ulKey>>iShift)&(SORT_BUCKETS-1)]++;
+      pulKeysTmp[iDst]   = ulKey;
+      piIndicesTmp[iDst] = piIndices[i];
+    }
+    Swap( pulKeys,   pulKeysTmp);
+    Swap( piIndices, piIndicesTmp);
+  }
 
-  // generate inverse table
-  CStaticArray<INDEX> aiInverse;
-  aiInverse.New(ctParticles);
+  // gather vertices, texture coords and colors in sorted order
+  const INDEX ctVertices = ctParticles*4;
+  _avtxSorted.PopAll();
+  _atexSorted.PopAll();
+  _acolSorted.PopAll();
+  GFXVertex   *pvtxSorted = _avtxSorted.Push(ctVertices);
+  GFXTexCoord *ptexSorted = _atexSorted.Push(ctVertices);
+  GFXColor    *pcolSorted = _acolSorted.Push(ctVertices);
+  const GFXTexCoord *ptex = &_atexCommon[0];
+  const GFXColor    *pcol = &_acolCommon[0];
   for( i=0; i<ctParticles; i++) {
-    const INDEX iOrig = aiIndices[i];
-    aiInverse[iOrig] = i;
-  }
-
-  // sort vertices by indices
-  for( i=0; i<ctParticles;) // i is incremented in loop
-  { // fetch destination
-    INDEX &iWhere = aiInverse[i];
-    ASSERT( iWhere<ctParticles);
-    // if current is already in place, advance to next index
-    if( iWhere==i) { i++; continue; }
-    // swap vertices
-    Swap( _avtxCommon[iWhere*4+0], _avtxCommon[i*4+0]);
-    Swap( _avtxCommon[iWhere*4+1], _avtxCommon[i*4+1]);
-    Swap( _avtxCommon[iWhere*4+2], _avtxCommon[i*4+2]);
-    Swap( _avtxCommon[iWhere*4+3], _avtxCommon[i*4+3]);
-    // swap texture coords
-    Swap( _atexCommon[iWhere*4+0], _atexCommon[i*4+0]);
-    Swap( _atexCommon[iWhere*4+1], _atexCommon[i*4+1]);
-    Swap( _atexCommon[iWhere*4+2], _atexCommon[i*4+2]);
-    Swap( _atexCommon[iWhere*4+3], _atexCommon[i*4+3]);
-    // swap colors
-    Swap( _acolCommon[iWhere*4+0], _acolCommon[i*4+0]);
-    Swap( _acolCommon[iWhere*4+1], _acolCommon[i*4+1]);
-    Swap( _acolCommon[iWhere*4+2], _acolCommon[i*4+2]);
-    Swap( _acolCommon[iWhere*4+3], _acolCommon[i*4+3]);
-    // swap indices
-    Swap( aiInverse[iWhere], aiInverse[i]);
+    const INDEX iSrc = piIndices[i]*4;
+    memcpy( pvtxSorted+i*4, pvtx+iSrc, 4*sizeof(GFXVertex));
+    memcpy( ptexSorted+i*4, ptex+iSrc, 4*sizeof(GFXTexCoord));
+    memcpy( pcolSorted+i*4, pcol+iSrc, 4*sizeof(GFXColor));
   }
+  memcpy( &_avtxCommon[0], pvtxSorted, ctVertices*sizeof(GFXVertex));
+  memcpy( &_atexCommon[0], ptexSorted, ctVertices*sizeof(GFXTexCoord));
+  memcpy( &_acolCommon[0], pcolSorted, ctVertices*sizeof(GFXColor));
 
 #ifndef NDEBUG
   // test to see whether the array is sorted
-  INDEX      *pidx = &aiInverse[0];
-  GFXVertex4 *pvtx = &_avtxCommon[0];
   for( i=0; i<ctParticles-1; i++) {
-    ASSERT( pidx[i] < pidx[i+1]);
-    ASSERT( pvtx[i*4].z >= pvtx[(i+1)*4].z);
+    ASSERT( pulKeys[i] <= pulKeys[i+1]);
+    ASSERT( b3D || _avtxCommon[i*4].z >= _avtxCommon[(i+1)*4].z);
   }
 #endif
 }
+
+
+
+// BENCHMARK
+
+// time and compare scalar and batched squares, and radix and qsort sorting (no rendering is done)
+void ParticleBenchmark(void *pArgs)
+{
+  INDEX ctParticles = NEXTARGUMENT(INDEX);
+  ctParticles = Clamp( ctParticles, (INDEX)100, (INDEX)1000000);
+  if( _avtxCommon.Count()>0) {
+    CPrintF("Cannot run particle benchmark while rendering.\n");
+    return;
+  }
+
+  // setup projection and particle system as Particle_PrepareSystem() would
+  CPerspectiveProjection3D prPerspective;
+  prPerspective.FOVL() = AngleDeg(90.0f);
+  prPerspective.ScreenBBoxL() = FLOATaabbox2D( FLOAT2D(0.0f, 0.0f), FLOAT2D(640.0f, 480.0f));
+  prPerspective.AspectRatioL() = 1.0f;
+  prPerspective.FrontClipDistanceL() = 0.25f;
+  prPerspective.ViewerPlacementL()  = CPlacement3D( FLOAT3D(0,0,0), ANGLE3D(0,0,0));
+  prPerspective.ObjectPlacementL()  = CPlacement3D( FLOAT3D(0,0,0), ANGLE3D(0,0,0));
+  prPerspective.Prepare();
+  CProjection3D *pprProjectionOld = _pprProjection;
+  _pprProjection = &prPerspective;
+  _fNearClipDistance  = -prPerspective.pr_NearClipDistance;
+  _fPerspectiveFactor = prPerspective.ppr_PerspectiveRatios(1);
+  _bPerspective = TRUE;
+  const BOOL bHasFogOld  = _Particle_bHasFog;
+  const BOOL bHasHazeOld = _Particle_bHasHaze;
+  _Particle_bHasFog  = FALSE;
+  _Particle_bHasHaze = FALSE;
+  _bTransFogHaze = FALSE;
+  _atexFogHaze.PopAll();
+  _atexFogHaze.Push(4);
+  for( INDEX iTex=0; iTex<4; iTex++) {
+    _atex[iTex].st.s = (iTex&1) ? 1.0f : 0.0f;
+    _atex[iTex].st.t = (iTex&2) ? 1.0f : 0.0f;
+  }
+
+  // make particles in front of viewer (some out of view, some rotated)
+  CStaticArray<FLOAT> afX, afY, afZ, afSize;
+  CStaticArray<ANGLE> aaRotation;
+  CStaticArray<COLOR> acol;
+  afX.New(ctParticles);  afY.New(ctParticles);  afZ.New(ctParticles);
+  afSize.New(ctParticles);  aaRotation.New(ctParticles);  acol.New(ctParticles);
+  CBenchmarkRandom rnd;
+  #define RND (rnd.NextFloat())
+  INDEX i;
+  for( i=0; i<ctParticles; i++) {
+    const FLOAT fZ = -0.5f-RND*100.0f;
+    afX[i] = (RND*2.4f-1.2f)*fZ;
+    afY[i] = (RND*2.0f-1.0f)*fZ;
+    afZ[i] = fZ;
+    afSize[i] = 0.05f+RND*0.5f;
+    aaRotation[i] = (RND<0.5f) ? 0.0f : RND*360.0f;
+    acol[i] = (RND<0.9f) ? C_WHITE|0x80 : C_lBLUE|0xFF;
+  }
+  #undef RND
+  CPrintF("Particle benchmark with %d particles:\n", ctParticles);
+  CBenchmarkTimer bt;
+
+  // scalar
+  bt.Start();
+  for( i=0; i<ctParticles; i++) {
+    Particle_RenderSquare( FLOAT3D(afX[i], afY[i], afZ[i]), afSize[i], aaRotation[i], acol[i]);
+  }
+  const DOUBLE dScalar = bt.Stop();
+  const INDEX ctVertices = _avtxCommon.Count();
+  CStaticArray<GFXVertex> avtxScalar;
+  CStaticArray<GFXColor>  acolScalar;
+  avtxScalar.New(Max(ctVertices, (INDEX)1));
+  acolScalar.New(Max(ctVertices, (INDEX)1));
+  if( ctVertices>0) {
+    memcpy( &avtxScalar[0], &_avtxCommon[0], ctVertices*sizeof(GFXVertex));
+    memcpy( &acolScalar[0], &_acolCommon[0], ctVertices*sizeof(GFXColor));
+  }
+  gfxResetArrays();
+
+  // batched
+  bt.Start();
+  Particle_RenderSquares( ctParticles, &afX[0], &afY[0], &afZ[0], &afSize[0], &aaRotation[0], &acol[0]);
+  const DOUBLE dBatched = bt.Stop();
+
+  // compare
+  INDEX ctMismatches = 0;
+  if( _avtxCommon.Count()!=ctVertices) ctMismatches = 1;
+  else {
+    for( i=0; i<ctVertices; i++) {
+      const GFXVertex &v0 = avtxScalar[i];
+      const GFXVertex &v1 = _avtxCommon[i];
+      const FLOAT fEpsilon = 0.001f*(1.0f+Abs(v0.x)+Abs(v0.y));
+      if( Abs(v0.x-v1.x)>fEpsilon || Abs(v0.y-v1.y)>fEpsilon || v0.z!=v1.z
+       || acolScalar[i].ul.abgr!=_acolCommon[i].ul.abgr) ctMismatches++;
+    }
+  }
+  const INDEX ctVisible = ctVertices/4;
+  CPrintF("  %-28s %9.1f particles/ms  (%.3f ms)\n", "submit (one by one)", ctParticles/(dScalar*1000.0), dScalar*1000.0);
+  CPrintF("  %-28s %9.1f particles/ms  (%.3f ms)\n", "submit (batched)", ctParticles/(dBatched*1000.0), dBatched*1000.0);
+
+  // sort with radix sort
+  if( ctVisible>1) {
+    memcpy( &avtxScalar[0], &_avtxCommon[0], ctVertices*sizeof(GFXVertex));
+    bt.Start();
+    Particle_Sort();
+    const DOUBLE dRadix = bt.Stop();
+    // and with qsort, as it used to be done
+    memcpy( &_avtxCommon[0], &avtxScalar[0], ctVertices*sizeof(GFXVertex));
+    CStaticArray<INDEX> aiIndices;
+    aiIndices.New(ctVisible);
+    bt.Start();
+    for( i=0; i<ctVisible; i++) aiIndices[i] = i;
+    qsort( &aiIndices[0], ctVisible, sizeof(INDEX), qsort_CompareZ);
+    const DOUBLE dQSort = bt.Stop();
+    CPrintF("  %-28s %9.1f particles/ms  (%.3f ms)\n", "sort (radix)", ctVisible/(dRadix*1000.0), dRadix*1000.0);
+    CPrintF("  %-28s %9.1f particles/ms  (%.3f ms)\n", "sort (qsort, reference)", ctVisible/(dQSort*1000.0), dQSort*1000.0);
+  }
+
+  CPrintF("  %d of %d particles visible\n", ctVisible, ctParticles);
+  if( ctMismatches>0) {
+    CPrintF("  ERROR: batched squares differ from single ones in %d vertices!\n", ctMismatches);
+  }
+
+  // clean up
+  gfxResetArrays();
+  _atexFogHaze.PopAll();
+  _bNeedsClipping = FALSE;
+  _Particle_bHasFog  = bHasFogOld;
+  _Particle_bHasHaze = bHasHazeOld;
+  // projection was local
+  _pprProjection = pprProjectionOld;
+}
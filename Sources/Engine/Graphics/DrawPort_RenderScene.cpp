@@ -1551,7 +1551,7 @@ void RSRenderGroup( ScenePolygon *pspoGroup, ULONG ulGroupFlags, ULONG ulTestedF
   extern INDEX d3d_iMaxBurstSize;
   ogl_iMaxBurstSize = Clamp( ogl_iMaxBurstSize, 0, 9999);
   d3d_iMaxBurstSize = Clamp( d3d_iMaxBurstSize, 0, 9999);
-  const INDEX iMaxBurstSize = (eAPI==GAT_OGL) ? ogl_iMaxBurstSize : d3d_iMaxBurstSize;
+  const INDEX iMaxBurstSize = (eAPI==GAT_OGL || eAPI==GAT_NULL) ? ogl_iMaxBurstSize : d3d_iMaxBurstSize;
 
   // if unlimited lock count
   if( iMaxBurstSize==0)
@@ -1843,9 +1843,9 @@ void RenderScene( CDrawPort *pDP, ScenePolygon *pspoFirst, CAnyProjection3D &prP
   ASSERT( GfxValidApi(eAPI) );
 
 #ifdef SE1_D3D
-  if( eAPI!=GAT_OGL && eAPI!=GAT_D3D) return;
+  if( eAPI!=GAT_OGL && eAPI!=GAT_D3D && eAPI!=GAT_NULL) return;
 #else
-  if( eAPI!=GAT_OGL) return;
+  if( eAPI!=GAT_OGL && eAPI!=GAT_NULL) return;
 #endif
 
   // some cvars cannot be altered in multiplayer mode!
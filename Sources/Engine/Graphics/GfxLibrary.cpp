@@ -135,8 +135,10 @@ INDEX tex_bFineFog    = TRUE;          // should fog be 8/32bit? (or just plain
 INDEX tex_iFogSize    = 7;             // limit fog texture size 
 INDEX tex_iFiltering       =  0;       // -6 - +6; negative = sharpen, positive = blur, 0 = none
 INDEX tex_iEffectFiltering = +4;       // filtering of fire effect textures
+INDEX tex_bParallelEffects = TRUE;     // animate effect textures used in last tick on worker threads
 INDEX tex_bProgressiveFilter = FALSE;  // filter mipmaps in creation time (not afterwards)
 INDEX tex_bColorizeMipmaps   = FALSE;  // DEBUG: colorize texture's mipmap levels in various colors
+INDEX tex_bMipmapCache       = TRUE;   // keep processed mipmaps on disk and reuse them
 
 INDEX shd_iStaticSize  = 8;
 INDEX shd_iDynamicSize = 8;    
@@ -245,6 +247,7 @@ INDEX wld_bShowDetailTextures   = FALSE;
 INDEX wld_iDetailRemovingBias   = 3;
 FLOAT wld_fEdgeOffsetI          = 0.0f; //0.125f;
 FLOAT wld_fEdgeAdjustK          = 1.0f; //1.0001f;
+INDEX wld_iASERBands            = 0;    // >1 scans view in that many bands on job threads
                                      
 INDEX gfx_bRenderWorld      = TRUE;
 INDEX gfx_bRenderParticles  = TRUE;
@@ -514,11 +517,16 @@ static void GAPInfo(void)
 #ifdef SE1_D3D
     && _pGfx->gl_pd3dDevice==NULL
 #endif // SE1_D3D
-    ) || eAPI==GAT_NONE) {
+    && eAPI!=GAT_NULL) || eAPI==GAT_NONE) {
     // be brief, be quick
     CPrintF( TRANS("Display driver hasn't been initialized.\n\n"));
     return;
   }
+  // null device has no adapters nor driver to report
+  if( eAPI==GAT_NULL) {
+    CPrintF( TRANS("- Graphics API: Null (headless)\n\n"));
+    return;
+  }
 
   // report API
   CPrintF( "- Graphics API: ");
@@ -921,6 +929,13 @@ static void ReloadModels(void)
 }
 
 
+// texture cache tools (in TextureCache.cpp)
+extern void TextureCachePrewarm(void *pArgs);
+extern void TextureCachePurge(void);
+extern void GfxNullStats(void);
+extern void GfxNullTrace(void *pArgs);
+
+
 // variable change post functions
 static BOOL _bLastModelQuality = -1;
 static void MdlPostFunc(void *pvVar)
@@ -1147,6 +1162,10 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("user void RecacheShadows(void);", (void *) &RecacheShadows);
   _pShell->DeclareSymbol("user void RefreshTextures(void);", (void *) &RefreshTextures);
   _pShell->DeclareSymbol("user void ReloadModels(void);", (void *) &ReloadModels);
+  _pShell->DeclareSymbol("user void TextureCachePrewarm(CTString);", (void *) &TextureCachePrewarm);
+  _pShell->DeclareSymbol("user void TextureCachePurge(void);", (void *) &TextureCachePurge);
+  _pShell->DeclareSymbol("user void GfxNullStats(void);", (void *) &GfxNullStats);
+  _pShell->DeclareSymbol("user void GfxNullTrace(CTString);", (void *) &GfxNullTrace);
 
   _pShell->DeclareSymbol("persistent user INDEX ogl_bUseCompiledVertexArrays;", (void *) &ogl_bUseCompiledVertexArrays);
   _pShell->DeclareSymbol("persistent user INDEX ogl_bExclusive;",    (void *) &ogl_bExclusive);
@@ -1236,6 +1255,7 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX tex_iAnimationSize;", (void *) &tex_iAnimationSize);
   _pShell->DeclareSymbol("persistent user INDEX tex_iEffectSize;", (void *) &tex_iEffectSize);
   _pShell->DeclareSymbol("persistent user INDEX tex_bFineEffect;", (void *) &tex_bFineEffect);
+  _pShell->DeclareSymbol("persistent user INDEX tex_bParallelEffects;", (void *) &tex_bParallelEffects);
   _pShell->DeclareSymbol("persistent user INDEX tex_bFineFog;", (void *) &tex_bFineFog);
   _pShell->DeclareSymbol("persistent user INDEX tex_iFogSize;", (void *) &tex_iFogSize);
 
@@ -1247,6 +1267,7 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user INDEX tex_iEffectFiltering;", (void *) &tex_iEffectFiltering);
   _pShell->DeclareSymbol("persistent user INDEX tex_bProgressiveFilter;", (void *) &tex_bProgressiveFilter);
   _pShell->DeclareSymbol("           user INDEX tex_bColorizeMipmaps;", (void *) &tex_bColorizeMipmaps);
+  _pShell->DeclareSymbol("persistent user INDEX tex_bMipmapCache;", (void *) &tex_bMipmapCache);
 
   _pShell->DeclareSymbol("persistent user INDEX shd_iStaticSize;", (void *) &shd_iStaticSize);
   _pShell->DeclareSymbol("persistent user INDEX shd_iDynamicSize;", (void *) &shd_iDynamicSize);
@@ -1272,6 +1293,7 @@ void CGfxLibrary::Init(void)
   _pShell->DeclareSymbol("persistent user FLOAT wld_fEdgeOffsetI;",   (void *) &wld_fEdgeOffsetI);
   _pShell->DeclareSymbol("persistent user FLOAT wld_fEdgeAdjustK;",   (void *) &wld_fEdgeAdjustK);
   _pShell->DeclareSymbol("persistent user INDEX wld_iDetailRemovingBias;", (void *) &wld_iDetailRemovingBias);
+  _pShell->DeclareSymbol("persistent user INDEX wld_iASERBands;", (void *) &wld_iASERBands);
   _pShell->DeclareSymbol("           user INDEX wld_bRenderEmptyBrushes;", (void *) &wld_bRenderEmptyBrushes);
   _pShell->DeclareSymbol("           user INDEX wld_bRenderShadowMaps;", (void *) &wld_bRenderShadowMaps);
   _pShell->DeclareSymbol("           user INDEX wld_bRenderTextures;", (void *) &wld_bRenderTextures);
@@ -1337,7 +1359,8 @@ BOOL CGfxLibrary::SetDisplayMode( enum GfxAPIType eAPI, INDEX iAdapter, PIX pixS
   if( !bRet) return FALSE; // didn't make it?
 
   // update some info
-  gl_iCurrentAdapter = gl_gaAPI[gl_eCurrentAPI].ga_iCurrentAdapter = iAdapter;
+  gl_iCurrentAdapter = iAdapter;
+  if( gl_eCurrentAPI!=GAT_NULL) gl_gaAPI[gl_eCurrentAPI].ga_iCurrentAdapter = iAdapter;
   gl_dmCurrentDisplayMode.dm_pixSizeI = pixSizeI;
   gl_dmCurrentDisplayMode.dm_pixSizeJ = pixSizeJ;
   gl_dmCurrentDisplayMode.dm_ddDepth  = eColorDepth;
@@ -1448,6 +1471,13 @@ BOOL CGfxLibrary::StartDisplayMode( enum GfxAPIType eAPI, INDEX iAdapter, PIX pi
   }
 #endif // SE1_D3D
 
+  // null device ?
+  else if( eAPI==GAT_NULL)
+  {
+    // nothing to startup
+    gl_eCurrentAPI = GAT_NULL;
+  }
+
   // no driver
   else
   {
@@ -1465,6 +1495,8 @@ BOOL CGfxLibrary::StartDisplayMode( enum GfxAPIType eAPI, INDEX iAdapter, PIX pi
 
   // set function pointers
   GFX_SetFunctionPointers( (INDEX)gl_eCurrentAPI);
+  // null device doesn't wait for a window
+  if( gl_eCurrentAPI==GAT_NULL) InitContext_NULL();
 
   // all done
   return TRUE;
@@ -1496,6 +1528,11 @@ void CGfxLibrary::StopDisplayMode(void)
   }
 #endif
 
+  else if( gl_eCurrentAPI==GAT_NULL)
+  { // null device
+    EndDriver_NULL();
+  }
+
   else
   { // none
     ASSERT( gl_eCurrentAPI==GAT_NONE);
@@ -1527,6 +1564,7 @@ BOOL CGfxLibrary::SetCurrentViewport(CViewPort *pvp)
   if( gl_eCurrentAPI==GAT_D3D)  return SetCurrentViewport_D3D(pvp);
 #endif // SE1_D3D
   if( gl_eCurrentAPI==GAT_NONE) return TRUE;
+  if( gl_eCurrentAPI==GAT_NULL) return TRUE;
   ASSERTALWAYS( "SetCurrenViewport: Wrong API!");
   return FALSE;
 }
@@ -1536,11 +1574,7 @@ BOOL CGfxLibrary::SetCurrentViewport(CViewPort *pvp)
 BOOL CGfxLibrary::LockDrawPort( CDrawPort *pdpToLock)
 {
   // check API
-#ifdef SE1_D3D
-  ASSERT( gl_eCurrentAPI==GAT_OGL || gl_eCurrentAPI==GAT_D3D || gl_eCurrentAPI==GAT_NONE);
-#else // SE1_D3D
-  ASSERT( gl_eCurrentAPI==GAT_OGL || gl_eCurrentAPI==GAT_NONE);
-#endif // SE1_D3D
+  ASSERT( GfxValidApi(gl_eCurrentAPI));
 
   // don't allow locking if drawport is too small
   if( pdpToLock->dp_Width<1 || pdpToLock->dp_Height<1) return FALSE;
@@ -1592,11 +1626,7 @@ BOOL CGfxLibrary::LockDrawPort( CDrawPort *pdpToLock)
 void CGfxLibrary::UnlockDrawPort( CDrawPort *pdpToUnlock)
 {
   // check API
-#ifdef SE1_D3D
-  ASSERT(gl_eCurrentAPI == GAT_OGL || gl_eCurrentAPI == GAT_D3D || gl_eCurrentAPI == GAT_NONE);
-#else // SE1_D3D
-  ASSERT(gl_eCurrentAPI == GAT_OGL || gl_eCurrentAPI == GAT_NONE);
-#endif // SE1_D3D
+  ASSERT( GfxValidApi(gl_eCurrentAPI));
   // eventually signalize that scene rendering has ended
 }
 
@@ -1811,14 +1841,10 @@ static BOOL GenerateGammaTable(void);
 void CGfxLibrary::SwapBuffers(CViewPort *pvp)
 {
   // check API
-#ifdef SE1_D3D
-  ASSERT(gl_eCurrentAPI == GAT_OGL || gl_eCurrentAPI == GAT_D3D || gl_eCurrentAPI == GAT_NONE);
-#else // SE1_D3D
-  ASSERT(gl_eCurrentAPI == GAT_OGL || gl_eCurrentAPI == GAT_NONE);
-#endif // SE1_D3D
+  ASSERT( GfxValidApi(gl_eCurrentAPI));
 
-  // safety check
-  ASSERT( gl_pvpActive!=NULL);
+  // safety check (null device can swap without a viewport)
+  ASSERT( gl_pvpActive!=NULL || gl_eCurrentAPI==GAT_NULL);
   if( pvp!=gl_pvpActive) {
     ASSERTALWAYS( "Swapping viewport that was not last drawn to!");
     return;
@@ -1970,7 +1996,7 @@ void CGfxLibrary::SwapBuffers(CViewPort *pvp)
   }
 
   // clear viewport if needed
-  if( gfx_bClearScreen) pvp->vp_Raster.ra_MainDrawPort.Fill( C_BLACK|CT_OPAQUE);
+  if( gfx_bClearScreen && pvp!=NULL) pvp->vp_Raster.ra_MainDrawPort.Fill( C_BLACK|CT_OPAQUE);
   //pvp->vp_Raster.ra_MainDrawPort.FillZBuffer(ZBUF_BACK);
 
   // adjust gamma table if supported ...
@@ -2025,6 +2051,11 @@ CDisplayMode *CGfxLibrary::EnumDisplayModes( INDEX &ctModes, enum GfxAPIType eAP
 {
   if( eAPI==GAT_CURRENT) eAPI = gl_eCurrentAPI;
   if( iAdapter==0) iAdapter = gl_iCurrentAdapter;
+  // null device has no display modes
+  if( eAPI==GAT_NULL) {
+    ctModes = 0;
+    return NULL;
+  }
   CDisplayAdapter *pda = &gl_gaAPI[eAPI].ga_adaAdapter[iAdapter];
   ctModes = pda->da_ctDisplayModes;
   return &pda->da_admDisplayModes[0];
@@ -2037,7 +2068,7 @@ BOOL CGfxLibrary::LockRaster( CRaster *praToLock)
 {
   // don't do this! it can break sync consistency in entities!
   // SetFPUPrecision(FPT_24BIT); 
-  ASSERT( praToLock->ra_pvpViewPort!=NULL);
+  ASSERT( praToLock->ra_pvpViewPort!=NULL || gl_eCurrentAPI==GAT_NULL);
   BOOL bRes = SetCurrentViewport( praToLock->ra_pvpViewPort);
   if( bRes) {
     // must signal to picky Direct3D
@@ -67,6 +67,7 @@ enum GfxAPIType
 #ifdef SE1_D3D
   GAT_D3D  =  1,     // Direct3D
 #endif // SE1_D3D
+  GAT_NULL =  2,     // headless device (draws nothing, only counts and traces calls)
   GAT_CURRENT = 9,   // current API
 };
 
@@ -74,9 +75,9 @@ enum GfxAPIType
 __forceinline bool GfxValidApi(GfxAPIType eAPI)
 {
 #ifdef SE1_D3D
-  return(eAPI==GAT_OGL || eAPI==GAT_D3D || eAPI==GAT_NONE);
+  return(eAPI==GAT_OGL || eAPI==GAT_D3D || eAPI==GAT_NULL || eAPI==GAT_NONE);
 #else
-  return(eAPI==GAT_OGL || eAPI==GAT_NONE);
+  return(eAPI==GAT_OGL || eAPI==GAT_NULL || eAPI==GAT_NONE);
 #endif
 }
 
@@ -223,6 +224,10 @@ private:
   void SwapBuffers_D3D( CViewPort *pvpToSwap);
 #endif
 
+  // null device specific
+  void InitContext_NULL(void);
+  void EndDriver_NULL(void);
+
 public:
 
   // common
@@ -278,6 +283,7 @@ public:
 #ifdef SE1_D3D
     if( eAPI==GAT_D3D) return (gl_gaAPI[1].ga_ctAdapters>0);
 #endif // SE1_D3D
+    if( eAPI==GAT_NULL) return TRUE;
     return FALSE;
   };
 
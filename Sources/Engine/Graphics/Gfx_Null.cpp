@@ -0,0 +1,202 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Graphics/GfxLibrary.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Stream.h>
+
+#include <Engine/Templates/DynamicContainer.cpp>
+#include <Engine/Templates/Stock_CTextureData.h>
+
+extern ULONG _fog_ulTexture;
+extern ULONG _haze_ulTexture;
+extern INDEX GFX_ctVertices;
+extern INDEX GFX_iTexModulation[GFX_MAXTEXUNITS];
+
+extern BOOL GFX_bDepthTest;
+extern BOOL GFX_bDepthWrite;
+extern BOOL GFX_bAlphaTest;
+extern BOOL GFX_bBlending;
+extern BOOL GFX_bDithering;
+extern BOOL GFX_bClipping;
+extern BOOL GFX_bClipPlane;
+extern BOOL GFX_bColorArray;
+extern BOOL GFX_bFrontFace;
+extern BOOL GFX_bTruform;
+extern INDEX GFX_iActiveTexUnit;
+extern FLOAT GFX_fMinDepthRange;
+extern FLOAT GFX_fMaxDepthRange;
+extern GfxBlend GFX_eBlendSrc;
+extern GfxBlend GFX_eBlendDst;
+extern GfxComp  GFX_eDepthFunc;
+extern GfxFace  GFX_eCullFace;
+
+
+// initialize null device (it has no window, so this is done at once)
+void CGfxLibrary::InitContext_NULL(void)
+{
+  // reset engine's internal state variables
+  extern BOOL GFX_abTexture[GFX_MAXTEXUNITS];
+  for( INDEX iUnit=0; iUnit<GFX_MAXTEXUNITS; iUnit++) {
+    GFX_abTexture[iUnit] = FALSE;
+    GFX_iTexModulation[iUnit] = 1;
+  }
+  GFX_iActiveTexUnit = 0;
+  extern BOOL  GFX_bViewMatrix;
+  extern FLOAT GFX_fLastL, GFX_fLastR, GFX_fLastT, GFX_fLastB, GFX_fLastN, GFX_fLastF;
+  GFX_fLastL = GFX_fLastR = GFX_fLastT = GFX_fLastB = GFX_fLastN = GFX_fLastF = 0;
+  GFX_bViewMatrix = TRUE;
+  // same defaults as OpenGL context
+  GFX_bTruform     = FALSE;
+  GFX_bClipping    = TRUE;
+  GFX_abTexture[0] = TRUE;
+  GFX_bDithering   = TRUE;
+  GFX_bBlending    = FALSE;
+  GFX_bDepthTest   = FALSE;
+  GFX_bAlphaTest   = FALSE;
+  GFX_bClipPlane   = FALSE;
+  GFX_eCullFace    = GFX_NONE;
+  GFX_bFrontFace   = TRUE;
+  GFX_bDepthWrite  = FALSE;
+  GFX_eDepthFunc   = GFX_LESS_EQUAL;
+  GFX_eBlendSrc = GFX_eBlendDst = GFX_ONE;
+  GFX_fMinDepthRange = 0.0f;
+  GFX_fMaxDepthRange = 1.0f;
+  GFX_bColorArray  = FALSE;
+  GFX_ctVertices   = 0;
+
+  // capabilities of a plain multi-texturing card
+  gl_ctTextureUnits = GFX_MAXTEXUNITS;
+  gl_ctRealTextureUnits = GFX_MAXTEXUNITS;
+  gl_ctMaxStreams = 16;
+  gl_pixMaxTextureDimension = 4096;
+  gl_fMaxTextureLODBias = 0.0f;
+  gl_iMaxTextureAnisotropy = 1;
+  gl_iTessellationLevel = 0;
+  gl_iMaxTessellationLevel = 0;
+  gl_ulFlags |= GLF_32BITTEXTURES;
+  extern INDEX truform_iLevel;
+  extern BOOL  truform_bLinear;
+  truform_iLevel  = -1;
+  truform_bLinear = FALSE;
+  gl_dwVertexShader = NONE;
+
+  // forget old texture objects and make the ones that context always has
+  extern void ResetTextures_NULL(void);
+  ResetTextures_NULL();
+  gfxGenerateTexture(_fog_ulTexture);
+  gfxGenerateTexture(_haze_ulTexture);
+  extern PIX _fog_pixSizeH;
+  extern PIX _fog_pixSizeL;
+  extern PIX _haze_pixSize;
+  _fog_pixSizeH = 0;
+  _fog_pixSizeL = 0;
+  _haze_pixSize = 0;
+  extern CTexParams _tpPattern;
+  extern ULONG _ulPatternTexture;
+  extern ULONG _ulLastUploadedPattern;
+  gfxGenerateTexture(_ulPatternTexture);
+  _ulLastUploadedPattern = 0;
+  _tpPattern.Clear();
+
+  // reset texture filtering
+  _tpGlobal[0].Clear();
+  _tpGlobal[1].Clear();
+  _tpGlobal[2].Clear();
+  _tpGlobal[3].Clear();
+  extern INDEX gap_iTextureFiltering;
+  extern INDEX gap_iTextureAnisotropy;
+  extern FLOAT gap_fTextureLODBias;
+  gfxSetTextureFiltering( gap_iTextureFiltering, gap_iTextureAnisotropy);
+  gfxSetTextureBiasing( gap_fTextureLODBias);
+
+  CPrintF( TRANS("\n* Null gfx device started: *---------------------------------\n\n"));
+
+  // update console system vars
+  extern void UpdateGfxSysCVars(void);
+  UpdateGfxSysCVars();
+
+  // reload all loaded textures (only to count their uploads)
+  extern void ReloadTextures(void);
+  ReloadTextures();
+  gl_ulFlags &= ~GLF_INITONNEXTWINDOW;
+}
+
+
+
+// shutdown null device (unbind textures, so other API won't delete its own ones by these names)
+void CGfxLibrary::EndDriver_NULL(void)
+{
+  // unbind all textures
+  if( _pTextureStock!=NULL) {
+    {FOREACHINDYNAMICCONTAINER( _pTextureStock->st_ctObjects, CTextureData, ittd) {
+      CTextureData &td = *ittd;
+      td.td_tpLocal.Clear();
+      td.Unbind();
+    }}
+  } // unbind fog/haze
+  gfxDeleteTexture( _fog_ulTexture);
+  gfxDeleteTexture( _haze_ulTexture);
+
+  ASSERT( _ptdFlat!=NULL);
+  _ptdFlat->td_tpLocal.Clear();
+  _ptdFlat->Unbind();
+}
+
+
+// print counters of null device, and reset them
+void GfxNullStats(void)
+{
+  const GfxNullCounters &nc = GFX_ncCounters;
+  if( _pGfx->gl_eCurrentAPI!=GAT_NULL) {
+    CPrintF( TRANS("Null gfx device is not active.\n"));
+  }
+  CPrintF( TRANS("Null gfx device counters:\n"));
+  CPrintF( "  draw calls:    %10d\n", nc.nc_ctDrawCalls);
+  CPrintF( "  triangles:     %10d\n", nc.nc_ctElements/3);
+  CPrintF( "  vertices:      %10d\n", nc.nc_ctVertices);
+  CPrintF( "  state changes: %10d\n", nc.nc_ctStateChanges);
+  CPrintF( "  texture binds: %10d\n", nc.nc_ctTextureBinds);
+  CPrintF( "  uploads:       %10d (%d KB)\n", nc.nc_ctUploads, (SLONG)(nc.nc_llUploadBytes/1024));
+  memset( &GFX_ncCounters, 0, sizeof(GFX_ncCounters));
+}
+
+
+// start writing calls that reach null device to a file (or stop if file name is empty)
+void GfxNullTrace(void *pArgs)
+{
+  CTString strFile = *NEXTARGUMENT(CTString*);
+  if( GFX_pstrmNullTrace!=NULL) {
+    delete GFX_pstrmNullTrace;
+    GFX_pstrmNullTrace = NULL;
+    CPrintF( TRANS("Gfx trace stopped.\n"));
+  }
+  if( strFile=="") return;
+
+  CTFileStream *pstrm = new CTFileStream;
+  try {
+    pstrm->Create_t( CTFileName(strFile), CTStream::CM_TEXT);
+  } catch( char *strError) {
+    CPrintF( "%s\n", strError);
+    delete pstrm;
+    return;
+  }
+  GFX_pstrmNullTrace = pstrm;
+  CPrintF( TRANS("Tracing null gfx device calls to '%s'.\n"), (const char *)strFile);
+}
@@ -20,6 +20,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Graphics/GfxProfile.h>
 #include <Engine/Base/Statistics_Internal.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Base/Stream.h>
 
 //#include <d3dx8math.h>
 //#pragma comment(lib, "d3dx8.lib")
@@ -187,6 +190,12 @@ extern void  UploadTexture_D3D( LPDIRECT3DTEXTURE8 *ppd3dTexture, ULONG *pulText
                                 PIX pixSizeU, PIX pixSizeV, D3DFORMAT eInternalFormat, BOOL bDiscard);
 #endif // SE1_D3D
 
+static void  null_SetTextureUnit( INDEX iUnit);
+static void  null_SetTexture( ULONG ulTexObject, CTexParams &tpLocal);
+static void  null_UploadTexture( ULONG *pulTexture, PIX pixWidth, PIX pixHeight, ULONG ulFormat, BOOL bNoDiscard);
+static SLONG null_GetTextureSize( ULONG ulTexObject);
+static INDEX null_GetTexturePixRatio( ULONG ulTexObject);
+
 // update texture LOD bias
 FLOAT _fCurrentLODBias = 0;  // LOD bias adjuster
 void UpdateLODBias( const FLOAT fLODBias)
@@ -324,7 +333,8 @@ void gfxSetTextureUnit( INDEX iUnit)
   if( GFX_iActiveTexUnit==iUnit) return;
   GFX_iActiveTexUnit = iUnit;
 
-  // really set only for OpenGL
+  // really set only for OpenGL (and counted by null device)
+  if( eAPI==GAT_NULL) null_SetTextureUnit(iUnit);
   if( eAPI!=GAT_OGL) return;
 
   _sfStats.StartTimer(CStatForm::STI_GFXAPI);
@@ -369,6 +379,9 @@ void gfxSetTexture( ULONG &ulTexObject, CTexParams &tpLocal)
     MimicTexParams_D3D(tpLocal);
   }
 #endif // SE1_D3D
+  else if( eAPI==GAT_NULL) { // null device
+    null_SetTexture( ulTexObject, tpLocal);
+  }
   // done
   _pfGfxProfile.StopTimer(CGfxProfile::PTI_SETCURRENTTEXTURE);
   _sfStats.StopTimer(CStatForm::STI_BINDTEXTURE);
@@ -400,6 +413,9 @@ void gfxUploadTexture( ULONG *pulTexture, PIX pixWidth, PIX pixHeight, ULONG ulF
     }
   } 
 #endif // SE1_D3D
+  else if( eAPI==GAT_NULL) { // null device
+    null_UploadTexture( pulTexture, pixWidth, pixHeight, ulFormat, bNoDiscard);
+  }
   _sfStats.StopTimer(CStatForm::STI_GFXAPI);
 }
 
@@ -454,6 +470,11 @@ SLONG gfxGetTextureSize( ULONG ulTexObject, BOOL bHasMipmaps/*=TRUE*/)
     slMipSize = d3dSurfDesc.Size;
   }
 #endif // SE1_D3D
+  // null device (remembers what was uploaded)
+  else if( eAPI==GAT_NULL)
+  {
+    slMipSize = null_GetTextureSize(ulTexObject);
+  }
 
   // eventually count in all the mipmaps (takes extra 33% of texture size)
   extern INDEX gap_bAllowSingleMipmap;
@@ -475,6 +496,7 @@ INDEX gfxGetTexturePixRatio( ULONG ulTextureObject)
 #ifdef SE1_D3D
   else if( eAPI==GAT_D3D) return GetTexturePixRatio_D3D( (LPDIRECT3DTEXTURE8)ulTextureObject);
 #endif // SE1_D3D
+  else if( eAPI==GAT_NULL) return null_GetTexturePixRatio(ulTextureObject);
   else return 0;
 }
 
@@ -489,6 +511,7 @@ INDEX gfxGetFormatPixRatio( ULONG ulTextureFormat)
 #ifdef SE1_D3D
   else if( eAPI==GAT_D3D) return GetFormatPixRatio_D3D( (D3DFORMAT)ulTextureFormat);
 #endif // SE1_D3D
+  else if( eAPI==GAT_NULL) return GetFormatPixRatio_OGL( (GLenum)ulTextureFormat); // null device uses OpenGL formats
   else return 0;
 }
 
@@ -666,6 +689,7 @@ extern ULONG gfxGetColorMask(void)
 
 #include "Gfx_wrapper_OpenGL.cpp"
 #include "Gfx_wrapper_Direct3D.cpp"
+#include "Gfx_wrapper_Null.cpp"
 
 
 
@@ -692,7 +716,7 @@ static void none_SetColorMask( ULONG ulColorMask) { NOTHING; };
 
 
 
-// functions initialization for OGL, D3D or NONE (dummy)
+// functions initialization for OGL, D3D, NULL (counting) or NONE (dummy)
 void GFX_SetFunctionPointers( INDEX iAPI)
 {
   // OpenGL?
@@ -797,6 +821,56 @@ void GFX_SetFunctionPointers( INDEX iAPI)
     gfxSetColorMask         = &d3d_SetColorMask;
   }
 #endif // SE1_D3D
+  // null device?
+  else if( iAPI==(INDEX)GAT_NULL)
+  {
+    gfxEnableDepthWrite     = &null_EnableDepthWrite;
+    gfxEnableDepthBias      = &null_EnableDepthBias;
+    gfxEnableDepthTest      = &null_EnableDepthTest;
+    gfxEnableAlphaTest      = &null_EnableAlphaTest;
+    gfxEnableBlend          = &null_EnableBlend;
+    gfxEnableDither         = &null_EnableDither;
+    gfxEnableTexture        = &null_EnableTexture;
+    gfxEnableClipping       = &null_EnableClipping;
+    gfxEnableClipPlane      = &null_EnableClipPlane;
+    gfxEnableTruform        = &null_EnableTruform;
+    gfxDisableDepthWrite    = &null_DisableDepthWrite;
+    gfxDisableDepthBias     = &null_DisableDepthBias;
+    gfxDisableDepthTest     = &null_DisableDepthTest;
+    gfxDisableAlphaTest     = &null_DisableAlphaTest;
+    gfxDisableBlend         = &null_DisableBlend;
+    gfxDisableDither        = &null_DisableDither;
+    gfxDisableTexture       = &null_DisableTexture;
+    gfxDisableClipping      = &null_DisableClipping;
+    gfxDisableClipPlane     = &null_DisableClipPlane;
+    gfxDisableTruform       = &null_DisableTruform;
+    gfxBlendFunc            = &null_BlendFunc;
+    gfxDepthFunc            = &null_DepthFunc;
+    gfxDepthRange           = &null_DepthRange;
+    gfxCullFace             = &null_CullFace;
+    gfxFrontFace            = &null_FrontFace;
+    gfxClipPlane            = &null_ClipPlane;
+    gfxSetOrtho             = &null_SetOrtho;
+    gfxSetFrustum           = &null_SetFrustum;
+    gfxSetTextureMatrix     = &null_SetTextureMatrix;
+    gfxSetViewMatrix        = &null_SetViewMatrix;
+    gfxPolygonMode          = &null_PolygonMode;
+    gfxSetTextureWrapping   = &null_SetTextureWrapping;
+    gfxSetTextureModulation = &null_SetTextureModulation;
+    gfxGenerateTexture      = &null_GenerateTexture;
+    gfxDeleteTexture        = &null_DeleteTexture;
+    gfxSetVertexArray       = &null_SetVertexArray;
+    gfxSetNormalArray       = &null_SetNormalArray;
+    gfxSetTexCoordArray     = &null_SetTexCoordArray;
+    gfxSetColorArray        = &null_SetColorArray;
+    gfxDrawElements         = &null_DrawElements;
+    gfxSetConstantColor     = &null_SetConstantColor;
+    gfxEnableColorArray     = &null_EnableColorArray;
+    gfxDisableColorArray    = &null_DisableColorArray;
+    gfxFinish               = &null_Finish;
+    gfxLockArrays           = &null_LockArrays;
+    gfxSetColorMask         = &null_SetColorMask;
+  }
   // NONE!
   else
   {
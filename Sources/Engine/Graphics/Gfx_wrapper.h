@@ -258,6 +258,21 @@ extern void (*gfxLockArrays)(void);
 extern void gfxUnlockArrays(void);
 
 
+// counters kept by null device (since last reset)
+struct GfxNullCounters {
+  SLONG   nc_ctDrawCalls;     // gfxDrawElements() calls
+  SLONG   nc_ctElements;      // elements drawn (indices, or vertices for quads)
+  SLONG   nc_ctVertices;      // vertices passed thru gfxSetVertexArray()
+  SLONG   nc_ctStateChanges;  // state changes that weren't skipped as cached
+  SLONG   nc_ctTextureBinds;  // textures set as current
+  SLONG   nc_ctUploads;       // textures uploaded
+  __int64 nc_llUploadBytes;   // bytes uploaded (as stored in chosen format, w/o mipmaps)
+};
+extern struct GfxNullCounters GFX_ncCounters;
+// command trace of null device (NULL if not tracing)
+extern CTFileStream *GFX_pstrmNullTrace;
+
+
 // helper functions for drawing simple primitives thru drawelements
 
 inline void gfxResetArrays(void)
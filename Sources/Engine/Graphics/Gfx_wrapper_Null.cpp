@@ -0,0 +1,566 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+
+// Null device accepts everything and draws nothing. It keeps the same state
+// cache as other APIs (so same calls are skipped), counts what gets thru and
+// can write it to a trace file, one short line per call.
+
+
+// COUNTERS AND TRACE
+
+struct GfxNullCounters GFX_ncCounters = { 0, 0, 0, 0, 0, 0, 0 };
+CTFileStream *GFX_pstrmNullTrace = NULL;
+static INDEX _iLastTracedFrame = -1;
+
+// null device texture object (bind number is index+1)
+struct NullTexture {
+  PIX   nt_pixWidth;
+  PIX   nt_pixHeight;
+  ULONG nt_ulFormat;
+};
+static CStaticStackArray<NullTexture> _antNullTextures;
+static ULONG _ulNullCurrentTexture = NONE;
+
+
+// write one call to trace
+static void null_Trace( const char *strCall, SLONG sl0=0, SLONG sl1=0)
+{
+  if( GFX_pstrmNullTrace==NULL) return;
+  try {
+    // mark each new frame
+    if( _iLastTracedFrame!=_pGfx->gl_iFrameNumber) {
+      _iLastTracedFrame = _pGfx->gl_iFrameNumber;
+      GFX_pstrmNullTrace->FPrintF_t( "frame %d\n", _iLastTracedFrame);
+    }
+    GFX_pstrmNullTrace->FPrintF_t( "%s %d %d\n", strCall, sl0, sl1);
+  } catch( char *strError) {
+    // stop tracing
+    CPrintF( TRANS("Gfx trace stopped: %s\n"), strError);
+    delete GFX_pstrmNullTrace;
+    GFX_pstrmNullTrace = NULL;
+  }
+}
+
+// count and trace state change
+static __forceinline void null_StateChange( const char *strCall, SLONG sl0=0, SLONG sl1=0)
+{
+  GFX_ncCounters.nc_ctStateChanges++;
+  null_Trace( strCall, sl0, sl1);
+}
+
+
+
+// ENABLE/DISABLE FUNCTIONS
+
+
+static void null_EnableTexture(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_abTexture[GFX_iActiveTexUnit] && gap_bOptimizeStateChanges) return;
+  GFX_abTexture[GFX_iActiveTexUnit] = TRUE;
+  null_StateChange( "tex", GFX_iActiveTexUnit, 1);
+}
+
+static void null_DisableTexture(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_abTexture[GFX_iActiveTexUnit] && gap_bOptimizeStateChanges) return;
+  GFX_abTexture[GFX_iActiveTexUnit] = FALSE;
+  null_StateChange( "tex", GFX_iActiveTexUnit, 0);
+}
+
+
+static void null_EnableDepthTest(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bDepthTest && gap_bOptimizeStateChanges) return;
+  GFX_bDepthTest = TRUE;
+  null_StateChange( "ztest", 1);
+}
+
+static void null_DisableDepthTest(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bDepthTest && gap_bOptimizeStateChanges) return;
+  GFX_bDepthTest = FALSE;
+  null_StateChange( "ztest", 0);
+}
+
+
+static void null_EnableDepthBias(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  null_StateChange( "zbias", 1);
+}
+
+static void null_DisableDepthBias(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  null_StateChange( "zbias", 0);
+}
+
+
+static void null_EnableDepthWrite(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bDepthWrite && gap_bOptimizeStateChanges) return;
+  GFX_bDepthWrite = TRUE;
+  null_StateChange( "zwrite", 1);
+}
+
+static void null_DisableDepthWrite(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bDepthWrite && gap_bOptimizeStateChanges) return;
+  GFX_bDepthWrite = FALSE;
+  null_StateChange( "zwrite", 0);
+}
+
+
+static void null_EnableDither(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bDithering && gap_bOptimizeStateChanges) return;
+  GFX_bDithering = TRUE;
+  null_StateChange( "dither", 1);
+}
+
+static void null_DisableDither(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bDithering && gap_bOptimizeStateChanges) return;
+  GFX_bDithering = FALSE;
+  null_StateChange( "dither", 0);
+}
+
+
+static void null_EnableAlphaTest(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bAlphaTest && gap_bOptimizeStateChanges) return;
+  GFX_bAlphaTest = TRUE;
+  null_StateChange( "atest", 1);
+}
+
+static void null_DisableAlphaTest(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bAlphaTest && gap_bOptimizeStateChanges) return;
+  GFX_bAlphaTest = FALSE;
+  null_StateChange( "atest", 0);
+}
+
+
+static void null_EnableBlend(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bBlending && gap_bOptimizeStateChanges) return;
+  GFX_bBlending = TRUE;
+  null_StateChange( "blend", 1);
+  // adjust dithering (as OpenGL does)
+  if( gap_iDithering==2) null_EnableDither();
+  else null_DisableDither();
+}
+
+static void null_DisableBlend(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bBlending && gap_bOptimizeStateChanges) return;
+  GFX_bBlending = FALSE;
+  null_StateChange( "blend", 0);
+  // adjust dithering (as OpenGL does)
+  if( gap_iDithering==0) null_DisableDither();
+  else null_EnableDither();
+}
+
+
+static void null_EnableClipping(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bClipping && gap_bOptimizeStateChanges) return;
+  GFX_bClipping = TRUE;
+  null_StateChange( "clip", 1);
+}
+
+static void null_DisableClipping(void)
+{
+  // only if allowed
+  if( gap_iOptimizeClipping<2) return;
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bClipping && gap_bOptimizeStateChanges) return;
+  GFX_bClipping = FALSE;
+  null_StateChange( "clip", 0);
+}
+
+
+static void null_EnableClipPlane(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bClipPlane && gap_bOptimizeStateChanges) return;
+  GFX_bClipPlane = TRUE;
+  null_StateChange( "cplane", 1);
+}
+
+static void null_DisableClipPlane(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bClipPlane && gap_bOptimizeStateChanges) return;
+  GFX_bClipPlane = FALSE;
+  null_StateChange( "cplane", 0);
+}
+
+
+static void null_EnableColorArray(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bColorArray && gap_bOptimizeStateChanges) return;
+  GFX_bColorArray = TRUE;
+  null_StateChange( "colarr", 1);
+}
+
+static void null_DisableColorArray(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bColorArray && gap_bOptimizeStateChanges) return;
+  GFX_bColorArray = FALSE;
+  null_StateChange( "colarr", 0);
+}
+
+
+static void null_EnableTruform(void)
+{
+  if( truform_iLevel<1) return;
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_bTruform && gap_bOptimizeStateChanges) return;
+  GFX_bTruform = TRUE;
+  null_StateChange( "truform", 1);
+}
+
+static void null_DisableTruform(void)
+{
+  if( truform_iLevel<1) return;
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( !GFX_bTruform && gap_bOptimizeStateChanges) return;
+  GFX_bTruform = FALSE;
+  null_StateChange( "truform", 0);
+}
+
+
+
+// STATES AND MATRICES
+
+
+static void null_BlendFunc( GfxBlend eSrc, GfxBlend eDst)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( eSrc==GFX_eBlendSrc && eDst==GFX_eBlendDst && gap_bOptimizeStateChanges) return;
+  GFX_eBlendSrc = eSrc;
+  GFX_eBlendDst = eDst;
+  null_StateChange( "blendfunc", eSrc, eDst);
+}
+
+
+static void null_SetColorMask( ULONG ulColorMask)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  _ulCurrentColorMask = ulColorMask;
+  null_StateChange( "colmask", ulColorMask>>24);
+}
+
+
+static void null_DepthFunc( GfxComp eFunc)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( eFunc==GFX_eDepthFunc && gap_bOptimizeStateChanges) return;
+  GFX_eDepthFunc = eFunc;
+  null_StateChange( "zfunc", eFunc);
+}
+
+
+static void null_DepthRange( FLOAT fMin, FLOAT fMax)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_fMinDepthRange==fMin && GFX_fMaxDepthRange==fMax && gap_bOptimizeStateChanges) return;
+  GFX_fMinDepthRange = fMin;
+  GFX_fMaxDepthRange = fMax;
+  // (range is traced in thousandths)
+  null_StateChange( "zrange", FloatToInt(fMin*1000), FloatToInt(fMax*1000));
+}
+
+
+static void null_CullFace( GfxFace eFace)
+{
+  ASSERT( eFace==GFX_FRONT || eFace==GFX_BACK || eFace==GFX_NONE);
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_eCullFace==eFace && gap_bOptimizeStateChanges) return;
+  GFX_eCullFace = eFace;
+  null_StateChange( "cull", eFace);
+}
+
+
+static void null_FrontFace( GfxFace eFace)
+{
+  ASSERT( eFace==GFX_CW || eFace==GFX_CCW);
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  const BOOL bFrontFace = (eFace==GFX_CCW);
+  if( !bFrontFace==!GFX_bFrontFace && gap_bOptimizeStateChanges) return;
+  GFX_bFrontFace = bFrontFace;
+  null_StateChange( "front", eFace);
+}
+
+
+static void null_ClipPlane( const DOUBLE *pdViewPlane)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL && pdViewPlane!=NULL);
+  null_StateChange( "cplanedef");
+}
+
+
+static void null_SetTextureMatrix( const FLOAT *pfMatrix/*=NULL*/)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  null_StateChange( "texmatrix", pfMatrix!=NULL);
+}
+
+
+static void null_SetViewMatrix( const FLOAT *pfMatrix/*=NULL*/)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  // cached? (only identity matrix)
+  if( pfMatrix==NULL && GFX_bViewMatrix==NONE && gap_bOptimizeStateChanges) return;
+  GFX_bViewMatrix = (pfMatrix!=NULL);
+  null_StateChange( "viewmatrix", pfMatrix!=NULL);
+}
+
+
+static void null_SetOrtho( const FLOAT fLeft,   const FLOAT fRight, const FLOAT fTop,
+                           const FLOAT fBottom, const FLOAT fNear,  const FLOAT fFar,
+                           const BOOL bSubPixelAdjust/*=FALSE*/)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_fLastL==fLeft  && GFX_fLastT==fTop    && GFX_fLastN==fNear
+   && GFX_fLastR==fRight && GFX_fLastB==fBottom && GFX_fLastF==fFar && gap_bOptimizeStateChanges) return;
+  GFX_fLastL = fLeft;   GFX_fLastT = fTop;     GFX_fLastN = fNear;
+  GFX_fLastR = fRight;  GFX_fLastB = fBottom;  GFX_fLastF = fFar;
+  null_StateChange( "ortho", FloatToInt(fRight-fLeft), FloatToInt(fBottom-fTop));
+}
+
+
+static void null_SetFrustum( const FLOAT fLeft, const FLOAT fRight,
+                             const FLOAT fTop,  const FLOAT fBottom,
+                             const FLOAT fNear, const FLOAT fFar)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  if( GFX_fLastL==-fLeft  && GFX_fLastT==-fTop    && GFX_fLastN==-fNear
+   && GFX_fLastR==-fRight && GFX_fLastB==-fBottom && GFX_fLastF==-fFar && gap_bOptimizeStateChanges) return;
+  GFX_fLastL = -fLeft;   GFX_fLastT = -fTop;     GFX_fLastN = -fNear;
+  GFX_fLastR = -fRight;  GFX_fLastB = -fBottom;  GFX_fLastF = -fFar;
+  // (near clip distance is traced in thousandths)
+  null_StateChange( "frustum", FloatToInt(fNear*1000));
+}
+
+
+static void null_PolygonMode( GfxPolyMode ePolyMode)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  null_StateChange( "polymode", ePolyMode);
+}
+
+
+
+// TEXTURE MANAGEMENT
+
+
+static void null_SetTextureWrapping( enum GfxWrap eWrapU, enum GfxWrap eWrapV)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  _tpGlobal[GFX_iActiveTexUnit].tp_eWrapU = eWrapU;
+  _tpGlobal[GFX_iActiveTexUnit].tp_eWrapV = eWrapV;
+}
+
+
+static void null_SetTextureModulation( INDEX iScale)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  ASSERT( iScale==1 || iScale==2);
+  if( GFX_iTexModulation[GFX_iActiveTexUnit]==iScale) return;
+  GFX_iTexModulation[GFX_iActiveTexUnit] = iScale;
+  null_StateChange( "texmod", GFX_iActiveTexUnit, iScale);
+}
+
+
+static void null_SetTextureUnit( INDEX iUnit)
+{
+  null_StateChange( "texunit", iUnit);
+}
+
+
+static void null_GenerateTexture( ULONG &ulTexObject)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  NullTexture &nt = _antNullTextures.Push();
+  nt.nt_pixWidth  = 0;
+  nt.nt_pixHeight = 0;
+  nt.nt_ulFormat  = NONE;
+  ulTexObject = _antNullTextures.Count();
+}
+
+
+static void null_DeleteTexture( ULONG &ulTexObject)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  // numbers are not reused, so it's enough to forget the object
+  if( _ulNullCurrentTexture==ulTexObject) _ulNullCurrentTexture = NONE;
+  ulTexObject = NONE;
+}
+
+
+// get texture object for bind number (NULL if not generated in this context)
+static NullTexture *null_GetTexture( ULONG ulTexObject)
+{
+  if( ulTexObject==NONE || ulTexObject>(ULONG)_antNullTextures.Count()) return NULL;
+  return &_antNullTextures[ulTexObject-1];
+}
+
+
+static void null_SetTexture( ULONG ulTexObject, CTexParams &tpLocal)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  _ulNullCurrentTexture = ulTexObject;
+  GFX_ncCounters.nc_ctTextureBinds++;
+  null_Trace( "bind", GFX_iActiveTexUnit, ulTexObject);
+
+  // texture parameters change as in MimicTexParams_OGL()
+  const CTexParams &tpGlobal = _tpGlobal[GFX_iActiveTexUnit];
+  if( tpLocal.tp_iFilter!=_tpGlobal[0].tp_iFilter || tpLocal.tp_iAnisotropy!=_tpGlobal[0].tp_iAnisotropy) {
+    tpLocal.tp_iFilter     = _tpGlobal[0].tp_iFilter;
+    tpLocal.tp_iAnisotropy = _tpGlobal[0].tp_iAnisotropy;
+    null_StateChange( "texfilter", tpLocal.tp_iFilter, tpLocal.tp_iAnisotropy);
+  }
+  if( tpLocal.tp_eWrapU!=tpGlobal.tp_eWrapU || tpLocal.tp_eWrapV!=tpGlobal.tp_eWrapV) {
+    tpLocal.tp_eWrapU = tpGlobal.tp_eWrapU;
+    tpLocal.tp_eWrapV = tpGlobal.tp_eWrapV;
+    null_StateChange( "texwrap", tpLocal.tp_eWrapU, tpLocal.tp_eWrapV);
+  }
+}
+
+
+static void null_UploadTexture( ULONG *pulTexture, PIX pixWidth, PIX pixHeight, ULONG ulFormat, BOOL bNoDiscard)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  ASSERT( pulTexture!=NULL && pixWidth>0 && pixHeight>0);
+  NullTexture *pnt = null_GetTexture(_ulNullCurrentTexture);
+  if( pnt!=NULL) {
+    pnt->nt_pixWidth  = pixWidth;
+    pnt->nt_pixHeight = pixHeight;
+    pnt->nt_ulFormat  = ulFormat;
+  }
+  GFX_ncCounters.nc_ctUploads++;
+  GFX_ncCounters.nc_llUploadBytes += pixWidth*pixHeight * GetFormatPixRatio_OGL((GLenum)ulFormat);
+  null_Trace( "upload", pixWidth, pixHeight);
+}
+
+
+static SLONG null_GetTextureSize( ULONG ulTexObject)
+{
+  const NullTexture *pnt = null_GetTexture(ulTexObject);
+  if( pnt==NULL) return 0;
+  return pnt->nt_pixWidth*pnt->nt_pixHeight * GetFormatPixRatio_OGL((GLenum)pnt->nt_ulFormat);
+}
+
+
+static INDEX null_GetTexturePixRatio( ULONG ulTexObject)
+{
+  const NullTexture *pnt = null_GetTexture(ulTexObject);
+  if( pnt==NULL) return 0;
+  return GetFormatPixRatio_OGL((GLenum)pnt->nt_ulFormat);
+}
+
+
+// forget all texture objects (when context is created)
+void ResetTextures_NULL(void)
+{
+  _antNullTextures.PopAll();
+  _ulNullCurrentTexture = NONE;
+}
+
+
+
+// VERTEX ARRAYS
+
+
+static void null_SetVertexArray( GFXVertex4 *pvtx, INDEX ctVtx)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  ASSERT( ctVtx>0 && pvtx!=NULL && GFX_iActiveTexUnit==0);
+  GFX_ctVertices = ctVtx;
+  GFX_bColorArray = FALSE; // same as OpenGL
+  GFX_ncCounters.nc_ctVertices += ctVtx;
+  null_Trace( "vtx", ctVtx);
+}
+
+
+static void null_SetNormalArray( GFXNormal *pnor)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL && pnor!=NULL);
+}
+
+
+static void null_SetColorArray( GFXColor *pcol)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL && pcol!=NULL);
+  null_EnableColorArray();
+}
+
+
+static void null_SetTexCoordArray( GFXTexCoord *ptex, BOOL b4/*=FALSE*/)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL && ptex!=NULL);
+}
+
+
+static void null_SetConstantColor( COLOR col)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  null_DisableColorArray();
+}
+
+
+static void null_DrawElements( INDEX ctElem, INDEX_T *pidx)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+#ifndef NDEBUG
+  // check if all indices are inside vertex array
+  if( pidx!=NULL) for( INDEX i=0; i<ctElem; i++) ASSERT( pidx[i] < GFX_ctVertices);
+#endif
+  _pGfx->gl_ctTotalTriangles += ctElem/3;  // for profiling
+  GFX_ncCounters.nc_ctDrawCalls++;
+  GFX_ncCounters.nc_ctElements += ctElem;
+  null_Trace( pidx==NULL ? "quads" : "draw", ctElem, GFX_ctVertices);
+}
+
+
+static void null_Finish(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+}
+
+
+static void null_LockArrays(void)
+{
+  ASSERT( _pGfx->gl_eCurrentAPI==GAT_NULL);
+  ASSERT( GFX_ctVertices>0 && !_bCVAReallyLocked);
+}
@@ -16,6 +16,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include "Engine/StdH.h"
 
 #include <Engine/Base/Statistics_Internal.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Jobs.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
 #include <Engine/Graphics/GfxLibrary.h>
 #include <Engine/Graphics/RenderPoly.h>
 #include <Engine/Graphics/Color.h>
@@ -26,6 +31,15 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <mmintrin.h>
 #endif
 
+// kernels for mipmaps, filtering and dithering
+#if !defined(USE_PORTABLE_C) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+  #define BITMAP_SSE2 1
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define BITMAP_NEON 1
+  #include <arm_neon.h>
+#endif
+
 // asm shortcuts
 #define O offset
 #define Q qword ptr
@@ -190,6 +204,106 @@ void FlipBitmap( UBYTE *pubSrc, UBYTE *pubDst, PIX pixWidth, PIX pixHeight, INDE
 
 
 
+// use vector kernels and jobs for bitmap processing (only benchmark turns them off, for reference)
+static BOOL _bVectorBitmaps = TRUE;
+
+// bitmaps larger than this many pixels are processed in bands of about that size, as jobs
+#define BITMAP_BAND_PIXELS (128*128)
+
+// run a function for rows [0, ctRows) of a bitmap, split into jobs if it is large enough
+static void ForBitmapRows( JobRangeFunction_t pFunction, void *pvParam, PIX pixWidth, PIX ctRows)
+{
+  const PIX ctBandRows = Max( BITMAP_BAND_PIXELS/Max(pixWidth,(PIX)1), (PIX)1);
+  if( _pJobs==NULL || ctRows<=ctBandRows) {
+    pFunction( pvParam, 0, ctRows);
+    return;
+  }
+  _pJobs->ParallelFor( pFunction, pvParam, ctRows, ctBandRows);
+}
+
+
+// mipmap rows to make (sizes are of lower mipmap)
+struct MipmapRows {
+  const ULONG *mr_pulSrc;
+  ULONG *mr_pulDst;
+  PIX mr_pixWidth, mr_pixHeight;
+};
+
+// average 2x2 source pixels into each destination pixel, rounded
+static void BilinearMipmapRows( void *pvRows, INDEX iFirst, INDEX iLast)
+{
+  const MipmapRows &mr = *(const MipmapRows *)pvRows;
+  const PIX pixWidth = mr.mr_pixWidth;
+  for( INDEX iRow=iFirst; iRow<iLast; iRow++)
+  {
+    const ULONG *pulUp   = mr.mr_pulSrc + iRow*pixWidth*4;
+    const ULONG *pulDown = pulUp + pixWidth*2;
+    ULONG *pulDst = mr.mr_pulDst + iRow*pixWidth;
+    PIX pix = 0;
+#if BITMAP_SSE2
+    const __m128i xmm0 = _mm_setzero_si128();
+    const __m128i xmmRounder = _mm_set1_epi16(2);
+    for( ; pix+4<=pixWidth; pix+=4) {
+      __m128i axmmPairs[2];
+      for( INDEX i=0; i<2; i++) {
+        // sum up and down pixels of two source pairs
+        const __m128i xmmUp   = _mm_loadu_si128( (const __m128i*)(pulUp  +pix*2+i*4));
+        const __m128i xmmDown = _mm_loadu_si128( (const __m128i*)(pulDown+pix*2+i*4));
+        const __m128i xmmLo = _mm_add_epi16( _mm_unpacklo_epi8(xmmUp,xmm0), _mm_unpacklo_epi8(xmmDown,xmm0));
+        const __m128i xmmHi = _mm_add_epi16( _mm_unpackhi_epi8(xmmUp,xmm0), _mm_unpackhi_epi8(xmmDown,xmm0));
+        // then left and right ones
+        __m128i xmmSum = _mm_add_epi16( _mm_unpacklo_epi64(xmmLo,xmmHi), _mm_unpackhi_epi64(xmmLo,xmmHi));
+        xmmSum = _mm_add_epi16( xmmSum, xmmRounder);
+        axmmPairs[i] = _mm_srli_epi16( xmmSum, 2);
+      }
+      _mm_storeu_si128( (__m128i*)(pulDst+pix), _mm_packus_epi16( axmmPairs[0], axmmPairs[1]));
+    }
+#elif BITMAP_NEON
+    for( ; pix+4<=pixWidth; pix+=4) {
+      // split even and odd source pixels
+      const uint32x4x2_t u32Up   = vld2q_u32( (const uint32_t*)(pulUp  +pix*2));
+      const uint32x4x2_t u32Down = vld2q_u32( (const uint32_t*)(pulDown+pix*2));
+      const uint8x16_t u8UL = vreinterpretq_u8_u32(u32Up.val[0]);
+      const uint8x16_t u8UR = vreinterpretq_u8_u32(u32Up.val[1]);
+      const uint8x16_t u8DL = vreinterpretq_u8_u32(u32Down.val[0]);
+      const uint8x16_t u8DR = vreinterpretq_u8_u32(u32Down.val[1]);
+      const uint16x8_t u16Lo = vaddq_u16( vaddl_u8( vget_low_u8(u8UL),  vget_low_u8(u8UR)),
+                                          vaddl_u8( vget_low_u8(u8DL),  vget_low_u8(u8DR)));
+      const uint16x8_t u16Hi = vaddq_u16( vaddl_u8( vget_high_u8(u8UL), vget_high_u8(u8UR)),
+                                          vaddl_u8( vget_high_u8(u8DL), vget_high_u8(u8DR)));
+      // (sum+2)/4
+      vst1q_u8( (uint8_t*)(pulDst+pix), vcombine_u8( vrshrn_n_u16(u16Lo,2), vrshrn_n_u16(u16Hi,2)));
+    }
+#endif
+    for( ; pix<pixWidth; pix++) {
+      const UBYTE *pubUp   = (const UBYTE*)(pulUp  +pix*2);
+      const UBYTE *pubDown = (const UBYTE*)(pulDown+pix*2);
+      UBYTE *pubDst = (UBYTE*)(pulDst+pix);
+      for( INDEX i=0; i<BYTES_PER_TEXEL; i++) {
+        pubDst[i] = (pubUp[i] + pubUp[i+BYTES_PER_TEXEL] + pubDown[i] + pubDown[i+BYTES_PER_TEXEL] +2) >>2;
+      }
+    }
+  }
+}
+
+// take one of 2x2 source pixels, the one nearest to the outer border of its mipmap quarter
+static void NearestMipmapRows( void *pvRows, INDEX iFirst, INDEX iLast)
+{
+  const MipmapRows &mr = *(const MipmapRows *)pvRows;
+  const PIX pixWidth  = mr.mr_pixWidth;
+  const PIX pixHeight = mr.mr_pixHeight;
+  for( INDEX iRow=iFirst; iRow<iLast; iRow++)
+  {
+    const PIX pixSrcRow = iRow*2 + ((pixHeight>1 && iRow>=pixHeight/2) ? 1 : 0);
+    const ULONG *pulSrc = mr.mr_pulSrc + pixSrcRow*pixWidth*2;
+    ULONG *pulDst = mr.mr_pulDst + iRow*pixWidth;
+    const PIX pixHalf = (pixWidth>1) ? pixWidth/2 : pixWidth;
+    for( PIX pix=0; pix<pixHalf; pix++) pulDst[pix] = pulSrc[pix*2];
+    for( PIX pix=pixHalf; pix<pixWidth; pix++) pulDst[pix] = pulSrc[pix*2+1];
+  }
+}
+
+
 // makes one level lower mipmap (bilinear or nearest-neighbour with border preservance)
 #if (defined __GNUC__)
 __int64 mmRounder = 0x0002000200020002ll;
@@ -206,6 +320,16 @@ static void MakeOneMipmap( ULONG *pulSrcMipmap, ULONG *pulDstMipmap, PIX pixWidt
   pixWidth >>=1;
   pixHeight>>=1;
 
+  if( _bVectorBitmaps) {
+    MipmapRows mr;
+    mr.mr_pulSrc = pulSrcMipmap;
+    mr.mr_pulDst = pulDstMipmap;
+    mr.mr_pixWidth  = pixWidth;
+    mr.mr_pixHeight = pixHeight;
+    ForBitmapRows( bBilinear ? BilinearMipmapRows : NearestMipmapRows, &mr, pixWidth, pixHeight);
+    return;
+  }
+
   if( bBilinear) // type of filtering?
   { // BILINEAR
 
@@ -467,9 +591,11 @@ fullEnd:
 
      for (int q = 0; q < 2; q++)
      {
-         for (PIX i = pixHeight / 2; i > 0; i--)
+         // like asm, do upper half and left halves at least once (for 1 pixel wide or high mipmaps)
+         const PIX ctHalfRows = (q==0) ? Max(pixHeight/2, (PIX)1) : pixHeight/2;
+         for (PIX i = ctHalfRows; i > 0; i--)
          {
-             for (PIX j = pixWidth / 2; j > 0; j--)
+             for (PIX j = Max(pixWidth/2, (PIX)1); j > 0; j--)
              {
                  *pulDstMipmap = *(pulSrcMipmap + offset);
                  pulSrcMipmap += 2;
@@ -653,6 +779,47 @@ static inline void IncrementByteWithClip( UBYTE &ub, SLONG slAdd)
 }
 #endif
 
+// bitmap rows to dither with an ordered matrix
+struct DitherRows {
+  const ULONG *dr_pulSrc;
+  ULONG *dr_pulDst;
+  PIX dr_pixWidth, dr_pixCanvasWidth;
+  UBYTE dr_aaubPattern[4][4*BYTES_PER_TEXEL];  // what to add to 4 pixels of each row modulo 4
+};
+
+// add dither pattern to pixels, with saturation
+static void DitherOrderedRows( void *pvRows, INDEX iFirst, INDEX iLast)
+{
+  const DitherRows &dr = *(const DitherRows *)pvRows;
+  const PIX pixWidth = dr.dr_pixWidth;
+  for( INDEX iRow=iFirst; iRow<iLast; iRow++)
+  {
+    const ULONG *pulSrc = dr.dr_pulSrc + iRow*dr.dr_pixCanvasWidth;
+    ULONG *pulDst = dr.dr_pulDst + iRow*dr.dr_pixCanvasWidth;
+    const UBYTE *pubPattern = dr.dr_aaubPattern[iRow&3];
+    PIX pix = 0;
+#if BITMAP_SSE2
+    const __m128i xmmPattern = _mm_loadu_si128( (const __m128i*)pubPattern);
+    for( ; pix+4<=pixWidth; pix+=4) {
+      const __m128i xmmPixels = _mm_loadu_si128( (const __m128i*)(pulSrc+pix));
+      _mm_storeu_si128( (__m128i*)(pulDst+pix), _mm_adds_epu8( xmmPixels, xmmPattern));
+    }
+#elif BITMAP_NEON
+    const uint8x16_t u8Pattern = vld1q_u8(pubPattern);
+    for( ; pix+4<=pixWidth; pix+=4) {
+      vst1q_u8( (uint8_t*)(pulDst+pix), vqaddq_u8( vld1q_u8((const uint8_t*)(pulSrc+pix)), u8Pattern));
+    }
+#endif
+    for( ; pix<pixWidth; pix++) {
+      const UBYTE *pubSrc = (const UBYTE*)(pulSrc+pix);
+      UBYTE *pubDst = (UBYTE*)(pulDst+pix);
+      for( INDEX i=0; i<BYTES_PER_TEXEL; i++) {
+        pubDst[i] = Min( pubSrc[i] + pubPattern[(pix&3)*BYTES_PER_TEXEL+i], 255);
+      }
+    }
+  }
+}
+
 // performs dithering of a 32-bit bipmap (can be in-place)
 void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PIX pixHeight,
                    PIX pixCanvasWidth, PIX pixCanvasHeight)
@@ -774,6 +941,23 @@ void DitherBitmap( INDEX iDitherType, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth
 // ------------------------------- ordered matrix dithering routine
 
 ditherOrder:
+  if( _bVectorBitmaps) {
+    // shifting bytes gives the same as shifting and masking whole words, as asm does
+    DitherRows dr;
+    for( INDEX iRow=0; iRow<4; iRow++) {
+      for( INDEX i=0; i<4*BYTES_PER_TEXEL; i++) {
+        const UBYTE ub = ((UBYTE*)(pulDitherTable+iRow*4))[i];
+        dr.dr_aaubPattern[iRow][i] = (ub>>mmShifter) & (UBYTE)mmMask;
+      }
+    }
+    dr.dr_pulSrc = pulSrc;
+    dr.dr_pulDst = pulDst;
+    dr.dr_pixWidth = pixWidth;
+    dr.dr_pixCanvasWidth = pixCanvasWidth;
+    ForBitmapRows( DitherOrderedRows, &dr, pixWidth, pixHeight);
+    goto theEnd;
+  }
+
 #if (defined __MSVC_INLINE__)
   __asm {
     mov     esi,D [pulSrc]
@@ -889,18 +1073,22 @@ nextRowO:
     UBYTE bytes[8];
   } __attribute__((packed));	//avoid optimisation and BUSERROR on Pyra build
   for (int i=0; i<pixHeight; i++) {
-    int idx = i&3;
-    uConv dith;
-    dith.dwords[0] = pulDitherTable[idx];
-    dith.dwords[1] = pulDitherTable[idx+1];
-    for (int j=0; j<4; j++) { dith.words[j] >>= mmShifter; }
-    dith.val &= mmMask;
-    uConv* src = (uConv*)(pulSrc+i*pixWidth);
-    uConv* dst = (uConv*)(pulDst+i*pixWidth);
+    // like asm, take pattern of 4 pixels from row i&3 of the table
+    int idx = (i&3)*4;
+    uConv dith[2];
+    dith[0].dwords[0] = pulDitherTable[idx+0];
+    dith[0].dwords[1] = pulDitherTable[idx+1];
+    dith[1].dwords[0] = pulDitherTable[idx+2];
+    dith[1].dwords[1] = pulDitherTable[idx+3];
+    for (int j=0; j<4; j++) { dith[0].words[j] >>= mmShifter;  dith[1].words[j] >>= mmShifter; }
+    dith[0].val &= mmMask;
+    dith[1].val &= mmMask;
+    uConv* src = (uConv*)(pulSrc+i*pixCanvasWidth);
+    uConv* dst = (uConv*)(pulDst+i*pixCanvasWidth);
     for (int j=0; j<pixWidth; j+=2) {
       uConv p=src[0];
       for (int k=0; k<8; k++) {
-        IncrementByteWithClip(p.bytes[k], dith.bytes[k]);
+        IncrementByteWithClip(p.bytes[k], dith[(j>>1)&1].bytes[k]);
       }
       dst[0] = p;
       src++;
@@ -1247,6 +1435,151 @@ static void GenerateConvolutionMatrix( INDEX iFilter)
 }
 
 
+// bitmap rows to filter (source must not be the destination)
+struct FilterRows {
+  const ULONG *fr_pulSrc;
+  ULONG *fr_pulDst;
+  PIX fr_pixWidth, fr_pixHeight;
+  PIX fr_pixSrcStride, fr_pixDstStride;
+  SWORD fr_swCorner, fr_swEdge, fr_swMiddle, fr_swInvDiv;
+  BOOL fr_bInPlace;   // some pixels are taken from already filtered ones, as it is with in-place filtering
+};
+
+// same values as GenerateConvolutionMatrix() makes for middle pixels (edge and corner pixels
+// get the same result with their bordering pixels repeated, so they need no values of their own)
+static void SetFilterWeights( FilterRows &fr, INDEX iFilter)
+{
+  INDEX iFilterAbs = Abs(iFilter) -1;
+  INDEX iMc = aiFilters[iFilterAbs][0];  // corner
+  INDEX iMe = aiFilters[iFilterAbs][1];  // edge
+  INDEX iMm = aiFilters[iFilterAbs][2];  // middle
+  if( iFilter<0) {
+    iMm += (iMe+iMc) *8;
+    iMe  = -iMe;
+    iMc  = -iMc;
+  }
+  fr.fr_swInvDiv = (SWORD)(((__int64)ceil(65536.0f/(iMc*4+iMe*4+iMm))) & 0xFFFF);
+  fr.fr_swCorner = (SWORD)iMc;
+  fr.fr_swEdge   = (SWORD)iMe;
+  fr.fr_swMiddle = (SWORD)iMm;
+}
+
+// filter one pixel, doing the same 16-bit math per channel as MMX does
+// (left pixels of each row can come from a different row)
+static inline ULONG FilterPixel( const FilterRows &fr, const ULONG *pulUpLeft, const ULONG *pulUp,
+                                 const ULONG *pulMidLeft, const ULONG *pulMid, const ULONG *pulDownLeft, const ULONG *pulDown,
+                                 PIX pixLeft, PIX pix, PIX pixRight)
+{
+  ULONG ulResult = 0;
+  for( INDEX iShift=0; iShift<32; iShift+=8) {
+#define CHANNEL(pul, i) ((SLONG)((pul[i]>>iShift)&0xFF))
+    const SLONG slCorners = CHANNEL(pulUpLeft,pixLeft) + CHANNEL(pulUp,pixRight) + CHANNEL(pulDownLeft,pixLeft) + CHANNEL(pulDown,pixRight);
+    const SLONG slEdges   = CHANNEL(pulUp,pix) + CHANNEL(pulMidLeft,pixLeft) + CHANNEL(pulMid,pixRight) + CHANNEL(pulDown,pix);
+    const SWORD swSum = (SWORD)(slCorners*fr.fr_swCorner + slEdges*fr.fr_swEdge + CHANNEL(pulMid,pix)*fr.fr_swMiddle);
+#undef CHANNEL
+    const SLONG slRounded = Clamp( (SLONG)swSum+7, (SLONG)-32768, (SLONG)32767);
+    const SLONG slFiltered = (slRounded*fr.fr_swInvDiv) >>16;
+    ulResult |= ((ULONG)Clamp( slFiltered, (SLONG)0, (SLONG)255)) <<iShift;
+  }
+  return ulResult;
+}
+
+// filter rows of bitmap, repeating border pixels (in order, if in-place, as reference
+// there writes each filtered row while still reading the next one, and last row while reading it)
+static void FilterBitmapRows( void *pvRows, INDEX iFirst, INDEX iLast)
+{
+  const FilterRows &fr = *(const FilterRows *)pvRows;
+  const PIX pixLast = fr.fr_pixWidth-1;
+  for( INDEX iRow=iFirst; iRow<iLast; iRow++)
+  {
+    const ULONG *pulMid  = fr.fr_pulSrc + iRow*fr.fr_pixSrcStride;
+    const ULONG *pulUp   = (iRow>0) ? pulMid-fr.fr_pixSrcStride : pulMid;
+    const ULONG *pulDown = (iRow<fr.fr_pixHeight-1) ? pulMid+fr.fr_pixSrcStride : pulMid;
+    ULONG *pulDst = fr.fr_pulDst + iRow*fr.fr_pixDstStride;
+    const BOOL bLastInPlace = fr.fr_bInPlace && iRow==fr.fr_pixHeight-1;
+    const ULONG *pulUpLeft   = (fr.fr_bInPlace && iRow>0) ? pulDst-fr.fr_pixDstStride : pulUp;
+    const ULONG *pulMidLeft  = bLastInPlace ? pulDst : pulMid;
+    const ULONG *pulDownLeft = bLastInPlace ? pulDst : pulDown;
+    pulDst[0] = FilterPixel( fr, pulUp, pulUp, pulMid, pulMid, pulDown, pulDown, 0, 0, 1);
+    // there each pixel depends on the one before, so it is not vectorized
+    const PIX pixVectorEnd = bLastInPlace ? 1 : pixLast;
+    PIX pix = 1;
+#if BITMAP_SSE2
+    const __m128i xmm0 = _mm_setzero_si128();
+    const __m128i xmmCorner = _mm_set1_epi16(fr.fr_swCorner);
+    const __m128i xmmEdge   = _mm_set1_epi16(fr.fr_swEdge);
+    const __m128i xmmMiddle = _mm_set1_epi16(fr.fr_swMiddle);
+    const __m128i xmmInvDiv = _mm_set1_epi16(fr.fr_swInvDiv);
+    const __m128i xmmAdd    = _mm_set1_epi16(7);
+    for( ; pix+4<=pixVectorEnd; pix+=4) {
+      const __m128i xmmUL = _mm_loadu_si128( (const __m128i*)(pulUpLeft+pix-1));
+      const __m128i xmmU  = _mm_loadu_si128( (const __m128i*)(pulUp  +pix  ));
+      const __m128i xmmUR = _mm_loadu_si128( (const __m128i*)(pulUp  +pix+1));
+      const __m128i xmmL  = _mm_loadu_si128( (const __m128i*)(pulMid +pix-1));
+      const __m128i xmmM  = _mm_loadu_si128( (const __m128i*)(pulMid +pix  ));
+      const __m128i xmmR  = _mm_loadu_si128( (const __m128i*)(pulMid +pix+1));
+      const __m128i xmmDL = _mm_loadu_si128( (const __m128i*)(pulDown+pix-1));
+      const __m128i xmmD  = _mm_loadu_si128( (const __m128i*)(pulDown+pix  ));
+      const __m128i xmmDR = _mm_loadu_si128( (const __m128i*)(pulDown+pix+1));
+      __m128i axmmHalves[2];
+      for( INDEX i=0; i<2; i++) {
+#define EXTEND(xmm) (i==0 ? _mm_unpacklo_epi8(xmm,xmm0) : _mm_unpackhi_epi8(xmm,xmm0))
+        const __m128i xmmCorners = _mm_add_epi16( _mm_add_epi16( EXTEND(xmmUL), EXTEND(xmmUR)),
+                                                  _mm_add_epi16( EXTEND(xmmDL), EXTEND(xmmDR)));
+        const __m128i xmmEdges   = _mm_add_epi16( _mm_add_epi16( EXTEND(xmmU),  EXTEND(xmmL)),
+                                                  _mm_add_epi16( EXTEND(xmmR),  EXTEND(xmmD)));
+        __m128i xmmSum = _mm_add_epi16( _mm_mullo_epi16( xmmCorners, xmmCorner), _mm_mullo_epi16( xmmEdges, xmmEdge));
+        xmmSum = _mm_add_epi16( xmmSum, _mm_mullo_epi16( EXTEND(xmmM), xmmMiddle));
+#undef EXTEND
+        xmmSum = _mm_adds_epi16( xmmSum, xmmAdd);
+        axmmHalves[i] = _mm_mulhi_epi16( xmmSum, xmmInvDiv);
+      }
+      _mm_storeu_si128( (__m128i*)(pulDst+pix), _mm_packus_epi16( axmmHalves[0], axmmHalves[1]));
+    }
+#elif BITMAP_NEON
+    const int16x8_t s16Corner = vdupq_n_s16(fr.fr_swCorner);
+    const int16x8_t s16Edge   = vdupq_n_s16(fr.fr_swEdge);
+    const int16x8_t s16Middle = vdupq_n_s16(fr.fr_swMiddle);
+    const int16x4_t s16InvDiv = vdup_n_s16(fr.fr_swInvDiv);
+    const int16x8_t s16Add    = vdupq_n_s16(7);
+    for( ; pix+4<=pixVectorEnd; pix+=4) {
+      const uint8x16_t u8UL = vld1q_u8( (const uint8_t*)(pulUpLeft+pix-1));
+      const uint8x16_t u8U  = vld1q_u8( (const uint8_t*)(pulUp  +pix  ));
+      const uint8x16_t u8UR = vld1q_u8( (const uint8_t*)(pulUp  +pix+1));
+      const uint8x16_t u8L  = vld1q_u8( (const uint8_t*)(pulMid +pix-1));
+      const uint8x16_t u8M  = vld1q_u8( (const uint8_t*)(pulMid +pix  ));
+      const uint8x16_t u8R  = vld1q_u8( (const uint8_t*)(pulMid +pix+1));
+      const uint8x16_t u8DL = vld1q_u8( (const uint8_t*)(pulDown+pix-1));
+      const uint8x16_t u8D  = vld1q_u8( (const uint8_t*)(pulDown+pix  ));
+      const uint8x16_t u8DR = vld1q_u8( (const uint8_t*)(pulDown+pix+1));
+      uint8x8_t au8Halves[2];
+      for( INDEX i=0; i<2; i++) {
+#define EXTEND(u8) vreinterpretq_s16_u16( vmovl_u8( i==0 ? vget_low_u8(u8) : vget_high_u8(u8)))
+        const int16x8_t s16Corners = vaddq_s16( vaddq_s16( EXTEND(u8UL), EXTEND(u8UR)),
+                                                vaddq_s16( EXTEND(u8DL), EXTEND(u8DR)));
+        const int16x8_t s16Edges   = vaddq_s16( vaddq_s16( EXTEND(u8U),  EXTEND(u8L)),
+                                                vaddq_s16( EXTEND(u8R),  EXTEND(u8D)));
+        int16x8_t s16Sum = vmulq_s16( s16Corners, s16Corner);
+        s16Sum = vmlaq_s16( s16Sum, s16Edges, s16Edge);
+        s16Sum = vmlaq_s16( s16Sum, EXTEND(u8M), s16Middle);
+#undef EXTEND
+        s16Sum = vqaddq_s16( s16Sum, s16Add);
+        // high halves of products
+        const int16x8_t s16Filtered = vcombine_s16( vshrn_n_s32( vmull_s16( vget_low_s16(s16Sum),  s16InvDiv), 16),
+                                                    vshrn_n_s32( vmull_s16( vget_high_s16(s16Sum), s16InvDiv), 16));
+        au8Halves[i] = vqmovun_s16(s16Filtered);
+      }
+      vst1q_u8( (uint8_t*)(pulDst+pix), vcombine_u8( au8Halves[0], au8Halves[1]));
+    }
+#endif
+    for( ; pix<pixLast; pix++) {
+      pulDst[pix] = FilterPixel( fr, pulUpLeft, pulUp, pulMidLeft, pulMid, pulDownLeft, pulDown, pix-1, pix, pix+1);
+    }
+    pulDst[pixLast] = FilterPixel( fr, pulUpLeft, pulUp, pulMidLeft, pulMid, pulDownLeft, pulDown, pixLast-1, pixLast, pixLast);
+  }
+}
+
+
 extern "C" {
     ULONG *FB_pulSrc = NULL;
     ULONG *FB_pulDst = NULL;
@@ -1350,6 +1683,38 @@ void FilterBitmap( INDEX iFilter, ULONG *pulSrc, ULONG *pulDst, PIX pixWidth, PI
 
   // prepare convolution matrix and row modulo
   iFilter = Clamp( iFilter, -6, 6);
+
+  if( _bVectorBitmaps) {
+    FilterRows fr;
+    SetFilterWeights( fr, iFilter);
+    fr.fr_pulDst = pulDst;
+    fr.fr_pixWidth  = pixWidth;
+    fr.fr_pixHeight = pixHeight;
+    fr.fr_pixDstStride = pixCanvasWidth;
+    // in-place filtering reads from a copy of source, row by row
+    ULONG *pulCopy = NULL;
+    fr.fr_bInPlace = pulSrc==pulDst;
+    if( fr.fr_bInPlace) {
+      pulCopy = (ULONG*)AllocMemory( pixWidth*pixHeight *BYTES_PER_TEXEL);
+      for( PIX pixRow=0; pixRow<pixHeight; pixRow++) {
+        memcpy( pulCopy+pixRow*pixWidth, pulSrc+pixRow*pixCanvasWidth, pixWidth*BYTES_PER_TEXEL);
+      }
+      fr.fr_pulSrc = pulCopy;
+      fr.fr_pixSrcStride = pixWidth;
+    } else {
+      fr.fr_pulSrc = pulSrc;
+      fr.fr_pixSrcStride = pixCanvasWidth;
+    }
+    if( fr.fr_bInPlace) {
+      FilterBitmapRows( &fr, 0, pixHeight);
+    } else {
+      ForBitmapRows( FilterBitmapRows, &fr, pixWidth, pixHeight);
+    }
+    if( pulCopy!=NULL) FreeMemory(pulCopy);
+    _pfGfxProfile.StopTimer( CGfxProfile::PTI_FILTERBITMAP);
+    return;
+  }
+
   GenerateConvolutionMatrix( iFilter);
   SLONG slModulo1 = (pixCanvasWidth-pixWidth+1) *BYTES_PER_TEXEL;
   SLONG slCanvasWidth = pixCanvasWidth *BYTES_PER_TEXEL;
@@ -3086,3 +3451,141 @@ allDoneE:
     }
 
 #endif
+
+
+
+/////////////////////////////////////////////////////////////////////
+//                      BENCHMARK
+/////////////////////////////////////////////////////////////////////
+
+// stages of texture processing to compare
+static const char *_astrBitmapStages[] = {
+  "mipmaps (bilinear)",
+  "mipmaps (nearest)",
+  "filter (all 12)",
+  "filter (canvas)",
+  "filter (in-place)",
+  "dither (ordered)",
+};
+static const INDEX _ctBitmapStages = ARRAYCOUNT(_astrBitmapStages);
+
+// ordered dither types
+static INDEX _aiOrderedDithers[] = { 1, 2, 4, 5, 6, 8, 9 };
+static const INDEX _ctOrderedDithers = ARRAYCOUNT(_aiOrderedDithers);
+
+// run one stage on bitmap (followed by room for its mipmaps and one more bitmap),
+// returns number of source bytes processed
+static SLONG RunBitmapStage( INDEX iStage, ULONG *pulBitmap, ULONG *pulSpare, PIX pixWidth, PIX pixHeight)
+{
+  const SLONG slSize = pixWidth*pixHeight *BYTES_PER_TEXEL;
+  switch( iStage) {
+  case 0:
+    MakeMipmaps( 32, pulBitmap, pixWidth, pixHeight);
+    return slSize;
+  case 1:
+    MakeMipmaps( 0, pulBitmap, pixWidth, pixHeight);
+    return slSize;
+  case 2: {
+    // back and forth, so it ends in bitmap
+    INDEX ctFilters = 0;
+    for( INDEX iFilter=-6; iFilter<=6; iFilter++) {
+      if( iFilter==0) continue;
+      if( ctFilters&1) FilterBitmap( iFilter, pulSpare, pulBitmap, pixWidth, pixHeight);
+      else             FilterBitmap( iFilter, pulBitmap, pulSpare, pixWidth, pixHeight);
+      ctFilters++;
+    }
+    return slSize*ctFilters; }
+  case 3:
+    // odd sized part of bitmap, as shadow maps are filtered
+    FilterBitmap( 3, pulBitmap, pulSpare, pixWidth-3, pixHeight-1, pixWidth, pixHeight);
+    return (pixWidth-3)*(pixHeight-1) *BYTES_PER_TEXEL;
+  case 4:
+    // strongest sharpen and blur, once each
+    FilterBitmap( -6, pulBitmap, pulBitmap, pixWidth, pixHeight);
+    FilterBitmap( +6, pulSpare,  pulSpare,  pixWidth, pixHeight);
+    return slSize*2;
+  case 5:
+    for( INDEX i=0; i<_ctOrderedDithers; i++) {
+      DitherBitmap( _aiOrderedDithers[i], pulBitmap, pulBitmap, pixWidth, pixHeight);
+    }
+    return slSize*_ctOrderedDithers;
+  }
+  ASSERTALWAYS( "Unknown bitmap stage.");
+  return 0;
+}
+
+// largest difference of a color channel between two bitmaps
+static INDEX MaxChannelDifference( const ULONG *pul0, const ULONG *pul1, PIX ctPixels)
+{
+  INDEX iMax = 0;
+  const UBYTE *pub0 = (const UBYTE*)pul0;
+  const UBYTE *pub1 = (const UBYTE*)pul1;
+  for( INDEX i=0; i<ctPixels*BYTES_PER_TEXEL; i++) {
+    iMax = Max( iMax, (INDEX)Abs( pub0[i]-pub1[i]));
+  }
+  return iMax;
+}
+
+// compare vector and threaded bitmap processing with reference code and time both
+void BitmapBenchmark(void *pArgs)
+{
+  INDEX iSize = NEXTARGUMENT(INDEX);
+  // (reference filter can not do bitmaps wider than its row buffer)
+  const PIX pixWidth  = 1L<<FastLog2( Clamp( iSize, (INDEX)16, (INDEX)2048));
+  const PIX pixHeight = pixWidth/2;
+  const PIX pixMips = GetMipmapOffset( 32, pixWidth, pixHeight);
+  const PIX pixBuffer = pixMips + pixWidth*pixHeight;
+  const INDEX ctRepeats = Max( (INDEX)((1<<24)/(pixWidth*pixHeight)), (INDEX)1);
+  CPrintF("Bitmap benchmark, %dx%d, %d times (%d threads):\n", pixWidth, pixHeight, ctRepeats,
+    _pJobs!=NULL ? _pJobs->GetThreadCount() : 1);
+  CPrintF("  %-20s %14s %14s\n", "stage", "reference", "vector");
+
+  // noisy gradients, with some pixels at extremes
+  ULONG *pulSource = (ULONG*)AllocMemory( pixBuffer *BYTES_PER_TEXEL);
+  ULONG *pulRef    = (ULONG*)AllocMemory( pixBuffer *BYTES_PER_TEXEL);
+  ULONG *pulVec    = (ULONG*)AllocMemory( pixBuffer *BYTES_PER_TEXEL);
+  ULONG ulSeed = 0x12345678;
+  for( PIX pix=0; pix<pixBuffer; pix++) {
+    ulSeed = ulSeed*1103515245+12345;
+    const PIX pixU = pix%pixWidth;
+    const PIX pixV = (pix/pixWidth)%pixHeight;
+    const UBYTE ubNoise = ulSeed>>24;
+    pulSource[pix] = RGBAToColor( pixU*255/pixWidth, pixV*255/pixHeight, ubNoise, (pixU^pixV)&0xFF);
+    if( (ulSeed>>8)%61==0) pulSource[pix] = (ulSeed&0x100) ? 0xFFFFFFFF : 0x00000000;
+  }
+
+  INDEX ctMismatches = 0;
+  for( INDEX iStage=0; iStage<_ctBitmapStages; iStage++)
+  {
+    DOUBLE adSeconds[2] = { 0, 0 };
+    SLONG slBytes = 0;
+    for( INDEX iVector=0; iVector<2; iVector++) {
+      _bVectorBitmaps = iVector;
+      ULONG *pulBitmap = iVector ? pulVec : pulRef;
+      for( INDEX iRepeat=0; iRepeat<ctRepeats; iRepeat++) {
+        memcpy( pulBitmap, pulSource, pixBuffer *BYTES_PER_TEXEL);
+        const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+        slBytes = RunBitmapStage( iStage, pulBitmap, pulBitmap+pixMips, pixWidth, pixHeight);
+        adSeconds[iVector] += (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+      }
+    }
+    _bVectorBitmaps = TRUE;
+
+    CTString strResult = "";
+    const INDEX iDifference = MaxChannelDifference( pulRef, pulVec, pixBuffer);
+    if( iDifference>0) {
+      strResult.PrintF("  MISMATCH (by %d)", iDifference);
+      ctMismatches++;
+    }
+    const DOUBLE dMB = (DOUBLE)slBytes*ctRepeats/(1024.0*1024.0);
+    CPrintF("  %-20s %9.1f MB/s %9.1f MB/s%s\n", _astrBitmapStages[iStage],
+      dMB/Max(adSeconds[0],1E-9), dMB/Max(adSeconds[1],1E-9), (const char *)strResult);
+  }
+
+  if( ctMismatches>0) {
+    CPrintF("  ERROR: %d stages differ from reference!\n", ctMismatches);
+  }
+  FreeMemory( pulSource);
+  FreeMemory( pulRef);
+  FreeMemory( pulVec);
+}
@@ -24,6 +24,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Graphics/GfxLibrary.h>
 #include <Engine/Graphics/ImageInfo.h>
 #include <Engine/Graphics/TextureEffects.h>
+#include <Engine/Graphics/TextureCache.h>
 
 #include <Engine/Templates/DynamicArray.h>
 #include <Engine/Templates/DynamicArray.cpp>
@@ -56,7 +57,7 @@ struct TextureSettings TS = {0};
 // determine (or assume) support for OpenGL and Direct3D texture internal formats
 extern void DetermineSupportedTextureFormats( GfxAPIType eAPI)
 {
-  if( eAPI==GAT_OGL) {
+  if( eAPI==GAT_OGL || eAPI==GAT_NULL) {
     TS.ts_tfRGB8   = GL_RGB8;
     TS.ts_tfRGBA8  = GL_RGBA8;
     TS.ts_tfRGB5   = GL_RGB5;
@@ -365,6 +366,8 @@ static void InitEffectBufferDimensions( CTextureData *pTD)
 // free effect buffers' memory
 static void FreeEffectBuffers( CTextureData *pTD)
 {
+  // buffers might be in use by animation job
+  if( pTD->td_ptegEffect != NULL) pTD->td_ptegEffect->FinishAnimating();
   if( pTD->td_pubBuffer1 != NULL) {
     FreeMemory( pTD->td_pubBuffer1);
     pTD->td_pubBuffer1 = NULL;
@@ -900,6 +903,17 @@ void CTextureData::Read_t( CTStream *inFile)
 
   // if texture is in old format, convert it to current format
   if( iVersion==3) Convert(this);
+
+  // if it has been processed with same settings before, take mip-maps from the cache
+  CTextureCacheKey tck;
+  const BOOL bUseCache = !_bExport && iVersion==4 && tex_bMipmapCache;
+  if( bUseCache) {
+    MakeTextureCacheKey( this, tck);
+    if( LoadCachedTexture( this, tck)) {
+      if( bHasContext && !(td_ulFlags&TEX_STATIC)) SetAsCurrent();
+      return;
+    }
+  }
   PIX pixWidth  = GetPixWidth();
   PIX pixHeight = GetPixHeight();
   PIX pixTexSize = pixWidth*pixHeight;
@@ -984,7 +998,7 @@ void CTextureData::Read_t( CTStream *inFile)
   INDEX iDitherType = 0;
   if( !(td_ulFlags&TEX_STATIC) || !(td_ulFlags&TEX_CONSTANT)) { // only non-static-constant textures can be dithered
     extern INDEX AdjustDitheringType_OGL(    GLenum eFormat, INDEX iDitheringType);
-    if( eAPI==GAT_OGL) iDitherType = AdjustDitheringType_OGL(    (GLenum)td_ulInternalFormat, tex_iDithering);
+    if( eAPI==GAT_OGL || eAPI==GAT_NULL) iDitherType = AdjustDitheringType_OGL(    (GLenum)td_ulInternalFormat, tex_iDithering);
 #ifdef SE1_D3D
     extern INDEX AdjustDitheringType_D3D( D3DFORMAT eFormat, INDEX iDitheringType);
     if( eAPI==GAT_D3D) iDitherType = AdjustDitheringType_D3D( (D3DFORMAT)td_ulInternalFormat, tex_iDithering);
@@ -998,6 +1012,9 @@ void CTextureData::Read_t( CTStream *inFile)
       DitherMipmaps( iDitherType, pulCurrentFrame, pulCurrentFrame, pixWidth, pixHeight);
     }
   }
+  // keep processed mip-maps for next time
+  if( bUseCache) SaveCachedTexture( this, tck);
+
   // upload texture if not static and API is active
   // (or, in the other hand, better not - this could cause reloading due to force() after obtain())
   if( !_bExport && bHasContext && !(td_ulFlags&TEX_STATIC)) SetAsCurrent();
@@ -1097,6 +1114,7 @@ void CTextureData::Write_t( CTStream *outFile)   // throw char *
     // if effect buffers are valid
     if( td_pubBuffer1!=NULL && td_pubBuffer2!=NULL)
     { // write chunk containing effect buffers
+      td_ptegEffect->FinishAnimating();
       outFile->WriteID_t( CChunkID("FXB2"));
       ULONG ulSize = GetEffectBufferSize(this);
       // write effect buffers
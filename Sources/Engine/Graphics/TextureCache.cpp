@@ -0,0 +1,276 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Graphics/TextureCache.h>
+#include <Engine/Graphics/Texture.h>
+#include <Engine/Graphics/GfxLibrary.h>
+#include <Engine/Graphics/Color.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Math/Functions.h>
+#include <Engine/Templates/DynamicStackArray.cpp>
+
+extern INDEX tex_iFiltering;
+extern INDEX tex_iDithering;
+extern INDEX tex_bProgressiveFilter;
+extern INDEX tex_bColorizeMipmaps;
+extern INDEX gap_bAllowSingleMipmap;
+extern INDEX gap_bAllowGrayTextures;
+extern INDEX _iTexForcedQuality;
+
+// change this whenever texture processing starts giving different results
+#define TEXTURECACHE_VERSION 1
+
+// statistics (for prewarming report)
+static INDEX _ctCacheHits = 0;
+static INDEX _ctCacheStores = 0;
+
+// 64-bit FNV-1a, taking a whole long at a time
+#define HASH_START 0xCBF29CE484222325ULL
+static inline void HashLONG( __uint64 &ullHash, ULONG ul)
+{
+  ullHash = (ullHash^ul) * 0x100000001B3ULL;
+}
+static inline void HashLONGs( __uint64 &ullHash, const ULONG *pul, INDEX ctLongs)
+{
+  __uint64 ull = ullHash;
+  for( INDEX i=0; i<ctLongs; i++) ull = (ull^pul[i]) * 0x100000001B3ULL;
+  ullHash = ull;
+}
+
+
+/* Make key for texture that has just got its raw frames read. */
+void MakeTextureCacheKey( CTextureData *ptd, CTextureCacheKey &tck)
+{
+  // hash base mip-map of each frame (the rest isn't made yet)
+  const PIX pixTexSize = ptd->GetPixWidth()*ptd->GetPixHeight();
+  const PIX pixFrameSize = ptd->td_slFrameSize/BYTES_PER_TEXEL;
+  tck.tck_ullFrames = HASH_START;
+  for( INDEX iFrame=0; iFrame<ptd->td_ctFrames; iFrame++) {
+    HashLONGs( tck.tck_ullFrames, ptd->td_pulFrames + iFrame*pixFrameSize, pixTexSize);
+  }
+
+  // static flag alone doesn't change anything (it is only set for prewarming)
+  ULONG ulFlags = ptd->td_ulFlags;
+  if( !(ulFlags&TEX_CONSTANT)) ulFlags &= ~TEX_STATIC;
+
+  __uint64 &ull = tck.tck_ullSettings;
+  ull = HASH_START;
+  HashLONG( ull, TEXTURECACHE_VERSION);
+  HashLONG( ull, ulFlags);
+  HashLONG( ull, ptd->td_mexWidth);
+  HashLONG( ull, ptd->td_mexHeight);
+  HashLONG( ull, ptd->td_iFirstMipLevel);
+  HashLONG( ull, ptd->td_ctFineMipLevels);
+  HashLONG( ull, ptd->td_ctFrames);
+  HashLONG( ull, ptd->td_slFrameSize);
+  // filtering, saturation and colorizing
+  HashLONG( ull, Clamp( tex_iFiltering, -6, 6));
+  HashLONG( ull, tex_bProgressiveFilter);
+  HashLONG( ull, _slTexSaturation);
+  HashLONG( ull, _slTexHueShift);
+  HashLONG( ull, tex_bColorizeMipmaps);
+  HashLONG( ull, gap_bAllowSingleMipmap);
+  // size limits and internal format (that also decides dithering)
+  HashLONG( ull, _pGfx->gl_eCurrentAPI);
+  HashLONG( ull, _pGfx->gl_pixMaxTextureDimension);
+  HashLONG( ull, gap_bAllowGrayTextures);
+  HashLONG( ull, _iTexForcedQuality);
+  HashLONG( ull, Clamp( tex_iDithering, 0, 10));
+  HashLONG( ull, TS.ts_iNormQualityO);
+  HashLONG( ull, TS.ts_iNormQualityA);
+  HashLONG( ull, TS.ts_iAnimQualityO);
+  HashLONG( ull, TS.ts_iAnimQualityA);
+  HashLONG( ull, TS.ts_pixNormSize);
+  HashLONG( ull, TS.ts_pixAnimSize);
+  HashLONG( ull, TS.ts_tfRGB8);
+  HashLONG( ull, TS.ts_tfRGBA8);
+  HashLONG( ull, TS.ts_tfRGB5);
+  HashLONG( ull, TS.ts_tfRGBA4);
+  HashLONG( ull, TS.ts_tfRGB5A1);
+  HashLONG( ull, TS.ts_tfLA8);
+  HashLONG( ull, TS.ts_tfL8);
+  HashLONG( ull, TS.ts_tfCRGB);
+  HashLONG( ull, TS.ts_tfCRGBA);
+}
+
+
+// file that holds the entry for given key
+static CTFileName CacheFileName( const CTextureCacheKey &tck)
+{
+  CTString strName;
+  strName.PrintF( "Temp\\TextureCache\\%08X%08X%08X%08X.tch",
+    ULONG(tck.tck_ullFrames>>32), ULONG(tck.tck_ullFrames),
+    ULONG(tck.tck_ullSettings>>32), ULONG(tck.tck_ullSettings));
+  return CTFileName(strName);
+}
+
+
+// read entry for given key into a new buffer, along with what processing changed
+static ULONG *ReadEntry_t( CTextureData *ptd, const CTextureCacheKey &tck, const CTFileName &fnm,
+  ULONG &ulFlags, SLONG &slFrameSize, INDEX &iFirstMipLevel, INDEX &ctFineMipLevels, ULONG &ulInternalFormat) // throw char *
+{
+  CTFileStream strm;
+  strm.Open_t(fnm);
+  strm.ExpectID_t("TXCH");
+  // key is in the file too, so a renamed or stale file cannot be taken for another one
+  ULONG aulKey[5];
+  for( INDEX i=0; i<5; i++) strm>>aulKey[i];
+  if( aulKey[0]!=TEXTURECACHE_VERSION
+   || aulKey[1]!=ULONG(tck.tck_ullFrames>>32)   || aulKey[2]!=ULONG(tck.tck_ullFrames)
+   || aulKey[3]!=ULONG(tck.tck_ullSettings>>32) || aulKey[4]!=ULONG(tck.tck_ullSettings)) {
+    throw TRANS("Texture cache entry doesn't match its name.");
+  }
+  strm>>ulFlags;
+  strm>>slFrameSize;
+  strm>>iFirstMipLevel;
+  strm>>ctFineMipLevels;
+  strm>>ulInternalFormat;
+  // mip-maps can only have been removed
+  if( slFrameSize<=0 || slFrameSize>ptd->td_slFrameSize || (slFrameSize%BYTES_PER_TEXEL)!=0) {
+    throw TRANS("Invalid texture cache entry.");
+  }
+  // read processed frames straight into the buffer they will be uploaded from
+  ULONG *pulFrames = (ULONG*)AllocMemory( slFrameSize*ptd->td_ctFrames);
+  try {
+    strm.Read_t( pulFrames, slFrameSize*ptd->td_ctFrames);
+  } catch( char *) {
+    FreeMemory(pulFrames);
+    throw;
+  }
+  return pulFrames;
+}
+
+
+/* Replace raw frames with processed ones from the cache (FALSE if not cached). */
+BOOL LoadCachedTexture( CTextureData *ptd, const CTextureCacheKey &tck)
+{
+  const CTFileName fnm = CacheFileName(tck);
+  if( !FileExists(fnm)) return FALSE;
+
+  ULONG *pulFrames;
+  ULONG ulFlags, ulInternalFormat;
+  SLONG slFrameSize;
+  INDEX iFirstMipLevel, ctFineMipLevels;
+  try {
+    pulFrames = ReadEntry_t( ptd, tck, fnm, ulFlags, slFrameSize, iFirstMipLevel, ctFineMipLevels, ulInternalFormat);
+  } catch( char *strError) {
+    // entry that cannot be used is just in the way
+    CPrintF( TRANS("Texture cache: %s (%s)\n"), strError, (const char*)(CTString&)fnm);
+    RemoveFile(fnm);
+    return FALSE;
+  }
+
+  // replace raw frames
+  FreeMemory( ptd->td_pulFrames);
+  ptd->td_pulFrames        = pulFrames;
+  ptd->td_slFrameSize      = slFrameSize;
+  ptd->td_iFirstMipLevel   = iFirstMipLevel;
+  ptd->td_ctFineMipLevels  = ctFineMipLevels;
+  ptd->td_ulInternalFormat = ulInternalFormat;
+  // static flag stays as it was asked for now
+  ptd->td_ulFlags = (ulFlags&~TEX_STATIC) | (ptd->td_ulFlags&TEX_STATIC);
+  _ctCacheHits++;
+  return TRUE;
+}
+
+
+// write entry for given key
+static void WriteEntry_t( CTextureData *ptd, const CTextureCacheKey &tck, const CTFileName &fnm) // throw char *
+{
+  CTFileStream strm;
+  strm.Create_t(fnm);
+  strm.WriteID_t("TXCH");
+  strm<<ULONG(TEXTURECACHE_VERSION);
+  strm<<ULONG(tck.tck_ullFrames>>32)   << ULONG(tck.tck_ullFrames);
+  strm<<ULONG(tck.tck_ullSettings>>32) << ULONG(tck.tck_ullSettings);
+  strm<<ptd->td_ulFlags;
+  strm<<ptd->td_slFrameSize;
+  strm<<ptd->td_iFirstMipLevel;
+  strm<<ptd->td_ctFineMipLevels;
+  strm<<ptd->td_ulInternalFormat;
+  strm.Write_t( ptd->td_pulFrames, ptd->td_slFrameSize*ptd->td_ctFrames);
+}
+
+
+/* Remember processed frames of texture in the cache. */
+void SaveCachedTexture( CTextureData *ptd, const CTextureCacheKey &tck)
+{
+  const CTFileName fnm = CacheFileName(tck);
+  try {
+    WriteEntry_t( ptd, tck, fnm);
+  } catch( char *strError) {
+    // not having it cached is no error, but don't leave half of it behind
+    CPrintF( TRANS("Texture cache: %s\n"), strError);
+    RemoveFile(fnm);
+    return;
+  }
+  _ctCacheStores++;
+}
+
+
+// load all textures in a directory, so they get to the cache
+void TextureCachePrewarm(void *pArgs)
+{
+  CTString strDir = *NEXTARGUMENT(CTString*);
+  if( !tex_bMipmapCache) {
+    CPrintF( TRANS("Texture cache is off (tex_bMipmapCache).\n"));
+    return;
+  }
+  if( strDir!="" && strDir[strlen(strDir)-1]!='\\') strDir += "\\";
+
+  CDynamicStackArray<CTFileName> afnmTextures;
+  MakeDirList( afnmTextures, CTFileName(strDir), CTString("*.tex"), DLI_RECURSIVE);
+  const INDEX ctHits   = _ctCacheHits;
+  const INDEX ctStores = _ctCacheStores;
+  INDEX ctFailed = 0;
+  const CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+
+  for( INDEX i=0; i<afnmTextures.Count(); i++) {
+    // static, so that it is processed even without a driver, but not uploaded
+    CTextureData td;
+    td.td_ulFlags |= TEX_STATIC;
+    try {
+      td.Load_t( afnmTextures[i]);
+    } catch( char *strError) {
+      CPrintF( "%s\n", strError);
+      ctFailed++;
+    }
+  }
+
+  const DOUBLE dSeconds = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+  CPrintF( TRANS("Texture cache: %d textures in %.2f s - %d already cached, %d stored, %d failed\n"),
+    afnmTextures.Count(), dSeconds, _ctCacheHits-ctHits, _ctCacheStores-ctStores, ctFailed);
+}
+
+
+// remove all entries from the cache
+void TextureCachePurge(void)
+{
+  CDynamicStackArray<CTFileName> afnmEntries;
+  MakeDirList( afnmEntries, CTFileName(CTString("Temp\\TextureCache\\")), CTString("*.tch"), 0);
+  INDEX ctRemoved = 0;
+  for( INDEX i=0; i<afnmEntries.Count(); i++) {
+    if( RemoveFile( afnmEntries[i])) ctRemoved++;
+  }
+  CPrintF( TRANS("Texture cache: %d of %d entries removed\n"), ctRemoved, afnmEntries.Count());
+}
+
@@ -0,0 +1,52 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_TEXTURECACHE_H
+#define SE_INCL_TEXTURECACHE_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+/*
+ * Disk cache of processed textures.
+ *
+ * Mip-maps of a texture are made, filtered, resized, colorized and dithered
+ * each time it is loaded. The result depends only on raw frames from the file
+ * and on a handful of settings, so it is kept in user's Temp\TextureCache\
+ * directory under a name made of hash of both, and read back instead of being
+ * processed again next time. Entries that don't match (other settings, other
+ * texture contents) simply aren't found, so the cache never has to be flushed
+ * for correctness, only to free disk space.
+ */
+
+// what an entry is stored under
+class CTextureCacheKey {
+public:
+  __uint64 tck_ullFrames;    // hash of raw frames
+  __uint64 tck_ullSettings;  // hash of texture header and settings that affect processing
+};
+
+// make key for texture that has just got its raw frames read
+void MakeTextureCacheKey( CTextureData *ptd, CTextureCacheKey &tck);
+// replace raw frames with processed ones from the cache (FALSE if not cached)
+BOOL LoadCachedTexture( CTextureData *ptd, const CTextureCacheKey &tck);
+// remember processed frames of texture in the cache
+void SaveCachedTexture( CTextureData *ptd, const CTextureCacheKey &tck);
+
+// use the cache when loading textures
+extern INDEX tex_bMipmapCache;
+
+
+#endif  /* include-once check. */
@@ -20,10 +20,14 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Math/Functions.h>
 #include <Engine/Base/Timer.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Jobs.h>
 #include <Engine/Base/Statistics_Internal.h>
 #include <Engine/Templates/DynamicArray.cpp>
 #include <Engine/Templates/Stock_CTextureData.h>
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
 
 // asm shortcuts
 #define O offset
@@ -40,6 +44,25 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #define ASMOPT 0
 #endif
 
+// state used while animating is per thread, so effects can animate as jobs
+// (asm refers to it by name, so there it stays global and effects animate serially)
+#if ASMOPT == 1
+#define EFFECT_LOCAL
+#define PARALLEL_EFFECTS 0
+#else
+#define EFFECT_LOCAL THREAD_LOCAL
+#define PARALLEL_EFFECTS 1
+#endif
+
+// kernels for water and plasma propagation
+#if !defined(USE_PORTABLE_C) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+  #define EFFECTS_SSE2 1
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define EFFECTS_NEON 1
+  #include <arm_neon.h>
+#endif
+
 __int64 mmBaseWidthShift=0;
 __int64 mmBaseWidth=0;
 __int64 mmBaseWidthMask=0;
@@ -88,18 +111,21 @@ const __int64 mm00M0  = 0x00000000FFFF0000;
 SBYTE asbMod3Sub1Table[256];
 static BOOL  bTableSet = FALSE;
 
-static CTextureData *_ptdEffect, *_ptdBase;
-static ULONG _ulBufferMask;
-static INDEX _iWantedMipLevel;
-static UBYTE *_pubDrawBuffer;
-static SWORD *_pswDrawBuffer;
+static EFFECT_LOCAL CTextureData *_ptdEffect, *_ptdBase;
+static EFFECT_LOCAL ULONG _ulBufferMask;
+static EFFECT_LOCAL INDEX _iWantedMipLevel;
+static EFFECT_LOCAL UBYTE *_pubDrawBuffer;
+static EFFECT_LOCAL SWORD *_pswDrawBuffer;
 
-PIX _pixTexWidth,    _pixTexHeight;
-PIX _pixBufferWidth, _pixBufferHeight;
+EFFECT_LOCAL PIX _pixTexWidth,    _pixTexHeight;
+EFFECT_LOCAL PIX _pixBufferWidth, _pixBufferHeight;
+
+// use vector kernels (only benchmark turns them off, for reference)
+static BOOL _bEffectKernelsSIMD = TRUE;
 
 
 // randomizer
-ULONG ulRNDSeed;
+EFFECT_LOCAL ULONG ulRNDSeed;
 
 inline void Randomize( ULONG ulSeed)
 {
@@ -1135,36 +1161,90 @@ void InitializeWater(void)
 }
 
 
+// propagate water waves for pixels [pixFirst, pixFirst+ctPixels) (no wrapping around edges)
+static void PropagateWater( SWORD *pNew, const SWORD *pOld, PIX pixFirst, PIX ctPixels, SLONG slDensity)
+{
+  const PIX pixWidth = _pixBufferWidth;
+  PIX pixOffset = pixFirst;
+  const PIX pixEnd = pixFirst+ctPixels;
+
+  if( _bEffectKernelsSIMD) {
+#if EFFECTS_SSE2
+    // eight pixels at once, in 32 bits as the scalar version
+    const __m128i mDensity = _mm_cvtsi32_si128(slDensity);
+    #define WIDEN_LO(m) _mm_srai_epi32( _mm_unpacklo_epi16( m, m), 16)
+    #define WIDEN_HI(m) _mm_srai_epi32( _mm_unpackhi_epi16( m, m), 16)
+    for( ; pixOffset+8<=pixEnd; pixOffset+=8) {
+      const __m128i mAbove = _mm_loadu_si128((const __m128i*)(pOld+pixOffset-pixWidth));
+      const __m128i mBelow = _mm_loadu_si128((const __m128i*)(pOld+pixOffset+pixWidth));
+      const __m128i mLeft  = _mm_loadu_si128((const __m128i*)(pOld+pixOffset-1));
+      const __m128i mRight = _mm_loadu_si128((const __m128i*)(pOld+pixOffset+1));
+      const __m128i mNew   = _mm_loadu_si128((const __m128i*)(pNew+pixOffset));
+      __m128i mLo = _mm_add_epi32( _mm_add_epi32( WIDEN_LO(mAbove), WIDEN_LO(mBelow)),
+                                   _mm_add_epi32( WIDEN_LO(mLeft),  WIDEN_LO(mRight)));
+      __m128i mHi = _mm_add_epi32( _mm_add_epi32( WIDEN_HI(mAbove), WIDEN_HI(mBelow)),
+                                   _mm_add_epi32( WIDEN_HI(mLeft),  WIDEN_HI(mRight)));
+      mLo = _mm_sub_epi32( _mm_srai_epi32( mLo, 1), WIDEN_LO(mNew));
+      mHi = _mm_sub_epi32( _mm_srai_epi32( mHi, 1), WIDEN_HI(mNew));
+      mLo = _mm_sub_epi32( mLo, _mm_sra_epi32( mLo, mDensity));
+      mHi = _mm_sub_epi32( mHi, _mm_sra_epi32( mHi, mDensity));
+      // truncate to 16 bits, as storing to SWORD does
+      mLo = _mm_srai_epi32( _mm_slli_epi32( mLo, 16), 16);
+      mHi = _mm_srai_epi32( _mm_slli_epi32( mHi, 16), 16);
+      _mm_storeu_si128( (__m128i*)(pNew+pixOffset), _mm_packs_epi32( mLo, mHi));
+    }
+    #undef WIDEN_LO
+    #undef WIDEN_HI
+#elif EFFECTS_NEON
+    const int32x4_t mShift = vdupq_n_s32(-slDensity);
+    for( ; pixOffset+8<=pixEnd; pixOffset+=8) {
+      const int16x8_t mAbove = vld1q_s16(pOld+pixOffset-pixWidth);
+      const int16x8_t mBelow = vld1q_s16(pOld+pixOffset+pixWidth);
+      const int16x8_t mLeft  = vld1q_s16(pOld+pixOffset-1);
+      const int16x8_t mRight = vld1q_s16(pOld+pixOffset+1);
+      const int16x8_t mNew   = vld1q_s16(pNew+pixOffset);
+      int32x4_t mLo = vaddq_s32( vaddl_s16( vget_low_s16(mAbove),  vget_low_s16(mBelow)),
+                                 vaddl_s16( vget_low_s16(mLeft),   vget_low_s16(mRight)));
+      int32x4_t mHi = vaddq_s32( vaddl_s16( vget_high_s16(mAbove), vget_high_s16(mBelow)),
+                                 vaddl_s16( vget_high_s16(mLeft),  vget_high_s16(mRight)));
+      mLo = vsubq_s32( vshrq_n_s32( mLo, 1), vmovl_s16( vget_low_s16(mNew)));
+      mHi = vsubq_s32( vshrq_n_s32( mHi, 1), vmovl_s16( vget_high_s16(mNew)));
+      mLo = vsubq_s32( mLo, vshlq_s32( mLo, mShift));
+      mHi = vsubq_s32( mHi, vshlq_s32( mHi, mShift));
+      vst1q_s16( pNew+pixOffset, vcombine_s16( vmovn_s32(mLo), vmovn_s32(mHi)));
+    }
+#endif
+  }
+
+  // the rest (or all, if no vector kernel)
+  for( ; pixOffset<pixEnd; pixOffset++) {
+    const SLONG slNew = (( (SLONG)pOld[pixOffset - pixWidth]
+                         + (SLONG)pOld[pixOffset + pixWidth]
+                         + (SLONG)pOld[pixOffset - 1]
+                         + (SLONG)pOld[pixOffset + 1]
+                        ) >> 1)
+                         - (SLONG)pNew[pixOffset];
+    pNew[pixOffset] = slNew - (slNew >> slDensity);
+  }
+}
+
+
 /*******************************
        Water Animation
 ********************************/
 static void AnimateWater( SLONG slDensity)
 {
-  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
-
 /////////////////////////////////// move water
 
   SWORD *pNew = (SWORD*)_ptdEffect->td_pubBuffer1;
   SWORD *pOld = (SWORD*)_ptdEffect->td_pubBuffer2;
 
-  PIX pixV, pixU;
+  PIX pixU;
   PIX pixOffset, iNew;
   SLONG slLineAbove, slLineBelow, slLineLeft, slLineRight;
 
   // inner rectangle (without 1 pixel top and bottom line)
-  pixOffset = _pixBufferWidth + 1;
-  for( pixV=_pixBufferHeight-2; pixV>0; pixV--) {
-    for( pixU=_pixBufferWidth; pixU>0; pixU--) {
-      iNew = (( (SLONG)pOld[pixOffset - _pixBufferWidth]
-              + (SLONG)pOld[pixOffset + _pixBufferWidth]
-              + (SLONG)pOld[pixOffset - 1]
-              + (SLONG)pOld[pixOffset + 1]
-             ) >> 1)
-              - (SLONG)pNew[pixOffset];
-      pNew[pixOffset] =  iNew - (iNew >> slDensity);
-      pixOffset++;
-    }
-  }
+  PropagateWater( pNew, pOld, _pixBufferWidth+1, (_pixBufferHeight-2)*_pixBufferWidth, slDensity);
 
   // upper horizontal border (without corners)
   slLineAbove = ((_pixBufferHeight-1)*_pixBufferWidth) + 1;
@@ -1241,8 +1321,6 @@ static void AnimateWater( SLONG slDensity)
 
   // swap buffers
   Swap( _ptdEffect->td_pubBuffer1, _ptdEffect->td_pubBuffer2);
-
-  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
 }
 
 
@@ -2576,19 +2654,80 @@ enum PlasmaType {
   ptDownTile
 };
 
+// blur plasma for pixels [pixFirst, pixFirst+ctPixels), writing them moved by given offset (no wrapping around edges)
+static void PropagatePlasma( UBYTE *pNew, const UBYTE *pOld, PIX pixFirst, PIX ctPixels, PIX pixDstOffset, SLONG slDensity)
+{
+  const PIX pixWidth = _pixBufferWidth;
+  PIX pixOffset = pixFirst;
+  const PIX pixEnd = pixFirst+ctPixels;
+
+  if( _bEffectKernelsSIMD) {
+#if EFFECTS_SSE2
+    // sixteen pixels at once, in 16 bits (sum of four fits easily)
+    const __m128i mZero = _mm_setzero_si128();
+    const __m128i mDensity = _mm_cvtsi32_si128(slDensity);
+    for( ; pixOffset+16<=pixEnd; pixOffset+=16) {
+      const __m128i mAbove = _mm_loadu_si128((const __m128i*)(pOld+pixOffset-pixWidth));
+      const __m128i mBelow = _mm_loadu_si128((const __m128i*)(pOld+pixOffset+pixWidth));
+      const __m128i mLeft  = _mm_loadu_si128((const __m128i*)(pOld+pixOffset-1));
+      const __m128i mRight = _mm_loadu_si128((const __m128i*)(pOld+pixOffset+1));
+      const __m128i mMid   = _mm_loadu_si128((const __m128i*)(pOld+pixOffset));
+      __m128i mLo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( mAbove, mZero), _mm_unpacklo_epi8( mBelow, mZero)),
+                                   _mm_add_epi16( _mm_unpacklo_epi8( mLeft,  mZero), _mm_unpacklo_epi8( mRight, mZero)));
+      __m128i mHi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( mAbove, mZero), _mm_unpackhi_epi8( mBelow, mZero)),
+                                   _mm_add_epi16( _mm_unpackhi_epi8( mLeft,  mZero), _mm_unpackhi_epi8( mRight, mZero)));
+      mLo = _mm_srli_epi16( _mm_add_epi16( _mm_srli_epi16( mLo, 2), _mm_unpacklo_epi8( mMid, mZero)), 1);
+      mHi = _mm_srli_epi16( _mm_add_epi16( _mm_srli_epi16( mHi, 2), _mm_unpackhi_epi8( mMid, mZero)), 1);
+      mLo = _mm_sub_epi16( mLo, _mm_srl_epi16( mLo, mDensity));
+      mHi = _mm_sub_epi16( mHi, _mm_srl_epi16( mHi, mDensity));
+      _mm_storeu_si128( (__m128i*)(pNew+pixOffset+pixDstOffset), _mm_packus_epi16( mLo, mHi));
+    }
+#elif EFFECTS_NEON
+    const int16x8_t mShift = vdupq_n_s16(-slDensity);
+    for( ; pixOffset+16<=pixEnd; pixOffset+=16) {
+      const uint8x16_t mAbove = vld1q_u8(pOld+pixOffset-pixWidth);
+      const uint8x16_t mBelow = vld1q_u8(pOld+pixOffset+pixWidth);
+      const uint8x16_t mLeft  = vld1q_u8(pOld+pixOffset-1);
+      const uint8x16_t mRight = vld1q_u8(pOld+pixOffset+1);
+      const uint8x16_t mMid   = vld1q_u8(pOld+pixOffset);
+      uint16x8_t mLo = vaddq_u16( vaddl_u8( vget_low_u8(mAbove),  vget_low_u8(mBelow)),
+                                  vaddl_u8( vget_low_u8(mLeft),   vget_low_u8(mRight)));
+      uint16x8_t mHi = vaddq_u16( vaddl_u8( vget_high_u8(mAbove), vget_high_u8(mBelow)),
+                                  vaddl_u8( vget_high_u8(mLeft),  vget_high_u8(mRight)));
+      mLo = vshrq_n_u16( vaddw_u8( vshrq_n_u16( mLo, 2), vget_low_u8(mMid)),  1);
+      mHi = vshrq_n_u16( vaddw_u8( vshrq_n_u16( mHi, 2), vget_high_u8(mMid)), 1);
+      mLo = vsubq_u16( mLo, vshlq_u16( mLo, mShift));
+      mHi = vsubq_u16( mHi, vshlq_u16( mHi, mShift));
+      vst1q_u8( pNew+pixOffset+pixDstOffset, vcombine_u8( vmovn_u16(mLo), vmovn_u16(mHi)));
+    }
+#endif
+  }
+
+  // the rest (or all, if no vector kernel)
+  for( ; pixOffset<pixEnd; pixOffset++) {
+    const ULONG ulNew = ((((ULONG)pOld[pixOffset - pixWidth] +
+                           (ULONG)pOld[pixOffset + pixWidth] +
+                           (ULONG)pOld[pixOffset - 1] +
+                           (ULONG)pOld[pixOffset + 1]
+                          )>>2) +
+                           (ULONG)pOld[pixOffset]
+                        )>>1;
+    pNew[pixOffset+pixDstOffset] = ulNew - (ulNew >> slDensity);
+  }
+}
+
+
 /*******************************
        Plasma Animation
 ********************************/
 static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
 {
-  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
-
 /////////////////////////////////// move plasma
 
   UBYTE *pNew = (UBYTE*)_ptdEffect->td_pubBuffer1;
   UBYTE *pOld = (UBYTE*)_ptdEffect->td_pubBuffer2;
 
-  PIX pixV, pixU;
+  PIX pixU;
   PIX pixOffset;
   SLONG slLineAbove, slLineBelow, slLineLeft, slLineRight;
   ULONG ulNew;
@@ -2598,20 +2737,7 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
   // --------------------------
   if (eType == ptNormal) {
     // inner rectangle (without 1 pixel border)
-    pixOffset = _pixBufferWidth;
-    for( pixV=1; pixV<_pixBufferHeight-1; pixV++) {
-      for( pixU=0; pixU<_pixBufferWidth; pixU++) {
-        ulNew = ((((ULONG)pOld[pixOffset - _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset + _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset - 1] +
-                   (ULONG)pOld[pixOffset + 1]
-                  )>>2) +
-                   (ULONG)pOld[pixOffset]
-                )>>1;
-        pNew[pixOffset] = ulNew - (ulNew >> slDensity);
-        pixOffset++;
-      }
-    }
+    PropagatePlasma( pNew, pOld, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, 0, slDensity);
     // upper horizontal border (without corners)
     slLineAbove = ((_pixBufferHeight-1)*_pixBufferWidth) + 1;
     slLineBelow = _pixBufferWidth + 1;
@@ -2697,20 +2823,7 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
   // --------------------------
   } else if (eType==ptUp || eType==ptUpTile) {
     // inner rectangle (without 1 pixel border)
-    pixOffset = _pixBufferWidth;
-    for( pixV=1; pixV<_pixBufferHeight-1; pixV++) {
-      for( pixU=0; pixU<_pixBufferWidth; pixU++) {
-        ulNew = ((((ULONG)pOld[pixOffset - _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset + _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset - 1] +
-                   (ULONG)pOld[pixOffset + 1]
-                  )>>2) +
-                   (ULONG)pOld[pixOffset]
-                )>>1;
-        pNew[pixOffset-_pixBufferWidth] = ulNew - (ulNew >> slDensity);
-        pixOffset++;
-      }
-    }
+    PropagatePlasma( pNew, pOld, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, -_pixBufferWidth, slDensity);
     // tile
     if (eType==ptUpTile) {
       // upper horizontal border (without corners)
@@ -2799,20 +2912,7 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
   // --------------------------
   } else if (eType==ptDown || eType==ptDownTile) {
     // inner rectangle (without 1 pixel border)
-    pixOffset = _pixBufferWidth;
-    for( pixV=1; pixV<_pixBufferHeight-1; pixV++) {
-      for( pixU=0; pixU<_pixBufferWidth; pixU++) {
-        ulNew = ((((ULONG)pOld[pixOffset - _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset + _pixBufferWidth] +
-                   (ULONG)pOld[pixOffset - 1] +
-                   (ULONG)pOld[pixOffset + 1]
-                  )>>2) +
-                   (ULONG)pOld[pixOffset]
-                )>>1;
-        pNew[pixOffset+_pixBufferWidth] = ulNew - (ulNew >> slDensity);
-        pixOffset++;
-      }
-    }
+    PropagatePlasma( pNew, pOld, _pixBufferWidth, (_pixBufferHeight-2)*_pixBufferWidth, +_pixBufferWidth, slDensity);
     // tile
     if (eType==ptDownTile) {
       // upper horizontal border (without corners)
@@ -2898,8 +2998,6 @@ static void AnimatePlasma( SLONG slDensity, PlasmaType eType)
 
   // swap buffers
   Swap( _ptdEffect->td_pubBuffer1, _ptdEffect->td_pubBuffer2);
-
-  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
 }
 
 
@@ -3386,28 +3484,65 @@ BOOL CTextureEffectGlobal::IsWater(void)
   return( _ategtTextureEffectGlobalPresets[teg_ulEffectType].tegt_Initialize == InitializeWater);
 }
 
+// effects used since animation jobs were last started
+static CStaticStackArray<CTextureEffectGlobal *> _apegSeen;
+#if PARALLEL_EFFECTS
+// tick for which animation jobs were last started
+static TIME _tmJobsStarted = -1.0f;
+#endif
+
 // default constructor
 CTextureEffectGlobal::CTextureEffectGlobal(CTextureData *ptdTexture, ULONG ulGlobalEffect)
 {
   // remember global effect's texture data for cross linking
   teg_ptdTexture = ptdTexture;
   teg_ulEffectType = ulGlobalEffect;
+  teg_tmSeen   = -1.0f;
+  teg_tmQueued = -1.0f;
   // init for animating
   _ategtTextureEffectGlobalPresets[teg_ulEffectType].tegt_Initialize();
+  teg_ulRandomSeed = ulRNDSeed;
   // make sure the texture will be updated next time when used
   teg_updTexture.Invalidate();
 }
 
+// destructor
+CTextureEffectGlobal::~CTextureEffectGlobal(void)
+{
+  FinishAnimating();
+  // forget it was used
+  for( INDEX i=0; i<_apegSeen.Count();) {
+    if( _apegSeen[i]==this) {
+      _apegSeen[i] = _apegSeen[_apegSeen.Count()-1];
+      _apegSeen.Pop();
+    } else {
+      i++;
+    }
+  }
+}
+
 // add new effect source.
 void CTextureEffectGlobal::AddEffectSource( ULONG ulEffectSourceType, PIX pixU0, PIX pixV0,
                                             PIX pixU1, PIX pixV1)
 {
+  FinishAnimating();
+  _ptdEffect       = teg_ptdTexture;
+  _pixBufferWidth  = _ptdEffect->td_pixBufferWidth;
+  _pixBufferHeight = _ptdEffect->td_pixBufferHeight;
+  ulRNDSeed = teg_ulRandomSeed;
   CTextureEffectSource* ptesNew = teg_atesEffectSources.New(1);
   ptesNew->Initialize(this, ulEffectSourceType, pixU0, pixV0, pixU1, pixV1);
+  teg_ulRandomSeed = ulRNDSeed;
 }
 
-// animate effect texture
-void CTextureEffectGlobal::Animate(void)
+// wait for eventual animation job
+void CTextureEffectGlobal::FinishAnimating(void)
+{
+  if( _pJobs!=NULL) _pJobs->Wait(teg_jcAnimating);
+}
+
+// prepare tables used by effects
+static void PrepareEffectTables(void)
 {
   // if not set yet (funny word construction:)
   if( !bTableSet) {
@@ -3415,24 +3550,79 @@ void CTextureEffectGlobal::Animate(void)
     for( INDEX i=0; i<256; i++) asbMod3Sub1Table[i]=(SBYTE)((i%3)-1);
     bTableSet = TRUE;
   }
+}
 
+// calculate next frame of effect (can be run by any thread)
+static void AnimateEffect( CTextureEffectGlobal &teg)
+{
   // setup some internal vars
-  _ptdEffect       = teg_ptdTexture;
+  _ptdEffect       = teg.teg_ptdTexture;
   _pixBufferWidth  = _ptdEffect->td_pixBufferWidth;
   _pixBufferHeight = _ptdEffect->td_pixBufferHeight;
   _ulBufferMask    = _pixBufferHeight*_pixBufferWidth -1;
+  ulRNDSeed        = teg.teg_ulRandomSeed;
 
   // remember buffer pointers
   _pubDrawBuffer=(UBYTE*)_ptdEffect->td_pubBuffer2;
   _pswDrawBuffer=(SWORD*)_ptdEffect->td_pubBuffer2;
   
   // for each effect source
-  FOREACHINDYNAMICARRAY( teg_atesEffectSources, CTextureEffectSource, itEffectSource) {
+  FOREACHINDYNAMICARRAY( teg.teg_atesEffectSources, CTextureEffectSource, itEffectSource) {
     // let it animate itself
     itEffectSource->Animate();
   }
   // use animation function for this global effect type
-  _ategtTextureEffectGlobalPresets[teg_ulEffectType].tegt_Animate();
+  _ategtTextureEffectGlobalPresets[teg.teg_ulEffectType].tegt_Animate();
+  teg.teg_ulRandomSeed = ulRNDSeed;
+}
+
+#if PARALLEL_EFFECTS
+static void AnimateEffectJob( void *pvEffect)
+{
+  AnimateEffect( *(CTextureEffectGlobal *)pvEffect);
+}
+
+// start animating effects that were used in last tick, as they will probably be used again
+static void StartEffectJobs( TIME tmNow)
+{
+  _tmJobsStarted = tmNow;
+  for( INDEX i=0; i<_apegSeen.Count(); i++) {
+    CTextureEffectGlobal *pteg = _apegSeen[i];
+    if( pteg->teg_updTexture.LastUpdateTime()==tmNow || !pteg->teg_jcAnimating.IsDone()) continue;
+    pteg->teg_tmQueued = tmNow;
+    _pJobs->Run( AnimateEffectJob, pteg, &pteg->teg_jcAnimating);
+  }
+  _apegSeen.PopAll();
+}
+#endif
+
+// animate effect texture
+void CTextureEffectGlobal::Animate(void)
+{
+  PrepareEffectTables();
+  const TIME tmNow = _pTimer->CurrentTick();
+#if PARALLEL_EFFECTS
+  extern INDEX tex_bParallelEffects;
+  const BOOL bParallel = tex_bParallelEffects && _pJobs!=NULL;
+  if( bParallel && tmNow!=_tmJobsStarted) StartEffectJobs(tmNow);
+#endif
+
+  _sfStats.StartTimer(CStatForm::STI_EFFECTRENDER);
+  // if already started for this tick, just wait for it
+  const BOOL bQueued = (teg_tmQueued==tmNow);
+  FinishAnimating();
+  teg_tmQueued = -1.0f;
+  // otherwise calculate it now
+  if( !bQueued) AnimateEffect(*this);
+  _sfStats.StopTimer(CStatForm::STI_EFFECTRENDER);
+
+#if PARALLEL_EFFECTS
+  // remember that it was used, to start it as job next tick (textures that are not used are not animated at all)
+  if( bParallel && teg_tmSeen!=tmNow) {
+    teg_tmSeen = tmNow;
+    _apegSeen.Push() = this;
+  }
+#endif
   // remember that it was calculated
   teg_updTexture.MarkUpdated();
 }
@@ -3469,3 +3659,129 @@ DOUBLE CTextureEffectGlobal::GetRenderingTime(void)
 }
 
 
+
+/////////////////////////////////////////////////////////////////////
+//                      BENCHMARK
+/////////////////////////////////////////////////////////////////////
+
+// buffer sizes to test (water buffers are always 64 pixels wide or high)
+static PIX _apixWaterSizes[][2] = { {64,64}, {64,32}, {32,64}, {64,16} };
+static PIX _apixFireSizes[][2]  = { {32,32}, {64,64}, {128,128}, {256,256}, {256,64} };
+
+static SLONG BenchmarkBufferSize( CTextureData *ptd)
+{
+  const PIX pixWidth  = ptd->td_pixBufferWidth;
+  const PIX pixHeight = ptd->td_pixBufferHeight;
+  if( ptd->td_ptegEffect->IsWater()) return pixWidth*(pixHeight+2) *sizeof(SWORD);
+  return pixWidth*pixHeight *sizeof(UBYTE);
+}
+
+// make an effect texture without base texture (can only be animated, not rendered)
+static CTextureData *MakeBenchmarkEffect( INDEX iType, PIX pixWidth, PIX pixHeight)
+{
+  CTextureData *ptd = new CTextureData;
+  ptd->td_pixBufferWidth  = pixWidth;
+  ptd->td_pixBufferHeight = pixHeight;
+  ptd->td_ptegEffect = new CTextureEffectGlobal( ptd, iType);
+  const SLONG slSize = BenchmarkBufferSize(ptd);
+  ptd->td_pubBuffer1 = (UBYTE*)AllocMemory( slSize+8);
+  ptd->td_pubBuffer2 = (UBYTE*)AllocMemory( slSize+8);
+  memset( ptd->td_pubBuffer1, 0, slSize);
+  memset( ptd->td_pubBuffer2, 0, slSize);
+
+  // same sources and randomizer for all effects of same type and size
+  CTextureEffectGlobal &teg = *ptd->td_ptegEffect;
+  teg.teg_ulRandomSeed = 0x87654321*262147;
+  if( teg.IsWater()) {
+    teg.AddEffectSource( 0, 0, 0, 0, 0);                              // raindrops
+    teg.AddEffectSource( 1, 0, 0, 0, 0);                              // big raindrops
+    teg.AddEffectSource( 4, pixWidth/2, pixHeight/2, pixWidth/2+4, pixHeight/2); // oscilator
+  } else {
+    teg.AddEffectSource( 0, pixWidth/2,   pixHeight-2, 0, 0);        // point
+    teg.AddEffectSource( 1, pixWidth/4,   pixHeight-2, 0, 0);        // random point
+    teg.AddEffectSource( 2, pixWidth*3/4, pixHeight-2, 0, 0);        // shake point
+  }
+  return ptd;
+}
+
+static BOOL SameBuffers( CTextureData *ptd0, CTextureData *ptd1)
+{
+  const SLONG slSize = BenchmarkBufferSize(ptd0);
+  return memcmp( ptd0->td_pubBuffer1, ptd1->td_pubBuffer1, slSize)==0
+      && memcmp( ptd0->td_pubBuffer2, ptd1->td_pubBuffer2, slSize)==0;
+}
+
+// time animation of all effect types at all sizes, with reference and vector kernels, serially and as jobs
+void TextureEffectBenchmark(void *pArgs)
+{
+  INDEX ctTicks = NEXTARGUMENT(INDEX);
+  ctTicks = Clamp( ctTicks, (INDEX)1, (INDEX)10000);
+  PrepareEffectTables();
+  CPrintF("Texture effect benchmark, %d ticks:\n", ctTicks);
+  CPrintF("  %-16s %-8s %12s %12s\n", "effect", "size", "reference", "vector");
+
+  CStaticStackArray<CTextureData *> aptdRef, aptdVec;
+  INDEX ctMismatches = 0;
+  for( INDEX iType=0; iType<_ctTextureEffectGlobalPresets; iType++)
+  { // skip unused presets
+    if( _ategtTextureEffectGlobalPresets[iType].tegt_strName[0]==0) continue;
+    const BOOL bWater = _ategtTextureEffectGlobalPresets[iType].tegt_Initialize==InitializeWater;
+    const INDEX ctSizes = bWater ? ARRAYCOUNT(_apixWaterSizes) : ARRAYCOUNT(_apixFireSizes);
+    for( INDEX iSize=0; iSize<ctSizes; iSize++) {
+      const PIX pixWidth  = bWater ? _apixWaterSizes[iSize][0] : _apixFireSizes[iSize][0];
+      const PIX pixHeight = bWater ? _apixWaterSizes[iSize][1] : _apixFireSizes[iSize][1];
+      CTextureData *ptdRef = MakeBenchmarkEffect( iType, pixWidth, pixHeight);
+      CTextureData *ptdVec = MakeBenchmarkEffect( iType, pixWidth, pixHeight);
+      aptdRef.Push() = ptdRef;
+      aptdVec.Push() = ptdVec;
+
+      _bEffectKernelsSIMD = FALSE;
+      CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+      for( INDEX iTick=0; iTick<ctTicks; iTick++) AnimateEffect( *ptdRef->td_ptegEffect);
+      const DOUBLE dRef = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+      _bEffectKernelsSIMD = TRUE;
+      tvStart = _pTimer->GetHighPrecisionTimer();
+      for( INDEX iTick=0; iTick<ctTicks; iTick++) AnimateEffect( *ptdVec->td_ptegEffect);
+      const DOUBLE dVec = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+
+      const BOOL bSame = SameBuffers( ptdRef, ptdVec);
+      if( !bSame) ctMismatches++;
+      CTString strSize;
+      strSize.PrintF("%dx%d", pixWidth, pixHeight);
+      CPrintF("  %-16s %-8s %9.3f ms %9.3f ms%s\n", _ategtTextureEffectGlobalPresets[iType].tegt_strName,
+        (const char *)strSize, dRef*1000.0/ctTicks, dVec*1000.0/ctTicks, bSame ? "" : "  MISMATCH");
+    }
+  }
+
+  // animate all of them at once, serially and as jobs (only where effect state is per thread)
+#if PARALLEL_EFFECTS
+  if( _pJobs!=NULL) {
+    const INDEX ctEffects = aptdVec.Count();
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    for( INDEX iTick=0; iTick<ctTicks; iTick++) {
+      for( INDEX i=0; i<ctEffects; i++) AnimateEffect( *aptdRef[i]->td_ptegEffect);
+    }
+    const DOUBLE dSerial = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    for( INDEX iTick=0; iTick<ctTicks; iTick++) {
+      CJobCounter jc;
+      for( INDEX i=0; i<ctEffects; i++) _pJobs->Run( AnimateEffectJob, aptdVec[i]->td_ptegEffect, &jc);
+      _pJobs->Wait(jc);
+    }
+    const DOUBLE dParallel = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+    for( INDEX i=0; i<ctEffects; i++) {
+      if( !SameBuffers( aptdRef[i], aptdVec[i])) ctMismatches++;
+    }
+    CPrintF("  all %d effects: %.3f ms serial, %.3f ms as jobs on %d threads (per tick)\n", ctEffects,
+      dSerial*1000.0/ctTicks, dParallel*1000.0/ctTicks, _pJobs->GetThreadCount());
+  }
+#endif
+
+  if( ctMismatches>0) {
+    CPrintF("  ERROR: %d effects differ from reference!\n", ctMismatches);
+  }
+  for( INDEX i=0; i<aptdRef.Count(); i++) {
+    delete aptdRef[i];
+    delete aptdVec[i];
+  }
+}
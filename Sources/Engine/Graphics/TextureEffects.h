@@ -23,6 +23,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicArray.h>
 #include <Engine/Base/Updateable.h>
 #include <Engine/Base/Stream.h>
+#include <Engine/Base/Jobs.h>
 
 struct TextureEffectPixel {
   char tepp_achDummy[8];
@@ -75,15 +76,23 @@ public:
   ULONG teg_ulEffectType;
   CUpdateable teg_updTexture;   // when the texture was last updated
   CDynamicArray<CTextureEffectSource> teg_atesEffectSources;
+  ULONG teg_ulRandomSeed;         // randomizer of this effect (so it animates the same on any thread)
+  TIME teg_tmSeen;                // tick in which the texture was last used
+  TIME teg_tmQueued;              // tick for which animation job was started (-1 if none)
+  CJobCounter teg_jcAnimating;    // animation job in progress
 
   // Constructor.
   CTextureEffectGlobal(CTextureData *ptdTexture, ULONG ulGlobalEffect);
+  // Destructor.
+  ~CTextureEffectGlobal(void);
 
   // Add a new effect source.
   ENGINE_API void AddEffectSource( ULONG ulEffectSourceType, PIX pixU0, PIX pixV0,
                                                              PIX pixU1, PIX pixV1);
   // animate effect texture
   void Animate(void);
+  // wait for eventual animation job (before touching effect buffers)
+  void FinishAnimating(void);
   // render effect texture in required mip level
   void Render( INDEX iWantedMipLevel, PIX pixTexWidth, PIX pixTexHeight);
 
@@ -27,6 +27,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/DynamicContainer.cpp>
 #include <Engine/Templates/DynamicArray.cpp>
 #include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/SlotMap.cpp>
 #include <Engine/Templates/BSP.h>
 #include <Engine/Terrain/Terrain.h>
 
@@ -2877,6 +2877,8 @@ specMipLoop:
 // render patches on model
 void CModelObject::RenderPatches_View( CRenderModel &rm)
 {
+  // patches are mapped thru OpenGL texture matrix
+  if( _pGfx->gl_eCurrentAPI!=GAT_OGL) return;
   _pfModelProfile.StartTimer( CModelProfile::PTI_VIEW_RENDERPATCHES);
   _pfModelProfile.IncrementTimerAveragingCounter( CModelProfile::PTI_VIEW_RENDERPATCHES);
 
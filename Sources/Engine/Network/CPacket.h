@@ -20,6 +20,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #endif
 
 #include <Engine/Base/Lists.h>
+#include <Engine/Base/Allocator.h>
 #include <Engine/Base/Timer.h>
 
 
@@ -61,7 +62,7 @@ public:
 /*
  * A class that contains a single UDP packet. 
  */
-class CPacket {
+class CPacket : public CPooledObject<MTG_NETWORK> {
 public:
 	ULONG	pa_ulSequence;		// Sequence number of this packet
 	UBYTE	pa_ubReliable;					// Is packet reliable or not
@@ -18,6 +18,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/Stream.h>
 #include <Engine/Network/Compression.h>
 #include <Engine/Base/Synchronization.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Math/Functions.h>
 #include <Engine/zlib/zlib.h>
 
 extern CTCriticalSection zip_csLock; // critical section for access to zlib functions
@@ -73,6 +77,95 @@ void CCompressor::PackStream_t(CTMemoryStream &strmSrc, CTStream &strmDst) // th
   FreeMemory(pubDst);
 }
 
+/////////////////////////////////////////////////////////////////////
+// compressor registry and tagged streams
+
+// shared instances, indexed by compressor ID
+static CRLEBBCompressor _compRLEBB;
+static CLZCompressor    _compLZRW1;
+static CzlibCompressor  _compZlib;
+static CLZ4Compressor   _compLZ4;
+static CzlibCompressor  _compZlibMax(9);
+
+/* Get shared compressor instance for given ID (NULL if unknown). */
+CCompressor *GetCompressorByID(INDEX iID)
+{
+  switch (iID) {
+  case CT_RLEBB:   return &_compRLEBB;
+  case CT_LZRW1:   return &_compLZRW1;
+  case CT_ZLIB:    return &_compZlib;
+  case CT_LZ4:     return &_compLZ4;
+  case CT_ZLIBMAX: return &_compZlibMax;
+  default:         return NULL;
+  }
+}
+
+/* Get printable name of a compressor ID. */
+const char *GetCompressorName(INDEX iID)
+{
+  switch (iID) {
+  case CT_NONE:    return "none";
+  case CT_RLEBB:   return "RLE";
+  case CT_LZRW1:   return "LZRW1";
+  case CT_ZLIB:    return "zlib";
+  case CT_LZ4:     return "LZ4";
+  case CT_ZLIBMAX: return "zlib-max";
+  default:         return "unknown";
+  }
+}
+
+/* Pack from stream to stream, writing compressor ID in the header. */
+void PackStreamTagged_t(INDEX iCompressor, CTMemoryStream &strmSrc, CTStream &strmDst) // throw char *
+{
+  CCompressor *pcomp = GetCompressorByID(iCompressor);
+  // unknown ID or empty stream is just stored
+  SLONG slSizeSrc = strmSrc.GetStreamSize()-strmSrc.mstrm_slLocation;
+  if (pcomp==NULL || slSizeSrc<=0) {
+    iCompressor = CT_NONE;
+  }
+
+  strmDst.WriteID_t("CMPT");
+  strmDst<<iCompressor;
+  if (iCompressor==CT_NONE) {
+    strmDst<<slSizeSrc;
+    strmDst<<slSizeSrc;
+    strmDst.Write_t(strmSrc.mstrm_pubBuffer + strmSrc.mstrm_slLocation, slSizeSrc);
+    return;
+  }
+  pcomp->PackStream_t(strmSrc, strmDst);
+}
+
+/* Unpack a stream written by PackStreamTagged_t(), or by PackStream_t() of the given legacy compressor. */
+void UnpackStreamTagged_t(CTMemoryStream &strmSrc, CTStream &strmDst, INDEX iLegacyCompressor) // throw char *
+{
+  // old streams start with the size, which can never look like the tag
+  INDEX iCompressor = iLegacyCompressor;
+  if (strmSrc.PeekID_t()==CChunkID("CMPT")) {
+    strmSrc.ExpectID_t("CMPT");
+    strmSrc>>iCompressor;
+  }
+
+  if (iCompressor==CT_NONE) {
+    SLONG slSizeDst, slSizeSrc;
+    strmSrc>>slSizeDst;
+    strmSrc>>slSizeSrc;
+    if (slSizeSrc!=slSizeDst || slSizeSrc>strmSrc.GetStreamSize()-strmSrc.mstrm_slLocation) {
+      ThrowF_t(TRANS("Error while unpacking a stream."));
+    }
+    strmDst.Write_t(strmSrc.mstrm_pubBuffer + strmSrc.mstrm_slLocation, slSizeSrc);
+    strmDst.SetPos_t(0);
+    // skip the stored data, as if it was read
+    strmSrc.Seek_t(slSizeSrc, CTStream::SD_CUR);
+    return;
+  }
+
+  CCompressor *pcomp = GetCompressorByID(iCompressor);
+  if (pcomp==NULL) {
+    ThrowF_t(TRANS("Unknown compressor %d in packed stream."), iCompressor);
+  }
+  pcomp->UnpackStream_t(strmSrc, strmDst);
+}
+
 /////////////////////////////////////////////////////////////////////
 // RLE compressor
 
@@ -426,9 +519,9 @@ int ZEXPORT compress (dest, destLen, source, sourceLen)
 
   CTSingleLock slZip(&zip_csLock, TRUE);
   uLongf dstlen = (uLongf) slDstSize;
-  const int iResult = compress(
+  const int iResult = compress2(
     (Bytef *)pvDst, &dstlen,
-    (const Bytef *)pvSrc, (uLong)slSrcSize);
+    (const Bytef *)pvSrc, (uLong)slSrcSize, zc_iLevel);
   slDstSize = (SLONG) dstlen;
   if (iResult==Z_OK) {
     return TRUE;
@@ -462,3 +555,266 @@ int ZEXPORT uncompress (dest, destLen, source, sourceLen)
     return FALSE;
   }
 }
+
+/////////////////////////////////////////////////////////////////////
+// LZ4 compressor
+
+/*
+LZ4 block format:
+  Packed data is a series of sequences. Each sequence starts with a token byte, whose
+  high nibble is the count of literal bytes and low nibble is the match length minus 4.
+  A nibble of 15 means that the count continues in following bytes (each 255 means more).
+  Literals follow, then a 2-byte little-endian backward offset of the match, then the
+  extra match length bytes. The last sequence holds only literals.
+  The last match must start at least 12 bytes before the end of the block and the last
+  5 bytes are always literals, so the output can be read by any LZ4 block decoder.
+*/
+
+#define LZ4_MINMATCH     4
+#define LZ4_HASHLOG      12
+#define LZ4_LASTLITERALS 5
+#define LZ4_MFLIMIT      12
+#define LZ4_MAXOFFSET    65535
+
+static inline ULONG LZ4_Read32(const UBYTE *pub)
+{
+  ULONG ul;
+  memcpy(&ul, pub, sizeof(ul));
+  return ul;
+}
+
+static inline ULONG LZ4_Hash(ULONG ulSequence)
+{
+  return (ulSequence*2654435761U)>>(32-LZ4_HASHLOG);
+}
+
+static inline UBYTE *LZ4_WriteLength(UBYTE *pub, SLONG slLength)
+{
+  while (slLength>=255) {
+    *pub++ = 255;
+    slLength -= 255;
+  }
+  *pub++ = (UBYTE)slLength;
+  return pub;
+}
+
+static SLONG lz4_compress(const UBYTE *pubSrc, SLONG slSrcSize, UBYTE *pubDst)
+{
+  const UBYTE *pubIn     = pubSrc;
+  const UBYTE *pubAnchor = pubSrc;
+  const UBYTE *pubEnd    = pubSrc+slSrcSize;
+  UBYTE *pubOut = pubDst;
+
+  // hash of last position where each 4-byte sequence was seen
+  SLONG aslHash[1<<LZ4_HASHLOG];
+  memset(aslHash, -1, sizeof(aslHash));
+
+  if (slSrcSize>LZ4_MFLIMIT) {
+    const UBYTE *pubMatchLimit = pubEnd-LZ4_MFLIMIT;
+    const UBYTE *pubExtendLimit = pubEnd-LZ4_LASTLITERALS;
+    while (pubIn<pubMatchLimit) {
+      const ULONG ulSequence = LZ4_Read32(pubIn);
+      const ULONG ulHash = LZ4_Hash(ulSequence);
+      const SLONG slRef = aslHash[ulHash];
+      const SLONG slPos = pubIn-pubSrc;
+      aslHash[ulHash] = slPos;
+      // if no match here
+      if (slRef<0 || slPos-slRef>LZ4_MAXOFFSET || LZ4_Read32(pubSrc+slRef)!=ulSequence) {
+        // this byte goes to literals
+        pubIn++;
+        continue;
+      }
+
+      // extend the match as far as possible
+      const UBYTE *pubRef = pubSrc+slRef;
+      const UBYTE *pubMatchEnd = pubIn+LZ4_MINMATCH;
+      const UBYTE *pubRefEnd   = pubRef+LZ4_MINMATCH;
+      while (pubMatchEnd<pubExtendLimit && *pubMatchEnd==*pubRefEnd) {
+        pubMatchEnd++;
+        pubRefEnd++;
+      }
+
+      // write the sequence
+      const SLONG slLiterals = pubIn-pubAnchor;
+      const SLONG slMatch = pubMatchEnd-pubIn-LZ4_MINMATCH;
+      UBYTE *pubToken = pubOut++;
+      *pubToken = (UBYTE)((Min(slLiterals, SLONG(15))<<4) | Min(slMatch, SLONG(15)));
+      if (slLiterals>=15) {
+        pubOut = LZ4_WriteLength(pubOut, slLiterals-15);
+      }
+      memcpy(pubOut, pubAnchor, slLiterals);
+      pubOut += slLiterals;
+      const SLONG slOffset = pubIn-pubRef;
+      *pubOut++ = (UBYTE)(slOffset&0xFF);
+      *pubOut++ = (UBYTE)(slOffset>>8);
+      if (slMatch>=15) {
+        pubOut = LZ4_WriteLength(pubOut, slMatch-15);
+      }
+      pubIn = pubMatchEnd;
+      pubAnchor = pubIn;
+    }
+  }
+
+  // write the last literals
+  const SLONG slLiterals = pubEnd-pubAnchor;
+  *pubOut++ = (UBYTE)(Min(slLiterals, SLONG(15))<<4);
+  if (slLiterals>=15) {
+    pubOut = LZ4_WriteLength(pubOut, slLiterals-15);
+  }
+  memcpy(pubOut, pubAnchor, slLiterals);
+  pubOut += slLiterals;
+  return pubOut-pubDst;
+}
+
+static BOOL lz4_decompress(const UBYTE *pubSrc, SLONG slSrcSize, UBYTE *pubDst, SLONG &slDstSize)
+{
+  const UBYTE *pubIn    = pubSrc;
+  const UBYTE *pubInEnd = pubSrc+slSrcSize;
+  UBYTE *pubOut    = pubDst;
+  UBYTE *pubOutEnd = pubDst+slDstSize;
+
+  while (pubIn<pubInEnd) {
+    const UBYTE ubToken = *pubIn++;
+    // copy literals
+    SLONG slLiterals = ubToken>>4;
+    if (slLiterals==15) {
+      UBYTE ub;
+      do {
+        if (pubIn>=pubInEnd) return FALSE;
+        ub = *pubIn++;
+        slLiterals += ub;
+      } while (ub==255);
+    }
+    if (slLiterals>pubInEnd-pubIn || slLiterals>pubOutEnd-pubOut) return FALSE;
+    memcpy(pubOut, pubIn, slLiterals);
+    pubIn  += slLiterals;
+    pubOut += slLiterals;
+    // last sequence has no match
+    if (pubIn>=pubInEnd) break;
+
+    // copy the match
+    if (pubInEnd-pubIn<2) return FALSE;
+    const SLONG slOffset = pubIn[0] | (pubIn[1]<<8);
+    pubIn += 2;
+    if (slOffset==0 || slOffset>pubOut-pubDst) return FALSE;
+    SLONG slMatch = ubToken&15;
+    if (slMatch==15) {
+      UBYTE ub;
+      do {
+        if (pubIn>=pubInEnd) return FALSE;
+        ub = *pubIn++;
+        slMatch += ub;
+      } while (ub==255);
+    }
+    slMatch += LZ4_MINMATCH;
+    if (slMatch>pubOutEnd-pubOut) return FALSE;
+    const UBYTE *pubRef = pubOut-slOffset;
+    if (slOffset>=slMatch) {
+      memcpy(pubOut, pubRef, slMatch);
+      pubOut += slMatch;
+    } else {
+      // overlapping match replicates a pattern
+      while (slMatch-->0) *pubOut++ = *pubRef++;
+    }
+  }
+
+  slDstSize = pubOut-pubDst;
+  return TRUE;
+}
+
+/* Calculate needed size for destination buffer when packing memory. */
+SLONG CLZ4Compressor::NeededDestinationSize(SLONG slSourceSize)
+{
+  // worst case is all literals with length continuation bytes
+  return slSourceSize + slSourceSize/255 + 16;
+}
+
+// on entry, slDstSize holds maximum size of output buffer,
+// on exit, it is filled with resulting size
+/* Pack a chunk of data using given compression. */
+BOOL CLZ4Compressor::Pack(const void *pvSrc, SLONG slSrcSize, void *pvDst, SLONG &slDstSize)
+{
+  if (slDstSize<NeededDestinationSize(slSrcSize)) {
+    return FALSE;
+  }
+  slDstSize = lz4_compress((const UBYTE *)pvSrc, slSrcSize, (UBYTE *)pvDst);
+  return TRUE;
+}
+
+// on entry, slDstSize holds maximum size of output buffer,
+// on exit, it is filled with resulting size
+/* Unpack a chunk of data using given compression. */
+BOOL CLZ4Compressor::Unpack(const void *pvSrc, SLONG slSrcSize, void *pvDst, SLONG &slDstSize)
+{
+  return lz4_decompress((const UBYTE *)pvSrc, slSrcSize, (UBYTE *)pvDst, slDstSize);
+}
+
+/////////////////////////////////////////////////////////////////////
+// benchmark
+
+// pack and unpack whole buffer in chunks of given size with given compressor
+static void BenchmarkCompressor(INDEX iID, const UBYTE *pubData, SLONG slSize, SLONG slChunk)
+{
+  CCompressor *pcomp = GetCompressorByID(iID);
+  if (pcomp==NULL) return;
+
+  SLONG slMaxPacked = pcomp->NeededDestinationSize(slChunk);
+  UBYTE *pubPacked   = (UBYTE*)AllocMemory(slMaxPacked);
+  UBYTE *pubUnpacked = (UBYTE*)AllocMemory(slChunk);
+
+  SLONG slPackedTotal = 0;
+  DOUBLE dPackTime = 0, dUnpackTime = 0;
+  BOOL bOk = TRUE;
+  for (SLONG slOffset=0; slOffset<slSize; slOffset+=slChunk) {
+    const SLONG slSrc = Min(slChunk, slSize-slOffset);
+    SLONG slPacked = slMaxPacked;
+    CTimerValue tv0 = _pTimer->GetHighPrecisionTimer();
+    bOk &= pcomp->Pack(pubData+slOffset, slSrc, pubPacked, slPacked);
+    CTimerValue tv1 = _pTimer->GetHighPrecisionTimer();
+    SLONG slUnpacked = slChunk;
+    bOk &= pcomp->Unpack(pubPacked, slPacked, pubUnpacked, slUnpacked);
+    CTimerValue tv2 = _pTimer->GetHighPrecisionTimer();
+    bOk &= slUnpacked==slSrc && memcmp(pubUnpacked, pubData+slOffset, slSrc)==0;
+    dPackTime   += (tv1-tv0).GetSeconds();
+    dUnpackTime += (tv2-tv1).GetSeconds();
+    slPackedTotal += slPacked;
+  }
+  FreeMemory(pubPacked);
+  FreeMemory(pubUnpacked);
+
+  const DOUBLE dMB = slSize/(1024.0*1024.0);
+  CPrintF("  %-9s %6.2f%%  pack %8.1f MB/s  unpack %8.1f MB/s%s\n",
+    GetCompressorName(iID), slPackedTotal*100.0/slSize,
+    dMB/Max(dPackTime, 1E-9), dMB/Max(dUnpackTime, 1E-9), bOk ? "" : "  MISMATCH!");
+}
+
+// compare all compressors on a recorded file (demo, savegame, ...)
+void CompressionBenchmark(void *pArgs)
+{
+  CTString strFile = *NEXTARGUMENT(CTString*);
+  CTMemoryStream strmData;
+  try {
+    CTFileStream strmFile;
+    strmFile.Open_t(CTFileName(strFile));
+    SLONG slSize = strmFile.GetStreamSize();
+    UBYTE *pub = (UBYTE*)AllocMemory(slSize);
+    strmFile.Read_t(pub, slSize);
+    strmData.Write_t(pub, slSize);
+    FreeMemory(pub);
+  } catch (char *strError) {
+    CPrintF("%s\n", strError);
+    return;
+  }
+  const SLONG slSize = strmData.GetStreamSize();
+  if (slSize<=0) return;
+
+  // network sized chunks model game stream messages, big ones model savegames and states
+  static const SLONG aslChunks[] = { 2048, 65536, 1024*1024 };
+  CPrintF("Compressing '%s' (%d bytes):\n", (const char*)strFile, slSize);
+  for (INDEX iChunk=0; iChunk<(INDEX)ARRAYCOUNT(aslChunks); iChunk++) {
+    CPrintF(" %d byte chunks:\n", aslChunks[iChunk]);
+    for (INDEX iID=CT_NONE+1; iID<CT_COUNT; iID++) {
+      BenchmarkCompressor(iID, strmData.mstrm_pubBuffer, slSize, aslChunks[iChunk]);
+    }
+  }
+}
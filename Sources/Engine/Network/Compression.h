@@ -19,11 +19,27 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #pragma once
 #endif
 
+// compressor IDs, as written in tagged streams and extended message headers
+// NOTE: never renumber these - they are stored in demos, savegames and on the wire
+enum CompressorType {
+  CT_NONE   = 0,  // stored, no compression
+  CT_RLEBB  = 1,  // RLE byte-byte
+  CT_LZRW1  = 2,  // LZRW1 (Ross Williams)
+  CT_ZLIB   = 3,  // zlib at default level
+  CT_LZ4    = 4,  // LZ4 block format (fast)
+  CT_ZLIBMAX= 5,  // zlib at max level (high ratio)
+  CT_COUNT,
+};
+
 /*
  * Abstract base class for objects that can compress memory blocks.
  */
 class CCompressor {
 public:
+  virtual ~CCompressor(void) {};
+  /* Get ID of this compressor (one of CompressorType values). */
+  virtual INDEX GetID(void) = 0;
+
   /* Calculate needed size for destination buffer when packing memory with given compression. */
   virtual SLONG NeededDestinationSize(SLONG slSourceSize) = 0;
 
@@ -39,11 +55,22 @@ public:
   void PackStream_t(CTMemoryStream &strmSrc, CTStream &strmDst); // throw char *
 };
 
+/* Get shared compressor instance for given ID (NULL if unknown). */
+CCompressor *GetCompressorByID(INDEX iID);
+/* Get printable name of a compressor ID. */
+const char *GetCompressorName(INDEX iID);
+
+/* Pack from stream to stream, writing compressor ID in the header so any compressor can read it back. */
+void PackStreamTagged_t(INDEX iCompressor, CTMemoryStream &strmSrc, CTStream &strmDst); // throw char *
+/* Unpack a stream written by PackStreamTagged_t(), or by PackStream_t() of the given legacy compressor. */
+void UnpackStreamTagged_t(CTMemoryStream &strmSrc, CTStream &strmDst, INDEX iLegacyCompressor); // throw char *
+
 /*
  * Compressor for compressing memory blocks using RLE BYTE-BYTE compression
  */
 class CRLEBBCompressor : public CCompressor {
 public:
+  INDEX GetID(void) { return CT_RLEBB; };
   /* Calculate needed size for destination buffer when packing memory. */
   SLONG NeededDestinationSize(SLONG slSourceSize);
 
@@ -62,6 +89,7 @@ public:
  */
 class CLZCompressor : public CCompressor {
 public:
+  INDEX GetID(void) { return CT_LZRW1; };
   /* Calculate needed size for destination buffer when packing memory. */
   SLONG NeededDestinationSize(SLONG slSourceSize);
 
@@ -79,6 +107,29 @@ public:
  */
 class CzlibCompressor : public CCompressor {
 public:
+  INDEX zc_iLevel;  // zlib compression level (Z_DEFAULT_COMPRESSION, or 1-9)
+
+  CzlibCompressor(void) { zc_iLevel = -1; };
+  CzlibCompressor(INDEX iLevel) { zc_iLevel = iLevel; };
+  INDEX GetID(void) { return zc_iLevel==9 ? CT_ZLIBMAX : CT_ZLIB; };
+  /* Calculate needed size for destination buffer when packing memory. */
+  SLONG NeededDestinationSize(SLONG slSourceSize);
+
+  // on entry, slDstSize holds maximum size of output buffer,
+  // on exit, it is filled with resulting size
+  /* Pack a chunk of data using given compression. */
+  BOOL   Pack(const void *pvSrc, SLONG slSrcSize, void *pvDst, SLONG &slDstSize);
+  /* Unpack a chunk of data using given compression. */
+  BOOL Unpack(const void *pvSrc, SLONG slSrcSize, void *pvDst, SLONG &slDstSize);
+};
+
+/*
+ * Compressor for compressing memory blocks using LZ4 block format
+ * (byte-aligned LZ77, much faster than zlib at a somewhat lower ratio)
+ */
+class CLZ4Compressor : public CCompressor {
+public:
+  INDEX GetID(void) { return CT_LZ4; };
   /* Calculate needed size for destination buffer when packing memory. */
   SLONG NeededDestinationSize(SLONG slSourceSize);
 
@@ -0,0 +1,232 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/ErrorReporting.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/Translation.h>
+#include <Engine/Base/Lists.inl>
+#include <Engine/Math/Functions.h>
+#include <Engine/Network/Compression.h>
+#include <Engine/Network/LevelChange.h>
+
+// number of temp files made so far (for unique names)
+static INDEX _ctSpilledLevels = 0;
+
+CRememberedLevel::CRememberedLevel(void)
+{
+  rl_pstrmSessionState = NULL;
+  rl_iCompressor = CT_NONE;
+  rl_slUnpackedSize = 0;
+  rl_pubPacked = NULL;
+  rl_slPackedSize = 0;
+}
+
+CRememberedLevel::~CRememberedLevel(void)
+{
+  // packing job must not outlive the level
+  if (rl_pstrmSessionState!=NULL) {
+    _pJobs->Wait(rl_jcPacking);
+    delete rl_pstrmSessionState;
+  }
+  if (rl_pubPacked!=NULL) {
+    FreeMemory(rl_pubPacked);
+  }
+  if (rl_fnmSpilled!="") {
+    RemoveFile(rl_fnmSpilled);
+  }
+}
+
+// job that packs the saved state into the prepared buffer
+static void PackRememberedLevel(void *pvLevel)
+{
+  CRememberedLevel &rl = *(CRememberedLevel *)pvLevel;
+  CCompressor *pcomp = GetCompressorByID(rl.rl_iCompressor);
+  SLONG slPacked = rl.rl_slPackedSize;
+  if (!pcomp->Pack(rl.rl_pstrmSessionState->mstrm_pubBuffer, rl.rl_slUnpackedSize, rl.rl_pubPacked, slPacked)) {
+    slPacked = -1;
+  }
+  rl.rl_slPackedSize = slPacked;
+}
+
+// keep the saved state as it is
+static void StoreUnpacked(CRememberedLevel &rl)
+{
+  rl.rl_iCompressor = CT_NONE;
+  rl.rl_slPackedSize = rl.rl_slUnpackedSize;
+  rl.rl_pubPacked = (UBYTE *)AllocMemory(Max(rl.rl_slUnpackedSize, SLONG(1)));
+  memcpy(rl.rl_pubPacked, rl.rl_pstrmSessionState->mstrm_pubBuffer, rl.rl_slUnpackedSize);
+  delete rl.rl_pstrmSessionState;
+  rl.rl_pstrmSessionState = NULL;
+}
+
+/* Start packing saved session state in the background. */
+void CRememberedLevel::StartPacking(void)
+{
+  ASSERT(rl_pstrmSessionState!=NULL && rl_pubPacked==NULL);
+  rl_slUnpackedSize = rl_pstrmSessionState->GetStreamSize();
+
+  CCompressor *pcomp = GetCompressorByID(gam_iRememberCompression);
+  if (pcomp==NULL || rl_slUnpackedSize<=0) {
+    StoreUnpacked(*this);
+    return;
+  }
+  // buffer is made here, so the job doesn't allocate
+  rl_iCompressor = pcomp->GetID();
+  rl_slPackedSize = pcomp->NeededDestinationSize(rl_slUnpackedSize);
+  rl_pubPacked = (UBYTE *)AllocMemory(rl_slPackedSize);
+  _pJobs->Run(PackRememberedLevel, this, &rl_jcPacking);
+}
+
+/* Check if packing has finished. */
+BOOL CRememberedLevel::IsPacked(void)
+{
+  return rl_pstrmSessionState==NULL || rl_jcPacking.IsDone();
+}
+
+/* Wait for packing to finish and release the unpacked state. */
+void CRememberedLevel::FinishPacking(void)
+{
+  if (rl_pstrmSessionState==NULL) {
+    return;
+  }
+  _pJobs->Wait(rl_jcPacking);
+  // if it could not be packed
+  if (rl_slPackedSize<0) {
+    // keep it as it is
+    FreeMemory(rl_pubPacked);
+    StoreUnpacked(*this);
+    return;
+  }
+  ResizeMemory((void **)&rl_pubPacked, Max(rl_slPackedSize, SLONG(1)));
+  delete rl_pstrmSessionState;
+  rl_pstrmSessionState = NULL;
+}
+
+/* Move packed state to a temp file. */
+void CRememberedLevel::Spill_t(void) // throw char *
+{
+  FinishPacking();
+  // if already spilled
+  if (rl_pubPacked==NULL) {
+    return;
+  }
+  CTString strName;
+  strName.PrintF("Temp\\RememberedLevel%03d.bin", _ctSpilledLevels++);
+  CTFileStream strmFile;
+  strmFile.Create_t(CTFileName(strName));
+  strmFile.Write_t(rl_pubPacked, rl_slPackedSize);
+  strmFile.Close();
+  rl_fnmSpilled = strName;
+  FreeMemory(rl_pubPacked);
+  rl_pubPacked = NULL;
+}
+
+// read spilled packed state into a new buffer
+static UBYTE *ReadSpilled_t(CRememberedLevel &rl) // throw char *
+{
+  CTFileStream strmFile;
+  strmFile.Open_t(rl.rl_fnmSpilled);
+  UBYTE *pub = (UBYTE *)AllocMemory(Max(rl.rl_slPackedSize, SLONG(1)));
+  try {
+    strmFile.Read_t(pub, rl.rl_slPackedSize);
+  } catch (char *) {
+    FreeMemory(pub);
+    throw;
+  }
+  return pub;
+}
+
+/* Get packed state in memory (loads it back if spilled). */
+void CRememberedLevel::Load_t(void) // throw char *
+{
+  FinishPacking();
+  if (rl_pubPacked!=NULL) {
+    return;
+  }
+  rl_pubPacked = ReadSpilled_t(*this);
+  RemoveFile(rl_fnmSpilled);
+  rl_fnmSpilled = CTString("");
+}
+
+/* Unpack saved session state into a stream. */
+void CRememberedLevel::Unpack_t(CTMemoryStream &strm) // throw char *
+{
+  Load_t();
+  if (rl_iCompressor==CT_NONE) {
+    strm.Write_t(rl_pubPacked, rl_slPackedSize);
+    strm.SetPos_t(0);
+    return;
+  }
+
+  CCompressor *pcomp = GetCompressorByID(rl_iCompressor);
+  if (pcomp==NULL) {
+    ThrowF_t(TRANS("Unknown compressor %d in packed stream."), rl_iCompressor);
+  }
+  UBYTE *pubUnpacked = (UBYTE *)AllocMemory(rl_slUnpackedSize);
+  SLONG slUnpacked = rl_slUnpackedSize;
+  if (!pcomp->Unpack(rl_pubPacked, rl_slPackedSize, pubUnpacked, slUnpacked) || slUnpacked!=rl_slUnpackedSize) {
+    FreeMemory(pubUnpacked);
+    ThrowF_t(TRANS("Error while unpacking a stream."));
+  }
+  strm.Write_t(pubUnpacked, slUnpacked);
+  FreeMemory(pubUnpacked);
+  strm.SetPos_t(0);
+}
+
+/* Write packed state to a savegame. */
+void CRememberedLevel::Write_t(CTStream &strm) // throw char *
+{
+  FinishPacking();
+  strm.WriteID_t("RLVL");
+  strm<<rl_strFileName;
+  strm<<rl_iCompressor;
+  strm<<rl_slUnpackedSize;
+  strm<<rl_slPackedSize;
+  // it is written as it is, without packing again
+  if (rl_pubPacked!=NULL) {
+    strm.Write_t(rl_pubPacked, rl_slPackedSize);
+  // if spilled
+  } else {
+    // copy from the temp file, without keeping it in memory
+    UBYTE *pub = ReadSpilled_t(*this);
+    try {
+      strm.Write_t(pub, rl_slPackedSize);
+    } catch (char *) {
+      FreeMemory(pub);
+      throw;
+    }
+    FreeMemory(pub);
+  }
+}
+
+/* Read packed state from a savegame. */
+void CRememberedLevel::Read_t(CTStream &strm) // throw char *
+{
+  ASSERT(rl_pstrmSessionState==NULL && rl_pubPacked==NULL);
+  strm.ExpectID_t("RLVL");
+  strm>>rl_strFileName;
+  strm>>rl_iCompressor;
+  strm>>rl_slUnpackedSize;
+  strm>>rl_slPackedSize;
+  if (rl_slUnpackedSize<=0 || rl_slPackedSize<=0
+    || (rl_iCompressor!=CT_NONE && GetCompressorByID(rl_iCompressor)==NULL)) {
+    ThrowF_t(TRANS("Invalid remembered level '%s'."), (const char *)rl_strFileName);
+  }
+  rl_pubPacked = (UBYTE *)AllocMemory(rl_slPackedSize);
+  strm.Read_t(rl_pubPacked, rl_slPackedSize);
+}
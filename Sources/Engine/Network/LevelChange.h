@@ -34,13 +34,54 @@ enum LevelChangePhase {
 
 extern LevelChangePhase _lphCurrent;
 
+#include <Engine/Base/Jobs.h>
+
+/*
+ * Saved state of a level that players left and may come back to.
+ *
+ * The state is written to a memory stream and packed by a job in the background.
+ * Once packed, it is kept in memory until the remembered levels take more than
+ * gam_iRememberedLevelsMaxKB, when the oldest ones are spilled to temp files.
+ * It is unpacked only when the level is restored.
+ */
 class CRememberedLevel {
 public:
   CListNode rl_lnInSessionState;      // for linking in list of all remembered levels
   CTString rl_strFileName;            // file name of the level
-  CTMemoryStream rl_strmSessionState; // saved session state
+  CTMemoryStream *rl_pstrmSessionState; // saved session state (only until packed)
+  INDEX rl_iCompressor;               // compressor used for packed state
+  SLONG rl_slUnpackedSize;            // size of saved session state
+  UBYTE *rl_pubPacked;                // packed state (being filled while packing, NULL if spilled)
+  SLONG rl_slPackedSize;              // size of packed state
+  CTFileName rl_fnmSpilled;           // temp file holding packed state (if spilled)
+  CJobCounter rl_jcPacking;           // for waiting on the packing job
+
+  CRememberedLevel(void);
+  ~CRememberedLevel(void);
+
+  /* Start packing saved session state in the background. */
+  void StartPacking(void);
+  /* Wait for packing to finish and release the unpacked state. */
+  void FinishPacking(void);
+  /* Check if packing has finished. */
+  BOOL IsPacked(void);
+  /* Move packed state to a temp file. */
+  void Spill_t(void); // throw char *
+  /* Get packed state in memory (loads it back if spilled). */
+  void Load_t(void); // throw char *
+  /* Unpack saved session state into a stream. */
+  void Unpack_t(CTMemoryStream &strm); // throw char *
+
+  /* Read/write packed state from/to a savegame. */
+  void Read_t(CTStream &strm); // throw char *
+  void Write_t(CTStream &strm); // throw char *
 };
 
+// compressor used for remembered levels
+extern INDEX gam_iRememberCompression;
+// memory for remembered levels, in KB, before the oldest are spilled to disk (0 for unlimited)
+extern INDEX gam_iRememberedLevelsMaxKB;
+
 
 #endif  /* include-once check. */
 
@@ -29,6 +29,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Entities/InternalClasses.h>
 #include <Engine/Entities/Precaching.h>
 #include <Engine/Network/CommunicationInterface.h>
+#include <Engine/Network/Compression.h>
 #include <Engine/Templates/Stock_CModelData.h>
 #include <Engine/Templates/Stock_CAnimData.h>
 #include <Engine/Templates/Stock_CTextureData.h>
@@ -47,6 +48,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Rendering/RenderProfile.h>
 #include <Engine/Network/NetworkProfile.h>
+#include <Engine/Base/Jobs.h>
 #include <Engine/Network/LevelChange.h>
 #include <Engine/Brushes/BrushArchive.h>
 #include <Engine/Entities/Entity.h>
@@ -135,6 +137,11 @@ INDEX cli_iMaxBPS = 4000;
 INDEX cli_iMinBPS = 0;
 
 INDEX net_iCompression = 1;
+INDEX ser_iStateCompression = CT_ZLIB;  // compressor for connection state deltas
+INDEX dem_iCompression = CT_NONE;       // compressor for session state in recorded demos
+INDEX gam_iSaveCompression = CT_NONE;   // compressor for session state in saved games
+INDEX gam_iRememberCompression = CT_ZLIB;   // compressor for remembered levels
+INDEX gam_iRememberedLevelsMaxKB = 32768;  // memory for remembered levels before spilling to disk
 INDEX net_bLookupHostNames = FALSE;
 INDEX net_bReportPackets = FALSE;
 INDEX net_iMaxSendRetries = 10;
@@ -281,6 +288,22 @@ extern BOOL MatchesBanMask(const CTString &strString, const CTString &strMask)
 }
 
 extern CTString RemoveSubstring(const CTString &strFull, const CTString &strSub);
+extern void CompressionBenchmark(void *pArgs);
+extern void LoadBenchmark(void *pArgs);
+extern void ClassCheckBenchmark(void *pArgs);
+extern void QueryLoadTest(void *pArgs);
+extern void ContainerBenchmark(void *pArgs);
+extern void RelationBenchmark(void *pArgs);
+extern void PredictorBenchmark(void *pArgs);
+extern void ParticleBenchmark(void *pArgs);
+extern void RenderBenchmark(void *pArgs);
+extern void ASERBenchmark(void *pArgs);
+extern void TextureEffectBenchmark(void *pArgs);
+extern void BitmapBenchmark(void *pArgs);
+extern void JobStressTest(void *pArgs);
+extern void JobBenchmark(void *pArgs);
+extern void JobStats(void);
+extern void RememberedLevelsInfo(void);
 
 static void AddIPMask(void* pArgs)
 {
@@ -737,6 +760,23 @@ void CNetworkLibrary::Init(const CTString &strGameID)
   _pShell->DeclareSymbol("user void StartDemoRecording(void);", (void *)&StartDemoRecording);
   _pShell->DeclareSymbol("user void StopDemoRecording(void);",  (void *)&StopDemoRecording);
   _pShell->DeclareSymbol("user void NetworkInfo(void);",  (void *)&NetworkInfo);
+  _pShell->DeclareSymbol("user void CompressionBenchmark(CTString);", (void *)&CompressionBenchmark);
+  _pShell->DeclareSymbol("user void LoadBenchmark(CTString, INDEX);", (void *)&LoadBenchmark);
+  _pShell->DeclareSymbol("user void ClassCheckBenchmark(INDEX);", (void *)&ClassCheckBenchmark);
+  _pShell->DeclareSymbol("user void QueryLoadTest(CTString, INDEX, INDEX);", (void *)&QueryLoadTest);
+  _pShell->DeclareSymbol("user void ContainerBenchmark(INDEX);", (void *)&ContainerBenchmark);
+  _pShell->DeclareSymbol("user void RelationBenchmark(INDEX);", (void *)&RelationBenchmark);
+  _pShell->DeclareSymbol("user void PredictorBenchmark(INDEX);", (void *)&PredictorBenchmark);
+  _pShell->DeclareSymbol("user void ParticleBenchmark(INDEX);", (void *)&ParticleBenchmark);
+  _pShell->DeclareSymbol("user void RenderBenchmark(INDEX);", (void *)&RenderBenchmark);
+  _pShell->DeclareSymbol("user void ASERBenchmark(INDEX);", (void *)&ASERBenchmark);
+  _pShell->DeclareSymbol("user void TextureEffectBenchmark(INDEX);", (void *)&TextureEffectBenchmark);
+  _pShell->DeclareSymbol("user void BitmapBenchmark(INDEX);", (void *)&BitmapBenchmark);
+  _pShell->DeclareSymbol("user void MemoryStats(void);",  (void *)&MemoryStats);
+  _pShell->DeclareSymbol("user void JobStressTest(INDEX);", (void *)&JobStressTest);
+  _pShell->DeclareSymbol("user void JobBenchmark(INDEX);", (void *)&JobBenchmark);
+  _pShell->DeclareSymbol("user void JobStats(void);",  (void *)&JobStats);
+  _pShell->DeclareSymbol("user void RememberedLevelsInfo(void);",  (void *)&RememberedLevelsInfo);
   _pShell->DeclareSymbol("user void StockInfo(void);",    (void *)&StockInfo);
   _pShell->DeclareSymbol("user void StockDump(void);",    (void *)&StockDump);
   _pShell->DeclareSymbol("user void RendererInfo(void);", (void *)&RendererInfo);
@@ -804,6 +844,11 @@ void CNetworkLibrary::Init(const CTString &strGameID)
   _pShell->DeclareSymbol("persistent user INDEX ser_iExtensiveSyncCheck;", (void *)&ser_iExtensiveSyncCheck);
   _pShell->DeclareSymbol("persistent user INDEX net_bLookupHostNames;",    (void *)&net_bLookupHostNames);
   _pShell->DeclareSymbol("persistent user INDEX net_iCompression ;",       (void *)&net_iCompression);
+  _pShell->DeclareSymbol("persistent user INDEX ser_iStateCompression;",   (void *)&ser_iStateCompression);
+  _pShell->DeclareSymbol("persistent user INDEX dem_iCompression;",        (void *)&dem_iCompression);
+  _pShell->DeclareSymbol("persistent user INDEX gam_iSaveCompression;",    (void *)&gam_iSaveCompression);
+  _pShell->DeclareSymbol("persistent user INDEX gam_iRememberCompression;", (void *)&gam_iRememberCompression);
+  _pShell->DeclareSymbol("persistent user INDEX gam_iRememberedLevelsMaxKB;", (void *)&gam_iRememberedLevelsMaxKB);
   _pShell->DeclareSymbol("persistent user INDEX net_bReportPackets;", (void *)&net_bReportPackets);
   _pShell->DeclareSymbol("persistent user INDEX net_iMaxSendRetries;", (void *)&net_iMaxSendRetries);
   _pShell->DeclareSymbol("persistent user FLOAT net_fSendRetryWait;", (void *)&net_fSendRetryWait);
@@ -893,6 +938,7 @@ void CNetworkLibrary::Init(const CTString &strGameID)
   _pShell->DeclareSymbol("persistent user CTString ga_strServer;", (void *)&ga_strServer);
   _pShell->DeclareSymbol("persistent user CTString ga_strMSLegacy;", (void *)&ga_strMSLegacy);
   _pShell->DeclareSymbol("persistent user INDEX ga_bMSLegacy;", (void *)&ga_bMSLegacy);
+  _pShell->DeclareSymbol("persistent user INDEX ga_iQueryRateLimit;", (void *)&ga_iQueryRateLimit);
 
 }
 
@@ -1091,6 +1137,53 @@ void CNetworkLibrary::StartPeerToPeer_t(const CTString &strSessionName,
   CPrintF( TRANS("  started.\n"));
 }
 
+// write session state to a stream, packed with given compressor (if any)
+static void WriteSessionState_t(CTStream &strm, INDEX iCompressor) // throw char *
+{
+  if (iCompressor==CT_NONE || GetCompressorByID(iCompressor)==NULL) {
+    _pNetwork->ga_sesSessionState.Write_t(&strm);
+    return;
+  }
+  CTMemoryStream strmState;
+  _pNetwork->ga_sesSessionState.Write_t(&strmState);
+  strmState.SetPos_t(0);
+  CTMemoryStream strmPacked;
+  PackStreamTagged_t(iCompressor, strmState, strmPacked);
+  SLONG slPackedSize = strmPacked.GetStreamSize();
+  strm.WriteID_t("SCMP");
+  strm<<slPackedSize;
+  strm.Write_t(strmPacked.mstrm_pubBuffer, slPackedSize);
+}
+
+// read session state from a stream, packed or not
+static void ReadSessionState_t(CTStream &strm) // throw char *
+{
+  if (strm.PeekID_t()!=CChunkID("SCMP")) {
+    _pNetwork->ga_sesSessionState.Read_t(&strm);
+    return;
+  }
+  strm.ExpectID_t("SCMP");
+  SLONG slPackedSize;
+  strm>>slPackedSize;
+  if (slPackedSize<=0) {
+    throw TRANS("Invalid packed session state!");
+  }
+  CTMemoryStream strmPacked;
+  UBYTE *pubPacked = (UBYTE*)AllocMemory(slPackedSize);
+  try {
+    strm.Read_t(pubPacked, slPackedSize);
+  } catch(char *) {
+    FreeMemory(pubPacked);
+    throw;
+  }
+  strmPacked.Write_t(pubPacked, slPackedSize);
+  FreeMemory(pubPacked);
+  strmPacked.SetPos_t(0);
+  CTMemoryStream strmState;
+  UnpackStreamTagged_t(strmPacked, strmState, CT_NONE);
+  _pNetwork->ga_sesSessionState.Read_t(&strmState);
+}
+
 /*
  * Save the game.
  */
@@ -1110,7 +1203,11 @@ void CNetworkLibrary::Save_t(const CTFileName &fnmGame) // throw char *
 
   // write game to stream
   strmFile.WriteID_t("GAME");
-  ga_sesSessionState.Write_t(&strmFile);
+  WriteSessionState_t(strmFile, gam_iSaveCompression);
+  // levels to come back to (only if there are any, so other saves stay readable by older versions)
+  if (ga_sesSessionState.ses_lhRememberedLevels.Count()>0) {
+    ga_sesSessionState.WriteRememberedLevels_t(&strmFile);
+  }
   strmFile.WriteID_t("GEND");   // game end
 }
 
@@ -1157,7 +1254,11 @@ void CNetworkLibrary::Load_t(const CTFileName &fnmGame) // throw char *
   // read session state
   try {
     ga_sesSessionState.Start_t(-1);
-    ga_sesSessionState.Read_t(&strmFile);
+    ReadSessionState_t(strmFile);
+    // read eventual levels to come back to
+    if (strmFile.PeekID_t()==CChunkID("RLEV")) {
+      ga_sesSessionState.ReadRememberedLevels_t(&strmFile);
+    }
     // if starting in network
     if (_cmiComm.IsNetworkEnabled()) {
       // make default state data for creating deltas
@@ -1330,7 +1431,7 @@ void CNetworkLibrary::StartDemoPlay_t(const CTFileName &fnDemo)  // throw char *
     } else {
       ga_ulDemoMinorVersion = 2;
     }
-    ga_sesSessionState.Read_t(&ga_strmDemoPlay);
+    ReadSessionState_t(ga_strmDemoPlay);
   } catch(char *) {
     RemoveTimerHandler();
     ga_strmDemoPlay.Close();
@@ -1776,7 +1877,7 @@ void CNetworkLibrary::StartDemoRec_t(const CTFileName &fnDemo) // throw char *
   ga_strmDemoRec.WriteID_t("DEMO");
   ga_strmDemoRec.WriteID_t("MVER");
   ga_strmDemoRec<<ULONG(_SE_BUILD_MINOR);
-  ga_sesSessionState.Write_t(&ga_strmDemoRec);
+  WriteSessionState_t(ga_strmDemoRec, dem_iCompression);
 
   // remember that recording demo
   ga_bDemoRec = TRUE;
@@ -1858,6 +1959,9 @@ void CNetworkLibrary::MainLoop(void)
     }
   }
 
+  _pJobs->UpdateProfile();
+
+  ProfileTraceFrame();
   _sfStats.StartTimer(CStatForm::STI_MAINLOOP);
   _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_MAINLOOP);
 
@@ -28,6 +28,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 #include <Engine/Base/ListIterator.inl>
 
+#include <Engine/Templates/StaticArray.cpp>
+
 static struct ErrorCode ErrorCodes[] = {
 // message types
   ERRORCODE(MSG_REQ_ENUMSERVERS, "MSG_REQ_ENUMSERVERS"),
@@ -61,7 +63,7 @@ CNetworkMessage::CNetworkMessage(void)
 {
   // allocate message buffer
   nm_slMaxSize = MAX_NETWORKMESSAGE_SIZE;
-  nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+  nm_pubMessage = (UBYTE*) AllocMemoryPooled(nm_slMaxSize, MTG_NETWORK);
 
   // mangle pointer and size so that it could not be accidentally read/written
   nm_pubPointer = NULL;
@@ -89,7 +91,7 @@ CNetworkMessage::CNetworkMessage(MESSAGETYPE mtType)
 {
   // allocate message buffer
   nm_slMaxSize = MAX_NETWORKMESSAGE_SIZE;
-  nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+  nm_pubMessage = (UBYTE*) AllocMemoryPooled(nm_slMaxSize, MTG_NETWORK);
 
   // init read/write pointer and size
   nm_pubPointer = nm_pubMessage;
@@ -107,7 +109,7 @@ CNetworkMessage::CNetworkMessage(const CNetworkMessage &nmOriginal)
 {
   // allocate message buffer
   nm_slMaxSize = nmOriginal.nm_slMaxSize;
-  nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+  nm_pubMessage = (UBYTE*) AllocMemoryPooled(nm_slMaxSize, MTG_NETWORK);
 
   // init read/write pointer and size
   nm_pubPointer = nm_pubMessage + (nmOriginal.nm_pubPointer-nmOriginal.nm_pubMessage);
@@ -130,7 +132,7 @@ void CNetworkMessage::operator=(const CNetworkMessage &nmOriginal)
 
     // allocate message buffer
     nm_slMaxSize = nmOriginal.nm_slMaxSize;
-    nm_pubMessage = (UBYTE*) AllocMemory(nm_slMaxSize);
+    nm_pubMessage = (UBYTE*) AllocMemoryPooled(nm_slMaxSize, MTG_NETWORK);
   }
 
   // init read/write pointer and size
@@ -333,10 +335,29 @@ void CNetworkMessage::Unpack(CNetworkMessage &nmUnpacked, CCompressor &comp)
 // NOTE:
 // compression type bits in the messages are different than compression type cvar values
 // this is to keep backward compatibility with old demos saved with full compression
+// type bits 3 mean that the compressor ID (see CompressorType) follows the message type
 void CNetworkMessage::PackDefault(CNetworkMessage &nmPacked)
 {
   extern INDEX net_iCompression;
-  if (net_iCompression==2) {
+  BOOL bPackedLZ4 = FALSE;
+  if (net_iCompression==3) {
+    // pack with LZ4, compressor ID is written in first byte after message type
+    CLZ4Compressor compLZ4;
+    SLONG slUnpackedSize = nm_slSize-sizeof(UBYTE);
+    void *pvUnpacked     = nm_pubMessage+sizeof(UBYTE);
+    SLONG slPackedSize   = nmPacked.nm_slMaxSize-2*sizeof(UBYTE);
+    void *pvPacked       = nmPacked.nm_pubMessage+2*sizeof(UBYTE);
+    bPackedLZ4 = compLZ4.Pack(pvUnpacked, slUnpackedSize, pvPacked, slPackedSize);
+    // if it doesn't fit, it is sent unpacked below
+    if (bPackedLZ4) {
+      nmPacked.nm_pubMessage[1] = (UBYTE)compLZ4.GetID();
+      nmPacked.nm_slSize = slPackedSize+2*sizeof(UBYTE);
+      (int&)nmPacked.nm_mtType|=3<<6;
+    }
+  }
+  if (bPackedLZ4) {
+    NOTHING;
+  } else if (net_iCompression==2) {
     // pack with zlib only
     CzlibCompressor compzlib;
     Pack(nmPacked, compzlib);
@@ -369,6 +390,18 @@ void CNetworkMessage::PackDefault(CNetworkMessage &nmPacked)
 void CNetworkMessage::UnpackDefault(CNetworkMessage &nmUnpacked)
 {
   switch (nm_mtType>>6) {
+  case 3: {
+    // unpack with compressor whose ID is in first byte after message type
+    CCompressor *pcomp = GetCompressorByID(nm_pubMessage[1]);
+    SLONG slPackedSize   = nm_slSize-2*sizeof(UBYTE);
+    void *pvPacked       = nm_pubMessage+2*sizeof(UBYTE);
+    SLONG slUnpackedSize = nmUnpacked.nm_slMaxSize-sizeof(UBYTE);
+    void *pvUnpacked     = nmUnpacked.nm_pubMessage+sizeof(UBYTE);
+    BOOL bSucceeded = pcomp!=NULL && slPackedSize>=0
+      && pcomp->Unpack(pvPacked, slPackedSize, pvUnpacked, slUnpackedSize);
+    ASSERT(bSucceeded);
+    nmUnpacked.nm_slSize = bSucceeded ? slUnpackedSize+sizeof(UBYTE) : sizeof(UBYTE);
+          } break;
   case 0: {
     // unpack with zlib only
     CzlibCompressor compzlib;
@@ -516,6 +549,8 @@ void CNetworkMessage::WriteBits(const void *pvBuffer, INDEX ctBits)
 CNetworkStreamBlock::CNetworkStreamBlock(void)
   : CNetworkMessage()
   , nsb_iSequenceNumber(-1)
+  , nsb_slPackedSize(-1)
+  , nsb_iPackedCompression(-1)
 {
 }
 
@@ -525,6 +560,8 @@ CNetworkStreamBlock::CNetworkStreamBlock(void)
 CNetworkStreamBlock::CNetworkStreamBlock(MESSAGETYPE mtType, INDEX iSequenceNumber)
   : CNetworkMessage(mtType)
   , nsb_iSequenceNumber(iSequenceNumber)
+  , nsb_slPackedSize(-1)
+  , nsb_iPackedCompression(-1)
 {
 }
 
@@ -538,6 +575,7 @@ void CNetworkStreamBlock::ReadFromMessage(CNetworkMessage &nmToRead)
   ASSERT(nsb_iSequenceNumber>=0);
   // read the block as a submessage
   nmToRead.ExtractSubMessage(*this);
+  nsb_slPackedSize = -1;
 }
 
 /*
@@ -553,10 +591,21 @@ void CNetworkStreamBlock::WriteToMessage(CNetworkMessage &nmToWrite)
 }
 
 /*
- * Remove the block from stream. */
-void CNetworkStreamBlock::RemoveFromStream(void)
+ * Get size of a game stream message holding only this block, packed (measured once).
+ */
+SLONG CNetworkStreamBlock::GetPackedSize(void)
 {
-  nsb_lnInStream.Remove();
+  // blocks don't change once written, so only remeasure if compression was changed
+  extern INDEX net_iCompression;
+  if (nsb_slPackedSize<0 || nsb_iPackedCompression!=net_iCompression) {
+    CNetworkMessage nmBlock(MSG_GAMESTREAMBLOCKS);
+    WriteToMessage(nmBlock);
+    CNetworkMessage nmPacked(MSG_GAMESTREAMBLOCKS);
+    nmBlock.PackDefault(nmPacked);
+    nsb_slPackedSize = nmPacked.nm_slSize;
+    nsb_iPackedCompression = net_iCompression;
+  }
+  return nsb_slPackedSize;
 }
 
 /* Read/write the block from file stream. */
@@ -577,6 +626,7 @@ void CNetworkStreamBlock::Read_t(CTStream &strm) // throw char *
   strm>>nm_slSize;
   // read block contents
   strm.Read_t(nm_pubMessage, nm_slSize);
+  nsb_slPackedSize = -1;
   // init the message read/write pointer
   nm_pubPointer = nm_pubMessage;
   nm_iBit = 0;
@@ -588,11 +638,19 @@ void CNetworkStreamBlock::Read_t(CTStream &strm) // throw char *
 
 /////////////////////////////////////////////////////////////////////
 // CNetworkStream
+
+// ring starts at this size and is never grown beyond the max
+#define NETSTREAM_MINRING 64
+#define NETSTREAM_MAXRING (1L<<18)
+
 /*
  * Constructor.
  */
 CNetworkStream::CNetworkStream(void)
 {
+  ns_iFirstSequence = 0;
+  ns_iLastSequence = -1;
+  ns_ctBlocks = 0;
 }
 
 /*
@@ -600,8 +658,6 @@ CNetworkStream::CNetworkStream(void)
  */
 CNetworkStream::~CNetworkStream(void)
 {
-  // report number of blocks left in stream
-  //_RPT1(_CRT_WARN, "Destructing stream, %d blocks contained.\n", ns_lhBlocks.Count());
   // remove all blocks
   Clear();
 }
@@ -611,38 +667,53 @@ CNetworkStream::~CNetworkStream(void)
  */
 void CNetworkStream::Clear(void)
 {
-  // for each block in list
-  FORDELETELIST(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsbInList) {
-    // remove it from list
-    itnsbInList->nsb_lnInStream.Remove();
-    // delete it
-    delete &*itnsbInList;
+  // for each block in ring
+  if (ns_ctBlocks>0) {
+    for (INDEX iSequence=ns_iFirstSequence; iSequence<=ns_iLastSequence; iSequence++) {
+      CNetworkStreamBlock *&pnsb = Slot(iSequence);
+      // delete it
+      delete pnsb;
+      pnsb = NULL;
+    }
   }
+  ns_iFirstSequence = 0;
+  ns_iLastSequence = -1;
+  ns_ctBlocks = 0;
 }
 /* Copy from another network stream. */
 void CNetworkStream::Copy(CNetworkStream &nsOther)
 {
-  // for each block in list
-  FOREACHINLIST(CNetworkStreamBlock, nsb_lnInStream, nsOther.ns_lhBlocks, itnsb) {
-    // add it here
-    AddBlock(*itnsb);
+  // for each block in ring
+  if (nsOther.ns_ctBlocks>0) {
+    for (INDEX iSequence=nsOther.ns_iFirstSequence; iSequence<=nsOther.ns_iLastSequence; iSequence++) {
+      CNetworkStreamBlock *pnsb = nsOther.Slot(iSequence);
+      // add it here
+      if (pnsb!=NULL) {
+        AddBlock(*pnsb);
+      }
+    }
   }
 }
 
 // get number of blocks used by this object
 INDEX CNetworkStream::GetUsedBlocks(void)
 {
-  return ns_lhBlocks.Count();
+  return ns_ctBlocks;
 }
 
 // get amount of memory used by this object
 SLONG CNetworkStream::GetUsedMemory(void)
 {
-  SLONG slMem = 0;
-  // for each block in list
-  FOREACHINLIST(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsb) {
-    // add its usage
-    slMem+=sizeof(CNetworkStreamBlock)+itnsb->nm_slMaxSize;
+  SLONG slMem = ns_apnsbBlocks.Count()*sizeof(CNetworkStreamBlock *);
+  // for each block in ring
+  if (ns_ctBlocks>0) {
+    for (INDEX iSequence=ns_iFirstSequence; iSequence<=ns_iLastSequence; iSequence++) {
+      CNetworkStreamBlock *pnsb = Slot(iSequence);
+      // add its usage
+      if (pnsb!=NULL) {
+        slMem+=sizeof(CNetworkStreamBlock)+pnsb->nm_slMaxSize;
+      }
+    }
   }
   return slMem;
 }
@@ -651,14 +722,60 @@ SLONG CNetworkStream::GetUsedMemory(void)
 INDEX CNetworkStream::GetNewestSequence(void)
 {
   // if the stream is empty
-  if (ns_lhBlocks.IsEmpty()) {
+  if (ns_ctBlocks==0) {
     // return dummy
     return -1;
   }
-  // get head of list
-  CNetworkStreamBlock *pnsb = LIST_HEAD(ns_lhBlocks, CNetworkStreamBlock, nsb_lnInStream);
-  // return its index
-  return pnsb->nsb_iSequenceNumber;
+  return ns_iLastSequence;
+}
+
+/*
+ * Resize the ring to hold given span of sequences.
+ */
+void CNetworkStream::GrowRing(INDEX ctSpan)
+{
+  INDEX ctSlots = Max(ns_apnsbBlocks.Count(), (INDEX)NETSTREAM_MINRING);
+  while (ctSlots<ctSpan) {
+    ctSlots*=2;
+  }
+  if (ctSlots==ns_apnsbBlocks.Count()) {
+    return;
+  }
+  // move stored blocks to their slots in new ring
+  CStaticArray<CNetworkStreamBlock *> apnsbNew;
+  apnsbNew.New(ctSlots);
+  memset(&apnsbNew[0], 0, ctSlots*sizeof(CNetworkStreamBlock *));
+  if (ns_ctBlocks>0) {
+    for (INDEX iSequence=ns_iFirstSequence; iSequence<=ns_iLastSequence; iSequence++) {
+      apnsbNew[iSequence&(ctSlots-1)] = Slot(iSequence);
+    }
+  }
+  ns_apnsbBlocks.MoveArray(apnsbNew);
+}
+
+/*
+ * Remove block in given slot and update the stored range.
+ */
+void CNetworkStream::RemoveSlot(INDEX iSequenceNumber)
+{
+  ASSERT(IsInRing(iSequenceNumber) && Slot(iSequenceNumber)!=NULL);
+  CNetworkStreamBlock *&pnsb = Slot(iSequenceNumber);
+  delete pnsb;
+  pnsb = NULL;
+  ns_ctBlocks--;
+  // if no more blocks
+  if (ns_ctBlocks==0) {
+    ns_iFirstSequence = 0;
+    ns_iLastSequence = -1;
+    return;
+  }
+  // keep both ends of the range on stored blocks
+  while (Slot(ns_iFirstSequence)==NULL) {
+    ns_iFirstSequence++;
+  }
+  while (Slot(ns_iLastSequence)==NULL) {
+    ns_iLastSequence--;
+  }
 }
 
 /*
@@ -666,22 +783,48 @@ INDEX CNetworkStream::GetNewestSequence(void)
  */
 void CNetworkStream::AddAllocatedBlock(CNetworkStreamBlock *pnsbBlock)
 {
-  // search all blocks already in list
-  FOREACHINLISTKEEP(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsbInList) {
-    // if the block in list has same sequence as the one to add
-    if (itnsbInList->nsb_iSequenceNumber == pnsbBlock->nsb_iSequenceNumber) {
-      // just discard the new block
+  const INDEX iSequence = pnsbBlock->nsb_iSequenceNumber;
+  ASSERT(iSequence>=0);
+
+  // if the stream is empty
+  if (ns_ctBlocks==0) {
+    GrowRing(NETSTREAM_MINRING);
+    ns_iFirstSequence = iSequence;
+    ns_iLastSequence = iSequence;
+    Slot(iSequence) = pnsbBlock;
+    ns_ctBlocks = 1;
+    return;
+  }
+  // if a block with same sequence is already in the stream
+  if (IsInRing(iSequence) && Slot(iSequence)!=NULL) {
+    // just discard the new block
+    delete pnsbBlock;
+    return;
+  }
+
+  // if the ring cannot span the new sequence
+  INDEX iFirst = Min(ns_iFirstSequence, iSequence);
+  INDEX iLast  = Max(ns_iLastSequence,  iSequence);
+  if (iLast-iFirst+1>NETSTREAM_MAXRING) {
+    // discard the block if too old, otherwise forget the oldest blocks
+    if (iSequence<ns_iFirstSequence) {
       delete pnsbBlock;
       return;
     }
-    // if the block in list has lower sequence than the one to add
-    if (itnsbInList->nsb_iSequenceNumber < pnsbBlock->nsb_iSequenceNumber) {
-      // stop searching
-      break;
+    RemoveOlderBlocksBySequence(iSequence-NETSTREAM_MAXRING+1);
+    if (ns_ctBlocks==0) {
+      AddAllocatedBlock(pnsbBlock);
+      return;
     }
+    iFirst = ns_iFirstSequence;
   }
-  // add the new block before current one
-  itnsbInList.InsertBeforeCurrent(pnsbBlock->nsb_lnInStream);
+  GrowRing(iLast-iFirst+1);
+
+  // slots outside of the stored range are always empty
+  Slot(iSequence) = pnsbBlock;
+  ns_iFirstSequence = iFirst;
+  ns_iLastSequence = iLast;
+  ns_ctBlocks++;
 }
 
 /*
@@ -693,7 +836,7 @@ void CNetworkStream::AddBlock(CNetworkStreamBlock &nsbBlock)
   CNetworkStreamBlock *pnsbCopy = new CNetworkStreamBlock(nsbBlock);
   // shrink it
   pnsbCopy->Shrink();
-  // add it to the list
+  // add it to the ring
   AddAllocatedBlock(pnsbCopy);
 }
 
@@ -708,7 +851,7 @@ void CNetworkStream::ReadBlock(CNetworkMessage &nmMessage)
   pnsbRead->ReadFromMessage(nmMessage);
   // shrink it
   pnsbRead->Shrink();
-  // add it to the list
+  // add it to the ring
   AddAllocatedBlock(pnsbRead);
 }
 
@@ -718,59 +861,47 @@ void CNetworkStream::ReadBlock(CNetworkMessage &nmMessage)
 CNetworkStream::Result CNetworkStream::GetBlockBySequence(
   INDEX iSequenceNumber, CNetworkStreamBlock *&pnsbBlock)
 {
-  BOOL bNewerFound = FALSE;
-  // search all blocks in list
-  FOREACHINLIST(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsbInList) {
-    CNetworkStreamBlock &nsbInList = *itnsbInList;
-    // if the block in list has newer sequence
-    if (nsbInList.nsb_iSequenceNumber >= iSequenceNumber) {
-      // remember that at least one newer block was found
-      bNewerFound = TRUE;
-    }
-
-    // if the block in list has wanted sequence
-    if (nsbInList.nsb_iSequenceNumber == iSequenceNumber) {
-      // return it
-      pnsbBlock = itnsbInList;
-      return R_OK;
-    }
-    // if the block in list has older sequence
-    if (nsbInList.nsb_iSequenceNumber < iSequenceNumber) {
-      // stop searching
-      break;
-    }
+  // if the block is stored
+  if (IsInRing(iSequenceNumber) && Slot(iSequenceNumber)!=NULL) {
+    // return it
+    pnsbBlock = Slot(iSequenceNumber);
+    return R_OK;
   }
 
   // ...if none found
+  pnsbBlock = NULL;
 
-  // if some block of newer sequence number was found
-  if (bNewerFound) {
+  // if some block of newer sequence number is stored
+  if (ns_ctBlocks>0 && ns_iLastSequence>iSequenceNumber) {
     // return that the block is missing (probably should be resent)
-    pnsbBlock = NULL;
     return R_BLOCKMISSING;
-  // if no newer blocks were found
+  // if no newer blocks are stored
   } else {
     // we assume that the wanted block is not yet received
-    pnsbBlock = NULL;
     return R_BLOCKNOTRECEIVEDYET;
   }
 }
 
+/*
+ * Remove a block gotten from the stream and delete it.
+ */
+void CNetworkStream::RemoveBlock(CNetworkStreamBlock *pnsbBlock)
+{
+  ASSERT(IsInRing(pnsbBlock->nsb_iSequenceNumber) && Slot(pnsbBlock->nsb_iSequenceNumber)==pnsbBlock);
+  RemoveSlot(pnsbBlock->nsb_iSequenceNumber);
+}
+
 // find oldest block after given one (for batching missing sequences)
 INDEX CNetworkStream::GetOldestSequenceAfter(INDEX iSequenceNumber)
 {
-  // block are sorted newer first, so we just remember the last block found
-  // until we find the given one
-  INDEX iOldest = iSequenceNumber;
-  FOREACHINLIST(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsb) {
-    CNetworkStreamBlock &nsb = *itnsb;
-    if (nsb.nsb_iSequenceNumber<iSequenceNumber) {
-      break;
-    } else {
-      iOldest = nsb.nsb_iSequenceNumber;
+  if (ns_ctBlocks>0) {
+    for (INDEX iSequence=Max(iSequenceNumber, ns_iFirstSequence); iSequence<=ns_iLastSequence; iSequence++) {
+      if (Slot(iSequence)!=NULL) {
+        return iSequence;
+      }
     }
   }
-  return iOldest;
+  return iSequenceNumber;
 }
 
 /*
@@ -778,14 +909,20 @@ INDEX CNetworkStream::GetOldestSequenceAfter(INDEX iSequenceNumber)
  */
 INDEX CNetworkStream::WriteBlocksToMessage(CNetworkMessage &nmMessage, INDEX ctBlocks)
 {
-  // for given number of newest blocks in list
+  // for given number of newest blocks in ring
   INDEX iBlock=0;
-  FOREACHINLIST(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsbInList) {
-    // write the block to message
-    itnsbInList->WriteToMessage(nmMessage);
-    iBlock++;
-    if (iBlock>=ctBlocks) {
-      return iBlock;
+  if (ns_ctBlocks>0) {
+    for (INDEX iSequence=ns_iLastSequence; iSequence>=ns_iFirstSequence; iSequence--) {
+      CNetworkStreamBlock *pnsb = Slot(iSequence);
+      if (pnsb==NULL) {
+        continue;
+      }
+      // write the block to message
+      pnsb->WriteToMessage(nmMessage);
+      iBlock++;
+      if (iBlock>=ctBlocks) {
+        return iBlock;
+      }
     }
   }
   return iBlock;
@@ -796,16 +933,22 @@ INDEX CNetworkStream::WriteBlocksToMessage(CNetworkMessage &nmMessage, INDEX ctB
  */
 void CNetworkStream::RemoveOlderBlocks(INDEX ctBlocksToKeep)
 {
-  // for each block in list
+  if (ctBlocksToKeep<=0) {
+    Clear();
+    return;
+  }
+  // find the oldest block to keep
   INDEX iBlock = 0;
-  FORDELETELIST(CNetworkStreamBlock, nsb_lnInStream, ns_lhBlocks, itnsbInList) {
-    iBlock++;
-    // if it is older that given count
-    if (iBlock>ctBlocksToKeep) {
-      // remove it from list
-      itnsbInList->nsb_lnInStream.Remove();
-      // delete it
-      delete &*itnsbInList;
+  if (ns_ctBlocks>0) {
+    for (INDEX iSequence=ns_iLastSequence; iSequence>=ns_iFirstSequence; iSequence--) {
+      if (Slot(iSequence)==NULL) {
+        continue;
+      }
+      iBlock++;
+      if (iBlock>=ctBlocksToKeep) {
+        RemoveOlderBlocksBySequence(iSequence);
+        return;
+      }
     }
   }
 }
@@ -813,18 +956,29 @@ void CNetworkStream::RemoveOlderBlocks(INDEX ctBlocksToKeep)
 /* Remove all blocks with sequence older than given. */
 void CNetworkStream::RemoveOlderBlocksBySequence(INDEX iLastSequenceToKeep)
 {
-  // while there are any blocks in the list
-  while(!ns_lhBlocks.IsEmpty()) {
-    // get the tail of the list
-    CNetworkStreamBlock *pnsb = LIST_TAIL(ns_lhBlocks, CNetworkStreamBlock, nsb_lnInStream);
-    // if it is not too old
-    if (pnsb->nsb_iSequenceNumber >= iLastSequenceToKeep) {
-      // stop
-      break;
+  // if nothing is too old
+  if (ns_ctBlocks==0 || iLastSequenceToKeep<=ns_iFirstSequence) {
+    return;
+  }
+  // if everything is too old
+  if (iLastSequenceToKeep>ns_iLastSequence) {
+    Clear();
+    return;
+  }
+  // delete all blocks before the given one
+  for (INDEX iSequence=ns_iFirstSequence; iSequence<iLastSequenceToKeep; iSequence++) {
+    CNetworkStreamBlock *&pnsb = Slot(iSequence);
+    if (pnsb!=NULL) {
+      delete pnsb;
+      pnsb = NULL;
+      ns_ctBlocks--;
     }
-    // remove the tail
-    delete pnsb;
-  };
+  }
+  // newest block is still there, so the range ends on stored blocks
+  ns_iFirstSequence = iLastSequenceToKeep;
+  while (Slot(ns_iFirstSequence)==NULL) {
+    ns_iFirstSequence++;
+  }
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -20,6 +20,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #endif
 
 #include <Engine/Base/Lists.h>
+#include <Engine/Base/Allocator.h>
+#include <Engine/Templates/StaticArray.h>
 #include <Engine/Math/Vector.h>
 
 // message type 
@@ -110,7 +112,7 @@ extern struct ErrorTable MessageTypes;
 /*
  * Holder for network message, can be read/written like a stream.
  */
-class ENGINE_API CNetworkMessage {
+class ENGINE_API CNetworkMessage : public CPooledObject<MTG_NETWORK> {
 public:
   MESSAGETYPE nm_mtType;                  // type of this message
 
@@ -200,9 +202,9 @@ public:
  */
 class CNetworkStreamBlock : public CNetworkMessage {
 public:
-  CListNode nsb_lnInStream;     // node in list of blocks in stream
-public:
-  INDEX nsb_iSequenceNumber;    // index for sorting in list
+  INDEX nsb_iSequenceNumber;    // index of the block in stream
+  SLONG nsb_slPackedSize;       // size of this block packed alone (-1 if not measured yet)
+  INDEX nsb_iPackedCompression; // compression the packed size was measured with
 public:
   /* Constructor for receiving -- uninitialized block. */
   CNetworkStreamBlock(void);
@@ -213,9 +215,8 @@ public:
   void ReadFromMessage(CNetworkMessage &nmToRead);
   /* Add a block to a message to send. */
   void WriteToMessage(CNetworkMessage &nmToWrite);
-
-  /* Remove the block from stream. */
-  void RemoveFromStream(void);
+  /* Get size of a game stream message holding only this block, packed (measured once). */
+  SLONG GetPackedSize(void);
 
   /* Read/write the block from file stream. */
   void Read_t(CTStream &strm); // throw char *
@@ -242,8 +243,24 @@ public:
     R_BLOCKNOTRECEIVEDYET,    // block is not yet received
   };
 public:
-  CListHead ns_lhBlocks;   // list of blocks of this stream (higher sequences first)
-
+  // blocks are kept in a ring indexed by sequence number (modulo ring size)
+  CStaticArray<CNetworkStreamBlock *> ns_apnsbBlocks;
+  INDEX ns_iFirstSequence;  // no block older than this is stored
+  INDEX ns_iLastSequence;   // newest stored sequence (-1 if empty)
+  INDEX ns_ctBlocks;        // number of blocks stored
+
+  // get ring slot for given sequence
+  inline CNetworkStreamBlock *&Slot(INDEX iSequenceNumber) {
+    return ns_apnsbBlocks[iSequenceNumber&(ns_apnsbBlocks.Count()-1)];
+  };
+  // check if a sequence can be stored without growing the ring
+  inline BOOL IsInRing(INDEX iSequenceNumber) {
+    return ns_ctBlocks>0 && iSequenceNumber>=ns_iFirstSequence && iSequenceNumber<=ns_iLastSequence;
+  };
+  /* Resize the ring to hold given span of sequences. */
+  void GrowRing(INDEX ctSpan);
+  /* Remove block in given slot and update the stored range. */
+  void RemoveSlot(INDEX iSequenceNumber);
   /* Add a block that is already allocated to the stream. */
   void AddAllocatedBlock(CNetworkStreamBlock *pnsbBlock);
 public:
@@ -269,6 +286,8 @@ public:
   /* Get a block from stream by its sequence number. */
   CNetworkStream::Result GetBlockBySequence(
     INDEX iSequenceNumber, CNetworkStreamBlock *&pnsbBlock);
+  /* Remove a block gotten from the stream and delete it. */
+  void RemoveBlock(CNetworkStreamBlock *pnsbBlock);
   // find oldest block after given one (for batching missing sequences)
   INDEX GetOldestSequenceAfter(INDEX iSequenceNumber);
 
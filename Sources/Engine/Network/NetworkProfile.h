@@ -34,6 +34,7 @@ public:
     PTI_SERVER_LOOP,              // time server spent processing messages
     PTI_SESSIONSTATE_LOOP,        // time session state spent processing messages
     PTI_SESSIONSTATE_PROCESSGAMESTREAM, // time session state spent processing gamestream (includes physics)
+    PTI_SESSIONSTATE_SETUPPREDICTORS,   // time session state spent creating or resyncing predictors
 
     PTI_SENDMESSAGE,              // time spend sending message
     PTI_RECEIVEMESSAGE,           // time spend receiving message
@@ -41,6 +42,7 @@ public:
   };
   enum ProfileCounterIndex {
     PCI_GAMESTREAMRESENDS,  // how many times gamestream block was resent from server
+    PCI_PREDICTORS,         // predictors set up for prediction (new and kept)
 
     PCI_GAMESTREAM_BYTES_SENT,      // bytes sent in gamestream messages
     PCI_GAMESTREAM_BYTES_RECEIVED,  // bytes received in gamestream messages
@@ -36,6 +36,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/CRC.h>
 #include <Engine/Base/ErrorTable.h>
 #include <Engine/GameAgent/GameAgent.h>
+#include <Engine/Base/Allocator.h>
 
 #include <Engine/Templates/StaticArray.cpp>
 
@@ -183,6 +184,7 @@ CNetworkMessage &operator>>(CNetworkMessage &nm, CSessionSocketParams &ssp)
 CServer::CServer(void)
 {
   srv_bActive = FALSE;
+  srv_fPackingRatio = 1.0f;
 
   srv_assoSessions.New(NET_MAXGAMECOMPUTERS);
   srv_aplbPlayers.New(NET_MAXGAMEPLAYERS);
@@ -370,6 +372,32 @@ INDEX CServer::FindSyncCheck(TIME tmTick, CSyncCheck &sc)
   }
 }
 
+// get size of the header that packing adds in front of packed data
+static SLONG GetPackHeaderSize(void)
+{
+  extern INDEX net_iCompression;
+  return net_iCompression==3 ? 2*sizeof(UBYTE) : sizeof(UBYTE);
+}
+
+// pack a batch of game stream blocks, dropping the last added blocks while it is over the limit
+// (blocks added after the first ctBlocksUp ones are older ones, and must fit in the lower limit)
+static void PackBlockBatch(CNetworkMessage &nmBlocks, const SLONG *aslBlockEnds, INDEX &ctBlocks,
+  INDEX ctBlocksUp, SLONG slMaxPacked, SLONG slMinPacked, CNetworkMessage &nmPacked)
+{
+  FOREVER {
+    nmPacked.Reinit();
+    nmBlocks.PackDefault(nmPacked);
+    const SLONG slLimit = ctBlocks>ctBlocksUp ? slMinPacked : slMaxPacked;
+    // at least one block is always sent
+    if (nmPacked.nm_slSize<slLimit || ctBlocks<=1) {
+      return;
+    }
+    ctBlocks--;
+    nmBlocks.nm_slSize = aslBlockEnds[ctBlocks-1];
+    nmBlocks.nm_pubPointer = nmBlocks.nm_pubMessage+nmBlocks.nm_slSize;
+  }
+}
+
 /* Send one regular batch of sequences to a client. */
 void CServer::SendGameStreamBlocks(INDEX iClient)
 {
@@ -404,13 +432,18 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
 
   // initialize the message that is to be sent
   CNetworkMessage nmGameStreamBlocks(MSG_GAMESTREAMBLOCKS);
-  // get one message for last compressed message of valid size
-  CNetworkMessage nmPackedBlocks(MSG_GAMESTREAMBLOCKS);
-  CNetworkMessage nmPackedBlocksNew(MSG_GAMESTREAMBLOCKS);
+  // remember where each block ends, to be able to drop the last ones
+  SLONG aslBlockEnds[100];
+  INDEX aiBlockSequences[100];
+  // packed size of the batch is estimated from sizes of the blocks packed alone,
+  // so that the batch is packed only once instead of after each added block
+  const SLONG slPackHeader = GetPackHeaderSize();
+  FLOAT fPackedEstimate = (FLOAT)slPackHeader;
+  SLONG slPackedAlone = 0;
 
   // repeat for max 100 sequences
   INDEX iBlocksOk = 0;
-  INDEX iMaxSent = -1;
+  INDEX ctBlocksUp = 100;  // number of blocks added before going downward
   for(INDEX i=0; i<100; i++) {
     if (iStep<0 && iBlocksOk>=3) {
 //      break;
@@ -439,6 +472,7 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
           iSequence = iLastSent;
         }
         iStep = -1;
+        ctBlocksUp = iBlocksOk;
         // retry
         continue;
       // otherwise
@@ -453,23 +487,24 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
       break;
     }
 
-    // add this block to the message and pack it
-    pnsbBlock->WriteToMessage(nmGameStreamBlocks);
-    nmPackedBlocksNew.Reinit();
-    nmGameStreamBlocks.PackDefault(nmPackedBlocksNew);
+    // estimate the batch size with this block added
+    const SLONG slBlockPacked = pnsbBlock->GetPackedSize()-slPackHeader;
+    const FLOAT fPackedEstimateNew = fPackedEstimate + slBlockPacked*srv_fPackingRatio;
     // if some blocks written already and the batch is too large
     if (iBlocksOk>0) {
-      if ((iStep>0 && nmPackedBlocksNew.nm_slSize>=ctMaxBytes) ||
-          (iStep<0 && nmPackedBlocksNew.nm_slSize>=ctMinBytes) ) {
+      if ((iStep>0 && fPackedEstimateNew>=ctMaxBytes) ||
+          (iStep<0 && fPackedEstimateNew>=ctMinBytes) ) {
         // stop
 //        CPrintF("toomuch ");
         break;
       }
     }
-    // use new pack
-//    CPrintF("added ");
-    nmPackedBlocks = nmPackedBlocksNew;
-    iMaxSent = Max(iMaxSent, iSequence);
+    // add this block to the message
+    pnsbBlock->WriteToMessage(nmGameStreamBlocks);
+    fPackedEstimate = fPackedEstimateNew;
+    slPackedAlone += slBlockPacked;
+    aslBlockEnds[iBlocksOk] = nmGameStreamBlocks.nm_slSize;
+    aiBlockSequences[iBlocksOk] = iSequence;
     iSequence+= iStep;
     iBlocksOk++;
   }
@@ -489,6 +524,22 @@ void CServer::SendGameStreamBlocks(INDEX iClient)
     return;
   }
 
+  // pack the batch, dropping the last added blocks if the estimate was too low
+  CNetworkMessage nmPackedBlocks(MSG_GAMESTREAMBLOCKS);
+  const INDEX ctBlocksEstimated = iBlocksOk;
+  PackBlockBatch(nmGameStreamBlocks, aslBlockEnds, iBlocksOk, ctBlocksUp, ctMaxBytes, ctMinBytes, nmPackedBlocks);
+  // learn how much better blocks pack together than alone
+  if (ctBlocksEstimated>1 && iBlocksOk==ctBlocksEstimated && slPackedAlone>0) {
+    FLOAT fRatio = FLOAT(nmPackedBlocks.nm_slSize-slPackHeader)/slPackedAlone;
+    srv_fPackingRatio = Lerp(srv_fPackingRatio, Clamp(fRatio, 0.1f, 1.5f), 0.1f);
+  } else if (iBlocksOk<ctBlocksEstimated) {
+    srv_fPackingRatio = ClampUp(srv_fPackingRatio*1.1f, 1.5f);
+  }
+  INDEX iMaxSent = -1;
+  {for (INDEX iBlock=0; iBlock<iBlocksOk; iBlock++) {
+    iMaxSent = Max(iMaxSent, aiBlockSequences[iBlock]);
+  }}
+
   // send the message to the client
 //  CPrintF("sent: %d=%dB\n", iBlocksOk, nmPackedBlocks.nm_slSize);
   _pNetwork->SendToClient(iClient, nmPackedBlocks);
@@ -719,6 +770,8 @@ void CServer::ServerLoop(void)
   }
 
   _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_SERVER_LOOP);
+  // account server message handling to network
+  CMemoryTagScope mtsNetwork(MTG_NETWORK);
 
 //  try {
 //    _cmiComm.Server_Accept_t();
@@ -817,6 +870,8 @@ void CServer::MakeAllActions(void)
 // add a block to streams for all sessions
 void CServer::AddBlockToAllSessions(CNetworkStreamBlock &nsb)
 {
+  // measure the packed block once, all the copies share the measurement
+  nsb.GetPackedSize();
   // for each active session
   for(INDEX iSession=0; iSession<srv_assoSessions.Count(); iSession++) {
     CSessionSocket &sso = srv_assoSessions[iSession];
@@ -1065,8 +1120,14 @@ void CServer::SendSessionStateData(INDEX iClient)
     DIFF_Diff_t(&strmDefaultState, pstrmState, pstrmDelta);
     pstrmDelta->SetPos_t(0);
     SLONG slDeltaSize = pstrmDelta->GetStreamSize();
-    CzlibCompressor comp;
-    comp.PackStream_t(*pstrmDelta, strmInfo);
+    extern INDEX ser_iStateCompression;
+    if (ser_iStateCompression==CT_ZLIB) {
+      // keep old format, so older clients can still connect
+      CzlibCompressor comp;
+      comp.PackStream_t(*pstrmDelta, strmInfo);
+    } else {
+      PackStreamTagged_t(ser_iStateCompression, *pstrmDelta, strmInfo);
+    }
 
     SLONG slSize = strmInfo.GetStreamSize();
 
@@ -41,6 +41,7 @@ public:
   BOOL srv_bPause;      // set while game is paused
   BOOL srv_bGameFinished; // set while game is finished
   FLOAT srv_fServerStep;  // counter for smooth time slowdown/speedup
+  FLOAT srv_fPackingRatio;  // packed batch size vs. sum of its blocks packed alone
 public:
   /* Send disconnect message to some client. */
   void SendDisconnectMessage(INDEX iClient, const char *strExplanation, BOOL bStream = FALSE);
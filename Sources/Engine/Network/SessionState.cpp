@@ -43,6 +43,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Base/ListIterator.inl>
 #include <Engine/Base/CRC.h>
+#include <Engine/Base/Allocator.h>
 
 #define SESSIONSTATEVERSION_OLD 1
 #define SESSIONSTATEVERSION_WITHBULLETTIME 2
@@ -373,8 +374,7 @@ void CSessionState::Start_AtClient_t(INDEX ctLocalPlayers)     // throw char *
     WaitStream_t(strmMessage, "data", MSG_REP_STATEDELTA);
     // decompress saved session state
     CTMemoryStream strmDelta;
-    CzlibCompressor comp;
-    comp.UnpackStream_t(strmMessage, strmDelta);
+    UnpackStreamTagged_t(strmMessage, strmDelta, CT_ZLIB);
     CTMemoryStream strmNew;
     DIFF_Undiff_t(pstrmState, &strmDelta, &strmNew);
     strmNew.SetPos_t(0);
@@ -929,6 +929,9 @@ void CSessionState::ProcessGameTick(CNetworkMessage &nmMessage, TIME tmCurrentTi
   _pTimer->SetCurrentTick(tmCurrentTick);
   _pfNetworkProfile.IncrementAveragingCounter();
   _pfPhysicsProfile.IncrementAveragingCounter();
+  UpdateMemoryProfile();
+  // entity simulation allocates on behalf of the world
+  CMemoryTagScope mtsWorld(MTG_WORLD);
 
   // random is allowed only here, during entity ai
   ses_bAllowRandom = TRUE;
@@ -1042,6 +1045,7 @@ void CSessionState::ProcessPredictedGameTick(INDEX iPredictionStep, FLOAT fFacto
   _pTimer->SetCurrentTick(tmCurrentTick);
   _pfNetworkProfile.IncrementAveragingCounter();
   _pfPhysicsProfile.IncrementAveragingCounter();
+  UpdateMemoryProfile();
 
   // random is allowed only here, during entity ai
   ses_bAllowRandom = TRUE;
@@ -1174,8 +1178,7 @@ void CSessionState::ProcessGameStream(void)
       // process the stream block
       ProcessGameStreamBlock(*pnsbBlock);
       // remove the block from the stream
-      pnsbBlock->RemoveFromStream();
-      delete pnsbBlock;
+      ses_nsGameStream.RemoveBlock(pnsbBlock);
       // remove eventual resent blocks that have already been processed
       ses_nsGameStream.RemoveOlderBlocksBySequence(ses_iLastProcessedSequence-2);
 
@@ -1294,10 +1297,15 @@ void CSessionState::ProcessPrediction(void)
   ULONG ulOldRandom = ses_ulRandomSeed;
   ULONG ulEntityID = _pNetwork->ga_World.wo_ulNextEntityID;
 
+  _pfNetworkProfile.StartTimer(CNetworkProfile::PTI_SESSIONSTATE_SETUPPREDICTORS);
   // delete all predictors (if any left from last time)
   _pNetwork->ga_World.DeletePredictors();
   // create new predictors
   _pNetwork->ga_World.CreatePredictors();
+  _pfNetworkProfile.StopTimer(CNetworkProfile::PTI_SESSIONSTATE_SETUPPREDICTORS);
+  _pfNetworkProfile.IncrementTimerAveragingCounter(CNetworkProfile::PTI_SESSIONSTATE_SETUPPREDICTORS,
+    _pNetwork->ga_World.wo_cenPredictor.Count());
+  _pfNetworkProfile.IncrementCounter(CNetworkProfile::PCI_PREDICTORS, _pNetwork->ga_World.wo_cenPredictor.Count());
 
   // for each step
   TIME tmPredictedTick = ses_tmLastProcessedTick;
@@ -1719,6 +1727,52 @@ void CSessionState::ReadWorldAndState_t(CTStream *pstr)   // throw char *
   _pNetwork->ga_World.UnlockAll();
 }
 
+// timings of last operations on remembered levels, for RememberedLevelsInfo()
+static DOUBLE _dRememberSeconds = 0.0;
+static DOUBLE _dRestoreSeconds = 0.0;
+static DOUBLE _dSaveSeconds = 0.0;
+
+// finish packing of levels that are done and spill the oldest ones over the memory limit
+static void LimitRememberedLevels(CListHead &lhLevels)
+{
+  // count memory of all levels in memory
+  SLONG slInMemory = 0;
+  {FOREACHINLIST(CRememberedLevel, rl_lnInSessionState, lhLevels, itrl) {
+    CRememberedLevel &rl = *itrl;
+    if (rl.IsPacked()) {
+      rl.FinishPacking();
+      if (rl.rl_pubPacked!=NULL) {
+        slInMemory += rl.rl_slPackedSize;
+      }
+    // the level still being packed is counted as unpacked
+    } else {
+      slInMemory += rl.rl_slUnpackedSize;
+    }
+  }}
+  if (gam_iRememberedLevelsMaxKB<=0) {
+    return;
+  }
+
+  // spill oldest levels first
+  const SLONG slMax = SLONG(gam_iRememberedLevelsMaxKB)*1024;
+  {FOREACHINLIST(CRememberedLevel, rl_lnInSessionState, lhLevels, itrl) {
+    CRememberedLevel &rl = *itrl;
+    if (slInMemory<=slMax) {
+      break;
+    }
+    if (rl.rl_pstrmSessionState!=NULL || rl.rl_pubPacked==NULL) {
+      continue;
+    }
+    try {
+      rl.Spill_t();
+      slInMemory -= rl.rl_slPackedSize;
+    } catch (char *strError) {
+      // it just stays in memory
+      CPrintF(TRANSV("Cannot spill remembered level '%s':\n%s\n"), (const char *)rl.rl_strFileName, strError);
+    }
+  }}
+}
+
 void CSessionState::ReadRememberedLevels_t(CTStream *pstr)
 {
   pstr->ExpectID_t("RLEV"); // remembered levels
@@ -1729,13 +1783,11 @@ void CSessionState::ReadRememberedLevels_t(CTStream *pstr)
   for(INDEX iLevel=0; iLevel<ctLevels; iLevel++) {
     // create it
     CRememberedLevel *prl = new CRememberedLevel;
+    ses_lhRememberedLevels.AddTail(prl->rl_lnInSessionState);
     // read it
-    (*pstr)>>prl->rl_strFileName;
-    //prl->rl_strmSessionState.
-    // use readstream() !!!! @@@@
-
+    prl->Read_t(*pstr);
   }
-  
+  LimitRememberedLevels(ses_lhRememberedLevels);
 };
 
 /*
@@ -1819,8 +1871,16 @@ void CSessionState::WriteWorldAndState_t(CTStream *pstr)   // throw char *
 
 void CSessionState::WriteRememberedLevels_t(CTStream *pstr)
 {
-    // use writestream() !!!! @@@@
-
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+  pstr->WriteID_t("RLEV"); // remembered levels
+  // write count of remembered levels
+  (*pstr)<<ses_lhRememberedLevels.Count();
+  // for each level
+  {FOREACHINLIST(CRememberedLevel, rl_lnInSessionState, ses_lhRememberedLevels, itrl) {
+    // write it (already packed)
+    itrl->Write_t(*pstr);
+  }}
+  _dSaveSeconds = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
 };
 
 // remember current level
@@ -1837,12 +1897,20 @@ void CSessionState::RememberCurrentLevel(const CTString &strFileName)
     delete prlOld;
   }
 
+  CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
   // create new remembered level
   CRememberedLevel *prlNew = new CRememberedLevel;
   ses_lhRememberedLevels.AddTail(prlNew->rl_lnInSessionState);
   // remember it
   prlNew->rl_strFileName = strFileName;
-  WriteWorldAndState_t(&prlNew->rl_strmSessionState);
+  prlNew->rl_pstrmSessionState = new CTMemoryStream;
+  WriteWorldAndState_t(prlNew->rl_pstrmSessionState);
+  // pack it in background
+  prlNew->StartPacking();
+  _dRememberSeconds = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
+
+  // older levels have had their time to get packed, keep them within memory limit
+  LimitRememberedLevels(ses_lhRememberedLevels);
 }
 
 // find a level if it is remembered
@@ -1866,10 +1934,14 @@ void CSessionState::RestoreOldLevel(const CTString &strFileName)
   ASSERT(prlOld!=NULL);
   // restore it
   try {
-    prlOld->rl_strmSessionState.SetPos_t(0);
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    // unpack it only now
+    CTMemoryStream strmState;
+    prlOld->Unpack_t(strmState);
     _pTimer->SetCurrentTick(0.0f);
-    ReadWorldAndState_t(&prlOld->rl_strmSessionState);
+    ReadWorldAndState_t(&strmState);
     _pTimer->SetCurrentTick(ses_tmLastProcessedTick);
+    _dRestoreSeconds = (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds();
   } catch (char *strError) {
     FatalError(TRANS("Cannot restore old level '%s':\n%s"), (const char *) prlOld->rl_strFileName, strError);
   }
@@ -1926,6 +1998,42 @@ void CSessionState::ForgetOldLevels(void)
   }}
 }
 
+// print memory used by remembered levels and timings of last operations on them
+void RememberedLevelsInfo(void)
+{
+  CListHead &lhLevels = _pNetwork->ga_sesSessionState.ses_lhRememberedLevels;
+  CPrintF("Remembered levels (%s, limit %d KB):\n",
+    GetCompressorName(gam_iRememberCompression), gam_iRememberedLevelsMaxKB);
+  SLONG slUnpacked = 0;
+  SLONG slInMemory = 0;
+  SLONG slOnDisk = 0;
+  {FOREACHINLIST(CRememberedLevel, rl_lnInSessionState, lhLevels, itrl) {
+    CRememberedLevel &rl = *itrl;
+    const char *strWhere;
+    SLONG slSize;
+    if (!rl.IsPacked()) {
+      strWhere = "packing";
+      slSize = rl.rl_slUnpackedSize;
+      slInMemory += slSize;
+    } else if (rl.rl_pstrmSessionState!=NULL || rl.rl_pubPacked!=NULL) {
+      strWhere = "memory";
+      slSize = (rl.rl_pstrmSessionState!=NULL && rl.rl_slPackedSize<0) ? rl.rl_slUnpackedSize : rl.rl_slPackedSize;
+      slInMemory += slSize;
+    } else {
+      strWhere = "disk";
+      slSize = rl.rl_slPackedSize;
+      slOnDisk += slSize;
+    }
+    slUnpacked += rl.rl_slUnpackedSize;
+    CPrintF("  %-40s %7d KB -> %7d KB  %s\n", (const char *)rl.rl_strFileName,
+      rl.rl_slUnpackedSize/1024, slSize/1024, strWhere);
+  }}
+  CPrintF("  total: %d levels, %d KB unpacked, %d KB in memory, %d KB on disk\n",
+    lhLevels.Count(), slUnpacked/1024, slInMemory/1024, slOnDisk/1024);
+  CPrintF("  last remember %.1f ms, restore %.1f ms, save %.1f ms\n",
+    _dRememberSeconds*1000.0, _dRestoreSeconds*1000.0, _dSaveSeconds*1000.0);
+}
+
 
 extern INDEX cli_bDumpSync;
 extern INDEX cli_bDumpSyncEachTick;
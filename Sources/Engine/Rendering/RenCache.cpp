@@ -835,29 +835,33 @@ void CRenderer::MakeSpan(CScreenPolygon &spo, CScreenEdge *psed0, CScreenEdge *p
   }
   // if rendering view
   else {
-    // if no span added to this polygon yet
-    if( !spo.spo_ubSpanAdded) {
-      spo.spo_ubSpanAdded = 1;
-      // add mirror if needed
-      AddMirror(spo);
-      // add polygon to scene polygons
-      AddPolygonToScene(&spo);
-      const PIX pixI0 = PIXCoord(psed0->sed_xI);
-      const PIX pixI1 = PIXCoord(psed1->sed_xI);
-      spo.spo_pixMinI = pixI0;
-      spo.spo_pixMaxI = pixI1;
-      spo.spo_pixMinJ = re_pixCurrentScanJ;
-      spo.spo_pixMaxJ = re_pixCurrentScanJ;
-      spo.spo_pixTotalArea = pixI1-pixI0;
-    } else {
-      const PIX pixI0 = PIXCoord(psed0->sed_xI);
-      const PIX pixI1 = PIXCoord(psed1->sed_xI);
-      spo.spo_pixMinI = Min(spo.spo_pixMinI, pixI0);
-      spo.spo_pixMaxI = Max(spo.spo_pixMaxI, pixI1);
-      spo.spo_pixMinJ = Min(spo.spo_pixMinJ, re_pixCurrentScanJ);
-      spo.spo_pixMaxJ = Max(spo.spo_pixMaxJ, re_pixCurrentScanJ);
-      spo.spo_pixTotalArea += pixI1-pixI0;
-    }
+    AddSpanToPolygon(spo, PIXCoord(psed0->sed_xI), PIXCoord(psed1->sed_xI));
+  }
+}
+
+/*
+ * Add a span of a polygon on current scan line to the polygon in view.
+ */
+void CRenderer::AddSpanToPolygon(CScreenPolygon &spo, PIX pixI0, PIX pixI1)
+{
+  // if no span added to this polygon yet
+  if( !spo.spo_ubSpanAdded) {
+    spo.spo_ubSpanAdded = 1;
+    // add mirror if needed
+    AddMirror(spo);
+    // add polygon to scene polygons
+    AddPolygonToScene(&spo);
+    spo.spo_pixMinI = pixI0;
+    spo.spo_pixMaxI = pixI1;
+    spo.spo_pixMinJ = re_pixCurrentScanJ;
+    spo.spo_pixMaxJ = re_pixCurrentScanJ;
+    spo.spo_pixTotalArea = pixI1-pixI0;
+  } else {
+    spo.spo_pixMinI = Min(spo.spo_pixMinI, pixI0);
+    spo.spo_pixMaxI = Max(spo.spo_pixMaxI, pixI1);
+    spo.spo_pixMinJ = Min(spo.spo_pixMinJ, re_pixCurrentScanJ);
+    spo.spo_pixMaxJ = Max(spo.spo_pixMaxJ, re_pixCurrentScanJ);
+    spo.spo_pixTotalArea += pixI1-pixI0;
   }
 }
 
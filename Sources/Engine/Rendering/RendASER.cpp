@@ -782,6 +782,14 @@ CScreenPolygon *CRenderer::ScanOneLine(void)
  */
 void CRenderer::ScanEdges(void)
 {
+  // if view should be scanned in bands on multiple threads
+  if (wld_iASERBands>1 && !re_bRenderingShadows && _pJobs!=NULL
+    && re_ctScanLines>=2*ASER_MINBANDSCANS) {
+    // do it that way
+    ScanEdgesInBands(wld_iASERBands);
+    return;
+  }
+
   _pfRenderProfile.StartTimer(CRenderProfile::PTI_SCANEDGES);
   // set up the list of active edges, surface stack and the sentinels
   InitScanEdges();
@@ -864,3 +872,533 @@ void CRenderer::ScanEdges(void)
   EndScanEdges();
   _pfRenderProfile.StopTimer(CRenderProfile::PTI_SCANEDGES);
 }
+
+
+/*
+ * Add a polygon to surface stack of a band.
+ */
+BOOL CRenderer::AddPolygonToBandStack(CScanBand &sb, CScreenPolygon &spo, FIX16_16 xI, FLOAT fScanJ)
+{
+  // if polygon has negative in-stack counter
+  INDEX ibs;
+  for (ibs=0; ibs<sb.sb_absAside.Count(); ibs++) {
+    CBandSurface &bs = sb.sb_absAside[ibs];
+    if (bs.bs_pspo==&spo) {
+      // just increment it (it cannot become 1 here)
+      bs.bs_ctInStack++;
+      if (bs.bs_ctInStack==0) {
+        bs = sb.sb_absAside[sb.sb_absAside.Count()-1];
+        sb.sb_absAside.Pop();
+      }
+      return FALSE;
+    }
+  }
+  // if polygon is already in stack
+  for (ibs=sb.sb_absStack.Count()-1; ibs>0; ibs--) {
+    CBandSurface &bs = sb.sb_absStack[ibs];
+    if (bs.bs_pspo==&spo) {
+      // just increment its counter
+      bs.bs_ctInStack++;
+      return FALSE;
+    }
+  }
+
+  // calculate 1/k for new polygon, same as in AddPolygonToSurfaceStack()
+  FLOAT fScanI = FLOAT(xI)+BIAS;
+  CPlanarGradients &pg = spo.spo_pgOoK;
+  FLOAT fOoK = pg.pg_f00 + pg.pg_fDOverDI*fScanI + pg.pg_fDOverDJ*fScanJ;
+  fOoK*=re_fEdgeAdjustK;
+
+  // start at top surface in stack and find first one that is not closer
+  ibs = sb.sb_absStack.Count()-1;
+  if (!re_prProjection.IsPerspective()) {
+    while (ibs>0) {
+      const CPlanarGradients &pgInStack = sb.sb_absStack[ibs].bs_pspo->spo_pgOoK;
+      if ((fOoK - pgInStack.pg_f00 - pgInStack.pg_fDOverDI*fScanI - pgInStack.pg_fDOverDJ*fScanJ)>=0) {
+        break;
+      }
+      ibs--;
+    }
+  } else {
+    while (ibs>0) {
+      const CPlanarGradients &pgInStack = sb.sb_absStack[ibs].bs_pspo->spo_pgOoK;
+      FLOAT fDelta = fOoK - pgInStack.pg_f00 - pgInStack.pg_fDOverDI*fScanI - pgInStack.pg_fDOverDJ*fScanJ;
+      if (((SLONG &)fDelta) >= 0) {
+        break;
+      }
+      ibs--;
+    }
+  }
+
+  // insert the new polygon above the one found
+  const INDEX ctStack = sb.sb_absStack.Count();
+  sb.sb_absStack.Push();
+  for (INDEX ibsMove=ctStack; ibsMove>ibs+1; ibsMove--) {
+    sb.sb_absStack[ibsMove] = sb.sb_absStack[ibsMove-1];
+  }
+  CBandSurface &bsNew = sb.sb_absStack[ibs+1];
+  bsNew.bs_pspo = &spo;
+  bsNew.bs_ctInStack = 1;
+  bsNew.bs_xSpanStart = xI;
+
+  // return if this is new top of stack
+  return ibs+1==ctStack;
+}
+
+/*
+ * Remove a polygon from surface stack of a band.
+ */
+BOOL CRenderer::RemPolygonFromBandStack(CScanBand &sb, CScreenPolygon &spo)
+{
+  // if polygon is in stack
+  INDEX ibs;
+  const INDEX ctStack = sb.sb_absStack.Count();
+  for (ibs=ctStack-1; ibs>0; ibs--) {
+    CBandSurface &bs = sb.sb_absStack[ibs];
+    if (bs.bs_pspo==&spo) {
+      // decrement in-stack counter
+      bs.bs_ctInStack--;
+      // if it doesn't have to be removed
+      if (bs.bs_ctInStack!=0) {
+        // return that this was not top
+        return FALSE;
+      }
+      // remove the polygon from stack
+      for (INDEX ibsMove=ibs; ibsMove<ctStack-1; ibsMove++) {
+        sb.sb_absStack[ibsMove] = sb.sb_absStack[ibsMove+1];
+      }
+      sb.sb_absStack.Pop();
+      // return if it was top
+      return ibs==ctStack-1;
+    }
+  }
+
+  // if not in stack, the in-stack counter goes negative
+  for (ibs=0; ibs<sb.sb_absAside.Count(); ibs++) {
+    CBandSurface &bs = sb.sb_absAside[ibs];
+    if (bs.bs_pspo==&spo) {
+      bs.bs_ctInStack--;
+      return FALSE;
+    }
+  }
+  CBandSurface &bs = sb.sb_absAside.Push();
+  bs.bs_pspo = &spo;
+  bs.bs_ctInStack = -1;
+  return FALSE;
+}
+
+// add a span to a band
+static inline void AddBandSpan(CScanBand &sb, CScreenPolygon *pspo, FIX16_16 xI0, FIX16_16 xI1)
+{
+  CBandSpan &bsp = sb.sb_abspSpans.Push();
+  bsp.bsp_pspo = pspo;
+  bsp.bsp_pixI0 = PIXCoord(xI0);
+  bsp.bsp_pixI1 = PIXCoord(xI1);
+}
+
+// remember a portal encountered in a band
+static inline void AddBandPortal(CScanBand &sb, CScreenPolygon *pspo)
+{
+  for (INDEX ipspo=0; ipspo<sb.sb_apspoPortals.Count(); ipspo++) {
+    if (sb.sb_apspoPortals[ipspo]==pspo) {
+      return;
+    }
+  }
+  sb.sb_apspoPortals.Push() = pspo;
+}
+
+/*
+ * Scan one line of a band into spans.
+ * This is ScanOneLine() that works on band's own data - instead of failing on
+ * portals, it remembers them and goes on, since the band is scanned again anyway.
+ */
+void CRenderer::ScanBandLine(CScanBand &sb, INDEX iScan)
+{
+  sb.sb_aiFirstSpan.Push() = sb.sb_abspSpans.Count();
+
+  // if left and right sentinels are sorted wrong
+  const INDEX ctActive = sb.sb_abeActive.Count();
+  if (sb.sb_abeActive[0].be_psedEdge!=&re_sedLeftSentinel
+    ||sb.sb_abeActive[ctActive-1].be_psedEdge!=&re_sedRightSentinel) {
+    // skip entire line (this patches some extremely rare crash situations)
+    return;
+  }
+  const FIX16_16 xRightI = sb.sb_abeActive[ctActive-1].be_xI;
+  const FLOAT fScanJ = FLOAT(iScan+re_pixTopScanLineJ);
+
+  // reinit surface stack with far sentinel only
+  sb.sb_absStack.PopAll();
+  sb.sb_absAside.PopAll();
+  CBandSurface &bsFar = sb.sb_absStack.Push();
+  bsFar.bs_pspo = &re_spoFarSentinel;
+  bsFar.bs_ctInStack = 1;
+  bsFar.bs_xSpanStart = sb.sb_abeActive[0].be_xI;
+
+  // for all edges in the line
+  for (INDEX ibe=1; ibe<ctActive-1; ibe++) {
+    const CBandEdge &be = sb.sb_abeActive[ibe];
+    const CScreenEdge &sed = *be.be_psedEdge;
+    const FIX16_16 xI = be.be_xI;
+    sb.sb_ctEdgeTransitions++;
+
+    // if this edge has no active polygon
+    if (sed.sed_pspo==NULL || !sed.sed_pspo->spo_bActive) {
+      // skip it
+      continue;
+    }
+    CScreenPolygon &spo = *sed.sed_pspo;
+    // if it is right edge of the polygon
+    if (sed.sed_ldtDirection==LDT_ASCENDING) {
+      // remove the left polygon from stack
+      const CBandSurface bsOld = sb.sb_absStack[sb.sb_absStack.Count()-1];
+      BOOL bWasTop = RemPolygonFromBandStack(sb, spo);
+      // if that was top polygon in surface stack
+      if (bWasTop) {
+        // if it is portal
+        if (spo.IsPortal() &&
+           (re_ubLightIllumination==0||re_ubLightIllumination!=spo.spo_ubIllumination)) {
+          // remember it instead of generating span
+          AddBandPortal(sb, &spo);
+        } else {
+          // generate a span for it
+          AddBandSpan(sb, &spo, bsOld.bs_xSpanStart, xI);
+        }
+        // mark that span of new top starts here
+        sb.sb_absStack[sb.sb_absStack.Count()-1].bs_xSpanStart = xI;
+      }
+
+    // if it is left edge of the polygon
+    } else {
+      ASSERT(sed.sed_ldtDirection==LDT_DESCENDING);
+      // add the right polygon to stack
+      BOOL bIsTop = AddPolygonToBandStack(sb, spo, xI, fScanJ);
+      // if it is the new top of surface stack
+      if (bIsTop) {
+        // get the old top
+        const INDEX ctStack = sb.sb_absStack.Count();
+        CBandSurface &bsOldTop = sb.sb_absStack[ctStack-2];
+        CScreenPolygon &spoOldTop = *bsOldTop.bs_pspo;
+        // if it is portal
+        if (spoOldTop.IsPortal() &&
+           (re_ubLightIllumination==0||re_ubLightIllumination!=spoOldTop.spo_ubIllumination)) {
+          // if its span has at least one pixel in length
+          if (PIXCoord(xI)-PIXCoord(bsOldTop.bs_xSpanStart)>0) {
+            // remember it
+            AddBandPortal(sb, &spoOldTop);
+          }
+        // if it is not portal
+        } else {
+          // generate span for old top
+          AddBandSpan(sb, &spoOldTop, bsOldTop.bs_xSpanStart, xI);
+        }
+        // span of new polygon started here already
+      }
+    }
+  }
+
+  // if surface stack contains something else except background
+  if (sb.sb_absStack.Count()>1) {
+    // generate span of the top polygon to the right border
+    const CBandSurface &bsTop = sb.sb_absStack[sb.sb_absStack.Count()-1];
+    CScreenPolygon &spo = *bsTop.bs_pspo;
+    if (!(spo.IsPortal()
+       && (re_ubLightIllumination==0 || re_ubLightIllumination!=spo.spo_ubIllumination))) {
+      AddBandSpan(sb, &spo, bsTop.bs_xSpanStart, xRightI);
+    }
+    // remove all left-over polygons from stack
+    sb.sb_absStack.PopUntil(0);
+    // mark start of background span at right border
+    sb.sb_absStack[0].bs_xSpanStart = xRightI;
+  }
+
+  // generate span for far sentinel
+  AddBandSpan(sb, &re_spoFarSentinel, sb.sb_absStack[0].bs_xSpanStart, xRightI);
+}
+
+/*
+ * Compare two band edges for quick-sort.
+ */
+static int qsort_CompareBandEdgesI( const void *pv0, const void *pv1)
+{
+  const CBandEdge &be0 = *(const CBandEdge*)pv0;
+  const CBandEdge &be1 = *(const CBandEdge*)pv1;
+       if (be0.be_xI.slHolder<be1.be_xI.slHolder) return -1;
+  else if (be0.be_xI.slHolder>be1.be_xI.slHolder) return +1;
+  else if (be0.be_iOrder<be1.be_iOrder) return -1;
+  else if (be0.be_iOrder>be1.be_iOrder) return +1;
+  else                                  return  0;
+}
+static int qsort_CompareBandEdgesTopI( const void *pv0, const void *pv1)
+{
+  const CBandEdge &be0 = *(const CBandEdge*)pv0;
+  const CBandEdge &be1 = *(const CBandEdge*)pv1;
+       if (be0.be_iTopLine<be1.be_iTopLine) return -1;
+  else if (be0.be_iTopLine>be1.be_iTopLine) return +1;
+  else return qsort_CompareBandEdgesI(pv0, pv1);
+}
+
+/*
+ * Scan all lines of a band into spans.
+ * Only reads shared renderer data, so it can run in jobs for different bands at once.
+ */
+void CRenderer::ScanBand(CScanBand &sb)
+{
+  const INDEX iFirstScan = sb.sb_iFirstScan;
+  const INDEX iLastScan  = sb.sb_iFirstScan+sb.sb_ctScans-1;
+  sb.sb_abspSpans.PopAll();
+  sb.sb_aiFirstSpan.PopAll();
+  sb.sb_apspoPortals.PopAll();
+  sb.sb_ctEdgeTransitions = 0;
+
+  // start active list with left sentinel
+  sb.sb_abeActive.PopAll();   sb.sb_abeActive.SetAllocationStep(256);
+  sb.sb_abeActiveTmp.PopAll(); sb.sb_abeActiveTmp.SetAllocationStep(256);
+  sb.sb_abePending.PopAll();  sb.sb_abePending.SetAllocationStep(256);
+  CBandEdge &beLeft = sb.sb_abeActive.Push();
+  beLeft.be_xI = re_sedLeftSentinel.sed_xI;
+  beLeft.be_xIStep = FIX16_16(0);
+  beLeft.be_psedEdge = &re_sedLeftSentinel;
+  beLeft.be_iTopLine = 0;
+  beLeft.be_iBottomLine = MAX_SLONG;
+  beLeft.be_iOrder = -1;
+
+  // for each edge that crosses the band
+  const INDEX ctEdges = re_apsedBandEdges.Count();
+  for (INDEX ised=0; ised<ctEdges; ised++) {
+    CScreenEdge &sed = *re_apsedBandEdges[ised];
+    const INDEX iTopLine = sed.sed_pixTopJ-re_pixTopScanLineJ;
+    const INDEX iBottomLine = sed.sed_pixBottomJ-1-re_pixTopScanLineJ;
+    if (iBottomLine<iFirstScan || iTopLine>iLastScan) {
+      continue;
+    }
+    // if it starts above the band
+    CBandEdge *pbe;
+    if (iTopLine<iFirstScan) {
+      // it is active from band start, stepped to its first line
+      pbe = &sb.sb_abeActive.Push();
+      pbe->be_xI.slHolder = sed.sed_xI.slHolder + sed.sed_xIStep.slHolder*(iFirstScan-iTopLine);
+    // if it starts inside the band
+    } else {
+      // it waits to be added on its top line
+      pbe = &sb.sb_abePending.Push();
+      pbe->be_xI = sed.sed_xI;
+    }
+    pbe->be_xIStep = sed.sed_xIStep;
+    pbe->be_psedEdge = &sed;
+    pbe->be_iTopLine = iTopLine;
+    pbe->be_iBottomLine = iBottomLine;
+    pbe->be_iOrder = ised;
+  }
+  // sort active edges by I and pending edges by top line and I
+  if (sb.sb_abeActive.Count()>2) {
+    qsort(&sb.sb_abeActive[1], sb.sb_abeActive.Count()-1, sizeof(CBandEdge), qsort_CompareBandEdgesI);
+  }
+  if (sb.sb_abePending.Count()>1) {
+    qsort(&sb.sb_abePending[0], sb.sb_abePending.Count(), sizeof(CBandEdge), qsort_CompareBandEdgesTopI);
+  }
+  // end active list with right sentinel
+  CBandEdge &beRight = sb.sb_abeActive.Push();
+  beRight.be_xI = re_sedRightSentinel.sed_xI;
+  beRight.be_xIStep = FIX16_16(0);
+  beRight.be_psedEdge = &re_sedRightSentinel;
+  beRight.be_iTopLine = 0;
+  beRight.be_iBottomLine = MAX_SLONG;
+  beRight.be_iOrder = -1;
+
+  // for each scan line in band
+  INDEX ibePending = 0;
+  const INDEX ctPending = sb.sb_abePending.Count();
+  for (INDEX iScan=iFirstScan; iScan<=iLastScan; iScan++) {
+
+    // if some edges start on this scan line
+    if (ibePending<ctPending && sb.sb_abePending[ibePending].be_iTopLine==iScan) {
+      // merge them to active list, same as in AddAddListToActiveList()
+      const INDEX ctActive = sb.sb_abeActive.Count();
+      CBandEdge *pbeSrc = &sb.sb_abeActive[0];
+      CBandEdge *pbeEnd = &sb.sb_abeActive[ctActive-1];
+      sb.sb_abeActiveTmp.PopAll();
+      while (ibePending<ctPending && sb.sb_abePending[ibePending].be_iTopLine==iScan) {
+        const CBandEdge &beAdd = sb.sb_abePending[ibePending];
+        while ((pbeSrc->be_xI.slHolder < beAdd.be_xI.slHolder) && (pbeSrc!=pbeEnd)) {
+          sb.sb_abeActiveTmp.Push() = *pbeSrc++;
+        }
+        sb.sb_abeActiveTmp.Push() = beAdd;
+        ibePending++;
+      }
+      while (pbeSrc<=pbeEnd) {
+        sb.sb_abeActiveTmp.Push() = *pbeSrc++;
+      }
+      // swap the lists
+      Swap(sb.sb_abeActive.sa_Count    , sb.sb_abeActiveTmp.sa_Count    );
+      Swap(sb.sb_abeActive.sa_Array    , sb.sb_abeActiveTmp.sa_Array    );
+      Swap(sb.sb_abeActive.sa_UsedCount, sb.sb_abeActiveTmp.sa_UsedCount);
+    }
+
+    // scan list of active edges into spans
+    ScanBandLine(sb, iScan);
+
+    // remove all edges that stop on this scan line
+    CBandEdge *pbeEnd = &sb.sb_abeActive[sb.sb_abeActive.Count()-1];
+    CBandEdge *pbeSrc = &sb.sb_abeActive[1];
+    CBandEdge *pbeDst = pbeSrc;
+    do {
+      if (pbeSrc->be_iBottomLine!=iScan) {
+        *pbeDst++ = *pbeSrc;
+      }
+      pbeSrc++;
+    } while (pbeSrc<=pbeEnd);
+    sb.sb_abeActive.PopUntil(pbeDst-&sb.sb_abeActive[0]-1);
+
+    // step all remaining edges by one scan line and resort them, same as in StepAndResortActiveList()
+    CBandEdge *pbe = &sb.sb_abeActive[1];
+    pbeEnd = &sb.sb_abeActive[sb.sb_abeActive.Count()-1];
+    while (pbe<pbeEnd) {
+      pbe->be_xI.slHolder += pbe->be_xIStep.slHolder;
+      if (pbe[-1].be_xI.slHolder > pbe->be_xI.slHolder) {
+        CBandEdge *pbePred = pbe;
+        do {
+          pbePred--;
+        } while(pbePred->be_xI.slHolder > pbe->be_xI.slHolder);
+        CBandEdge beCurrent = *pbe;
+        CBandEdge *pbeMove = pbe-1;
+        do {
+          pbeMove[1] = pbeMove[0];
+          pbeMove--;
+        } while (pbeMove>pbePred);
+        pbeMove[1] = beCurrent;
+      }
+      pbe++;
+    }
+  }
+}
+
+// scan given range of bands that need scanning
+static void ScanBandsJob(void *pvRenderer, INDEX iFirst, INDEX iLast)
+{
+  CRenderer &re = *(CRenderer *)pvRenderer;
+  for (INDEX i=iFirst; i<iLast; i++) {
+    re.ScanBand(CRenderer::re_asbBands[CRenderer::re_aiBandsToScan[i]]);
+  }
+}
+
+/*
+ * Rasterize edges into spans, scanning bands of scan lines in parallel.
+ *
+ * Each band is scanned from its own copy of active edges and surface stack. Portals
+ * cannot be passed while bands are scanned, so portals encountered in all bands are
+ * passed afterwards, and bands that were affected by that are scanned again - until
+ * no band encounters a portal. Sectors behind portals are added for all scan lines
+ * (not just below the current one), so the result doesn't depend on scanning order
+ * or number of threads. Spans are then added to the scene in scan line order.
+ */
+void CRenderer::ScanEdgesInBands(INDEX ctBands)
+{
+  _pfRenderProfile.StartTimer(CRenderProfile::PTI_SCANEDGES);
+  // set up the sentinels
+  InitScanEdges();
+
+  // divide scan lines into bands
+  ctBands = Clamp(ctBands, (INDEX)2, Min((INDEX)ASER_MAXBANDS, re_ctScanLines/ASER_MINBANDSCANS));
+  if (re_asbBands.Count()<ASER_MAXBANDS) {
+    re_asbBands.Clear();
+    re_asbBands.New(ASER_MAXBANDS);
+  }
+  INDEX iBand;
+  for (iBand=0; iBand<ctBands; iBand++) {
+    CScanBand &sb = re_asbBands[iBand];
+    sb.sb_iFirstScan = iBand*re_ctScanLines/ctBands;
+    sb.sb_ctScans = (iBand+1)*re_ctScanLines/ctBands - sb.sb_iFirstScan;
+    sb.sb_bDirty = TRUE;
+  }
+
+  // portals are passed for entire screen height
+  re_iCurrentScan = 0;
+  re_pixCurrentScanJ = re_pixTopScanLineJ;
+  re_fCurrentScanJ = FLOAT(re_pixCurrentScanJ);
+
+  // gather all edges added so far
+  re_apsedBandEdges.PopAll();
+  re_apsedBandEdges.SetAllocationStep(1024);
+  INDEX ctGatheredEdges = 0;
+
+  FOREVER {
+    // gather newly added edges and mark bands that they cross as dirty
+    for (; ctGatheredEdges<re_asedScreenEdges.Count(); ctGatheredEdges++) {
+      CScreenEdge &sed = re_asedScreenEdges[ctGatheredEdges];
+      if (!sed.sed_bAdded) {
+        continue;
+      }
+      re_apsedBandEdges.Push() = &sed;
+      const INDEX iTopLine = sed.sed_pixTopJ-re_pixTopScanLineJ;
+      const INDEX iBottomLine = sed.sed_pixBottomJ-1-re_pixTopScanLineJ;
+      for (iBand=0; iBand<ctBands; iBand++) {
+        CScanBand &sb = re_asbBands[iBand];
+        if (iTopLine<sb.sb_iFirstScan+sb.sb_ctScans && iBottomLine>=sb.sb_iFirstScan) {
+          sb.sb_bDirty = TRUE;
+        }
+      }
+    }
+
+    // find bands to scan
+    re_aiBandsToScan.PopAll();
+    for (iBand=0; iBand<ctBands; iBand++) {
+      if (re_asbBands[iBand].sb_bDirty) {
+        re_aiBandsToScan.Push() = iBand;
+        re_asbBands[iBand].sb_bDirty = FALSE;
+      }
+    }
+    // stop if none
+    if (re_aiBandsToScan.Count()==0) {
+      break;
+    }
+
+    // scan them all in parallel
+    _pJobs->ParallelFor(ScanBandsJob, this, re_aiBandsToScan.Count(), 1);
+    _ctScanPasses++;
+
+    // for each portal encountered, in order of bands
+    for (INDEX iScanned=0; iScanned<re_aiBandsToScan.Count(); iScanned++) {
+      CScanBand &sb = re_asbBands[re_aiBandsToScan[iScanned]];
+      for (INDEX ipspo=0; ipspo<sb.sb_apspoPortals.Count(); ipspo++) {
+        CScreenPolygon &spo = *sb.sb_apspoPortals[ipspo];
+        // band has to be scanned again without it
+        sb.sb_bDirty = TRUE;
+        // add sectors near the portal if some other band didn't do it already
+        if (spo.spo_bActive) {
+          _pfRenderProfile.IncrementCounter(CRenderProfile::PCI_SCANLINEPORTALRETRIES);
+          PassPortal(spo);
+        }
+      }
+    }
+  }
+
+  // for each scan line, top to bottom
+  for (iBand=0; iBand<ctBands; iBand++) {
+    CScanBand &sb = re_asbBands[iBand];
+    _sfStats.IncrementCounter(CStatForm::SCI_EDGETRANSITIONS, sb.sb_ctEdgeTransitions);
+    _pfRenderProfile.IncrementCounter(CRenderProfile::PCI_EDGETRANSITIONS, sb.sb_ctEdgeTransitions);
+    for (INDEX iScanInBand=0; iScanInBand<sb.sb_ctScans; iScanInBand++) {
+      re_iCurrentScan = sb.sb_iFirstScan+iScanInBand;
+      re_pixCurrentScanJ = re_iCurrentScan + re_pixTopScanLineJ;
+      re_fCurrentScanJ = FLOAT(re_pixCurrentScanJ);
+      _pfRenderProfile.IncrementCounter(CRenderProfile::PCI_OVERALLSCANLINES);
+      // add its spans to their polygons
+      const INDEX ibspFirst = sb.sb_aiFirstSpan[iScanInBand];
+      const INDEX ibspLast = (iScanInBand+1<sb.sb_ctScans) ? sb.sb_aiFirstSpan[iScanInBand+1] : sb.sb_abspSpans.Count();
+      for (INDEX ibsp=ibspFirst; ibsp<ibspLast; ibsp++) {
+        const CBandSpan &bsp = sb.sb_abspSpans[ibsp];
+        AddSpanToPolygon(*bsp.bsp_pspo, bsp.bsp_pixI0, bsp.bsp_pixI1);
+      }
+    }
+  }
+
+  // add lists were not used up, so clear them
+  for (INDEX iScan=0; iScan<re_ctScanLines; iScan++) {
+    re_alhAddLists[iScan].Clear();
+    re_actAddCounts[iScan] = 0;
+  }
+
+  // clean up the surface stack and the sentinels
+  EndScanEdges();
+  _pfRenderProfile.StopTimer(CRenderProfile::PTI_SCANEDGES);
+}
@@ -48,8 +48,13 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Math/Geometry.inl>
 
 #include <Engine/Graphics/DrawPort.h>
+#include <Engine/Graphics/Raster.h>
 #include <Engine/Graphics/GfxLibrary.h>
 #include <Engine/Graphics/Fog_internal.h>
+#include <Engine/Network/Network.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/Jobs.h>
 
 #include <Engine/Base/Statistics_Internal.h>
 #include <Engine/Rendering/RenderProfile.h>
@@ -80,6 +85,7 @@ static CRenderer _areRenderers[MAX_RENDERERS];
 static BOOL _bMirrorDrawn = FALSE;
 
 extern INDEX wld_bAlwaysAddAll;
+extern INDEX wld_iASERBands;
 extern INDEX wld_bRenderEmptyBrushes;
 extern INDEX wld_bRenderDetailPolygons;
 extern INDEX gfx_bRenderParticles;
@@ -97,6 +103,11 @@ PIX2D _vpixSelectNearPoint = PIX2D(0,0);
 BOOL _bSelectAlternative   = FALSE;
 PIX _pixDeltaAroundVertex  = 10;
 
+// time spent scanning edges and number of passes in scanning bands (for benchmarking)
+static BOOL _bTimeScanEdges = FALSE;
+static CTimerValue _tvScanEdges;
+static INDEX _ctScanPasses = 0;
+
 // shading info for viewer of last rendered view
 FLOAT3D _vViewerLightDirection;
 COLOR _colViewerLight;
@@ -147,6 +158,9 @@ CStaticArray<INDEX> CRenderer::re_actAddCounts;   // count of edges in given add
 CStaticArray<CScreenEdge *> CRenderer::re_apsedRemoveFirst;
 CStaticStackArray<CActiveEdge>  CRenderer::re_aaceActiveEdgesTmp;
 CStaticStackArray<CActiveEdge>  CRenderer::re_aaceActiveEdges;
+CStaticArray<CScanBand> CRenderer::re_asbBands;
+CStaticStackArray<INDEX> CRenderer::re_aiBandsToScan;
+CStaticStackArray<CScreenEdge *> CRenderer::re_apsedBandEdges;
 
 // container for sorting translucent polygons
 CDynamicStackArray<CTranslucentPolygon> CRenderer::re_atcTranslucentPolygons;
@@ -186,6 +200,15 @@ void RendererInfo(void)
   slMem += CRenderer::re_atcTranslucentPolygons.da_Count*sizeof(CTranslucentPolygon);
   slMem += CRenderer::re_aaceActiveEdges.sa_Count*sizeof(CActiveEdge);
   slMem += CRenderer::re_aaceActiveEdgesTmp.sa_Count*sizeof(CActiveEdge);
+  slMem += CRenderer::re_apsedBandEdges.sa_Count*sizeof(CScreenEdge *);
+  for (INDEX isb = 0; isb<CRenderer::re_asbBands.Count(); isb++) {
+    CScanBand &sb = CRenderer::re_asbBands[isb];
+    slMem += (sb.sb_abeActive.sa_Count+sb.sb_abeActiveTmp.sa_Count+sb.sb_abePending.sa_Count)*sizeof(CBandEdge);
+    slMem += (sb.sb_absStack.sa_Count+sb.sb_absAside.sa_Count)*sizeof(CBandSurface);
+    slMem += sb.sb_abspSpans.sa_Count*sizeof(CBandSpan);
+    slMem += sb.sb_aiFirstSpan.sa_Count*sizeof(INDEX);
+    slMem += sb.sb_apspoPortals.sa_Count*sizeof(CScreenPolygon *);
+  }
 
   for (INDEX ire = 0; ire<MAX_RENDERERS; ire++) {
     CRenderer &re = _areRenderers[ire];
@@ -217,6 +240,9 @@ void ClearRenderer(void)
   CRenderer::re_atcTranslucentPolygons.Clear();
   CRenderer::re_aaceActiveEdges.Clear();
   CRenderer::re_aaceActiveEdgesTmp.Clear();
+  CRenderer::re_asbBands.Clear();
+  CRenderer::re_aiBandsToScan.Clear();
+  CRenderer::re_apsedBandEdges.Clear();
 
   for (INDEX ire = 0; ire<MAX_RENDERERS; ire++) {
     CRenderer &re = _areRenderers[ire];
@@ -233,6 +259,148 @@ void ClearRenderer(void)
   CPrintF("Renderer buffers cleared.\n");
 }
 
+// gather camera path for render benchmarks and switch to null gfx device
+static BOOL StartRenderBenchmark(CDynamicContainer<CEntity> &cenPath, GfxAPIType &eOldAPI)
+{
+  CWorld &wo = _pNetwork->ga_World;
+  // camera path goes thru all models in the world, turning around at each one
+  {FOREACHINDYNAMICCONTAINER( wo.wo_cenEntities, CEntity, iten) {
+    if( iten->en_RenderType==CEntity::RT_MODEL || iten->en_RenderType==CEntity::RT_SKAMODEL) {
+      cenPath.Add(iten);
+    }
+  }}
+  if( cenPath.Count()==0) {
+    CPrintF("No world with models loaded.\n");
+    return FALSE;
+  }
+  // switching device would lose full screen mode
+  eOldAPI = _pGfx->gl_eCurrentAPI;
+  if( eOldAPI!=GAT_NULL && (_pGfx->gl_ulFlags&GLF_FULLSCREEN)) {
+    CPrintF("Cannot run render benchmark in full screen mode.\n");
+    return FALSE;
+  }
+  if( eOldAPI!=GAT_NULL && !_pGfx->ResetDisplayMode(GAT_NULL)) {
+    CPrintF("Cannot start null gfx device.\n");
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// render frames along the camera path and return time per frame (counters are reset on start)
+static DOUBLE RenderBenchmarkPath(CDynamicContainer<CEntity> &cenPath, INDEX ctFrames)
+{
+  CWorld &wo = _pNetwork->ga_World;
+  CRaster raBenchmark( 640, 480, 0);
+  CDrawPort &dp = raBenchmark.ra_MainDrawPort;
+  CPerspectiveProjection3D prPerspective;
+  prPerspective.FOVL() = AngleDeg(90.0f);
+  prPerspective.AspectRatioL() = 1.0f;
+  prPerspective.FrontClipDistanceL() = 0.3f;
+  prPerspective.ObjectPlacementL() = CPlacement3D( FLOAT3D(0,0,0), ANGLE3D(0,0,0));
+  CAnyProjection3D apr;
+  apr = prPerspective;
+
+  // render one frame to warm up caches and upload textures, then start counting
+  INDEX iFrame = -1;
+  CTimerValue tvStart;
+  for( ; iFrame<ctFrames; iFrame++) {
+    if( iFrame==0) {
+      memset( &GFX_ncCounters, 0, sizeof(GFX_ncCounters));
+      _tvScanEdges.Clear();
+      _ctScanPasses = 0;
+      tvStart = _pTimer->GetHighPrecisionTimer();
+    }
+    const INDEX iFrameOnPath = Max( iFrame, (INDEX)0);
+    CEntity &enViewer = cenPath[ iFrameOnPath*cenPath.Count()/ctFrames];
+    const FLOAT fHeading = iFrameOnPath*360.0f*cenPath.Count()/ctFrames;
+    apr->ViewerPlacementL() = CPlacement3D( enViewer.GetPlacement().pl_PositionVector+FLOAT3D(0,1.5f,0),
+                                            ANGLE3D( fHeading, 0, 0));
+    if( dp.Lock()) {
+      RenderView( wo, enViewer, apr, dp);
+      dp.Unlock();
+    }
+    _pGfx->SwapBuffers(NULL);
+  }
+  return (_pTimer->GetHighPrecisionTimer()-tvStart).GetSeconds()/ctFrames;
+}
+
+// render current world thru null gfx device from a fixed camera path and print per-frame costs
+void RenderBenchmark(void *pArgs)
+{
+  INDEX ctFrames = NEXTARGUMENT(INDEX);
+  ctFrames = Clamp( ctFrames, (INDEX)1, (INDEX)100000);
+  CDynamicContainer<CEntity> cenPath;
+  GfxAPIType eOldAPI;
+  if( !StartRenderBenchmark( cenPath, eOldAPI)) {
+    return;
+  }
+  const DOUBLE dFrameTime = RenderBenchmarkPath( cenPath, ctFrames);
+
+  const GfxNullCounters &nc = GFX_ncCounters;
+  CPrintF("Render benchmark, %d frames thru %d models:\n", ctFrames, cenPath.Count());
+  CPrintF("  %-16s %9.3f ms\n", "frame time:", dFrameTime*1000.0);
+  CPrintF("  %-16s %9.1f\n", "draw calls:",    nc.nc_ctDrawCalls   /(DOUBLE)ctFrames);
+  CPrintF("  %-16s %9.1f\n", "triangles:",     nc.nc_ctElements/3  /(DOUBLE)ctFrames);
+  CPrintF("  %-16s %9.1f\n", "vertices:",      nc.nc_ctVertices    /(DOUBLE)ctFrames);
+  CPrintF("  %-16s %9.1f\n", "state changes:", nc.nc_ctStateChanges/(DOUBLE)ctFrames);
+  CPrintF("  %-16s %9.1f\n", "texture binds:", nc.nc_ctTextureBinds/(DOUBLE)ctFrames);
+  CPrintF("  (all per frame)\n");
+  memset( &GFX_ncCounters, 0, sizeof(GFX_ncCounters));
+
+  // back to previous device
+  if( eOldAPI!=GAT_NULL) _pGfx->ResetDisplayMode(eOldAPI);
+}
+
+// render current world from the benchmark camera path, scanning edges serially
+// and then in bands on more and more threads, and print time spent in scanning
+void ASERBenchmark(void *pArgs)
+{
+  INDEX ctFrames = NEXTARGUMENT(INDEX);
+  ctFrames = Clamp( ctFrames, (INDEX)1, (INDEX)100000);
+  if( _pJobs==NULL) {
+    return;
+  }
+  CDynamicContainer<CEntity> cenPath;
+  GfxAPIType eOldAPI;
+  if( !StartRenderBenchmark( cenPath, eOldAPI)) {
+    return;
+  }
+  const INDEX iOldBands = wld_iASERBands;
+  const INDEX ctOldWorkers = _pJobs->js_ctWorkers;
+  const INDEX ctMaxWorkers = Max( ThreadGetCPUCount()-1, (INDEX)1);
+  const INDEX ctBands = (iOldBands>1) ? iOldBands : 16;
+  _bTimeScanEdges = TRUE;
+  CPrintF("ASER benchmark, %d frames thru %d models, %d bands:\n", ctFrames, cenPath.Count(), ctBands);
+
+  // serial scanning first
+  wld_iASERBands = 0;
+  DOUBLE dFrameTime = RenderBenchmarkPath( cenPath, ctFrames);
+  const DOUBLE dSerial = _tvScanEdges.GetSeconds()/ctFrames;
+  CPrintF("      serial: %8.3f ms scan %8.3f ms frame\n", dSerial*1000.0, dFrameTime*1000.0);
+
+  // then in bands
+  wld_iASERBands = ctBands;
+  for( INDEX ctWorkers=0; ctWorkers<=ctMaxWorkers; ctWorkers = (ctWorkers==0) ? 1 : ctWorkers*2) {
+    _pJobs->StopWorkers();
+    _pJobs->StartWorkers( Min( ctWorkers, ctMaxWorkers));
+    dFrameTime = RenderBenchmarkPath( cenPath, ctFrames);
+    const DOUBLE dScan = _tvScanEdges.GetSeconds()/ctFrames;
+    CPrintF("  %2d threads: %8.3f ms scan %8.3f ms frame  (%.2fx, %.1f passes)\n", _pJobs->GetThreadCount(),
+      dScan*1000.0, dFrameTime*1000.0, dScan>0 ? dSerial/dScan : 1.0, _ctScanPasses/(DOUBLE)ctFrames);
+    if( ctWorkers>=ctMaxWorkers) {
+      break;
+    }
+  }
+
+  // restore settings and previous device
+  _bTimeScanEdges = FALSE;
+  wld_iASERBands = iOldBands;
+  _pJobs->StopWorkers();
+  _pJobs->StartWorkers( ctOldWorkers);
+  memset( &GFX_ncCounters, 0, sizeof(GFX_ncCounters));
+  if( eOldAPI!=GAT_NULL) _pGfx->ResetDisplayMode(eOldAPI);
+}
+
 /*
  * How much to offset left, right, top and bottom clipping towards inside (in pixels).
  * This can be used to test clipping or to add an epsilon value for it.
@@ -447,7 +615,10 @@ void CRenderer::ScanForOtherSectors(void)
   if (re_bRenderingShadows
     ||_wrpWorldRenderPrefs.wrp_ftPolygons != CWorldRenderPrefs::FT_NONE) {
     // rasterize edges into spans
+    CTimerValue tvScanStart;
+    if (_bTimeScanEdges) tvScanStart = _pTimer->GetHighPrecisionTimer();
     ScanEdges();
+    if (_bTimeScanEdges) _tvScanEdges += _pTimer->GetHighPrecisionTimer()-tvScanStart;
   }
   // for each of models that were kept for delayed rendering
   for(INDEX iModel=0; iModel<re_admDelayedModels.Count(); iModel++) {
@@ -189,6 +189,61 @@ public:
   inline void Clear(void) {};
 };
 
+/*
+ * Structures used for scanning bands of scan lines in parallel.
+ * Each band keeps its own copies of everything that ASER changes while scanning,
+ * so that bands never write to edges or polygons shared with other bands.
+ */
+#define ASER_MAXBANDS     64  // maximum number of bands
+#define ASER_MINBANDSCANS 8   // minimum number of scan lines in one band
+
+// edge in active list of one band
+class CBandEdge {
+public:
+  FIX16_16 be_xI;             // I coordinate on current scan line
+  FIX16_16 be_xIStep;         // I coordinate step per scan line
+  CScreenEdge *be_psedEdge;   // the edge
+  INDEX be_iTopLine;          // first and last scan line of the edge
+  INDEX be_iBottomLine;
+  INDEX be_iOrder;            // order in which the edge was added (for sorting)
+};
+
+// polygon in surface stack of one band
+class CBandSurface {
+public:
+  CScreenPolygon *bs_pspo;    // the polygon
+  INDEX bs_ctInStack;         // in-stack counter
+  FIX16_16 bs_xSpanStart;     // I coordinate where its current span starts
+};
+
+// span generated in one band
+class CBandSpan {
+public:
+  CScreenPolygon *bsp_pspo;   // polygon of this span
+  PIX bsp_pixI0;              // span start and stop I
+  PIX bsp_pixI1;
+};
+
+// one band of scan lines
+class CScanBand {
+public:
+  INDEX sb_iFirstScan;        // first scan line in band
+  INDEX sb_ctScans;           // number of scan lines in band
+  BOOL  sb_bDirty;            // set if band must be scanned (again)
+  INDEX sb_ctEdgeTransitions; // edge transitions counted in last scanning
+
+  CStaticStackArray<CBandEdge> sb_abeActive;    // active edges for current scan line
+  CStaticStackArray<CBandEdge> sb_abeActiveTmp;
+  CStaticStackArray<CBandEdge> sb_abePending;   // edges that start inside the band, sorted
+  CStaticStackArray<CBandSurface> sb_absStack;  // surface stack - far sentinel first, top last
+  CStaticStackArray<CBandSurface> sb_absAside;  // polygons with negative in-stack counters
+  CStaticStackArray<CBandSpan> sb_abspSpans;    // spans of all scan lines in band
+  CStaticStackArray<INDEX> sb_aiFirstSpan;      // index of first span for each scan line
+  CStaticStackArray<CScreenPolygon *> sb_apspoPortals; // portals encountered while scanning
+
+  CScanBand(void) : sb_iFirstScan(0), sb_ctScans(0), sb_bDirty(FALSE), sb_ctEdgeTransitions(0) {};
+};
+
 /* We must declare dummy clear functions for external classes that
  * get stored in dynamic stack arrays.
  */
@@ -364,6 +419,11 @@ public:
   static CStaticStackArray<CActiveEdge> re_aaceActiveEdges; // active edges for current scan line
   static CStaticStackArray<CActiveEdge> re_aaceActiveEdgesTmp;
 
+  // bands for scanning in parallel
+  static CStaticArray<CScanBand> re_asbBands;
+  static CStaticStackArray<INDEX> re_aiBandsToScan;             // bands scanned in current pass
+  static CStaticStackArray<CScreenEdge *> re_apsedBandEdges;    // all added edges, in order of adding
+
   INDEX re_iCurrentScan;            // index of current scan line in tables
   PIX re_pixCurrentScanJ;           // J coordinate of current scan line
   FLOAT re_fCurrentScanJ;
@@ -455,6 +515,8 @@ public:
 
   /* Generate a span for a polygon on current scan line. */
   inline void MakeSpan(CScreenPolygon &spo, CScreenEdge *psed0, CScreenEdge *psed1);
+  /* Add a span of a polygon on current scan line to the polygon in view. */
+  inline void AddSpanToPolygon(CScreenPolygon &spo, PIX pixI0, PIX pixI1);
 
   /* Add spans in current line to scene. */
   void AddSpansToScene(void);
@@ -483,6 +545,16 @@ public:
   /* Rasterize edges into spans. */
   void ScanEdges(void);
 
+  /* Add polygon to/remove polygon from surface stack of a band. */
+  inline BOOL AddPolygonToBandStack(CScanBand &sb, CScreenPolygon &spo, FIX16_16 xI, FLOAT fScanJ);
+  inline BOOL RemPolygonFromBandStack(CScanBand &sb, CScreenPolygon &spo);
+  /* Scan one line of a band into spans. */
+  inline void ScanBandLine(CScanBand &sb, INDEX iScan);
+  /* Scan all lines of a band into spans (called from jobs). */
+  void ScanBand(CScanBand &sb);
+  /* Rasterize edges into spans, scanning bands of scan lines in parallel. */
+  void ScanEdgesInBands(INDEX ctBands);
+
   /* Render wireframe brushes. */
   void RenderWireFrameBrushes(void);
   /* Find lights for one model. */
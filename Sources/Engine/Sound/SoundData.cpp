@@ -18,6 +18,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Sound/SoundData.h>
 
 #include <Engine/Base/Memory.h>
+#include <Engine/Base/Allocator.h>
 #include <Engine/Base/Stream.h>
 #include <Engine/Base/ListIterator.inl>
 #include <Engine/Sound/Wave.h>
@@ -168,7 +169,7 @@ void CSoundData::Read_t(CTStream *inFile)  // throw char *
       // create Buffer
       sd_slBufferSampleSize = CpwiLoad.GetDataLength(sd_wfeFormat);
       SLONG slBufferSize = CpwiLoad.DetermineBufferSize(sd_wfeFormat);
-      sd_pswBuffer = (SWORD*)AllocMemory( slBufferSize+8);
+      sd_pswBuffer = (SWORD*)AllocMemoryTagged( slBufferSize+8, MTG_SOUND);
       // load data into buffer
       CpwiLoad.LoadData_t( inFile, sd_pswBuffer, sd_wfeFormat);
       // copy first sample to the last one (this is needed for linear interpolation)
@@ -24,6 +24,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/Translation.h>
 #include <Engine/Math/Functions.h>
 #include <Engine/Base/DynamicLoader.h>
+#include <Engine/Base/Threading.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Allocator.h>
+#include <Engine/Base/ListIterator.inl>
+#include <Engine/Sound/SoundProfile.h>
 
 // generic function called if a dll function is not found
 static void FailFunction_t(const char *strName) {
@@ -203,6 +208,133 @@ static ov_callbacks ovcCallbacks = {
 };
 
 
+// ------------------------------------ Decoding ahead
+
+extern INDEX snd_bStreamAhead;
+
+// streams that decoding thread fills ahead of mixer
+static CListHead _lhStreams;
+static volatile SLONG _slStreamsLock = 0;  // guards list of streams (never held while decoding)
+static INDEX _iNextStream = 0;             // round-robin position in list (decoding thread only)
+static void *_pvStreamThread = NULL;
+static void *_pvStreamWakeUp = NULL;       // signaled when there may be something to decode
+static volatile SLONG _bStreamThreadStop = FALSE;
+
+// statistics (since last reset)
+static volatile SLONG _ctStreamUnderruns = 0;   // decodings that found ring buffer empty
+static volatile SLONG _ctChunksAhead = 0;       // chunks decoded by decoding thread
+static volatile SLONG _ctChunksInMixer = 0;     // chunks that mixer had to decode by itself
+
+static inline void LockStreams(void)
+{
+  while (AtomicCompareExchange(&_slStreamsLock, 1, 0)!=0) {
+    ThreadYield();
+  }
+}
+
+static inline void UnlockStreams(void)
+{
+  AtomicRelease(&_slStreamsLock);
+}
+
+// give one chunk to each stream that has room for it, returns TRUE if anything was decoded
+// (list is locked only while picking a stream, so that starting/stopping a stream never waits for decoding)
+static BOOL DecodeStreamsAhead(void)
+{
+  BOOL bDecoded = FALSE;
+  LockStreams();
+  const INDEX ctStreams = _lhStreams.Count();
+  UnlockStreams();
+  for (INDEX iStream=0; iStream<ctStreams; iStream++) {
+    // pick next stream after the one decoded last time, so each one gets its turn
+    // (list is linked and unlinked only by game thread, so this thread just walks it)
+    LockStreams();
+    const INDEX ctNow = _lhStreams.Count();
+    if (ctNow==0) {
+      UnlockStreams();
+      break;
+    }
+    _iNextStream = (_iNextStream+1)%ctNow;
+    CSoundDecoder *psdc = NULL;
+    INDEX iCurrent = 0;
+    {FOREACHINLIST(CSoundDecoder, sdc_lnInStreams, _lhStreams, itsdc) {
+      if (iCurrent++==_iNextStream) {
+        psdc = itsdc;
+        break;
+      }
+    }}
+    CSoundDecoder &sdc = *psdc;
+    // skip if mixer is decoding it or it is being cleared
+    // (holding its ring lock keeps it from being cleared after list is unlocked)
+    const BOOL bLocked = AtomicCompareExchange(&sdc.sdc_slRingLock, 1, 0)==0;
+    UnlockStreams();
+    if (!bLocked) {
+      continue;
+    }
+    if (sdc.FillRing()>0) {
+      AtomicAdd(&_ctChunksAhead, 1);
+      bDecoded = TRUE;
+    }
+    AtomicRelease(&sdc.sdc_slRingLock);
+  }
+  return bDecoded;
+}
+
+static void StreamDecodingThread(void *pvParam)
+{
+  while (!AtomicLoad(&_bStreamThreadStop)) {
+    // if there was nothing to decode
+    if (!DecodeStreamsAhead()) {
+      // wait until mixer takes something or a new stream starts
+      SemaphoreWait(_pvStreamWakeUp);
+    }
+  }
+}
+
+static void StartStreamThread(void)
+{
+  if (_pvStreamThread!=NULL) {
+    return;
+  }
+  _bStreamThreadStop = FALSE;
+  _pvStreamWakeUp = SemaphoreCreate(0);
+  _pvStreamThread = ThreadCreate(StreamDecodingThread, NULL);
+  if (_pvStreamThread==NULL) {
+    SemaphoreDestroy(_pvStreamWakeUp);
+    _pvStreamWakeUp = NULL;
+  }
+}
+
+static void StopStreamThread(void)
+{
+  if (_pvStreamThread==NULL) {
+    return;
+  }
+  AtomicStore(&_bStreamThreadStop, TRUE);
+  SemaphoreSignal(_pvStreamWakeUp, 1);
+  ThreadJoin(_pvStreamThread);
+  _pvStreamThread = NULL;
+  SemaphoreDestroy(_pvStreamWakeUp);
+  _pvStreamWakeUp = NULL;
+}
+
+// print statistics of streams decoded ahead (and reset them)
+void SoundStreamStats(void)
+{
+  INDEX ctStreams = 0;
+  LockStreams();
+  {FOREACHINLIST(CSoundDecoder, sdc_lnInStreams, _lhStreams, itsdc) {
+    ctStreams++;
+  }}
+  UnlockStreams();
+  CPrintF(TRANS("Sound streams decoded ahead: %d (thread %s)\n"), ctStreams,
+    _pvStreamThread!=NULL ? TRANS("running") : TRANS("not running"));
+  CPrintF("  underruns:          %8d\n", AtomicExchange(&_ctStreamUnderruns, 0));
+  CPrintF("  chunks ahead:       %8d\n", AtomicExchange(&_ctChunksAhead, 0));
+  CPrintF("  chunks in mixer:    %8d\n", AtomicExchange(&_ctChunksInMixer, 0));
+}
+
+
 // initialize/end the decoding support engine(s)
 void CSoundDecoder::InitPlugins(void)
 {
@@ -260,6 +392,9 @@ void CSoundDecoder::InitPlugins(void)
 
 void CSoundDecoder::EndPlugins(void)
 {
+  // no more decoding ahead
+  StopStreamThread();
+
   // cleanup amp11lib when not needed anymore
   if (_bAMP11Enabled) {
     palEndLibrary();
@@ -283,6 +418,12 @@ CSoundDecoder::CSoundDecoder(const CTFileName &fnm)
 {
   sdc_pogg = NULL;
   sdc_pmpeg = NULL;
+  sdc_pubRing = NULL;
+  sdc_bLoop = FALSE;
+  sdc_slWritten = 0;
+  sdc_slRead = 0;
+  sdc_bEnded = FALSE;
+  sdc_slRingLock = 0;
 
   CTFileName fnmExpanded;
   INDEX iFileType = ExpandFilePath(EFP_READ, fnm, fnmExpanded);
@@ -505,6 +646,23 @@ CSoundDecoder::~CSoundDecoder(void)
 
 void CSoundDecoder::Clear(void)
 {
+  // stop decoding ahead (once ring lock is held, decoding thread is done with this stream,
+  // and after it is unlinked, thread can't pick it again; only game thread links streams,
+  // so checking the link here needs no lock)
+  if (sdc_lnInStreams.IsLinked()) {
+    while (AtomicCompareExchange(&sdc_slRingLock, 1, 0)!=0) {
+      ThreadYield();
+    }
+    LockStreams();
+    sdc_lnInStreams.Remove();
+    UnlockStreams();
+    AtomicRelease(&sdc_slRingLock);
+  }
+  if (sdc_pubRing!=NULL) {
+    FreeMemory(sdc_pubRing);
+    sdc_pubRing = NULL;
+  }
+
   if (sdc_pmpeg!=NULL) {
     if (sdc_pmpeg->mpeg_hDecoder!=0)  palClose(sdc_pmpeg->mpeg_hDecoder);
     if (sdc_pmpeg->mpeg_hFile!=0)     palClose(sdc_pmpeg->mpeg_hFile);
@@ -532,8 +690,82 @@ void CSoundDecoder::Clear(void)
   }
 }
 
+// start decoding ahead in background (call right after opening, before any decoding)
+void CSoundDecoder::StartStreaming(BOOL bLoop)
+{
+  ASSERT(sdc_pubRing==NULL && sdc_slRead==0);
+  sdc_bLoop = bLoop;
+  if (!snd_bStreamAhead || !IsOpen()) {
+    return;
+  }
+  StartStreamThread();
+  if (_pvStreamThread==NULL) {
+    return;
+  }
+  sdc_pubRing = (UBYTE*)AllocMemoryTagged(SDC_RINGSIZE, MTG_SOUND);
+  // add to streams and wake up the thread to prefetch it before mixer asks for it
+  LockStreams();
+  _lhStreams.AddTail(sdc_lnInStreams);
+  UnlockStreams();
+  SemaphoreSignal(_pvStreamWakeUp, 1);
+}
+
+
+// decode next chunk into ring buffer (ring lock must be held), returns bytes decoded
+INDEX CSoundDecoder::FillRing(void)
+{
+  if (sdc_bEnded) {
+    return 0;
+  }
+  // decode as much as there is room for, but not across end of ring
+  const ULONG ulWritten = (ULONG)sdc_slWritten;
+  const INDEX iOffset = ulWritten&(SDC_RINGSIZE-1);
+  INDEX ctToDecode = SDC_RINGSIZE-(INDEX)(ulWritten-(ULONG)AtomicLoad(&sdc_slRead));
+  ctToDecode = Min(ctToDecode, (INDEX)SDC_CHUNKSIZE);
+  ctToDecode = Min(ctToDecode, SDC_RINGSIZE-iOffset);
+  ctToDecode &= ~3;  // whole stereo samples only
+  if (ctToDecode<=0) {
+    return 0;
+  }
+  INDEX ctDecoded = DecodeDirect(sdc_pubRing+iOffset, ctToDecode);
+  // if stream came to end, restart it if looping
+  if (ctDecoded<=0 && sdc_bLoop) {
+    ResetDirect();
+    ctDecoded = DecodeDirect(sdc_pubRing+iOffset, ctToDecode);
+  }
+  // if nothing more, mark end after everything that was written
+  if (ctDecoded<=0) {
+    AtomicStore(&sdc_bEnded, TRUE);
+    return 0;
+  }
+  AtomicStore(&sdc_slWritten, (SLONG)(ulWritten+ctDecoded));
+  return ctDecoded;
+}
+
+
 // reset decoder to start of sample
 void CSoundDecoder::Reset(void)
+{
+  // if decoded ahead, throw away what was decoded and restart
+  if (sdc_pubRing!=NULL) {
+    while (AtomicCompareExchange(&sdc_slRingLock, 1, 0)!=0) {
+      ThreadYield();
+    }
+    ResetDirect();
+    AtomicStore(&sdc_slRead, sdc_slWritten);
+    AtomicStore(&sdc_bEnded, FALSE);
+    AtomicRelease(&sdc_slRingLock);
+    if (_pvStreamWakeUp!=NULL) {
+      SemaphoreSignal(_pvStreamWakeUp, 1);
+    }
+    return;
+  }
+  ResetDirect();
+}
+
+
+// reset decoder to start of sample (no ring buffer)
+void CSoundDecoder::ResetDirect(void)
 {
   if (sdc_pmpeg!=NULL) {
     palDecSeekAbs(sdc_pmpeg->mpeg_hDecoder, 0.0f);
@@ -571,11 +803,67 @@ void CSoundDecoder::GetFormat(WAVEFORMATEX &wfe)
 
 // decode a block of bytes
 INDEX CSoundDecoder::Decode(void *pvDestBuffer, INDEX ctBytesToDecode)
+{
+  // if decoded in place
+  if (sdc_pubRing==NULL) {
+    return DecodeDirect(pvDestBuffer, ctBytesToDecode);
+  }
+
+  UBYTE *pubDest = (UBYTE *)pvDestBuffer;
+  INDEX ctDone = 0;
+  BOOL bUnderrun = FALSE;
+  while (ctDone<ctBytesToDecode) {
+    // (check end before getting written size, so that nothing written before end is missed)
+    const BOOL bEnded = AtomicLoad(&sdc_bEnded);
+    const ULONG ulWritten = (ULONG)AtomicLoad(&sdc_slWritten);
+    const ULONG ulRead = (ULONG)sdc_slRead;
+    const INDEX ctAvailable = Min((INDEX)(ulWritten-ulRead), ctBytesToDecode-ctDone);
+    // if there is something in ring
+    if (ctAvailable>0) {
+      // copy it out (in two parts if it wraps around)
+      const INDEX iOffset = ulRead&(SDC_RINGSIZE-1);
+      const INDEX ctFirst = Min(ctAvailable, SDC_RINGSIZE-iOffset);
+      memcpy(pubDest+ctDone, sdc_pubRing+iOffset, ctFirst);
+      memcpy(pubDest+ctDone+ctFirst, sdc_pubRing, ctAvailable-ctFirst);
+      ctDone += ctAvailable;
+      // hand the space back to decoding thread
+      AtomicStore(&sdc_slRead, (SLONG)(ulRead+ctAvailable));
+      continue;
+    }
+    // if stream has ended, that's all
+    if (bEnded) {
+      break;
+    }
+    // decoding thread didn't keep up, so decode here
+    if (!bUnderrun) {
+      bUnderrun = TRUE;
+      AtomicAdd(&_ctStreamUnderruns, 1);
+      _pfSoundProfile.IncrementCounter(CSoundProfile::PCI_STREAMUNDERRUNS, 1);
+    }
+    while (AtomicCompareExchange(&sdc_slRingLock, 1, 0)!=0) {
+      ThreadYield();
+    }
+    if (FillRing()>0) {
+      AtomicAdd(&_ctChunksInMixer, 1);
+    }
+    AtomicRelease(&sdc_slRingLock);
+  }
+
+  // let decoding thread refill what was taken
+  if (_pvStreamWakeUp!=NULL) {
+    SemaphoreSignal(_pvStreamWakeUp, 1);
+  }
+  return ctDone;
+}
+
+
+// decode a block of bytes in place (no ring buffer)
+INDEX CSoundDecoder::DecodeDirect(void *pvDestBuffer, INDEX ctBytesToDecode)
 {
   // if ogg
   if (sdc_pogg!=NULL && sdc_pogg->ogg_vfVorbisFile!=0) {
     // decode ogg
-    static int iCurrrentSection = -1; // we don't care about this
+    int iCurrrentSection = -1; // we don't care about this (not static, streams are decoded from two threads)
     char *pch = (char *)pvDestBuffer;
     INDEX ctDecoded = 0;
     while (ctDecoded<ctBytesToDecode) {
@@ -19,11 +19,28 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #pragma once
 #endif
 
+#include <Engine/Base/Lists.h>
+
+// ring buffer of a stream decoded ahead by decoding thread (must be power of 2)
+#define SDC_RINGSIZE  (256*1024)
+// how much is decoded into ring buffer at once
+#define SDC_CHUNKSIZE (16*1024)
+
 class CSoundDecoder {
 public:
   class CDecodeData_MPEG *sdc_pmpeg;
   class CDecodeData_OGG  *sdc_pogg ;
 
+  // streams decoded ahead are read from ring buffer; decoding thread is the only one that
+  // fills it, unless mixer runs out of data and decodes by itself (under ring lock)
+  CListNode sdc_lnInStreams;      // for linking in list of streams decoded ahead
+  UBYTE *sdc_pubRing;             // NULL if stream is decoded in place
+  BOOL   sdc_bLoop;               // restart stream when it ends
+  volatile SLONG sdc_slWritten;   // total bytes put into ring (wraps around)
+  volatile SLONG sdc_slRead;      // total bytes taken from ring (wraps around)
+  volatile SLONG sdc_bEnded;      // set when stream has ended (nothing more will be written)
+  volatile SLONG sdc_slRingLock;  // taken while decoding into ring
+
   // initialize/end the decoding support engine(s)
   static void InitPlugins(void);
   static void EndPlugins(void);
@@ -38,11 +55,22 @@ public:
   // get wave format of the decoder (invaid if it is not open)
   void GetFormat(WAVEFORMATEX &wfe);
 
+  // start decoding ahead in background (call right after opening, before any decoding)
+  void StartStreaming(BOOL bLoop);
   // decode a block of bytes
   INDEX Decode(void *pvDestBuffer, INDEX ctBytesToDecode);
   // reset decoder to start of sample
   void Reset(void);
+
+  // decode in place (no ring buffer)
+  INDEX DecodeDirect(void *pvDestBuffer, INDEX ctBytesToDecode);
+  void ResetDirect(void);
+  // decode next chunk into ring buffer (ring lock must be held), returns bytes decoded
+  INDEX FillRing(void);
 };
 
+// print statistics of streams decoded ahead (and reset them)
+void SoundStreamStats(void);
+
 #endif  /* include-once check. */
 
@@ -44,6 +44,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Sound/SoundData.h>
 #include <Engine/Sound/SoundObject.h>
 #include <Engine/Sound/SoundDecoder.h>
+#include <Engine/Base/Allocator.h>
 #include <Engine/Network/Network.h>
 
 #include <Engine/Templates/StaticArray.cpp>
@@ -88,9 +89,15 @@ static INDEX snd_iMaxExtraChannels = 32;
 static FLOAT snd_tmOpenFailDelay = 0.5f;
 static FLOAT snd_fEAXPanning = 0.0f;
 
-static FLOAT snd_fNormalizer = 0.9f;
+FLOAT snd_fNormalizer = 0.9f;
+INDEX snd_bFloatMixer = TRUE;       // mix in floats instead of 32-bit integers
+FLOAT snd_fMixCullVolume = 0.001f;  // sounds quieter than this are skipped (not mixed)
+INDEX snd_bStreamAhead = TRUE;      // decode ogg/mpx streams ahead in a background thread
 static FLOAT _fLastNormalizeValue = 1;
 
+// render scripted sounds to wave file (see SoundRender.cpp)
+extern void SoundRender(void *pArgs);
+
 #ifdef PLATFORM_WIN32
 extern HWND  _hwndMain; // global handle for application window
 static HWND  _hwndCurrent = NULL;
@@ -256,7 +263,7 @@ static BOOL StartUp_SDLaudio( CSoundLibrary &sl, BOOL bReport=TRUE)
 
   sdl_silence = obtained.silence;
   sdl_backbuffer_allocation = (obtained.size * 4);
-  sdl_backbuffer = (Uint8 *)AllocMemory(sdl_backbuffer_allocation);
+  sdl_backbuffer = (Uint8 *)AllocMemoryTagged(sdl_backbuffer_allocation, MTG_SOUND);
   sdl_backbuffer_remain = 0;
   sdl_backbuffer_pos = 0;
 
@@ -286,8 +293,8 @@ static BOOL StartUp_SDLaudio( CSoundLibrary &sl, BOOL bReport=TRUE)
   }
 
   // initialize mixing and decoding buffer
-  sl.sl_pslMixerBuffer  = (SLONG*)AllocMemory( sl.sl_slMixerBufferSize *2); // (*2 because of 32-bit buffer)
-  sl.sl_pswDecodeBuffer = (SWORD*)AllocMemory( sl.sl_slDecodeBufferSize+4); // (+4 because of linear interpolation of last samples)
+  sl.sl_pslMixerBuffer  = (SLONG*)AllocMemoryTagged( sl.sl_slMixerBufferSize *2, MTG_SOUND); // (*2 because of 32-bit buffer)
+  sl.sl_pswDecodeBuffer = (SWORD*)AllocMemoryTagged( sl.sl_slDecodeBufferSize+4, MTG_SOUND); // (+4 because of linear interpolation of last samples)
 
   // the audio callback can now safely fill the audio stream with silence
   //  until there is actual audio data to mix...
@@ -807,8 +814,8 @@ static BOOL StartUp_dsound( CSoundLibrary &sl, BOOL bReport=TRUE)
   sl.sl_slDecodeBufferSize = sl.sl_slMixerBufferSize *
                            ((44100+sl.sl_SwfeFormat.nSamplesPerSec-1) /sl.sl_SwfeFormat.nSamplesPerSec);
   // allocate mixing and decoding buffers
-  sl.sl_pslMixerBuffer  = (SLONG*)AllocMemory( sl.sl_slMixerBufferSize *2); // (*2 because of 32-bit buffer)
-  sl.sl_pswDecodeBuffer = (SWORD*)AllocMemory( sl.sl_slDecodeBufferSize+4); // (+4 because of linear interpolation of last samples)
+  sl.sl_pslMixerBuffer  = (SLONG*)AllocMemoryTagged( sl.sl_slMixerBufferSize *2, MTG_SOUND); // (*2 because of 32-bit buffer)
+  sl.sl_pswDecodeBuffer = (SWORD*)AllocMemoryTagged( sl.sl_slDecodeBufferSize+4, MTG_SOUND); // (+4 because of linear interpolation of last samples)
 
   // report success
   if( bReport) {
@@ -928,7 +935,7 @@ static BOOL StartUp_waveout( CSoundLibrary &sl, BOOL bReport=TRUE)
   }
 
   // initialise waveout sound buffers
-  sl.sl_pubBuffersMemory = (UBYTE*)AllocMemory( sl.sl_slMixerBufferSize);
+  sl.sl_pubBuffersMemory = (UBYTE*)AllocMemoryTagged( sl.sl_slMixerBufferSize, MTG_SOUND);
   memset( sl.sl_pubBuffersMemory, 0, sl.sl_slMixerBufferSize);
   sl.sl_awhWOBuffers.New(ctWOBuffers); 
   for( INDEX iBuffer = 0; iBuffer<sl.sl_awhWOBuffers.Count(); iBuffer++) {
@@ -938,8 +945,8 @@ static BOOL StartUp_waveout( CSoundLibrary &sl, BOOL bReport=TRUE)
     wh.dwFlags = 0;
   }
   // initialize mixing and decoding buffer
-  sl.sl_pslMixerBuffer  = (SLONG*)AllocMemory( sl.sl_slMixerBufferSize *2); // (*2 because of 32-bit buffer)
-  sl.sl_pswDecodeBuffer = (SWORD*)AllocMemory( sl.sl_slDecodeBufferSize+4); // (+4 because of linear interpolation of last samples)
+  sl.sl_pslMixerBuffer  = (SLONG*)AllocMemoryTagged( sl.sl_slMixerBufferSize *2, MTG_SOUND); // (*2 because of 32-bit buffer)
+  sl.sl_pswDecodeBuffer = (SWORD*)AllocMemoryTagged( sl.sl_slDecodeBufferSize+4, MTG_SOUND); // (+4 because of linear interpolation of last samples)
 
   // done
   return TRUE;
@@ -1036,6 +1043,11 @@ void CSoundLibrary::Init(void)
   _pShell->DeclareSymbol( "persistent user FLOAT snd_fSoundVolume;", (void *) &snd_fSoundVolume);
   _pShell->DeclareSymbol( "persistent user FLOAT snd_fMusicVolume;", (void *) &snd_fMusicVolume);
   _pShell->DeclareSymbol( "persistent user FLOAT snd_fNormalizer;",  (void *) &snd_fNormalizer);
+  _pShell->DeclareSymbol( "persistent user INDEX snd_bFloatMixer;",  (void *) &snd_bFloatMixer);
+  _pShell->DeclareSymbol( "persistent user FLOAT snd_fMixCullVolume;", (void *) &snd_fMixCullVolume);
+  _pShell->DeclareSymbol( "user void SoundRender(CTString, CTString, INDEX);", (void *) &SoundRender);
+  _pShell->DeclareSymbol( "persistent user INDEX snd_bStreamAhead;", (void *) &snd_bStreamAhead);
+  _pShell->DeclareSymbol( "user void SoundStreamStats(void);", (void *) &SoundStreamStats);
   _pShell->DeclareSymbol( "persistent user FLOAT snd_tmMixAhead post:SndPostFunc;", (void *) &snd_tmMixAhead);
   _pShell->DeclareSymbol( "persistent user INDEX snd_iInterface post:SndPostFunc;", (void *) &snd_iInterface);
   _pShell->DeclareSymbol( "persistent user INDEX snd_iDevice post:SndPostFunc;", (void *) &snd_iDevice);
@@ -1197,6 +1209,7 @@ void CSoundLibrary::ClearLibrary(void)
     FreeMemory( sl_pslMixerBuffer);
     sl_pslMixerBuffer = NULL;
   }
+  FreeMixerBuffers();
   if( sl_pswDecodeBuffer!=NULL) {
     FreeMemory( sl_pswDecodeBuffer);
     sl_pswDecodeBuffer = NULL;
@@ -1656,7 +1669,7 @@ void CSoundLibrary::MixSounds(void)
 
   // prepare mixer buffer
   _pfSoundProfile.IncrementCounter(CSoundProfile::PCI_MIXINGS, 1);
-  ResetMixer( sl_pslMixerBuffer, slDataToMix);
+  ResetMixer( sl_pslMixerBuffer, slDataToMix, sl_SwfeFormat.nSamplesPerSec);
 
   BOOL bGamePaused = _pNetwork->IsPaused() || (_pNetwork->IsServer() && _pNetwork->GetLocalPause());
 
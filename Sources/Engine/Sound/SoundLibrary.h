@@ -34,7 +34,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 
 // Mixer
 // set master volume and resets mixer buffer (wipes it with zeroes and keeps pointers)
-void ResetMixer( const SLONG *pslBuffer, const SLONG slBufferSize);
+void ResetMixer( const SLONG *pslBuffer, const SLONG slBufferSize, const SLONG slSampleRate);
+// free buffers that mixer allocated by itself
+void FreeMixerBuffers(void);
 // copy mixer buffer to the output buffer(s)
 void CopyMixerBuffer_stereo( const SLONG slSrcOffset, void *pDstBuffer, const SLONG slBytes);
 void CopyMixerBuffer_mono(   const SLONG slSrcOffset, void *pDstBuffer, const SLONG slBytes);
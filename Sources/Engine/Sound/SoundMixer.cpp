@@ -22,6 +22,17 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Sound/SoundObject.h>
 #include <Engine/Base/Statistics_Internal.h>
 #include <Engine/Base/Console.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Allocator.h>
+
+// float mixer kernels use SSE2 or NEON where available (scalar code otherwise)
+#if !defined(USE_PORTABLE_C) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2))
+  #define MIXER_SSE2 1
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define MIXER_NEON 1
+  #include <arm_neon.h>
+#endif
 
 // asm shortcuts
 #define O offset
@@ -34,6 +45,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 extern FLOAT snd_fSoundVolume;
 extern FLOAT snd_fMusicVolume;
 extern INDEX snd_bMono;
+extern INDEX snd_bFloatMixer;
+extern FLOAT snd_fMixCullVolume;
 
 
 // a bunch of local vars coming up
@@ -65,8 +78,21 @@ INASM __int64 fixLeftOfs, fixRightOfs; // fixed integers 32:32
 INASM __int64 mmSurroundFactor, mmLeftStep, mmRightStep, mmVolumeGain;
 INASM BOOL bNotLoop, bEndOfSound;
 
+// float mixer buffer (interleaved stereo, converted to 16-bit into regular mixer buffer when done)
+static BOOL   _bFloatMixing = FALSE;      // is current buffer being mixed in floats
+static FLOAT *_pfMixerBuffer = NULL;
+static SLONG  _slFloatBufferSize = 0;     // allocated size in samples per channel
+
+// free buffers that mixer allocated by itself
+void FreeMixerBuffers(void)
+{
+  if( _pfMixerBuffer!=NULL) FreeMemory(_pfMixerBuffer);
+  _pfMixerBuffer = NULL;
+  _slFloatBufferSize = 0;
+}
+
 // reset mixer buffer (wipes it with zeroes and remembers pointers in static mixer variables)
-void ResetMixer( const SLONG *pslBuffer, const SLONG slBufferSize)
+void ResetMixer( const SLONG *pslBuffer, const SLONG slBufferSize, const SLONG slSampleRate)
 {
   // clamp master volumes
   snd_fSoundVolume = Clamp(snd_fSoundVolume, 0.0f, 1.0f);
@@ -76,7 +102,20 @@ void ResetMixer( const SLONG *pslBuffer, const SLONG slBufferSize)
   ASSERT( slBufferSize%4==0);
   pvMixerBuffer     = (void*)pslBuffer;
   slMixerBufferSize = slBufferSize /2/2; // because it's stereo and 16-bit dst format
-  slMixerBufferSampleRate = _pSound->sl_SwfeFormat.nSamplesPerSec;
+  slMixerBufferSampleRate = slSampleRate;
+
+  // if mixing in floats
+  _bFloatMixing = snd_bFloatMixer;
+  if( _bFloatMixing) {
+    // (re)allocate float buffer if needed and wipe it
+    if( _slFloatBufferSize<slMixerBufferSize) {
+      FreeMixerBuffers();
+      _pfMixerBuffer = (FLOAT*)AllocMemoryTagged( slMixerBufferSize*2*sizeof(FLOAT), MTG_SOUND);
+      _slFloatBufferSize = slMixerBufferSize;
+    }
+    memset( _pfMixerBuffer, 0, slMixerBufferSize*2*sizeof(FLOAT));
+    return;
+  }
 
   // wipe destination mixer buffer
   #if (defined __MSVC_INLINE__)
@@ -236,12 +275,136 @@ copyLoop:
 }
 
 
+// convert float mixer buffer to 16-bit clamped, with interpolated normalizer (returns its last value)
+static FLOAT ConvertFloatMixerBuffer( const INDEX iSamples, const FLOAT fNorm, const FLOAT fNormAdd, const FLOAT fNormValue)
+{
+  const FLOAT *pfSrc = _pfMixerBuffer;
+  SWORD *pswDst = (SWORD*)pvMixerBuffer;
+  const BOOL bNormDown = fNormAdd<0;
+  INDEX i=0;
+
+#if MIXER_SSE2
+  const __m128 mMax  = _mm_set1_ps(+32767.0f);
+  const __m128 mMin  = _mm_set1_ps(-32767.0f);
+  const __m128 mNormValue = _mm_set1_ps(fNormValue);
+  const __m128 mNormAdd4  = _mm_set1_ps(fNormAdd*4);
+  __m128 mNorm = _mm_add_ps( _mm_set1_ps(fNorm), _mm_mul_ps( _mm_set1_ps(fNormAdd), _mm_setr_ps(0,1,2,3)));
+  for( ; i+8<=iSamples; i+=8) {
+    // clamp interpolated normalizer
+    const __m128 mNorm0 = bNormDown ? _mm_max_ps( mNorm, mNormValue) : _mm_min_ps( mNorm, mNormValue);
+    mNorm = _mm_add_ps( mNorm, mNormAdd4);
+    const __m128 mNorm1 = bNormDown ? _mm_max_ps( mNorm, mNormValue) : _mm_min_ps( mNorm, mNormValue);
+    mNorm = _mm_add_ps( mNorm, mNormAdd4);
+    // normalize, clamp and pack to 16-bit
+    __m128 m0 = _mm_mul_ps( _mm_loadu_ps(pfSrc+i+0), mNorm0);
+    __m128 m1 = _mm_mul_ps( _mm_loadu_ps(pfSrc+i+4), mNorm1);
+    m0 = _mm_min_ps( _mm_max_ps( m0, mMin), mMax);
+    m1 = _mm_min_ps( _mm_max_ps( m1, mMin), mMax);
+    _mm_storeu_si128( (__m128i*)(pswDst+i), _mm_packs_epi32( _mm_cvtps_epi32(m0), _mm_cvtps_epi32(m1)));
+  }
+#elif MIXER_NEON
+  static const FLOAT afRamp[4] = { 0,1,2,3 };
+  const float32x4_t vMax  = vdupq_n_f32(+32767.0f);
+  const float32x4_t vMin  = vdupq_n_f32(-32767.0f);
+  const float32x4_t vNormValue = vdupq_n_f32(fNormValue);
+  const float32x4_t vNormAdd4  = vdupq_n_f32(fNormAdd*4);
+  const uint32x4_t  vSign = vdupq_n_u32(0x80000000);
+  const uint32x4_t  vHalf = vreinterpretq_u32_f32(vdupq_n_f32(0.5f));
+  float32x4_t vNorm = vmlaq_n_f32( vdupq_n_f32(fNorm), vld1q_f32(afRamp), fNormAdd);
+  for( ; i+8<=iSamples; i+=8) {
+    // clamp interpolated normalizer
+    const float32x4_t vNorm0 = bNormDown ? vmaxq_f32( vNorm, vNormValue) : vminq_f32( vNorm, vNormValue);
+    vNorm = vaddq_f32( vNorm, vNormAdd4);
+    const float32x4_t vNorm1 = bNormDown ? vmaxq_f32( vNorm, vNormValue) : vminq_f32( vNorm, vNormValue);
+    vNorm = vaddq_f32( vNorm, vNormAdd4);
+    // normalize and clamp
+    float32x4_t v0 = vmulq_f32( vld1q_f32(pfSrc+i+0), vNorm0);
+    float32x4_t v1 = vmulq_f32( vld1q_f32(pfSrc+i+4), vNorm1);
+    v0 = vminq_f32( vmaxq_f32( v0, vMin), vMax);
+    v1 = vminq_f32( vmaxq_f32( v1, vMin), vMax);
+    // round (add signed half and truncate) and pack to 16-bit
+    v0 = vaddq_f32( v0, vreinterpretq_f32_u32( vorrq_u32( vandq_u32( vreinterpretq_u32_f32(v0), vSign), vHalf)));
+    v1 = vaddq_f32( v1, vreinterpretq_f32_u32( vorrq_u32( vandq_u32( vreinterpretq_u32_f32(v1), vSign), vHalf)));
+    vst1q_s16( pswDst+i, vcombine_s16( vqmovn_s32(vcvtq_s32_f32(v0)), vqmovn_s32(vcvtq_s32_f32(v1))));
+  }
+#endif
+
+  // remaining samples
+  for( ; i<iSamples; i++) {
+    FLOAT fCurrentNormValue = fNorm + i*fNormAdd;
+    if( bNormDown) fCurrentNormValue = ClampDn( fCurrentNormValue, fNormValue);
+    else           fCurrentNormValue = ClampUp( fCurrentNormValue, fNormValue);
+    pswDst[i] = (SWORD)FloatToInt( Clamp( pfSrc[i]*fCurrentNormValue, -32767.0f, +32767.0f));
+  }
+
+  // return where normalizer came to
+  const FLOAT fLastNorm = fNorm + iSamples*fNormAdd;
+  return bNormDown ? ClampDn( fLastNorm, fNormValue) : ClampUp( fLastNorm, fNormValue);
+}
+
+
+// find peak of float mixer buffer
+static FLOAT FloatMixerBufferPeak( const INDEX iSamples)
+{
+  const FLOAT *pfSrc = _pfMixerBuffer;
+  FLOAT fPeak = 0.0f;
+  INDEX i=0;
+#if MIXER_SSE2
+  const __m128 mAbsMask = _mm_castsi128_ps( _mm_set1_epi32(0x7FFFFFFF));
+  __m128 mPeak = _mm_setzero_ps();
+  for( ; i+4<=iSamples; i+=4) mPeak = _mm_max_ps( mPeak, _mm_and_ps( _mm_loadu_ps(pfSrc+i), mAbsMask));
+  mPeak = _mm_max_ps( mPeak, _mm_shuffle_ps( mPeak, mPeak, _MM_SHUFFLE(1,0,3,2)));
+  mPeak = _mm_max_ps( mPeak, _mm_shuffle_ps( mPeak, mPeak, _MM_SHUFFLE(2,3,0,1)));
+  fPeak = _mm_cvtss_f32(mPeak);
+#elif MIXER_NEON
+  float32x4_t vPeak = vdupq_n_f32(0.0f);
+  for( ; i+4<=iSamples; i+=4) vPeak = vmaxq_f32( vPeak, vabsq_f32( vld1q_f32(pfSrc+i)));
+  float32x2_t vPeak2 = vpmax_f32( vget_low_f32(vPeak), vget_high_f32(vPeak));
+  vPeak2 = vpmax_f32( vPeak2, vPeak2);
+  fPeak = vget_lane_f32( vPeak2, 0);
+#endif
+  for( ; i<iSamples; i++) fPeak = Max( Abs(pfSrc[i]), fPeak);
+  return fPeak;
+}
+
+
+// normalize float mixer buffer (and convert it to 16-bit into regular mixer buffer)
+static void NormalizeMixerBuffer_float( const FLOAT fNormStrength, const SLONG slBytes, FLOAT &fLastNormValue)
+{
+  const INDEX iSamples = slBytes/2; // 16-bit was assumed -> samples (treat as mono)
+  // just convert to 16-bit if normalization isn't required
+  if( fNormStrength<0.01f) {
+    ConvertFloatMixerBuffer( iSamples, 1.0f, 0.0f, 1.0f);
+    return;
+  }
+
+  // determine normalize value and skip normalization if maximize is required (do not increase volume!)
+  // (unlike integer mixer, peaks above 16-bit range are not clamped before this)
+  FLOAT fNormValue = 32767.0f / ClampDn( FloatMixerBufferPeak(iSamples), 1.0f);
+  if( fNormValue>0.99f && fLastNormValue>0.99f) { // should be enough to tolerate
+    fLastNormValue = 1.0f;
+    ConvertFloatMixerBuffer( iSamples, 1.0f, 0.0f, 1.0f);
+    return;
+  }
+
+  // adjust normalize value by strength and normalize (and convert to 16-bit)
+  ASSERT( fNormStrength>=0 && fNormStrength<=1);
+  fNormValue = Lerp( 1.0f, fNormValue, fNormStrength);
+  const FLOAT fNormAdd = (fNormValue-fLastNormValue) / (iSamples/4);
+  fLastNormValue = ConvertFloatMixerBuffer( iSamples, fLastNormValue, fNormAdd, fNormValue);
+}
+
+
 // normalize mixer buffer
 void NormalizeMixerBuffer( const FLOAT fNormStrength, const SLONG slBytes, FLOAT &fLastNormValue)
 {
   // just convert to 16-bit if normalization isn't required
   ASSERT( slBytes%4==0);
   if( slBytes<8) return;
+  if( _bFloatMixing) {
+    NormalizeMixerBuffer_float( fNormStrength, slBytes, fLastNormValue);
+    return;
+  }
   if( fNormStrength<0.01f) {
     ConvertMixerBuffer(slBytes);
     return;
@@ -746,6 +909,225 @@ loopEnd:
 }
 
 
+// one channel of a sound being mixed in floats
+struct MixChannel {
+  DOUBLE mc_dOffset;   // position in source buffer (in samples)
+  FLOAT  mc_fStep;     // source samples per destination sample
+  FLOAT  mc_fVolume;   // current volume (negative for inverted phase)
+  FLOAT  mc_fGain;     // volume change per destination sample
+  FLOAT  mc_fFilter;   // low-pass factor (1 = no filtering)
+  FLOAT  mc_fLast;     // last filtered sample
+  INDEX  mc_iChannel;  // channel of source buffer to fetch from
+  // low-pass filter unrolled for 4 samples at once: y[k] = decay[k]*last + sum(column[j][k]*x[j])
+  FLOAT  mc_afDecay[4];
+  FLOAT  mc_aafColumn[4][4];
+};
+
+
+// set filter of a float mixer channel
+static void SetMixChannelFilter( MixChannel &mc, const SLONG slFilter)
+{
+  mc.mc_fFilter = (slFilter>=0x7FFF) ? 1.0f : slFilter*(1.0f/32768.0f);
+  const FLOAT fKeep = 1.0f-mc.mc_fFilter;
+  FLOAT afPow[4];
+  FLOAT fPow = 1.0f;
+  for( INDEX k=0; k<4; k++) {
+    afPow[k] = fPow;
+    fPow *= fKeep;
+    mc.mc_afDecay[k] = fPow;
+  }
+  for( INDEX j=0; j<4; j++) {
+    for( INDEX k=0; k<4; k++) mc.mc_aafColumn[j][k] = (k>=j) ? mc.mc_fFilter*afPow[k-j] : 0.0f;
+  }
+}
+
+
+// mix one lineary interpolated, filtered and volume-adjusted sample of a channel
+static inline FLOAT MixSample_float( MixChannel &mc, const SWORD *pswSrc, const INDEX ctSrcChannels, const SLONG slLastIndex)
+{
+  const SLONG slPos = (SLONG)mc.mc_dOffset;
+  const FLOAT fFrac = (FLOAT)(mc.mc_dOffset-slPos);
+  const SWORD *psw  = pswSrc + ClampUp( slPos, slLastIndex)*ctSrcChannels + mc.mc_iChannel;
+  const FLOAT fSample = psw[0] + (psw[ctSrcChannels]-psw[0])*fFrac;
+  mc.mc_fLast += (fSample-mc.mc_fLast)*mc.mc_fFilter;
+  const FLOAT fMixed = mc.mc_fLast*mc.mc_fVolume;
+  mc.mc_fVolume += mc.mc_fGain;
+  mc.mc_dOffset += mc.mc_fStep;
+  return fMixed;
+}
+
+
+#if MIXER_SSE2 || MIXER_NEON
+// fetch neighbouring source samples and interpolation fractions of a channel for next 4 samples
+static inline void GatherSamples_float( MixChannel &mc, const SWORD *pswSrc, const INDEX ctSrcChannels, const SLONG slLastIndex,
+                                        FLOAT af0[4], FLOAT af1[4], FLOAT afFrac[4])
+{
+  const SLONG slBase = (SLONG)mc.mc_dOffset;
+  const FLOAT fBaseFrac = (FLOAT)(mc.mc_dOffset-slBase);
+  for( INDEX i=0; i<4; i++) {
+    const FLOAT fPos  = fBaseFrac + i*mc.mc_fStep;
+    const SLONG slPos = (SLONG)fPos;
+    afFrac[i] = fPos-slPos;
+    const SWORD *psw = pswSrc + ClampUp( slBase+slPos, slLastIndex)*ctSrcChannels + mc.mc_iChannel;
+    af0[i] = psw[0];
+    af1[i] = psw[ctSrcChannels];
+  }
+  mc.mc_dOffset += 4*(DOUBLE)mc.mc_fStep;
+}
+#endif
+
+
+#if MIXER_SSE2
+// resample, filter and apply volume ramp to next 4 samples of a channel
+static inline __m128 MixBlock_SSE2( MixChannel &mc, const SWORD *pswSrc, const INDEX ctSrcChannels, const SLONG slLastIndex)
+{
+  FLOAT af0[4], af1[4], afFrac[4];
+  GatherSamples_float( mc, pswSrc, ctSrcChannels, slLastIndex, af0, af1, afFrac);
+  const __m128 m0 = _mm_loadu_ps(af0);
+  __m128 mX = _mm_add_ps( m0, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps(af1), m0), _mm_loadu_ps(afFrac)));
+  // filter
+  if( mc.mc_fFilter<1.0f) {
+    __m128 mY = _mm_mul_ps( _mm_loadu_ps(mc.mc_afDecay), _mm_set1_ps(mc.mc_fLast));
+    mY = _mm_add_ps( mY, _mm_mul_ps( _mm_loadu_ps(mc.mc_aafColumn[0]), _mm_shuffle_ps( mX, mX, _MM_SHUFFLE(0,0,0,0))));
+    mY = _mm_add_ps( mY, _mm_mul_ps( _mm_loadu_ps(mc.mc_aafColumn[1]), _mm_shuffle_ps( mX, mX, _MM_SHUFFLE(1,1,1,1))));
+    mY = _mm_add_ps( mY, _mm_mul_ps( _mm_loadu_ps(mc.mc_aafColumn[2]), _mm_shuffle_ps( mX, mX, _MM_SHUFFLE(2,2,2,2))));
+    mY = _mm_add_ps( mY, _mm_mul_ps( _mm_loadu_ps(mc.mc_aafColumn[3]), _mm_shuffle_ps( mX, mX, _MM_SHUFFLE(3,3,3,3))));
+    mX = mY;
+  }
+  mc.mc_fLast = _mm_cvtss_f32( _mm_shuffle_ps( mX, mX, _MM_SHUFFLE(3,3,3,3)));
+  // apply volume ramp
+  const __m128 mVolume = _mm_add_ps( _mm_set1_ps(mc.mc_fVolume), _mm_mul_ps( _mm_set1_ps(mc.mc_fGain), _mm_setr_ps(0,1,2,3)));
+  mc.mc_fVolume += 4*mc.mc_fGain;
+  return _mm_mul_ps( mX, mVolume);
+}
+#elif MIXER_NEON
+// resample, filter and apply volume ramp to next 4 samples of a channel
+static inline float32x4_t MixBlock_NEON( MixChannel &mc, const SWORD *pswSrc, const INDEX ctSrcChannels, const SLONG slLastIndex)
+{
+  static const FLOAT afRamp[4] = { 0,1,2,3 };
+  FLOAT af0[4], af1[4], afFrac[4];
+  GatherSamples_float( mc, pswSrc, ctSrcChannels, slLastIndex, af0, af1, afFrac);
+  const float32x4_t v0 = vld1q_f32(af0);
+  float32x4_t vX = vmlaq_f32( v0, vsubq_f32( vld1q_f32(af1), v0), vld1q_f32(afFrac));
+  // filter
+  if( mc.mc_fFilter<1.0f) {
+    float32x4_t vY = vmulq_n_f32( vld1q_f32(mc.mc_afDecay), mc.mc_fLast);
+    vY = vmlaq_n_f32( vY, vld1q_f32(mc.mc_aafColumn[0]), vgetq_lane_f32( vX, 0));
+    vY = vmlaq_n_f32( vY, vld1q_f32(mc.mc_aafColumn[1]), vgetq_lane_f32( vX, 1));
+    vY = vmlaq_n_f32( vY, vld1q_f32(mc.mc_aafColumn[2]), vgetq_lane_f32( vX, 2));
+    vY = vmlaq_n_f32( vY, vld1q_f32(mc.mc_aafColumn[3]), vgetq_lane_f32( vX, 3));
+    vX = vY;
+  }
+  mc.mc_fLast = vgetq_lane_f32( vX, 3);
+  // apply volume ramp
+  const float32x4_t vVolume = vmlaq_n_f32( vdupq_n_f32(mc.mc_fVolume), vld1q_f32(afRamp), mc.mc_fGain);
+  mc.mc_fVolume += 4*mc.mc_fGain;
+  return vmulq_f32( vX, vVolume);
+}
+#endif
+
+
+// mix a run of samples of one sound that doesn't cross end of its buffer into float mixer buffer
+static void MixRun_float( MixChannel &mcL, MixChannel &mcR, const SWORD *pswSrc, const INDEX ctSrcChannels,
+                          const SLONG slLastIndex, FLOAT *pfDst, INDEX ctSamples)
+{
+#if MIXER_SSE2
+  for( ; ctSamples>=4; ctSamples-=4, pfDst+=8) {
+    const __m128 mL = MixBlock_SSE2( mcL, pswSrc, ctSrcChannels, slLastIndex);
+    const __m128 mR = MixBlock_SSE2( mcR, pswSrc, ctSrcChannels, slLastIndex);
+    // interleave channels and mix them in
+    _mm_storeu_ps( pfDst+0, _mm_add_ps( _mm_loadu_ps(pfDst+0), _mm_unpacklo_ps( mL, mR)));
+    _mm_storeu_ps( pfDst+4, _mm_add_ps( _mm_loadu_ps(pfDst+4), _mm_unpackhi_ps( mL, mR)));
+  }
+#elif MIXER_NEON
+  for( ; ctSamples>=4; ctSamples-=4, pfDst+=8) {
+    // mix both channels in (load and store interleave them)
+    float32x4x2_t vDst = vld2q_f32(pfDst);
+    vDst.val[0] = vaddq_f32( vDst.val[0], MixBlock_NEON( mcL, pswSrc, ctSrcChannels, slLastIndex));
+    vDst.val[1] = vaddq_f32( vDst.val[1], MixBlock_NEON( mcR, pswSrc, ctSrcChannels, slLastIndex));
+    vst2q_f32( pfDst, vDst);
+  }
+#endif
+  // remaining samples one by one
+  for( ; ctSamples>0; ctSamples--, pfDst+=2) {
+    pfDst[0] += MixSample_float( mcL, pswSrc, ctSrcChannels, slLastIndex);
+    pfDst[1] += MixSample_float( mcR, pswSrc, ctSrcChannels, slLastIndex);
+  }
+}
+
+
+// how many samples can be mixed before channel reaches end of sound buffer
+static inline INDEX SamplesToEnd_float( const MixChannel &mc, const DOUBLE dBufferSize)
+{
+  if( mc.mc_fStep<=0) return MAX_SLONG;
+  const DOUBLE dSamples = ceil( (dBufferSize-mc.mc_dOffset) / mc.mc_fStep);
+  return (INDEX)Clamp( dSamples, 1.0, (DOUBLE)MAX_SLONG);
+}
+
+
+// mixes one mono or stereo 16-bit signed sound to float mixer buffer
+static void MixSound_float( const SLONG slChannels, const FLOAT fLeftVolume, const FLOAT fRightVolume,
+                            const FLOAT fLeftGain, const FLOAT fRightGain)
+{
+  _pfSoundProfile.StartTimer(CSoundProfile::PTI_RAWMIXER);
+
+  // set up both channels (mono sounds fetch same channel for both)
+  MixChannel mcL, mcR;
+  mcL.mc_dOffset  = fLeftOfs;
+  mcR.mc_dOffset  = fRightOfs;
+  mcL.mc_fStep    = fLeftStep;
+  mcR.mc_fStep    = fRightStep;
+  mcL.mc_fVolume  = fLeftVolume;
+  mcR.mc_fVolume  = fRightVolume;
+  mcL.mc_fGain    = fLeftGain;
+  mcR.mc_fGain    = fRightGain;
+  mcL.mc_fLast    = (SWORD)slLastLeftSample;
+  mcR.mc_fLast    = (SWORD)slLastRightSample;
+  mcL.mc_iChannel = 0;
+  mcR.mc_iChannel = slChannels-1;
+  SetMixChannelFilter( mcL, slLeftFilter);
+  SetMixChannelFilter( mcR, slRightFilter);
+  // surround sounds have left channel in inverted phase
+  if( mmSurroundFactor!=0) {
+    mcL.mc_fVolume = -mcL.mc_fVolume;
+    mcL.mc_fGain   = -mcL.mc_fGain;
+  }
+
+  // loop thru runs of samples that don't cross end of sound buffer
+  const DOUBLE dBufferSize = slSoundBufferSize;
+  FLOAT *pfDst = _pfMixerBuffer;
+  INDEX ctLeft = slMixerBufferSize;
+  FOREVER
+  {
+    // if channel source samples came to end of sample buffer, wrap them (and end it if it has no loop)
+    while( mcL.mc_dOffset >= dBufferSize) {
+      mcL.mc_dOffset -= dBufferSize;
+      bEndOfSound = bNotLoop;
+    }
+    while( mcR.mc_dOffset >= dBufferSize) {
+      mcR.mc_dOffset -= dBufferSize;
+      bEndOfSound = bNotLoop;
+    }
+    // end of buffer?
+    if( ctLeft<=0 || bEndOfSound) break;
+
+    // mix as much as both channels can before wrapping
+    const INDEX ctRun = Min( ctLeft, Min( SamplesToEnd_float( mcL, dBufferSize), SamplesToEnd_float( mcR, dBufferSize)));
+    MixRun_float( mcL, mcR, pswSrcBuffer, slChannels, slSoundBufferSize-1, pfDst, ctRun);
+    pfDst  += ctRun*2;
+    ctLeft -= ctRun;
+  }
+
+  // keep mixer state in same form as integer mixer
+  fixLeftOfs  = (__int64)(mcL.mc_dOffset*65536.0);
+  fixRightOfs = (__int64)(mcR.mc_dOffset*65536.0);
+  slLastLeftSample  = Clamp( FloatToInt(mcL.mc_fLast), -32767, +32767);
+  slLastRightSample = Clamp( FloatToInt(mcR.mc_fLast), -32767, +32767);
+
+  _pfSoundProfile.StopTimer(CSoundProfile::PTI_RAWMIXER);
+}
+
+
 // mixes one sound to destination buffer
 void MixSound( CSoundObject *pso)
 {
@@ -800,7 +1182,8 @@ void MixSound( CSoundObject *pso)
   }
 
   // if both channel volumes are too low
-  if( fLeftVolume<0.001f && fRightVolume<0.001f && fNewLeftVolume<0.001f && fNewRightVolume<0.001f)
+  const FLOAT fCullVolume = ClampDn( snd_fMixCullVolume, 0.0f);
+  if( fLeftVolume<fCullVolume && fRightVolume<fCullVolume && fNewLeftVolume<fCullVolume && fNewRightVolume<fCullVolume)
   {
     // if this is not an encoded sound
     if( !(psd->sd_ulFlags&SDF_ENCODED) ) {
@@ -849,10 +1232,15 @@ void MixSound( CSoundObject *pso)
   const SLONG slLeftGain  = FloatToInt( (fNewLeftVolume -fLeftVolume)  *fMixBufSize);
   const SLONG slRightGain = FloatToInt( (fNewRightVolume-fRightVolume) *fMixBufSize);
   mmVolumeGain  = ((__int64)(slRightGain)<<32) | ((__int64)(slLeftGain)&0xFFFFFFFF);
-  // extrapolate back new volumes because of not enough precision in interpolation!
-  // (otherwise we might hear occasional pucks)
-  if( fNewLeftVolume >0.001f) fNewLeftVolume  = (slLeftVolume  + slLeftGain *slMixerBufferSize) /(65536*32767.0f);
-  if( fNewRightVolume>0.001f) fNewRightVolume = (slRightVolume + slRightGain*slMixerBufferSize) /(65536*32767.0f);
+  // float mixer interpolates volumes precisely enough
+  FLOAT fLeftGain  = (fNewLeftVolume -fLeftVolume)  / slMixerBufferSize;
+  FLOAT fRightGain = (fNewRightVolume-fRightVolume) / slMixerBufferSize;
+  if( !_bFloatMixing) {
+    // extrapolate back new volumes because of not enough precision in interpolation!
+    // (otherwise we might hear occasional pucks)
+    if( fNewLeftVolume >0.001f) fNewLeftVolume  = (slLeftVolume  + slLeftGain *slMixerBufferSize) /(65536*32767.0f);
+    if( fNewRightVolume>0.001f) fNewRightVolume = (slRightVolume + slRightGain*slMixerBufferSize) /(65536*32767.0f);
+  }
   //ASSERT( fNewLeftVolume>=0 && fNewRightVolume>=0);
   //CPrintF( "NV: %.4f / %.4f, GV: %.4f / %.4f\n", fNewLeftVolume,fNewRightVolume, fLeftGainedVolume,fRightGainedVolume); 
 
@@ -952,13 +1340,20 @@ void MixSound( CSoundObject *pso)
       fRightStep = fLeftStep;
       slLeftVolume  = (slLeftVolume+slRightVolume)/2;
       slRightVolume = slLeftVolume;
+      fLeftVolume  = (fLeftVolume+fRightVolume)/2;
+      fRightVolume = fLeftVolume;
+      fLeftGain  = (fLeftGain+fRightGain)/2;
+      fRightGain = fLeftGain;
       slLeftFilter  = (slLeftFilter+slRightFilter)/2;
       slRightFilter = slLeftFilter;
     }
 
     // call corresponding mixer routine for current sound format
     bEndOfSound = FALSE;
-    if( slChannels==2) {
+    if( _bFloatMixing) {
+      // mix in floats (both 16-bit mono and stereo)
+      MixSound_float( slChannels, fLeftVolume, fRightVolume, fLeftGain, fRightGain);
+    } else if( slChannels==2) {
       // mix as 16-bit stereo
       MixStereo( pso);
     } else {
@@ -266,6 +266,8 @@ void CSoundObject::Play_internal( CSoundData *pCsdLink, SLONG slFlags)
     // create decoder
     if (so_pCsdLink->sd_ulFlags&SDF_STREAMING) {
       so_psdcDecoder = new CSoundDecoder(so_pCsdLink->GetName());
+      // start decoding it ahead, so mixer has something when it first comes to it
+      so_psdcDecoder->StartStreaming(so_slFlags&SOF_LOOP);
     } else {
       ASSERT(FALSE);  // nonstreaming not supported anymore
     }
@@ -39,4 +39,5 @@ CSoundProfile::CSoundProfile(void)
   SETCOUNTERNAME( PCI_SOUNDSSKIPPED, "sounds skipped for low volume");
   SETCOUNTERNAME( PCI_SOUNDSDELAYED, "sounds delayed for sound speed latency");
   SETCOUNTERNAME( PCI_SAMPLES,       "samples mixed");
+  SETCOUNTERNAME( PCI_STREAMUNDERRUNS, "stream underruns");
 }
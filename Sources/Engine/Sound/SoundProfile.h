@@ -41,6 +41,7 @@ public:
     PCI_SOUNDSSKIPPED,     // sounds skipped for low volume
     PCI_SOUNDSDELAYED,     // sounds delayed for sound speed latency
     PCI_SAMPLES,      // samples mixed
+    PCI_STREAMUNDERRUNS,   // streams that weren't decoded ahead enough
 
     PCI_COUNT
   };
@@ -0,0 +1,203 @@
+/* Copyright (c) 2002-2012 Croteam Ltd.
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Sound/SoundLibrary.h>
+#include <Engine/Sound/SoundData.h>
+#include <Engine/Sound/SoundObject.h>
+#include <Engine/Sound/Wave.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Stream.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Base/Memory.h>
+#include <Engine/Base/Allocator.h>
+#include <Engine/Base/CRC.h>
+#include <Engine/Templates/DynamicContainer.cpp>
+
+// offline rendering of scripted sounds thru the mixer, without a sound device
+
+#define RENDER_SAMPLERATE  44100
+#define RENDER_CHUNKSIZE    1024  // samples per channel mixed at once
+
+extern FLOAT snd_fSoundVolume;
+extern FLOAT snd_fNormalizer;
+
+// one scripted sound (data isn't registered with library, so mixer is the only one that sees it)
+struct RenderVoice {
+  CSoundData   rv_sd;
+  CSoundObject rv_so;
+};
+
+
+// load wave file into sound data that is not hooked to sound library
+static void LoadRenderWave_t( CSoundData &sd, const CTFileName &fnmWave)
+{
+  if( fnmWave.FileExt()!=".wav") ThrowF_t( TRANS("Only wave files can be rendered: '%s'"), (const char*)fnmWave);
+  CTFileStream strm;
+  strm.Open_t(fnmWave);
+
+  PCMWaveInput pwiLoad;
+  sd.sd_ulFlags   = NONE;
+  sd.sd_wfeFormat = pwiLoad.LoadInfo_t(&strm);
+  sd.sd_dSecondsLength = pwiLoad.GetSecondsLength();
+  // sounds can only be shrunk to mixer rate (mixer resamples the rest)
+  if( sd.sd_wfeFormat.nSamplesPerSec>RENDER_SAMPLERATE) sd.sd_wfeFormat.nSamplesPerSec = RENDER_SAMPLERATE;
+  sd.sd_wfeFormat.wBitsPerSample = 16;
+
+  sd.sd_slBufferSampleSize = pwiLoad.GetDataLength(sd.sd_wfeFormat);
+  const SLONG slBufferSize = pwiLoad.DetermineBufferSize(sd.sd_wfeFormat);
+  sd.sd_pswBuffer = (SWORD*)AllocMemoryTagged( slBufferSize+8, MTG_SOUND);
+  pwiLoad.LoadData_t( &strm, sd.sd_pswBuffer, sd.sd_wfeFormat);
+  // copy first sample to the last one (this is needed for linear interpolation)
+  (ULONG&)(((UBYTE*)sd.sd_pswBuffer)[slBufferSize]) = *(ULONG*)sd.sd_pswBuffer;
+}
+
+
+// read script of sounds to render; each line is:
+//   <delay> <left volume> <right volume> <pitch> <phase shift> <loop> <wave file>
+// (empty lines and lines starting with ';' are skipped)
+static void LoadRenderScript_t( const CTFileName &fnmScript, CDynamicContainer<RenderVoice> &cvoVoices)
+{
+  CTFileStream strm;
+  strm.Open_t(fnmScript);
+  INDEX iLine = 0;
+  while( !strm.AtEOF()) {
+    CTString strLine;
+    strm.GetLine_t(strLine);
+    iLine++;
+    strLine.TrimSpacesLeft();
+    strLine.TrimSpacesRight();
+    if( strLine=="" || ((const char*)strLine)[0]==';') continue;
+
+    FLOAT fDelay, fLeft, fRight, fPitch, fPhase;
+    INDEX bLoop;
+    int iFileStart = 0;
+    if( sscanf( strLine, "%f %f %f %f %f %d %n", &fDelay, &fLeft, &fRight, &fPitch, &fPhase, &bLoop, &iFileStart)<6 || iFileStart==0) {
+      ThrowF_t( TRANS("%s(%d): expected <delay> <left> <right> <pitch> <phase> <loop> <file>"), (const char*)fnmScript, iLine);
+    }
+
+    RenderVoice *prv = new RenderVoice;
+    cvoVoices.Add(prv);
+    LoadRenderWave_t( prv->rv_sd, CTFileName( CTString( ((const char*)strLine)+iFileStart)));
+
+    // link object to data by hand, so it won't be registered with sound library
+    CSoundObject &so = prv->rv_so;
+    so.so_pCsdLink = &prv->rv_sd;
+    so.so_sp.sp_fDelay        = ClampDn( fDelay, 0.0f);
+    so.so_sp.sp_fLeftVolume   = ClampDn( fLeft,  0.0f);
+    so.so_sp.sp_fRightVolume  = ClampDn( fRight, 0.0f);
+    so.so_sp.sp_fPitchShift   = ClampDn( fPitch, 0.01f);
+    so.so_sp.sp_fPhaseShift   = fPhase;
+    so.so_fLastLeftVolume  = so.so_sp.sp_fLeftVolume;
+    so.so_fLastRightVolume = so.so_sp.sp_fRightVolume;
+    so.so_slFlags = SOF_PLAY|SOF_PREPARE;
+    if( bLoop) so.so_slFlags |= SOF_LOOP;
+  }
+}
+
+
+// write 16-bit stereo wave file header
+static void WriteRenderWaveHeader_t( CTStream &strm, const SLONG slDataBytes)
+{
+  strm.Write_t( "RIFF", 4);
+  strm<<(ULONG)(36+slDataBytes);
+  strm.Write_t( "WAVEfmt ", 8);
+  strm<<(ULONG)16;
+  strm<<(UWORD)WAVE_FORMAT_PCM;
+  strm<<(UWORD)2;
+  strm<<(ULONG)RENDER_SAMPLERATE;
+  strm<<(ULONG)(RENDER_SAMPLERATE*4);
+  strm<<(UWORD)4;
+  strm<<(UWORD)16;
+  strm.Write_t( "data", 4);
+  strm<<(ULONG)slDataBytes;
+}
+
+
+// render script of sounds to a wave file and report how long mixing took
+void SoundRender(void *pArgs)
+{
+  CTString strScript = *NEXTARGUMENT(CTString*);
+  CTString strWave   = *NEXTARGUMENT(CTString*);
+  INDEX ctSeconds    = NEXTARGUMENT(INDEX);
+  ctSeconds = Clamp( ctSeconds, (INDEX)1, (INDEX)3600);
+
+  // sound library must not mix these (or anything else) meanwhile
+  CTSingleLock slSounds( &_pSound->sl_csSound, TRUE);
+
+  CDynamicContainer<RenderVoice> cvoVoices;
+  SLONG *pslMixerBuffer = NULL;
+  const FLOAT fOldSoundVolume = snd_fSoundVolume;
+  try {
+    LoadRenderScript_t( CTFileName(strScript), cvoVoices);
+    if( cvoVoices.Count()==0) ThrowF_t( TRANS("No sounds in '%s'"), (const char*)strScript);
+
+    CTFileStream strmWave;
+    strmWave.Create_t( CTFileName(strWave));
+    const SLONG slChunks = (ctSeconds*RENDER_SAMPLERATE+RENDER_CHUNKSIZE-1) / RENDER_CHUNKSIZE;
+    const SLONG slChunkBytes = RENDER_CHUNKSIZE*2*2;  // 16-bit stereo
+    WriteRenderWaveHeader_t( strmWave, slChunks*slChunkBytes);
+
+    // mixer needs twice as much for its 32-bit intermediate samples
+    pslMixerBuffer = (SLONG*)AllocMemoryTagged( slChunkBytes*2, MTG_SOUND);
+    snd_fSoundVolume = 1.0f;
+    FLOAT fLastNormValue = 1.0f;
+    ULONG ulCRC;
+    CRC_Start(ulCRC);
+    CTimerValue tvMixing;
+    tvMixing.Clear();
+    SLONG slVoicesMixed = 0;
+
+    for( SLONG slChunk=0; slChunk<slChunks; slChunk++) {
+      CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+      ResetMixer( pslMixerBuffer, slChunkBytes, RENDER_SAMPLERATE);
+      FOREACHINDYNAMICCONTAINER( cvoVoices, RenderVoice, itrv) {
+        CSoundObject &so = itrv->rv_so;
+        if( !(so.so_slFlags&SOF_PLAY)) continue;
+        MixSound(&so);
+        slVoicesMixed++;
+      }
+      NormalizeMixerBuffer( Clamp( snd_fNormalizer, 0.0f, 1.0f), slChunkBytes, fLastNormValue);
+      tvMixing += _pTimer->GetHighPrecisionTimer()-tvStart;
+      // mixed samples are 16-bit now
+      CRC_AddBlock( ulCRC, (UBYTE*)pslMixerBuffer, slChunkBytes);
+      strmWave.Write_t( pslMixerBuffer, slChunkBytes);
+    }
+    CRC_Finish(ulCRC);
+
+    const DOUBLE dRendered = (DOUBLE)slChunks*RENDER_CHUNKSIZE/RENDER_SAMPLERATE;
+    const DOUBLE dMixing = tvMixing.GetSeconds();
+    CPrintF( TRANS("Rendered %.1fs of %d sounds to '%s' (CRC 0x%08X)\n"), dRendered, cvoVoices.Count(), (const char*)strWave, ulCRC);
+    CPrintF( TRANS("  mixing: %.2f ms (%.0fx realtime), %d sound chunks mixed\n"),
+             dMixing*1000.0, dMixing>0 ? dRendered/dMixing : 0.0, slVoicesMixed);
+  } catch( char *strError) {
+    CPrintF( TRANS("Cannot render sounds: %s\n"), strError);
+  }
+
+  // unlink objects from data before they're destroyed (they were never hooked)
+  snd_fSoundVolume = fOldSoundVolume;
+  if( pslMixerBuffer!=NULL) FreeMemory(pslMixerBuffer);
+  FOREACHINDYNAMICCONTAINER( cvoVoices, RenderVoice, itrv) {
+    itrv->rv_so.so_pCsdLink = NULL;
+    itrv->rv_so.so_slFlags  = SOF_NONE;
+  }
+  while( cvoVoices.Count()>0) {
+    RenderVoice *prv = cvoVoices.Pointer(0);
+    cvoVoices.Remove(prv);
+    delete prv;
+  }
+}
@@ -0,0 +1,158 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Base/BenchmarkUtil.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Templates/DynamicArray.cpp>
+#include <Engine/Templates/DynamicContainer.cpp>
+#include <Engine/Templates/SlotMap.cpp>
+
+// object of roughly the size of small engine objects
+class CBenchmarkObject {
+public:
+  INDEX bo_iValue;
+  FLOAT bo_afData[7];
+  CBenchmarkObject(void) { bo_iValue = 0; };
+  void Clear(void) { bo_iValue = 0; };
+};
+
+// time typical operations of dynamic arrays, containers and slot maps
+void ContainerBenchmark(void *pArgs)
+{
+  INDEX ctObjects = NEXTARGUMENT(INDEX);
+  // deleting from dynamic arrays is quadratic, so keep it within reason
+  ctObjects = Clamp(ctObjects, (INDEX)100, (INDEX)50000);
+  CPrintF("Container benchmark with %d objects:\n", ctObjects);
+  CBenchmarkTimer bt;
+
+  CStaticArray<CBenchmarkObject*> apbo;
+  apbo.New(ctObjects);
+  INDEX iSum = 0;
+
+  // dynamic array
+  {
+    CDynamicArray<CBenchmarkObject> da;
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      apbo[i] = da.New();
+    }
+    bt.Print("CDynamicArray New()", ctObjects);
+    BenchmarkShuffle(apbo);
+    da.Lock();
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      iSum += da.Index(apbo[i]);
+    }
+    bt.Print("CDynamicArray Index()", ctObjects);
+    da.Unlock();
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      da.Delete(apbo[i]);
+    }
+    bt.Print("CDynamicArray Delete()", ctObjects);
+  }
+
+  // dynamic container
+  {
+    CDynamicArray<CBenchmarkObject> da;
+    CDynamicContainer<CBenchmarkObject> dc;
+    CBenchmarkObject *abo = da.New(ctObjects);
+    for (INDEX i=0; i<ctObjects; i++) {
+      apbo[i] = abo+i;
+    }
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      dc.Add(apbo[i]);
+    }
+    bt.Print("CDynamicContainer Add()", ctObjects);
+    BenchmarkShuffle(apbo);
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      dc.Remove(apbo[i]);
+    }
+    bt.Print("CDynamicContainer Remove()", ctObjects);
+  }
+
+  // slot map
+  {
+    CSlotMap<CBenchmarkObject> sm;
+    CStaticArray<ULONG> aulHandles;
+    aulHandles.New(ctObjects);
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      apbo[i] = sm.New();
+    }
+    bt.Print("CSlotMap New()", ctObjects);
+    BenchmarkShuffle(apbo);
+    sm.Lock();
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      iSum += sm.Index(apbo[i]);
+    }
+    bt.Print("CSlotMap Index()", ctObjects);
+    sm.Unlock();
+    for (INDEX i=0; i<ctObjects; i++) {
+      aulHandles[i] = sm.GetHandle(apbo[i]);
+    }
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      iSum += sm.FromHandle(aulHandles[i])->bo_iValue;
+    }
+    bt.Print("CSlotMap FromHandle()", ctObjects);
+    bt.Start();
+    {FOREACHINDYNAMICARRAY(sm, CBenchmarkObject, itbo) {
+      iSum += itbo->bo_iValue;
+    }}
+    bt.Print("CSlotMap iteration", ctObjects);
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      sm.Delete(apbo[i]);
+    }
+    bt.Print("CSlotMap Delete()", ctObjects);
+    // handles of deleted objects must not be valid any more
+    INDEX ctStale = 0;
+    for (INDEX i=0; i<ctObjects; i++) {
+      ctStale += sm.FromHandle(aulHandles[i])!=NULL;
+    }
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      apbo[i] = sm.New();
+    }
+    bt.Print("CSlotMap New() reusing", ctObjects);
+    // churn, as when entities are created and destroyed
+    bt.Start();
+    for (INDEX i=0; i<ctObjects; i++) {
+      sm.Delete(apbo[i]);
+      apbo[i] = sm.New();
+    }
+    bt.Print("CSlotMap Delete()+New()", ctObjects);
+    for (INDEX i=0; i<ctObjects; i++) {
+      sm.Delete(apbo[i]);
+    }
+    bt.Start();
+    sm.Compact();
+    bt.Print("CSlotMap Compact()", ctObjects);
+    if (ctStale>0 || sm.Count()!=0 || sm.sm_aiFreeSlots.Count()!=0) {
+      CPrintF("  ERROR: %d stale handles valid, %d objects and %d deleted ones left\n",
+        ctStale, sm.Count(), sm.sm_aiFreeSlots.Count());
+    }
+  }
+  // use the result so that lookups are not optimized away
+  if (iSum==-1) {
+    CPrintF("\n");
+  }
+}
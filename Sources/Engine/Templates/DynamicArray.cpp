@@ -37,6 +37,7 @@ class CDABlockInfo {
 public:
   CListNode bi_ListNode;
   void *bi_Memory;
+  INDEX bi_ctObjects;   // number of objects in block (not counting the extra one)
 };
 
 /*
@@ -178,6 +179,7 @@ Type *CDynamicArray<Type>::AllocBlock(INDEX iCount) {
   da_BlocksList.AddTail(pbi->bi_ListNode);
   // remember block memory
   pbi->bi_Memory = ptBlock;
+  pbi->bi_ctObjects = iCount;
   return ptBlock;
 }
 
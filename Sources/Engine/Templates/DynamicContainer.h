@@ -40,16 +40,19 @@ public:
   /* Copy constructor. */
   CDynamicContainer(CDynamicContainer<Type> &coOriginal);
   /* Destructor -- frees all memory. */
-  ~CDynamicContainer(void);
+  virtual ~CDynamicContainer(void);
+
+  // adding, removing and finding objects is virtual, so that derived containers
+  // can keep track of their members even when used through a base reference
 
   /* Add a given object to container. */
-  void Add(Type *ptNewObject);
+  virtual void Add(Type *ptNewObject);
   /* Remove a given object from container. */
-  void Remove(Type *ptOldObject);
+  virtual void Remove(Type *ptOldObject);
   /* Remove all objects, and reset the container to initial (empty) state. */
-  void Clear(void);
+  virtual void Clear(void);
   /* Test if a given object is in the container. */
-  BOOL IsMember(Type *ptOldObject);
+  virtual BOOL IsMember(Type *ptOldObject);
 
   /* Get pointer to a object from it's index. */
   Type *Pointer(INDEX iObject);
@@ -67,7 +70,7 @@ public:
   /* Unlock after getting indices. */
   void Unlock(void);
   /* Get index of a object from it's pointer. */
-  INDEX Index(Type *ptObject);
+  virtual INDEX Index(Type *ptObject);
   /* Get first object in container (there must be at least one when calling this). */
   Type &GetFirst(void);
 };
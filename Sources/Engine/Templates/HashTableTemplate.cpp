@@ -240,13 +240,19 @@ void CHashTable_TYPE::Add(TYPE *ptNew)
 void CHashTable_TYPE::Remove(TYPE *ptOld)
 {
   ASSERT(ht_ctCompartments>0 && ht_ctSlotsPerComp>0);
-  // find its slot
+  // find compartment number
   VALUE_TYPE Value = ht_GetItemValue(ptOld);
-  CHashTableSlot_TYPE *phts = FindSlot(ht_GetItemKey(Value), Value);
-  if( phts!=NULL) {
-    // mark slot as unused
-    ASSERT( phts->hts_ptElement==ptOld);
-    phts->hts_ptElement = NULL;
+  INDEX iComp = ht_GetItemKey(Value)%ht_ctCompartments;
+
+  // find the slot with exactly this element (other elements may have same value)
+  INDEX iSlot = iComp*ht_ctSlotsPerComp;
+  for(INDEX iSlotInComp=0; iSlotInComp<ht_ctSlotsPerComp; iSlotInComp++, iSlot++) {
+    CHashTableSlot_TYPE *phts = &ht_ahtsSlots[iSlot];
+    if (phts->hts_ptElement==ptOld) {
+      // mark slot as unused
+      phts->hts_ptElement = NULL;
+      return;
+    }
   }
 }
 
@@ -0,0 +1,32 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#include "Engine/StdH.h"
+
+#include <Engine/Entities/Entity.h>
+
+#define TYPE CEntity
+#define VALUE_TYPE ULONG
+#define CHashTable_TYPE CHashTable_CEntity
+#define CHashTableSlot_TYPE CHashTableSlot_CEntity
+
+#include <Engine/Templates/HashTableTemplate.h>
+#include <Engine/Templates/HashTableTemplate.cpp>
+
+#undef CHashTableSlot_TYPE
+#undef CHashTable_TYPE
+#undef VALUE_TYPE
+#undef TYPE
+
@@ -0,0 +1,382 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_SLOTMAP_CPP
+#define SE_INCL_SLOTMAP_CPP
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <new>
+
+#include <Engine/Templates/SlotMap.h>
+#include <Engine/Templates/DynamicArray.cpp>
+#include <Engine/Templates/StaticArray.cpp>
+#include <Engine/Templates/StaticStackArray.cpp>
+
+#define SLOTMAP_GENERATIONMASK (0xFFFFFFFFUL>>SLOTMAP_INDEXBITS)
+
+static inline ULONG SlotMapHash(const void *pvObject)
+{
+  return ULONG(((size_t)pvObject)>>4)*2654435761UL;
+}
+
+// advance generation of a slot, skipping the one that would give null handles
+static inline void NextSlotGeneration(CSlotMapSlot &sms)
+{
+  sms.sms_ulGeneration++;
+  if ((sms.sms_ulGeneration&SLOTMAP_GENERATIONMASK)==0) {
+    sms.sms_ulGeneration++;
+  }
+}
+
+/*
+ * Default constructor.
+ */
+template<class Type>
+CSlotMap<Type>::CSlotMap(void) {
+  sm_asSlots.SetAllocationStep(256);
+  sm_aiFreeSlots.SetAllocationStep(256);
+  sm_aiEmptySlots.SetAllocationStep(256);
+  sm_ctHashed = 0;
+}
+
+/*
+ * Destructor -- frees all memory.
+ */
+template<class Type>
+CSlotMap<Type>::~CSlotMap(void) {
+  Clear();
+}
+
+/*
+ * Destroy all objects, and reset the array to initial (empty) state.
+ */
+template<class Type>
+void CSlotMap<Type>::Clear(void) {
+  ASSERT(this!=NULL);
+  CDynamicArray<Type>::Clear();
+  sm_asSlots.Clear();
+  sm_aiFreeSlots.Clear();
+  sm_aiEmptySlots.Clear();
+  sm_aiHashed.Clear();
+  sm_ctHashed = 0;
+}
+
+/*
+ * Find hash entry of an object, or empty entry where it belongs.
+ */
+template<class Type>
+INDEX CSlotMap<Type>::FindHashed(Type *ptObject) const {
+  const INDEX ctEntries = sm_aiHashed.Count();
+  if (ctEntries==0) {
+    return -1;
+  }
+  INDEX iEntry = SlotMapHash(ptObject)&(ctEntries-1);
+  FOREVER {
+    const INDEX iSlot = sm_aiHashed[iEntry];
+    if (iSlot<0 || sm_asSlots[iSlot].sms_pvObject==ptObject) {
+      return iEntry;
+    }
+    iEntry = (iEntry+1)&(ctEntries-1);
+  }
+}
+
+/*
+ * Rebuild the hash to have at least given size.
+ */
+template<class Type>
+void CSlotMap<Type>::Rehash(INDEX ctMinimum) {
+  // keep the hash at most half full
+  INDEX ctEntries = 64;
+  while (ctEntries<ctMinimum*2) {
+    ctEntries*=2;
+  }
+  sm_aiHashed.Clear();
+  sm_aiHashed.New(ctEntries);
+  for (INDEX iEntry=0; iEntry<ctEntries; iEntry++) {
+    sm_aiHashed[iEntry] = -1;
+  }
+  sm_ctHashed = 0;
+  // add all objects that have memory
+  for (INDEX iSlot=0; iSlot<sm_asSlots.Count(); iSlot++) {
+    Type *ptObject = (Type *)sm_asSlots[iSlot].sms_pvObject;
+    if (ptObject!=NULL) {
+      sm_aiHashed[FindHashed(ptObject)] = iSlot;
+      sm_ctHashed++;
+    }
+  }
+}
+
+/*
+ * Add a new object to a slot.
+ */
+template<class Type>
+void CSlotMap<Type>::AddSlot(Type *ptObject) {
+  // reuse a slot without memory if possible, to keep its generation
+  INDEX iSlot;
+  if (sm_aiEmptySlots.Count()>0) {
+    iSlot = sm_aiEmptySlots.Pop();
+  } else {
+    iSlot = sm_asSlots.Count();
+    ASSERT(iSlot<=(INDEX)SLOTMAP_INDEXMASK);
+    sm_asSlots.Push().sms_ulGeneration = 1;
+  }
+  CSlotMapSlot &sms = sm_asSlots[iSlot];
+  sms.sms_pvObject = ptObject;
+  sms.sms_iIndex = -1;
+
+  if ((sm_ctHashed+1)*2>sm_aiHashed.Count()) {
+    Rehash(sm_ctHashed+1);
+  } else {
+    sm_aiHashed[FindHashed(ptObject)] = iSlot;
+    sm_ctHashed++;
+  }
+}
+
+/*
+ * Get slot of a member.
+ */
+template<class Type>
+INDEX CSlotMap<Type>::GetSlot(Type *ptMember) const {
+  INDEX iEntry = FindHashed(ptMember);
+  if (iEntry<0 || sm_aiHashed[iEntry]<0) {
+    ASSERTALWAYS("CSlotMap<>::GetSlot(): Not a member of this array!");
+    return -1;
+  }
+  return sm_aiHashed[iEntry];
+}
+
+/*
+ * Create a given number of new members.
+ */
+template<class Type>
+Type *CSlotMap<Type>::New(INDEX iCount /*= 1*/) {
+  ASSERT(this!=NULL && iCount>=0);
+  // if no new members are needed in fact
+  if (iCount==0) {
+    // do nothing
+    return NULL;
+  }
+
+  // if single object and there is a deleted one
+  if (iCount==1 && sm_aiFreeSlots.Count()>0) {
+    // reuse it
+    CSlotMapSlot &sms = sm_asSlots[sm_aiFreeSlots.Pop()];
+    Type *ptObject = (Type *)sms.sms_pvObject;
+    // construct it anew, as deleting only cleared it
+    ptObject->~Type();
+    ::new(ptObject) Type;
+    this->GrowPointers(1);
+    sms.sms_iIndex = this->da_Count-1;
+    this->da_Pointers[sms.sms_iIndex] = ptObject;
+    return ptObject;
+  }
+
+  // otherwise allocate a new block
+  INDEX iOldCount = this->da_Count;
+  this->GrowPointers(iCount);
+  Type *ptBlock = this->AllocBlock(iCount);
+  for (INDEX iNewMember=0; iNewMember<iCount; iNewMember++) {
+    Type *ptObject = ptBlock+iNewMember;
+    this->da_Pointers[iOldCount+iNewMember] = ptObject;
+    AddSlot(ptObject);
+    sm_asSlots[GetSlot(ptObject)].sms_iIndex = iOldCount+iNewMember;
+  }
+  return ptBlock;
+}
+
+/*
+ * Delete a given member.
+ */
+template<class Type>
+void CSlotMap<Type>::Delete(Type *ptMember) {
+  ASSERT(this!=NULL);
+#if CHECKARRAYLOCKING
+  // check that not locked for indices
+  ASSERT(this->da_LockCt == 0);
+#endif
+
+  // clear the object
+  ::Clear(*ptMember);
+
+  const INDEX iSlot = GetSlot(ptMember);
+  CSlotMapSlot &sms = sm_asSlots[iSlot];
+  const INDEX iMember = sms.sms_iIndex;
+  ASSERT(iMember>=0 && iMember<this->da_Count);
+  // move last pointer here
+  Type *ptLast = this->da_Pointers[this->da_Count-1];
+  if (ptLast!=ptMember) {
+    this->da_Pointers[iMember] = ptLast;
+    sm_asSlots[GetSlot(ptLast)].sms_iIndex = iMember;
+  }
+  // shrink pointers by one
+  this->ShrinkPointers(1);
+  // keep the object for reuse, but invalidate its handles
+  sms.sms_iIndex = -1;
+  NextSlotGeneration(sms);
+  sm_aiFreeSlots.Push() = iSlot;
+}
+
+/*
+ * Release memory of deleted objects where whole blocks of them are unused.
+ */
+template<class Type>
+void CSlotMap<Type>::Compact(void) {
+  ASSERT(this!=NULL);
+  // if nothing is deleted
+  if (sm_aiFreeSlots.Count()==0) {
+    // nothing to release
+    return;
+  }
+
+  // for all memory blocks
+  BOOL bReleased = FALSE;
+  FORDELETELIST(CDABlockInfo, bi_ListNode, this->da_BlocksList, itBlock) {
+    Type *ptBlock = (Type *)itBlock->bi_Memory;
+    const INDEX ctObjects = itBlock->bi_ctObjects;
+    // if any object in block exists
+    BOOL bUsed = FALSE;
+    for (INDEX iObject=0; iObject<ctObjects; iObject++) {
+      if (sm_asSlots[GetSlot(ptBlock+iObject)].sms_iIndex>=0) {
+        bUsed = TRUE;
+        break;
+      }
+    }
+    if (bUsed) {
+      // keep the block
+      continue;
+    }
+    // detach its objects from their slots
+    for (INDEX iObject=0; iObject<ctObjects; iObject++) {
+      const INDEX iSlot = GetSlot(ptBlock+iObject);
+      sm_asSlots[iSlot].sms_pvObject = NULL;
+      sm_aiEmptySlots.Push() = iSlot;
+    }
+    // free memory used by block
+    itBlock->bi_ListNode.Remove();
+    delete[] ptBlock;
+    delete &itBlock.Current();
+    bReleased = TRUE;
+  }
+  // if anything was released, forget it in hash
+  if (bReleased) {
+    Rehash(sm_asSlots.Count()-sm_aiEmptySlots.Count());
+  }
+
+  // keep only deleted objects that still have memory
+  INDEX ctFree = 0;
+  for (INDEX iFree=0; iFree<sm_aiFreeSlots.Count(); iFree++) {
+    const INDEX iSlot = sm_aiFreeSlots[iFree];
+    if (sm_asSlots[iSlot].sms_pvObject!=NULL) {
+      sm_aiFreeSlots[ctFree++] = iSlot;
+    }
+  }
+  sm_aiFreeSlots.PopUntil(ctFree-1);
+}
+
+/*
+ * Move all elements of another array into this one.
+ */
+template<class Type>
+void CSlotMap<Type>::MoveArray(CSlotMap<Type> &smOther) {
+  ASSERT(this!=NULL && &smOther!=NULL);
+  // if the other array has no elements, its blocks are not moved, so it keeps its slots too
+  if (smOther.da_Count==0) {
+    return;
+  }
+  // take over slots of all objects of other array
+  const INDEX iOldCount = this->da_Count;
+  for (INDEX iSlot=0; iSlot<smOther.sm_asSlots.Count(); iSlot++) {
+    const CSlotMapSlot &smsOther = smOther.sm_asSlots[iSlot];
+    if (smsOther.sms_pvObject==NULL) {
+      continue;
+    }
+    Type *ptObject = (Type *)smsOther.sms_pvObject;
+    AddSlot(ptObject);
+    const INDEX iNewSlot = GetSlot(ptObject);
+    if (smsOther.sms_iIndex>=0) {
+      sm_asSlots[iNewSlot].sms_iIndex = iOldCount+smsOther.sms_iIndex;
+    } else {
+      sm_aiFreeSlots.Push() = iNewSlot;
+    }
+  }
+  // move the objects
+  CDynamicArray<Type>::MoveArray(smOther);
+  smOther.sm_asSlots.Clear();
+  smOther.sm_aiFreeSlots.Clear();
+  smOther.sm_aiEmptySlots.Clear();
+  smOther.sm_aiHashed.Clear();
+  smOther.sm_ctHashed = 0;
+}
+
+/* Test if a given object is in the array. */
+template<class Type>
+BOOL CSlotMap<Type>::IsMember(Type *ptObject) const {
+  ASSERT(this!=NULL);
+  INDEX iEntry = FindHashed(ptObject);
+  if (iEntry<0 || sm_aiHashed[iEntry]<0) {
+    return FALSE;
+  }
+  return sm_asSlots[sm_aiHashed[iEntry]].sms_iIndex>=0;
+}
+
+/*
+ * Get index of a member from it's pointer.
+ */
+template<class Type>
+INDEX CSlotMap<Type>::Index(Type *ptMember) {
+  ASSERT(this!=NULL);
+#if CHECKARRAYLOCKING
+  // check that locked for indices
+  ASSERT(this->da_LockCt>0);
+#endif
+  INDEX iMember = sm_asSlots[GetSlot(ptMember)].sms_iIndex;
+  ASSERT(iMember>=0);
+  return iMember;
+}
+
+/*
+ * Get handle of a member.
+ */
+template<class Type>
+ULONG CSlotMap<Type>::GetHandle(Type *ptMember) const {
+  ASSERT(this!=NULL);
+  const INDEX iSlot = GetSlot(ptMember);
+  if (iSlot<0) {
+    return SLOTMAP_NOHANDLE;
+  }
+  return ((sm_asSlots[iSlot].sms_ulGeneration&SLOTMAP_GENERATIONMASK)<<SLOTMAP_INDEXBITS)|ULONG(iSlot);
+}
+
+/*
+ * Get member from its handle, or NULL if deleted in the meantime.
+ */
+template<class Type>
+Type *CSlotMap<Type>::FromHandle(ULONG ulHandle) {
+  ASSERT(this!=NULL);
+  const INDEX iSlot = ulHandle&SLOTMAP_INDEXMASK;
+  if (ulHandle==SLOTMAP_NOHANDLE || iSlot>=sm_asSlots.Count()) {
+    return NULL;
+  }
+  const CSlotMapSlot &sms = sm_asSlots[iSlot];
+  if (sms.sms_iIndex<0 || (sms.sms_ulGeneration&SLOTMAP_GENERATIONMASK)!=(ulHandle>>SLOTMAP_INDEXBITS)) {
+    return NULL;
+  }
+  return (Type *)sms.sms_pvObject;
+}
+
+
+#endif  /* include-once check. */
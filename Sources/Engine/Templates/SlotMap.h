@@ -0,0 +1,94 @@
+/* Copyright (c) 2002-2012 Croteam Ltd. 
+This program is free software; you can redistribute it and/or modify
+it under the terms of version 2 of the GNU General Public License as published by
+the Free Software Foundation
+
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program; if not, write to the Free Software Foundation, Inc.,
+51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
+
+#ifndef SE_INCL_SLOTMAP_H
+#define SE_INCL_SLOTMAP_H
+#ifdef PRAGMA_ONCE
+  #pragma once
+#endif
+
+#include <Engine/Templates/DynamicArray.h>
+#include <Engine/Templates/StaticArray.h>
+#include <Engine/Templates/StaticStackArray.h>
+
+// handle of an object in a slot map, holding slot index and its generation
+#define SLOTMAP_INDEXBITS 20
+#define SLOTMAP_INDEXMASK ((1UL<<SLOTMAP_INDEXBITS)-1)
+#define SLOTMAP_NOHANDLE  0UL
+
+class CSlotMapSlot {
+public:
+  void *sms_pvObject;       // object in this slot, NULL if its memory was released
+  ULONG sms_ulGeneration;   // increased each time the object is deleted
+  INDEX sms_iIndex;         // index among existing objects, -1 if deleted
+};
+
+/*
+ * Dynamic array that knows where each of its objects is, so that deleting, getting index
+ * and testing membership don't have to search. Deleted objects are reused by next New().
+ * Objects can be referred to by handles that become invalid when the object is deleted.
+ * Can be iterated with FOREACHINDYNAMICARRAY like any dynamic array.
+ */
+template<class Type>
+class CSlotMap : public CDynamicArray<Type> {
+public:
+  CStaticStackArray<CSlotMapSlot> sm_asSlots;  // all slots
+  CStaticStackArray<INDEX> sm_aiFreeSlots;     // slots with deleted objects, for reuse
+  CStaticStackArray<INDEX> sm_aiEmptySlots;    // slots whose object memory was released
+  CStaticArray<INDEX> sm_aiHashed;             // slots hashed by object pointer, -1 if none
+  INDEX sm_ctHashed;                           // number of used hash entries
+
+  /* Add a new object to a slot. */
+  void AddSlot(Type *ptObject);
+  /* Find hash entry of an object, or empty entry where it belongs. */
+  INDEX FindHashed(Type *ptObject) const;
+  /* Rebuild the hash to have at least given size. */
+  void Rehash(INDEX ctMinimum);
+  /* Get slot of a member. */
+  INDEX GetSlot(Type *ptMember) const;
+
+  // copying is not supported
+  CSlotMap(CSlotMap<Type> &smOriginal);
+  CSlotMap<Type> &operator=(CSlotMap<Type> &smOriginal);
+public:
+  /* Default constructor. */
+  CSlotMap(void);
+  /* Destructor -- frees all memory. */
+  ~CSlotMap(void);
+
+  /* Create a given number of new objects (if more than one, they are consecutive in memory). */
+  Type *New(INDEX iCount = 1);
+  /* Destroy a given member. */
+  void Delete(Type *ptMember);
+  /* Destroy all objects, and reset the array to initial (empty) state. */
+  void Clear(void);
+  /* Release memory of deleted objects where whole blocks of them are unused. */
+  void Compact(void);
+  /* Move all elements of another array into this one. */
+  void MoveArray(CSlotMap<Type> &smOther);
+
+  /* Test if a given object is in the array. */
+  BOOL IsMember(Type *ptObject) const;
+  /* Get index of a object from it's pointer. */
+  INDEX Index(Type *ptMember);
+
+  /* Get handle of a member. */
+  ULONG GetHandle(Type *ptMember) const;
+  /* Get member from its handle, or NULL if deleted in the meantime. */
+  Type *FromHandle(ULONG ulHandle);
+};
+
+
+#endif  /* include-once check. */
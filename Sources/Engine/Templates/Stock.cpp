@@ -14,6 +14,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA. */
 
 #include <Engine/Base/Stream.h>
+#include <Engine/Base/Allocator.h>
 
 #include <Engine/Templates/DynamicContainer.cpp>
 
@@ -55,6 +56,9 @@ TYPE *CStock_TYPE::Obtain_t(const CTFileName &fnmFileName)
 
   /* if not found, */
 
+  // everything the object loads is accounted to stock
+  CMemoryTagScope mtsStock(MTG_STOCK);
+
   // create new stock object
   TYPE *ptNew = new TYPE;
   ptNew->ser_FileName = fnmFileName;
@@ -22,15 +22,15 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/Serial.h>
 #include <Engine/Base/Lists.h>
 #include <Engine/Templates/StaticArray.h>
-#include <Engine/Templates/DynamicArray.h>
-#include <Engine/Templates/DynamicArray.cpp>
+#include <Engine/Templates/SlotMap.h>
+#include <Engine/Templates/SlotMap.cpp>
 
 /*
  * Terrain archive class -- a collection of terrains used by a level.
  */
 class ENGINE_API CTerrainArchive : public CSerial {
 public:
-  CDynamicArray<CTerrain> ta_atrTerrains; // all the terrains in archive
+  CSlotMap<CTerrain> ta_atrTerrains;      // all the terrains in archive
   CWorld *ta_pwoWorld;  // the world
 
   // overrides from CSerial
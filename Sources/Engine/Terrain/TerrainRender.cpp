@@ -109,6 +109,8 @@ inline static void SetMatrixDiagonal(Matrix12 &mat,FLOAT fValue)
 // Set texture matrix
 static inline void gfxSetTextureMatrix2(Matrix12 *pMatrix)
 {
+  // only OpenGL has texture matrix here
+  if( _pGfx->gl_eCurrentAPI!=GAT_OGL) return;
   pglMatrixMode( GL_TEXTURE);
   if(pMatrix==NULL) {
     pglLoadIdentity();
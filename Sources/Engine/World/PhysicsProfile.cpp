@@ -30,6 +30,8 @@ CPhysicsProfile::CPhysicsProfile(void)
   SETTIMERNAME(PTI_HANDLETIMERS,    " handling timers", "");
   SETTIMERNAME(PTI_HANDLEMOVERS,    " handling movers", "");
   SETTIMERNAME(PTI_WORLDBASETICK,   " WorldBase tick", "");
+  SETTIMERNAME(PTI_HANDLESENTEVENTS, "HandleSentEvents()", "event");
+  SETTIMERNAME(PTI_CASTRAY,         "CCastRay::Cast()", "ray");
 
   SETTIMERNAME(PTI_PREMOVING,       "PreMoving()", "move");
   SETTIMERNAME(PTI_POSTMOVING,      "PostMoving()", "move");
@@ -109,5 +111,8 @@ CPhysicsProfile::CPhysicsProfile(void)
   SETCOUNTERNAME(PCI_NEARCELLSFOUND,  "cells found in FindEntitiesNearBox()");
   SETCOUNTERNAME(PCI_NEAROCCUPIEDCELLSFOUND, "occupied cells found in FindEntitiesNearBox()");
   SETCOUNTERNAME(PCI_NEARENTITIESFOUND,  "entities found in FindEntitiesNearBox()");
+
+  SETCOUNTERNAME(PCI_SENTEVENTS, "handled sent events");
+  SETCOUNTERNAME(PCI_CASTRAYS,   "cast rays");
 }
 
@@ -36,6 +36,8 @@ public:
     PTI_HANDLETIMERS,
     PTI_HANDLEMOVERS,
     PTI_WORLDBASETICK,
+    PTI_HANDLESENTEVENTS,
+    PTI_CASTRAY,
 
     PTI_DUMMY1,
 
@@ -122,6 +124,9 @@ public:
     PCI_NEARCELLSFOUND,           // cells found in FindEntitiesNearBox()
     PCI_NEAROCCUPIEDCELLSFOUND,   // occupied cells found in FindEntitiesNearBox()
     PCI_NEARENTITIESFOUND,        // near entities found in FindEntitiesNearBox()
+
+    PCI_SENTEVENTS,               // number of handled sent events
+    PCI_CASTRAYS,                 // number of cast rays
     PCI_COUNT
   };
   // constructor
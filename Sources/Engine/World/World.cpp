@@ -16,6 +16,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/StdH.h>
 
 #include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
 #include <Engine/Math/Float.h>
 #include <Engine/World/World.h>
 #include <Engine/World/WorldEditingProfile.h>
@@ -38,6 +40,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Base/ProgressHook.h>
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Templates/Selection.cpp>
+#include <Engine/Templates/SlotMap.cpp>
 #include <Engine/Terrain/Terrain.h>
 
 #include <Engine/Templates/Stock_CEntityClass.h>
@@ -82,6 +85,77 @@ CTextureBlending::CTextureBlending(void)
   tb_colMultiply = C_WHITE|0xFF;
 }
 
+/////////////////////////////////////////////////////////////////////
+// CWorldEntityContainer
+
+/* Constructor for given slot in entities. */
+CWorldEntityContainer::CWorldEntityContainer(INDEX iSlot)
+{
+  ASSERT(iSlot>=0 && iSlot<2);
+  wec_iSlot = iSlot;
+}
+
+/* Add a given entity to container. */
+void CWorldEntityContainer::Add(CEntity *pen)
+{
+  pen->en_aiWorldSlots[wec_iSlot] = Count();
+  CDynamicContainer<CEntity>::Add(pen);
+}
+
+/* Remove a given entity from container. */
+void CWorldEntityContainer::Remove(CEntity *pen)
+{
+#if CHECKARRAYLOCKING
+  // check that not locked for indices
+  ASSERT(dc_LockCt == 0);
+#endif
+  ASSERT(IsMember(pen));
+  // move last entity to its place
+  INDEX iMember = pen->en_aiWorldSlots[wec_iSlot];
+  CEntity *penLast = sa_Array[Count()-1];
+  sa_Array[iMember] = penLast;
+  penLast->en_aiWorldSlots[wec_iSlot] = iMember;
+  Pop();
+  pen->en_aiWorldSlots[wec_iSlot] = -1;
+}
+
+/* Remove all entities from container. */
+void CWorldEntityContainer::Clear(void)
+{
+  for (INDEX iMember=0; iMember<Count(); iMember++) {
+    sa_Array[iMember]->en_aiWorldSlots[wec_iSlot] = -1;
+  }
+  CDynamicContainer<CEntity>::Clear();
+}
+
+/* Test if a given entity is in the container. */
+BOOL CWorldEntityContainer::IsMember(CEntity *pen)
+{
+  INDEX iMember = pen->en_aiWorldSlots[wec_iSlot];
+  return iMember>=0 && iMember<Count() && sa_Array[iMember]==pen;
+}
+
+/* Get index of an entity from its pointer. */
+INDEX CWorldEntityContainer::Index(CEntity *pen)
+{
+#if CHECKARRAYLOCKING
+  // check that locked for indices
+  ASSERT(dc_LockCt>0);
+#endif
+  ASSERT(IsMember(pen));
+  return pen->en_aiWorldSlots[wec_iSlot];
+}
+
+// callbacks for hashing entities by IDs
+static ULONG GetEntityIDKey(ULONG &ulID)
+{
+  return ulID;
+}
+static ULONG GetEntityID(CEntity *pen)
+{
+  return pen->en_ulID;
+}
+
 /*
  * Constructor.
  */
@@ -89,9 +163,11 @@ CWorld::CWorld(void)
   : wo_pecWorldBaseClass(NULL)      // worldbase class must be obtained before using the world
   , wo_baBrushes(*new CBrushArchive)
   , wo_taTerrains(*new CTerrainArchive)
+  , wo_cenAllEntities(1)
   , wo_colBackground(C_lGRAY)       // clear background color
   , wo_ulSpawnFlags(0)
   , wo_bPortalLinksUpToDate(FALSE)  // portal-sector links must be updated
+  , wo_cenEntities(0)
 {
   wo_baBrushes.ba_pwoWorld = this;
   wo_taTerrains.ta_pwoWorld = this;
@@ -117,6 +193,9 @@ CWorld::CWorld(void)
   wo_fRtL = wo_fRtH = 1.0f; wo_fRtCZ = wo_fRtCY = 0.0f;
 
   wo_ulNextEntityID = 1;
+  // entity IDs are sequential, so they spread evenly over compartments
+  wo_htEntitiesByID.SetAllocationParameters(1024, 4, 4);
+  wo_htEntitiesByID.SetCallbacks(GetEntityIDKey, GetEntityID);
 
   // set default placement
   wo_plFocus = CPlacement3D( FLOAT3D(3.0f, 4.0f, 10.0f),
@@ -175,6 +254,7 @@ void CWorld::Clear(void)
     ASSERT(wo_cenAllEntities.Count()==0);
     wo_cenEntities.Clear();
     wo_cenAllEntities.Clear();
+    wo_htEntitiesByID.Reset();
     cenToDestroy.Clear();
     wo_ulNextEntityID = 1;
   }
@@ -224,6 +304,7 @@ CEntity *CWorld::CreateEntity(const CPlacement3D &plPlacement, CEntityClass *pec
   wo_cenAllEntities.Add(penEntity);
   // set a new identifier
   penEntity->en_ulID = wo_ulNextEntityID++;
+  wo_htEntitiesByID.Add(penEntity);
   // set up the placement
   penEntity->en_plPlacement = plPlacement;
   // calculate rotation matrix
@@ -1103,16 +1184,73 @@ void CWorld::DeletePredictors(void)
   }
 }
 
-// get entity by its ID
-CEntity *CWorld::EntityFromID(ULONG ulID)
+// time predictor setup with everything predictable marked for prediction
+void PredictorBenchmark(void *pArgs)
 {
-  FOREACHINDYNAMICCONTAINER(wo_cenAllEntities, CEntity, iten) {
-    if (iten->en_ulID==ulID) {
-      return iten;
+  INDEX ctFrames = NEXTARGUMENT(INDEX);
+  ctFrames = Clamp(ctFrames, (INDEX)1, (INDEX)1000);
+
+  CWorld &wo = _pNetwork->ga_World;
+  if (wo.wo_cenPredictable.Count()==0) {
+    CPrintF("No predictable entities in current world.\n");
+    return;
+  }
+  CSessionState &ses = _pNetwork->ga_sesSessionState;
+  const ULONG ulRandomOld = ses.ses_ulRandomSeed;
+  const ULONG ulEntityIDOld = wo.wo_ulNextEntityID;
+  wo.DeletePredictors();
+  wo.UnmarkForPrediction();
+
+  INDEX ctPredictors = 0;
+  CTimerValue tvCreate((__int64) 0);
+  CTimerValue tvDelete((__int64) 0);
+  for (INDEX iFrame=0; iFrame<ctFrames; iFrame++) {
+    // mark everything that can be predicted, as if all was in range
+    for (INDEX iPlayer=0; iPlayer<CEntity::GetMaxPlayers(); iPlayer++) {
+      CEntity *pen = CEntity::GetPlayerEntity(iPlayer);
+      if (pen!=NULL) {
+        pen->AddToPrediction();
+      }
     }
+    {FOREACHINDYNAMICCONTAINER(wo.wo_cenPredictable, CEntity, iten) {
+      iten->AddToPrediction();
+    }}
+    // set up predictors as ProcessPrediction() does
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    wo.CreatePredictors();
+    tvCreate += _pTimer->GetHighPrecisionTimer()-tvStart;
+    ctPredictors = wo.wo_cenPredictor.Count();
+    // and remove them as a real tick does
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    wo.DeletePredictors();
+    tvDelete += _pTimer->GetHighPrecisionTimer()-tvStart;
+    wo.wo_ulNextEntityID = ulEntityIDOld;
   }
-  ASSERT(FALSE);
-  return NULL;
+
+  CPrintF("Predictor setup for %d predictable entities, %d frames (%d predictors):\n",
+    wo.wo_cenPredictable.Count(), ctFrames, ctPredictors);
+  CPrintF("  %8.3f ms create, %8.3f ms delete per frame\n",
+    tvCreate.GetSeconds()*1000.0/ctFrames, tvDelete.GetSeconds()*1000.0/ctFrames);
+
+  ses.ses_ulRandomSeed = ulRandomOld;
+  wo.wo_ulNextEntityID = ulEntityIDOld;
+}
+
+// get entity by its ID
+CEntity *CWorld::EntityFromID(ULONG ulID)
+{
+  CEntity *pen = wo_htEntitiesByID.Find(ulID);
+  ASSERT(pen!=NULL);
+  return pen;
+}
+
+// change ID of an entity
+void CWorld::SetEntityID(CEntity *pen, ULONG ulID)
+{
+  // rehash the entity under its new ID
+  wo_htEntitiesByID.Remove(pen);
+  pen->en_ulID = ulID;
+  wo_htEntitiesByID.Add(pen);
 }
 
 /* Triangularize selected polygons. */
@@ -27,6 +27,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Math/Placement.h>
 #include <Engine/Templates/StaticArray.h>
 #include <Engine/Templates/DynamicContainer.h>
+#include <Engine/Templates/HashTable_CEntity.h>
 
 class CTextureTransformation;
 class CTextureBlending;
@@ -43,6 +44,29 @@ enum WorldMirrorType {
   WMT_Z,
 };
 
+/*
+ * Container of world's entities that remembers index of each entity in the entity itself,
+ * so that removing, testing membership and getting index don't have to search.
+ */
+class ENGINE_API CWorldEntityContainer : public CDynamicContainer<CEntity> {
+public:
+  INDEX wec_iSlot;    // which of CEntity::en_aiWorldSlots is used by this container
+
+  /* Constructor for given slot in entities. */
+  CWorldEntityContainer(INDEX iSlot);
+
+  /* Add a given entity to container. */
+  void Add(CEntity *pen);
+  /* Remove a given entity from container. */
+  void Remove(CEntity *pen);
+  /* Remove all entities from container. */
+  void Clear(void);
+  /* Test if a given entity is in the container. */
+  BOOL IsMember(CEntity *pen);
+  /* Get index of an entity from its pointer. */
+  INDEX Index(CEntity *pen);
+};
+
 class ENGINE_API CWorld {
 public:
 // implementation:
@@ -63,7 +87,8 @@ public:
 
   CBrushArchive &wo_baBrushes;    // brush archive with all brushes in the world
   CTerrainArchive &wo_taTerrains; // terrain archive with all terrains in the world
-  CDynamicContainer<CEntity> wo_cenAllEntities;  // all entities including deleted but referenced ones
+  CWorldEntityContainer wo_cenAllEntities;  // all entities including deleted but referenced ones
+  CHashTable_CEntity wo_htEntitiesByID;     // all entities hashed by their IDs
   CDynamicContainer<CEntity> wo_cenPredictable;  // predictable entities
   CDynamicContainer<CEntity> wo_cenWillBePredicted;  // entities that will be predicted
   CDynamicContainer<CEntity> wo_cenPredicted;  // predicted entities
@@ -179,11 +204,13 @@ public:
 
   // get entity by its ID
   CEntity *EntityFromID(ULONG ulID);
+  // change ID of an entity
+  void SetEntityID(CEntity *pen, ULONG ulID);
   // triangularize selected polygons
   void TriangularizePolygons(CDynamicContainer<CBrushPolygon> &dcPolygons);
 public:
 // interface:
-  CDynamicContainer<CEntity> wo_cenEntities;           // all entities in the world
+  CWorldEntityContainer wo_cenEntities;           // all entities in the world
 
   TIME wo_WorldGameTick;  // game tick that world is currently in
 
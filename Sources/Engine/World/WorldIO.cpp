@@ -29,6 +29,11 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Network/Network.h>
 #include <Engine/Templates/StaticArray.cpp>
 #include <Engine/Terrain/Terrain.h>
+#include <Engine/Base/Console.h>
+#include <Engine/Base/Shell.h>
+#include <Engine/Base/Timer.h>
+#include <Engine/Math/Functions.h>
+#include <Engine/Base/Allocator.h>
 
 #define WORLDSTATEVERSION_NOCLASSCONTAINER 9
 #define WORLDSTATEVERSION_MULTITEXTURING 8
@@ -131,6 +136,8 @@ void CWorld::Read_t(CTStream *pistrm) // throw char *
 
   // need high FPU precision
   CSetFPUPrecision FPUPrecision(FPT_53BIT);
+  // account world data to world (stock resources it uses have their own tag)
+  CMemoryTagScope mtsWorld(MTG_WORLD);
 
   // clear eventual old data in the world
   Clear();
@@ -619,7 +626,7 @@ void CWorld::ReadState_new_t( CTStream *istr) // throw char *
     // adjust id if needed
     if (_bReadEntitiesByID) {
       wo_ulNextEntityID--;
-      penNew->en_ulID = ulID;
+      SetEntityID(penNew, ulID);
     }
     CallProgressHook_t(FLOAT(iEntity)/ctEntities);
   }}
@@ -838,3 +845,74 @@ void CWorld::WriteInfo_t(CTStream *strm) // throw char *
   // write the world description
   (*strm)<<wo_strDescription;
 }
+
+// find entity by ID by searching all entities, as a reference for the benchmark
+static CEntity *EntityFromIDLinear(CWorld &wo, ULONG ulID)
+{
+  FOREACHINDYNAMICCONTAINER(wo.wo_cenAllEntities, CEntity, iten) {
+    if (iten->en_ulID==ulID) {
+      return iten;
+    }
+  }
+  return NULL;
+}
+
+// measure loading time of a world or a savegame, and entity lookup speed
+void LoadBenchmark(void *pArgs)
+{
+  CTString strFile = *NEXTARGUMENT(CTString*);
+  INDEX ctRepeat = NEXTARGUMENT(INDEX);
+  ctRepeat = Clamp(ctRepeat, (INDEX)1, (INDEX)100);
+  const CTFileName fnmFile = CTString(strFile);
+  const BOOL bWorld = fnmFile.FileExt()==".wld";
+
+  CWorld *pwoTemp = NULL;
+  CTimerValue tvTotal((__int64) 0);
+  try {
+    for (INDEX iRepeat=0; iRepeat<ctRepeat; iRepeat++) {
+      CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+      if (bWorld) {
+        // load into a world of its own
+        delete pwoTemp;
+        pwoTemp = new CWorld;
+        pwoTemp->Load_t(fnmFile);
+      } else {
+        // savegames can only be loaded into the current session
+        _pNetwork->StopGame();
+        _pNetwork->Load_t(fnmFile);
+      }
+      tvTotal += _pTimer->GetHighPrecisionTimer()-tvStart;
+    }
+  } catch (char *strError) {
+    CPrintF("%s\n", strError);
+    delete pwoTemp;
+    return;
+  }
+
+  CWorld &wo = bWorld ? *pwoTemp : _pNetwork->ga_World;
+  const INDEX ctEntities = wo.wo_cenAllEntities.Count();
+  CPrintF("Loading '%s' (%d entities): %.2f ms average of %d\n", (const char *)strFile,
+    ctEntities, tvTotal.GetSeconds()*1000.0/ctRepeat, ctRepeat);
+
+  // look up each entity by its ID, through the hash and by searching
+  if (ctEntities>0) {
+    CStaticArray<ULONG> aulIDs;
+    aulIDs.New(ctEntities);
+    {for (INDEX ien=0; ien<ctEntities; ien++) {
+      aulIDs[ien] = wo.wo_cenAllEntities[ien].en_ulID;
+    }}
+    CTimerValue tvStart = _pTimer->GetHighPrecisionTimer();
+    {for (INDEX ien=0; ien<ctEntities; ien++) {
+      wo.EntityFromID(aulIDs[ien]);
+    }}
+    CTimerValue tvHashed = _pTimer->GetHighPrecisionTimer()-tvStart;
+    tvStart = _pTimer->GetHighPrecisionTimer();
+    {for (INDEX ien=0; ien<ctEntities; ien++) {
+      EntityFromIDLinear(wo, aulIDs[ien]);
+    }}
+    CTimerValue tvLinear = _pTimer->GetHighPrecisionTimer()-tvStart;
+    CPrintF("EntityFromID(): %.3f us hashed, %.3f us searching (per lookup)\n",
+      tvHashed.GetSeconds()*1E6/ctEntities, tvLinear.GetSeconds()*1E6/ctEntities);
+  }
+  delete pwoTemp;
+}
@@ -34,6 +34,7 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #include <Engine/Terrain/TerrainRayCasting.h>
 
 #include <Engine/Base/Statistics_Internal.h>
+#include <Engine/World/PhysicsProfile.h>
 #include <Engine/Templates/StaticStackArray.cpp>
 
 #define EPSILON (0.1f)
@@ -798,6 +799,9 @@ void CCastRay::Cast(CWorld *pwoWorld)
   const BOOL bMainLoopTimer = _sfStats.CheckTimer(CStatForm::STI_MAINLOOP);
   if( bMainLoopTimer) _sfStats.StopTimer(CStatForm::STI_MAINLOOP);
   _sfStats.StartTimer(CStatForm::STI_RAYCAST);
+  _pfPhysicsProfile.StartTimer(CPhysicsProfile::PTI_CASTRAY);
+  _pfPhysicsProfile.IncrementCounter(CPhysicsProfile::PCI_CASTRAYS);
+  _pfPhysicsProfile.IncrementTimerAveragingCounter(CPhysicsProfile::PTI_CASTRAY);
 
   // initially no polygon is found
   cr_pbpoBrushPolygon= NULL;
@@ -828,6 +832,7 @@ void CCastRay::Cast(CWorld *pwoWorld)
   cr_vHit = cr_vOrigin + (cr_vTarget-cr_vOrigin).Normalize()*cr_fHitDistance;
 
   // done with timing
+  _pfPhysicsProfile.StopTimer(CPhysicsProfile::PTI_CASTRAY);
   _sfStats.StopTimer(CStatForm::STI_RAYCAST);
   if( bMainLoopTimer) _sfStats.StartTimer(CStatForm::STI_MAINLOOP);
 }
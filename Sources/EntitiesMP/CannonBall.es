@@ -16,6 +16,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 506
 %{
 #include "EntitiesMP/StdH/StdH.h"
+#include "EntitiesMP/ExotechLarvaBattery.h"
+#include "EntitiesMP/Twister.h"
 #include "Models/Weapons/Cannon/Projectile/CannonBall.h"
 #include "EntitiesMP/MovingBrush.h"
 #include "EntitiesMP/DestroyableArchitecture.h"
@@ -311,7 +313,7 @@ void Explosion(FLOAT3D vCenter,
     plHandle.pl_PositionVector+=vCenter;
     SpawnEffect(plHandle, ese);
     // spawn sound event in range
-    if( IsDerivedFromClass( m_penLauncher, "Player")) {
+    if( IsDerivedFromClass( m_penLauncher, CPlayer_ClassID)) {
       SpawnRangeSound( m_penLauncher, this, SNDT_PLAYER, 100.0f);
     }
   }
@@ -375,24 +377,24 @@ BOOL BallTouchExplode(CEntityPointer penHit)
 
   if (penHit->GetPhysicsFlags()&EPF_MOVABLE) { 
     fHealth = ((CMovableEntity&)*penHit).GetHealth();
-    if( IsDerivedFromClass(penHit, "Enemy Base"))
+    if( IsDerivedFromClass(penHit, CEnemyBase_ClassID))
     {
       bForceCannonballToExplode = ((CEnemyBase&)*penHit).ForcesCannonballToExplode();
     }
   } else {
-    if (IsOfClass(penHit, "ModelHolder2") || IsOfClass(penHit, "ExotechLarvaBattery")) {
+    if (IsOfClass(penHit, CModelHolder2_ClassID) || IsOfClass(penHit, CExotechLarvaBattery_ClassID)) {
       fHealth = ((CLiveEntity&)*penHit).GetHealth();
     } else {
       return FALSE; 
     }
   }
 
-  if( IsOfClass(penHit, "ModelHolder2"))
+  if( IsOfClass(penHit, CModelHolder2_ClassID))
   {
     bForceCannonballToExplode=TRUE;
   }
 
-  if (IsOfClass(penHit, "Player")) {
+  if (IsOfClass(penHit, CPlayer_ClassID)) {
     fHealth += ((CPlayer&)*penHit).m_fArmor * 2.0f;
   }
   // inflict direct damage to kill hitted entity
@@ -471,7 +473,7 @@ procedures:
         // ignore launcher within 1 second
         bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
         // ignore twister
-        bHit &= !IsOfClass(epass.penOther, "Twister");
+        bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
 
         if (bHit)
         {
@@ -481,11 +483,11 @@ procedures:
       }
       on (ETouch etouch) : {
         // explode if touched another cannon ball
-        if( IsOfClass(etouch.penOther, "Cannon ball"))
+        if( IsOfClass(etouch.penOther, CCannonBall_ClassID))
         {
           stop;
         }
-        if( IsOfClass(etouch.penOther, "Moving Brush"))
+        if( IsOfClass(etouch.penOther, CMovingBrush_ClassID))
         {
           CMovingBrush &br = (CMovingBrush &) *etouch.penOther;
           if( br.m_fHealth>0)
@@ -498,7 +500,7 @@ procedures:
             stop;
           }
         }
-        if( IsOfClass(etouch.penOther, "DestroyableArchitecture"))
+        if( IsOfClass(etouch.penOther, CDestroyableArchitecture_ClassID))
         {
           CDestroyableArchitecture &br = (CDestroyableArchitecture &) *etouch.penOther;
           if( br.m_fHealth>0)
@@ -580,7 +582,7 @@ procedures:
     ESound eSound;
     eSound.EsndtSound = SNDT_EXPLOSION;
     eSound.penTarget = m_penLauncher;
-    if (IsDerivedFromClass(this, "Player")) {
+    if (IsDerivedFromClass(this, CPlayer_ClassID)) {
       SendEventInRange(eSound, FLOATaabbox3D(GetPlacement().pl_PositionVector, SOUND_RANGE));
     }
 
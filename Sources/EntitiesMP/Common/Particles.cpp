@@ -452,6 +452,37 @@ void SetupParticleTextureWithAddAlpha(enum ParticleTexture ptTexture)
   Particle_SetTexturePart( 512, 512, 0, 0);
 }
 
+// squares with same texture are gathered here and rendered all at once
+static CStaticStackArray<FLOAT> _afSquareX, _afSquareY, _afSquareZ, _afSquareSize;
+static CStaticStackArray<ANGLE> _aaSquareAngle;
+static CStaticStackArray<COLOR> _acolSquare;
+
+// add a square to be rendered with Squares_Render() (same parameters as Particle_RenderSquare())
+static inline void Squares_Add( const FLOAT3D &vPos, FLOAT fSize, ANGLE aRotation, COLOR col)
+{
+  _afSquareX.Push() = vPos(1);
+  _afSquareY.Push() = vPos(2);
+  _afSquareZ.Push() = vPos(3);
+  _afSquareSize.Push() = fSize;
+  _aaSquareAngle.Push() = aRotation;
+  _acolSquare.Push() = col;
+}
+
+// render all gathered squares with current texture
+static void Squares_Render(void)
+{
+  if( _afSquareX.Count()>0) {
+    Particle_RenderSquares( _afSquareX.Count(), &_afSquareX[0], &_afSquareY[0], &_afSquareZ[0],
+                            &_afSquareSize[0], &_aaSquareAngle[0], &_acolSquare[0]);
+  }
+  _afSquareX.PopAll();
+  _afSquareY.PopAll();
+  _afSquareZ.PopAll();
+  _afSquareSize.PopAll();
+  _aaSquareAngle.PopAll();
+  _acolSquare.PopAll();
+}
+
 void Particles_ViewerLocal(CEntity *penView)
 {
   ASSERT(penView!=NULL);
@@ -1857,8 +1888,9 @@ void Particles_Stardust( CEntity *pen, FLOAT fSize, FLOAT fHeight,
     COLOR colStar = RGBToColor((UBYTE) (auStarsColors[iMemeber][0]*fFade),
                                (UBYTE) (auStarsColors[iMemeber][1]*fFade),
                                (UBYTE) (auStarsColors[iMemeber][2]*fFade));
-    Particle_RenderSquare( vPos, 0.15f, 0, colStar|0xFF);
+    Squares_Add( vPos, 0.15f, 0, colStar|0xFF);
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -1908,8 +1940,9 @@ void Particles_Rising(CEntity *pen, FLOAT fStartTime, FLOAT fStopTime, FLOAT fSt
     
     UBYTE ub = NormFloatToByte( fFade);
     COLOR colStar = RGBToColor( ub, ub, ub>>1);
-    Particle_RenderSquare( vPos, fSize*fPowerFactor, 0, colStar|(UBYTE(0xFF*fPowerFactor)));
+    Squares_Add( vPos, fSize*fPowerFactor, 0, colStar|(UBYTE(0xFF*fPowerFactor)));
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -1946,9 +1979,10 @@ void Particles_Spiral( CEntity *pen, FLOAT fSize, FLOAT fHeight,
       vPos(3)+=sin((fT-iTrail*fTrailDelta)*4.0f*(afStarsPositions[iStar][2]*3.0f)+0.1f)*0.5f*fSize;
       UBYTE ub = NormFloatToByte( (FLOAT)(ctSpiralTrail-iTrail) / (FLOAT)(ctSpiralTrail));
       COLOR colStar = RGBToColor( ub, ub, ub>>1);
-      Particle_RenderSquare( vPos, 0.2f, 0, colStar|0xFF);
+      Squares_Add( vPos, 0.2f, 0, colStar|0xFF);
     }
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -1991,8 +2025,9 @@ void Particles_Emanate( CEntity *pen, FLOAT fSize, FLOAT fHeight,
     
     UBYTE ub = NormFloatToByte( fFade*fDisappearRatio);
     COLOR colStar = RGBToColor( ub, ub, ub>>1);
-    Particle_RenderSquare( vPos, 0.1f, 0, colStar|0xFF);
+    Squares_Add( vPos, 0.1f, 0, colStar|0xFF);
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -2030,8 +2065,9 @@ void Particles_WaterfallFoam(CEntity *pen, FLOAT fSizeX, FLOAT fSizeY, FLOAT fSi
     FLOAT fRndRotation = afStarsPositions[iFoam*3][1];
     UBYTE ub = NormFloatToByte( fFade);
     COLOR colStar = RGBToColor( ub, ub, ub);
-    Particle_RenderSquare( vPos, fParticleSize*(1.0f+afStarsPositions[iFoam][1]*0.25f), fRndRotation*300*fT, colStar|0xFF);
+    Squares_Add( vPos, fParticleSize*(1.0f+afStarsPositions[iFoam][1]*0.25f), fRndRotation*300*fT, colStar|0xFF);
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -2073,8 +2109,9 @@ void Particles_EmanatePlane(CEntity *pen, FLOAT fSizeX, FLOAT fSizeY, FLOAT fSiz
     
     UBYTE ub = NormFloatToByte( fFade*fDisappearRatio);
     COLOR colStar = RGBToColor( ub, ub, ub);
-    Particle_RenderSquare( vPos, fParticleSize, 0, colStar|0xFF);
+    Squares_Add( vPos, fParticleSize, 0, colStar|0xFF);
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -2119,9 +2156,10 @@ void Particles_Fountain( CEntity *pen, FLOAT fSize, FLOAT fHeight,
       COLOR colStar = pTD->GetTexel( FloatToInt(fFade*2048), 0);
       ULONG ulA = FloatToInt( ((colStar&CT_AMASK)>>CT_ASHIFT) * fFade);
       colStar = (colStar&~CT_AMASK) | (ulA<<CT_ASHIFT);
-      Particle_RenderSquare( vPos, 0.05f, 0, colStar);
+      Squares_Add( vPos, 0.05f, 0, colStar);
     }
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -3242,10 +3280,11 @@ void Particles_Snow(CEntity *pen, FLOAT fGridSize, INDEX ctGrids, FLOAT fFactor,
             continue;
           }
         }
-        Particle_RenderSquare( vRender, fSize, fAngle, colDrop);
+        Squares_Add( vRender, fSize, fAngle, colDrop);
       }
     }
   }
+  Squares_Render();
   // all done
   Particle_Flush();
 }
@@ -20,142 +20,342 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 #define PRINTOUT(_dummy)
 //#define PRINTOUT(something) something
 
-// open and closed lists of nodes
-static CListHead _lhOpen;
-static CListHead _lhClosed;
+// Navigation markers are flattened into a compact graph the first time a path is
+// needed in a level, and searched with A* over that graph. Path finding runs only on
+// the game thread, so the search state is kept in static arrays and reused.
+
+#define PATH_CACHESIZE   32   // number of recent paths remembered
+#define PATH_CACHENODES  64   // max nodes remembered in one path
+
+// the graph
+static CWorld *_pwoGraph = NULL;                   // world the graph was built for
+static BOOL _bGraphValid = FALSE;
+static CStaticArray<CNavigationMarker*> _apnmNodes;
+static CStaticArray<FLOAT> _afNodeX;               // node positions
+static CStaticArray<FLOAT> _afNodeY;
+static CStaticArray<FLOAT> _afNodeZ;
+static CStaticArray<INDEX> _aiFirstLink;           // links of node i are [_aiFirstLink[i], _aiFirstLink[i+1])
+static CStaticStackArray<INDEX> _aiLinks;
+static CStaticStackArray<FLOAT> _afLinkCost;
+
+// markers in each brush sector, for finding closest markers
+struct SectorMarkers {
+  CBrushSector *sm_pbsc;
+  INDEX sm_iFirst;
+  INDEX sm_ctMarkers;
+};
+static CStaticArray<SectorMarkers> _asmSectors;    // hashed by sector pointer
+static CStaticStackArray<INDEX> _aiSectorMarkers;
+
+// search state, valid for a node only if its visit stamp is current
+static CStaticArray<ULONG> _aulVisit;
+static CStaticArray<FLOAT> _afG;       // total cost to get here through the best parent
+static CStaticArray<FLOAT> _afF;       // total quality of the path going through this node
+static CStaticArray<INDEX> _aiParent;  // best found parent in path yet
+static CStaticArray<INDEX> _aiHeapPos; // position in open heap, -1 if closed
+static CStaticArray<INDEX> _aiHeap;    // open nodes, lowest F first
+static INDEX _ctHeap = 0;
+static ULONG _ulVisit = 0;
+
+// recently found paths
+struct CachedPath {
+  INDEX cp_iDst;            // -1 if unused
+  BOOL cp_bFound;           // if not found, holds only the source node
+  INDEX cp_ctNodes;
+  INDEX cp_aiNodes[PATH_CACHENODES];
+  ULONG cp_ulLastUsed;
+};
+static CachedPath _acpCache[PATH_CACHESIZE];
+static ULONG _ulCacheTime = 0;
+
+// mark navigation graph as outdated (when markers are created or destroyed)
+void PATH_InvalidateGraph(void)
+{
+  _bGraphValid = FALSE;
+}
 
-FLOAT NodeDistance(CPathNode *ppn0, CPathNode *ppn1)
+static inline ULONG HashSector(CBrushSector *pbsc)
 {
-  return (
-    ppn0->pn_pnmMarker->GetPlacement().pl_PositionVector - 
-    ppn1->pn_pnmMarker->GetPlacement().pl_PositionVector).Length();
+  return ULONG(((size_t)pbsc)>>4)*2654435761UL;
 }
 
-CPathNode::CPathNode(class CNavigationMarker *penMarker)
+// find slot of a sector in the sector hash, or empty slot where it belongs
+static INDEX FindSectorSlot(CBrushSector *pbsc)
 {
-  pn_pnmMarker = penMarker;
-  pn_ppnParent = NULL;
-  pn_fG = 0.0f;
-  pn_fH = 0.0f;
-  pn_fF = 0.0f;
+  const INDEX ctSlots = _asmSectors.Count();
+  if (ctSlots==0) {
+    return -1;
+  }
+  INDEX iSlot = HashSector(pbsc)&(ctSlots-1);
+  while (_asmSectors[iSlot].sm_pbsc!=NULL && _asmSectors[iSlot].sm_pbsc!=pbsc) {
+    iSlot = (iSlot+1)&(ctSlots-1);
+  }
+  return iSlot;
 }
 
-CPathNode::~CPathNode(void)
+// flatten all navigation markers in the world into the graph
+static void BuildGraph(CWorld *pwo)
 {
-  // detach from marker when deleting
-  ASSERT(pn_pnmMarker!=NULL);
-  pn_pnmMarker->m_ppnNode = NULL;
+  PRINTOUT(CPrintF("Building navigation graph\n"));
+  _pwoGraph = pwo;
+  _bGraphValid = TRUE;
+  for (INDEX iPath=0; iPath<PATH_CACHESIZE; iPath++) {
+    _acpCache[iPath].cp_iDst = -1;
+  }
+
+  // gather markers
+  CStaticStackArray<CNavigationMarker*> apnm;
+  INDEX ctSectorLinks = 0;
+  {FOREACHINDYNAMICCONTAINER(pwo->wo_cenEntities, CEntity, iten) {
+    if (!IsOfClass(iten, CNavigationMarker_ClassID) || (iten->GetFlags()&ENF_DELETED)) {
+      continue;
+    }
+    CNavigationMarker *pnm = (CNavigationMarker*)&*iten;
+    pnm->m_iPathNode = apnm.Count();
+    apnm.Push() = pnm;
+    {FOREACHSRCOFDST(pnm->en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+      ctSectorLinks++;
+    ENDFOR}
+  }}
+
+  // nodes and their links
+  const INDEX ctNodes = apnm.Count();
+  _apnmNodes.Clear();
+  _afNodeX.Clear();
+  _afNodeY.Clear();
+  _afNodeZ.Clear();
+  _aiFirstLink.Clear();
+  _aiLinks.PopAll();
+  _afLinkCost.PopAll();
+  _aiFirstLink.New(ctNodes+1);
+  if (ctNodes>0) {
+    _apnmNodes.New(ctNodes);
+    _afNodeX.New(ctNodes);
+    _afNodeY.New(ctNodes);
+    _afNodeZ.New(ctNodes);
+  }
+  for (INDEX iNode=0; iNode<ctNodes; iNode++) {
+    CNavigationMarker *pnm = apnm[iNode];
+    const FLOAT3D &v = pnm->GetPlacement().pl_PositionVector;
+    _apnmNodes[iNode] = pnm;
+    _afNodeX[iNode] = v(1);
+    _afNodeY[iNode] = v(2);
+    _afNodeZ[iNode] = v(3);
+  }
+  for (INDEX iNode=0; iNode<ctNodes; iNode++) {
+    _aiFirstLink[iNode] = _aiLinks.Count();
+    CNavigationMarker *pnmLink = NULL;
+    for (INDEX i=0; (pnmLink=_apnmNodes[iNode]->GetLink(i))!=NULL; i++) {
+      // skip links to anything that is not a marker in this graph
+      if (!IsOfClass(pnmLink, CNavigationMarker_ClassID) || pnmLink->m_iPathNode<0 || pnmLink->m_iPathNode>=ctNodes
+        || _apnmNodes[pnmLink->m_iPathNode]!=pnmLink) {
+        continue;
+      }
+      const INDEX iLink = pnmLink->m_iPathNode;
+      _aiLinks.Push() = iLink;
+      _afLinkCost.Push() = FLOAT3D(_afNodeX[iLink]-_afNodeX[iNode], _afNodeY[iLink]-_afNodeY[iNode],
+        _afNodeZ[iLink]-_afNodeZ[iNode]).Length();
+    }
+  }
+  _aiFirstLink[ctNodes] = _aiLinks.Count();
+
+  // markers in each sector
+  INDEX ctSlots = 16;
+  while (ctSlots<ctSectorLinks*2) {
+    ctSlots*=2;
+  }
+  _asmSectors.Clear();
+  _asmSectors.New(ctSlots);
+  for (INDEX iSlot=0; iSlot<ctSlots; iSlot++) {
+    _asmSectors[iSlot].sm_pbsc = NULL;
+    _asmSectors[iSlot].sm_iFirst = 0;
+    _asmSectors[iSlot].sm_ctMarkers = 0;
+  }
+  for (INDEX iNode=0; iNode<ctNodes; iNode++) {
+    {FOREACHSRCOFDST(_apnmNodes[iNode]->en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+      SectorMarkers &sm = _asmSectors[FindSectorSlot(pbsc)];
+      sm.sm_pbsc = pbsc;
+      sm.sm_ctMarkers++;
+    ENDFOR}
+  }
+  INDEX iFirst = 0;
+  for (INDEX iSlot=0; iSlot<ctSlots; iSlot++) {
+    _asmSectors[iSlot].sm_iFirst = iFirst;
+    iFirst += _asmSectors[iSlot].sm_ctMarkers;
+    _asmSectors[iSlot].sm_ctMarkers = 0;
+  }
+  _aiSectorMarkers.PopAll();
+  if (iFirst>0) {
+    _aiSectorMarkers.Push(iFirst);
+  }
+  for (INDEX iNode=0; iNode<ctNodes; iNode++) {
+    {FOREACHSRCOFDST(_apnmNodes[iNode]->en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+      SectorMarkers &sm = _asmSectors[FindSectorSlot(pbsc)];
+      _aiSectorMarkers[sm.sm_iFirst+sm.sm_ctMarkers] = iNode;
+      sm.sm_ctMarkers++;
+    ENDFOR}
+  }
+
+  // search state
+  _aulVisit.Clear();
+  _afG.Clear();
+  _afF.Clear();
+  _aiParent.Clear();
+  _aiHeapPos.Clear();
+  _aiHeap.Clear();
+  if (ctNodes>0) {
+    _aulVisit.New(ctNodes);
+    _afG.New(ctNodes);
+    _afF.New(ctNodes);
+    _aiParent.New(ctNodes);
+    _aiHeapPos.New(ctNodes);
+    _aiHeap.New(ctNodes);
+    for (INDEX iNode=0; iNode<ctNodes; iNode++) {
+      _aulVisit[iNode] = 0;
+    }
+  }
+  _ulVisit = 0;
 }
 
-// get name of this node
-const CTString &CPathNode::GetName(void)
+// make sure the graph is built for the world of given entity
+static void ValidateGraph(CEntity *penThis)
 {
-  ASSERT(this!=NULL);
-  static CTString strNone="<none>";
-  if (pn_pnmMarker==NULL) {
-    return strNone;
-  } else {
-    return pn_pnmMarker->GetName();
+  if (!_bGraphValid || _pwoGraph!=penThis->en_pwoWorld) {
+    BuildGraph(penThis->en_pwoWorld);
   }
 }
 
-// get link with given index or null if no more (for iteration along the graph)
-CPathNode *CPathNode::GetLink(INDEX i)
+// get graph node of a marker, or -1 if not in graph
+static INDEX GetNode(CEntity *penMarker)
 {
-  ASSERT(this!=NULL && pn_pnmMarker!=NULL);
-  CNavigationMarker *pnm = pn_pnmMarker->GetLink(i);
-  if (pnm==NULL) {
-    return NULL;
+  if (penMarker==NULL || !IsOfClass(penMarker, CNavigationMarker_ClassID)) {
+    return -1;
+  }
+  INDEX iNode = ((CNavigationMarker*)penMarker)->m_iPathNode;
+  if (iNode<0 || iNode>=_apnmNodes.Count() || _apnmNodes[iNode]!=penMarker) {
+    return -1;
   }
-  return pnm->GetPathNode();
+  return iNode;
 }
 
-// add given node to open list, sorting best first
-static void SortIntoOpenList(CPathNode *ppnLink)
+static inline FLOAT NodeDistance(INDEX iNode0, INDEX iNode1)
 {
-  // start at head of the open list
-  LISTITER(CPathNode, pn_lnInOpen) itpn(_lhOpen);
-  // while the given node is further than the one in list
-  while(ppnLink->pn_fF>itpn->pn_fF && !itpn.IsPastEnd()) {
-    // move to next node
-    itpn.MoveToNext();
+  return FLOAT3D(_afNodeX[iNode1]-_afNodeX[iNode0], _afNodeY[iNode1]-_afNodeY[iNode0],
+    _afNodeZ[iNode1]-_afNodeZ[iNode0]).Length();
+}
+
+// move node in open heap towards the top while better than its parent
+static void HeapUp(INDEX iPos)
+{
+  const INDEX iNode = _aiHeap[iPos];
+  const FLOAT fF = _afF[iNode];
+  while (iPos>0) {
+    const INDEX iParentPos = (iPos-1)/2;
+    const INDEX iParentNode = _aiHeap[iParentPos];
+    if (_afF[iParentNode]<=fF) {
+      break;
+    }
+    _aiHeap[iPos] = iParentNode;
+    _aiHeapPos[iParentNode] = iPos;
+    iPos = iParentPos;
   }
+  _aiHeap[iPos] = iNode;
+  _aiHeapPos[iNode] = iPos;
+}
 
-  // if past the end of list
-  if (itpn.IsPastEnd()) {
-    // add to the end of list
-    _lhOpen.AddTail(ppnLink->pn_lnInOpen);
-  // if not past end of list
-  } else {
-    // add before current node
-    itpn.InsertBeforeCurrent(ppnLink->pn_lnInOpen);
+// move node in open heap towards the bottom while worse than its children
+static void HeapDown(INDEX iPos)
+{
+  const INDEX iNode = _aiHeap[iPos];
+  const FLOAT fF = _afF[iNode];
+  FOREVER {
+    INDEX iChildPos = iPos*2+1;
+    if (iChildPos>=_ctHeap) {
+      break;
+    }
+    if (iChildPos+1<_ctHeap && _afF[_aiHeap[iChildPos+1]]<_afF[_aiHeap[iChildPos]]) {
+      iChildPos++;
+    }
+    const INDEX iChildNode = _aiHeap[iChildPos];
+    if (fF<=_afF[iChildNode]) {
+      break;
+    }
+    _aiHeap[iPos] = iChildNode;
+    _aiHeapPos[iChildNode] = iPos;
+    iPos = iChildPos;
   }
+  _aiHeap[iPos] = iNode;
+  _aiHeapPos[iNode] = iPos;
 }
-  
-// find shortest path from one marker to another
-static BOOL FindPath(CNavigationMarker *pnmSrc, CNavigationMarker *pnmDst)
+
+// find shortest path from one node to another
+static BOOL FindPath(INDEX iSrc, INDEX iDst)
 {
+  ASSERT(iSrc!=iDst);
+  PRINTOUT(CPrintF("--------------------\n"));
+  PRINTOUT(CPrintF("FindPath(%s, %s)\n", _apnmNodes[iSrc]->GetName(), _apnmNodes[iDst]->GetName()));
 
-  ASSERT(pnmSrc!=pnmDst);
-  CPathNode *ppnSrc = pnmSrc->GetPathNode();
-  CPathNode *ppnDst = pnmDst->GetPathNode();
+  // new search, all nodes are unvisited
+  _ulVisit++;
+  if (_ulVisit==0) {
+    for (INDEX iNode=0; iNode<_aulVisit.Count(); iNode++) {
+      _aulVisit[iNode] = 0;
+    }
+    _ulVisit = 1;
+  }
 
-  PRINTOUT(CPrintF("--------------------\n"));
-  PRINTOUT(CPrintF("FindPath(%s, %s)\n", ppnSrc->GetName(), ppnDst->GetName()));
-
-  // start with empty open and closed lists
-  ASSERT(_lhOpen.IsEmpty());
-  ASSERT(_lhClosed.IsEmpty());
-
-  // add the start node to open list
-  ppnSrc->pn_fG = 0.0f;
-  ppnSrc->pn_fH = NodeDistance(ppnSrc, ppnDst);
-  ppnSrc->pn_fF = ppnSrc->pn_fG +ppnSrc->pn_fH;
-  _lhOpen.AddTail(ppnSrc->pn_lnInOpen);
-  PRINTOUT(CPrintF("StartState: %s\n", ppnSrc->GetName()));
-
-  // while the open list is not empty
-  while (!_lhOpen.IsEmpty()) {
-    // get the first node from open list (that is, the one with lowest F)
-    CPathNode *ppnNode = LIST_HEAD(_lhOpen, CPathNode, pn_lnInOpen);
-    ppnNode->pn_lnInOpen.Remove();
-      _lhClosed.AddTail(ppnNode->pn_lnInClosed);
-    PRINTOUT(CPrintF("Node: %s - moved from OPEN to CLOSED\n", ppnNode->GetName()));
+  // add the start node to open heap
+  _aulVisit[iSrc] = _ulVisit;
+  _aiParent[iSrc] = -1;
+  _afG[iSrc] = 0.0f;
+  _afF[iSrc] = NodeDistance(iSrc, iDst);
+  _aiHeap[0] = iSrc;
+  _aiHeapPos[iSrc] = 0;
+  _ctHeap = 1;
+
+  // while there are open nodes
+  while (_ctHeap>0) {
+    // take the one with lowest F and close it
+    const INDEX iNode = _aiHeap[0];
+    _ctHeap--;
+    _aiHeapPos[iNode] = -1;
+    if (_ctHeap>0) {
+      _aiHeap[0] = _aiHeap[_ctHeap];
+      HeapDown(0);
+    }
+    PRINTOUT(CPrintF("Node: %s - moved from OPEN to CLOSED\n", _apnmNodes[iNode]->GetName()));
 
     // if this is the goal
-    if (ppnNode==ppnDst) {
+    if (iNode==iDst) {
       PRINTOUT(CPrintF("PATH FOUND!\n"));
       // the path is found
       return TRUE;
     }
 
     // for each link of current node
-    CPathNode *ppnLink = NULL;
-    for(INDEX i=0; (ppnLink=ppnNode->GetLink(i))!=NULL; i++) {
-      PRINTOUT(CPrintF(" Link %d: %s\n", i, ppnLink->GetName()));
+    for (INDEX i=_aiFirstLink[iNode]; i<_aiFirstLink[iNode+1]; i++) {
+      const INDEX iLink = _aiLinks[i];
       // get cost to get to this node if coming from current node
-      FLOAT fNewG = ppnLink->pn_fG+NodeDistance(ppnNode, ppnLink);
+      const FLOAT fNewG = _afG[iNode]+_afLinkCost[i];
       // if a shorter path already exists
-      if ((ppnLink->pn_lnInOpen.IsLinked() || ppnLink->pn_lnInClosed.IsLinked()) && fNewG>=ppnLink->pn_fG) {
-        PRINTOUT(CPrintF("  shorter path exists through: %s\n", ppnLink->pn_ppnParent->GetName()));
+      const BOOL bVisited = _aulVisit[iLink]==_ulVisit;
+      if (bVisited && fNewG>=_afG[iLink]) {
         // skip this link
         continue;
       }
       // remember this path
-      ppnLink->pn_ppnParent = ppnNode;
-      ppnLink->pn_fG = fNewG;
-      ppnLink->pn_fH = NodeDistance(ppnLink, ppnDst);
-      ppnLink->pn_fF = ppnLink->pn_fG + ppnLink->pn_fH;
-      // remove from closed list, if in it
-      if (ppnLink->pn_lnInClosed.IsLinked()) {
-        ppnLink->pn_lnInClosed.Remove();
-        PRINTOUT(CPrintF("  %s removed from CLOSED\n", ppnLink->GetName()));
-      }
-      // add to open if not in it
-      if (!ppnLink->pn_lnInOpen.IsLinked()) {
-        SortIntoOpenList(ppnLink);
-        PRINTOUT(CPrintF("  %s added to OPEN\n", ppnLink->GetName()));
+      _aiParent[iLink] = iNode;
+      _afG[iLink] = fNewG;
+      _afF[iLink] = fNewG + NodeDistance(iLink, iDst);
+      // add to open if not in it, or move up if it is
+      if (!bVisited || _aiHeapPos[iLink]<0) {
+        _aulVisit[iLink] = _ulVisit;
+        _aiHeap[_ctHeap] = iLink;
+        _aiHeapPos[iLink] = _ctHeap;
+        _ctHeap++;
       }
+      HeapUp(_aiHeapPos[iLink]);
+      PRINTOUT(CPrintF("  %s added to OPEN\n", _apnmNodes[iLink]->GetName()));
     }
   }
 
@@ -164,56 +364,97 @@ static BOOL FindPath(CNavigationMarker *pnmSrc, CNavigationMarker *pnmDst)
   return FALSE;
 }
 
-// clear all temporary structures used for path finding
-static void ClearPath(CEntity *penThis)
+// find next node on the path from source to destination in recent paths
+static BOOL FindCachedPath(INDEX iSrc, INDEX iDst, INDEX &iNext)
 {
-  {FORDELETELIST(CPathNode, pn_lnInOpen, _lhOpen, itpn) {
-    delete &itpn.Current();
-  }}
-  {FORDELETELIST(CPathNode, pn_lnInClosed, _lhClosed, itpn) {
-    delete &itpn.Current();          
-  }}
-
-#ifndef NDEBUG
-  // for each navigation marker in the world
-  {FOREACHINDYNAMICCONTAINER(penThis->en_pwoWorld->wo_cenEntities, CEntity, iten) {
-    if (!IsOfClass(iten, "NavigationMarker")) {
+  for (INDEX iPath=0; iPath<PATH_CACHESIZE; iPath++) {
+    CachedPath &cp = _acpCache[iPath];
+    if (cp.cp_iDst!=iDst) {
       continue;
     }
-    CNavigationMarker &nm = (CNavigationMarker&)*iten;
-    ASSERT(nm.m_ppnNode==NULL);
-  }}
-#endif
+    // any node along a found path leads to the destination the same way
+    const INDEX ctSearch = cp.cp_bFound ? cp.cp_ctNodes-1 : cp.cp_ctNodes;
+    for (INDEX iNode=0; iNode<ctSearch; iNode++) {
+      if (cp.cp_aiNodes[iNode]==iSrc) {
+        cp.cp_ulLastUsed = ++_ulCacheTime;
+        iNext = cp.cp_bFound ? cp.cp_aiNodes[iNode+1] : -1;
+        return TRUE;
+      }
+    }
+  }
+  return FALSE;
+}
+
+// remember path just found, replacing the least recently used one
+static void CachePath(INDEX iSrc, INDEX iDst, BOOL bFound)
+{
+  INDEX iOldest = -1;
+  for (INDEX iPath=0; iPath<PATH_CACHESIZE; iPath++) {
+    if (_acpCache[iPath].cp_iDst<0) {
+      iOldest = iPath;
+      break;
+    }
+    if (iOldest<0 || _acpCache[iPath].cp_ulLastUsed<_acpCache[iOldest].cp_ulLastUsed) {
+      iOldest = iPath;
+    }
+  }
+  CachedPath &cp = _acpCache[iOldest];
+  cp.cp_iDst = iDst;
+  cp.cp_bFound = bFound;
+  cp.cp_ulLastUsed = ++_ulCacheTime;
+  cp.cp_ctNodes = 0;
+  if (!bFound) {
+    cp.cp_aiNodes[cp.cp_ctNodes++] = iSrc;
+    return;
+  }
+  // count nodes on the path
+  INDEX ctPath = 0;
+  for (INDEX iNode=iDst; iNode>=0; iNode=_aiParent[iNode]) {
+    ctPath++;
+  }
+  // store as many as fit, from the source on
+  INDEX iPos = ctPath;
+  for (INDEX iNode=iDst; iNode>=0; iNode=_aiParent[iNode]) {
+    iPos--;
+    if (iPos<PATH_CACHENODES) {
+      cp.cp_aiNodes[iPos] = iNode;
+    }
+  }
+  cp.cp_ctNodes = Min(ctPath, (INDEX)PATH_CACHENODES);
 }
 
 // find marker closest to a given position
 static void FindClosestMarker(
     CEntity *penThis, const FLOAT3D &vSrc, CEntity *&penMarker, FLOAT3D &vPath)
 {
-  CNavigationMarker *pnmMin = NULL;
-  FLOAT fMinDist = UpperLimit(0.0f);
+  INDEX iMin = -1;
+  FLOAT fMinDist2 = UpperLimit(0.0f);
   // for each sector this entity is in
   {FOREACHSRCOFDST(penThis->en_rdSectors, CBrushSector, bsc_rsEntities, pbsc)
+    INDEX iSlot = FindSectorSlot(pbsc);
+    if (iSlot<0 || _asmSectors[iSlot].sm_pbsc==NULL) {
+      continue;
+    }
     // for each navigation marker in that sector
-    {FOREACHDSTOFSRC(pbsc->bsc_rsEntities, CEntity, en_rdSectors, pen)
-      if (!IsOfClass(pen, "NavigationMarker")) {
-        continue;
-      }
-      CNavigationMarker &nm = (CNavigationMarker&)*pen;
-
+    const SectorMarkers &sm = _asmSectors[iSlot];
+    for (INDEX i=sm.sm_iFirst; i<sm.sm_iFirst+sm.sm_ctMarkers; i++) {
+      const INDEX iNode = _aiSectorMarkers[i];
       // get distance from source
-      FLOAT fDist = (vSrc-nm.GetPlacement().pl_PositionVector).Length();
+      const FLOAT fDX = _afNodeX[iNode]-vSrc(1);
+      const FLOAT fDY = _afNodeY[iNode]-vSrc(2);
+      const FLOAT fDZ = _afNodeZ[iNode]-vSrc(3);
+      const FLOAT fDist2 = fDX*fDX+fDY*fDY+fDZ*fDZ;
       // if closer than best found
-      if(fDist<fMinDist) {
+      if (fDist2<fMinDist2) {
         // remember it
-        fMinDist = fDist;
-        pnmMin = &nm;
+        fMinDist2 = fDist2;
+        iMin = iNode;
       }
-    ENDFOR}
+    }
   ENDFOR}
 
   // if none found
-  if (pnmMin==NULL) {
+  if (iMin<0) {
     // fail
     vPath = vSrc;
     penMarker = NULL;
@@ -221,23 +462,25 @@ static void FindClosestMarker(
   }
 
   // return position
-  vPath = pnmMin->GetPlacement().pl_PositionVector;
-  penMarker = pnmMin;
+  vPath = FLOAT3D(_afNodeX[iMin], _afNodeY[iMin], _afNodeZ[iMin]);
+  penMarker = _apnmNodes[iMin];
 }
 
 // find first marker for path navigation
 void PATH_FindFirstMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &vDst, CEntity *&penMarker, FLOAT3D &vPath)
 {
+  ValidateGraph(penThis);
+
   // find closest markers to source and destination positions
-  CNavigationMarker *pnmSrc;
+  CEntity *penSrc;
   FLOAT3D vSrcPath;
-  FindClosestMarker(penThis, vSrc, (CEntity*&)pnmSrc, vSrcPath);
-  CNavigationMarker *pnmDst;
+  FindClosestMarker(penThis, vSrc, penSrc, vSrcPath);
+  CEntity *penDst;
   FLOAT3D vDstPath;
-  FindClosestMarker(penThis, vDst, (CEntity*&)pnmDst, vDstPath);
+  FindClosestMarker(penThis, vDst, penDst, vDstPath);
 
   // if at least one is not found, or if they are same
-  if (pnmSrc==NULL || pnmDst==NULL || pnmSrc==pnmDst) {
+  if (penSrc==NULL || penDst==NULL || penSrc==penDst) {
     // fail
     penMarker = NULL;
     vPath = vSrc;
@@ -246,48 +489,52 @@ void PATH_FindFirstMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &
 
   // go to the source marker position
   vPath = vSrcPath;
-  penMarker = pnmSrc;
+  penMarker = penSrc;
 }
 
 // find next marker for path navigation
 void PATH_FindNextMarker(CEntity *penThis, const FLOAT3D &vSrc, const FLOAT3D &vDst, CEntity *&penMarker, FLOAT3D &vPath)
 {
+  ValidateGraph(penThis);
+
   // find closest marker to destination position
-  CNavigationMarker *pnmDst;
+  CEntity *penDst;
   FLOAT3D vDstPath;
-  FindClosestMarker(penThis, vDst, (CEntity*&)pnmDst, vDstPath);
+  FindClosestMarker(penThis, vDst, penDst, vDstPath);
 
   // if at not found, or if same as current
-  if (pnmDst==NULL || penMarker==pnmDst) {
+  const INDEX iSrc = GetNode(penMarker);
+  if (penDst==NULL || penMarker==penDst || iSrc<0) {
     // fail
     penMarker = NULL;
     vPath = vSrc;
     return;
   }
-
-  // try to find shortest path to the destination
-  BOOL bFound = FindPath((CNavigationMarker*)penMarker, pnmDst);
+  const INDEX iDst = GetNode(penDst);
+
+  // try to find shortest path to the destination, if not found recently
+  INDEX iNext = -1;
+  if (!FindCachedPath(iSrc, iDst, iNext)) {
+    BOOL bFound = FindPath(iSrc, iDst);
+    CachePath(iSrc, iDst, bFound);
+    if (bFound) {
+      // find the first marker after current
+      iNext = iDst;
+      while (_aiParent[iNext]>=0 && _aiParent[iNext]!=iSrc) {
+        iNext = _aiParent[iNext];
+      }
+    }
+  }
 
   // if not found
-  if (!bFound) {
-    // just clean up and fail
-    delete pnmDst->GetPathNode();
-    ClearPath(penThis);
+  if (iNext<0) {
+    // fail
     penMarker = NULL;
     vPath = vSrc;
     return;
   }
 
-  // find the first marker position after current
-  CPathNode *ppn = pnmDst->GetPathNode();
-  while (ppn->pn_ppnParent!=NULL && ppn->pn_ppnParent->pn_pnmMarker!=penMarker) {
-    ppn = ppn->pn_ppnParent;
-  }
-  penMarker = ppn->pn_pnmMarker;
-
   // go there
-  vPath = penMarker->GetPlacement().pl_PositionVector;
-
-  // clean up
-  ClearPath(penThis);
+  penMarker = _apnmNodes[iNext];
+  vPath = FLOAT3D(_afNodeX[iNext], _afNodeY[iNext], _afNodeZ[iNext]);
 }
@@ -19,29 +19,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
   #pragma once
 #endif
 
-// temporary structure used for path finding
-class DECL_DLL CPathNode {
-public:
-  // cunstruction/destruction
-  CPathNode(class CNavigationMarker *penMarker);
-  ~CPathNode(void);
-
-  // get name of this node
-  const CTString &GetName(void);
-
-  // get link with given index or null if no more (for iteration along the graph)
-  CPathNode *GetLink(INDEX i);
-
-  class CNavigationMarker *pn_pnmMarker; // the marker itself
-
-  CListNode pn_lnInOpen;  // for linking in open/closed lists
-  CListNode pn_lnInClosed;
-
-  CPathNode *pn_ppnParent;  // best found parent in path yet
-  FLOAT pn_fG;  // total cost to get here through the best parent
-  FLOAT pn_fH;  // estimate of distance to the goal
-  FLOAT pn_fF;  // total quality of the path going through this node
-};
+// mark navigation graph as outdated (when markers are created or destroyed)
+DECL_DLL void PATH_InvalidateGraph(void);
 
 // find first marker for path navigation
 DECL_DLL void PATH_FindFirstMarker(
@@ -16,6 +16,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 310
 %{
 #include "EntitiesMP/StdH/StdH.h"
+#include "EntitiesMP/Bouncer.h"
+#include "EntitiesMP/DestroyableArchitecture.h"
+#include "EntitiesMP/ExotechLarva.h"
+#include "EntitiesMP/Player.h"
 #include "EntitiesMP/Common/PathFinding.h"
 #include "EntitiesMP/NavigationMarker.h"
 #include "EntitiesMP/TacticsHolder.h"
@@ -355,7 +359,7 @@ functions:
 
   BOOL IfTargetCrushed(CEntity *penOther, const FLOAT3D &vDirection)
   {
-    if( IsOfClass(penOther, "ModelHolder2"))
+    if( IsOfClass(penOther, CModelHolder2_ClassID))
     {
       FLOAT fCrushHealth = GetCrushHealth();
       if( fCrushHealth>((CRationalEntity &)*penOther).GetHealth())
@@ -968,7 +972,7 @@ functions:
   {
     return 
       penPlayer!=NULL && 
-      IsDerivedFromClass(penPlayer, "Player") &&
+      IsDerivedFromClass(penPlayer, CPlayer_ClassID) &&
       penPlayer->GetFlags()&ENF_ALIVE;
   }
   
@@ -1352,7 +1356,7 @@ functions:
   
     // return if there is no tactics manager or if it points to wrong type of entity
     // or if there is no enemy
-    if (m_penTacticsHolder==NULL || !IsOfClass(m_penTacticsHolder, "TacticsHolder")
+    if (m_penTacticsHolder==NULL || !IsOfClass(m_penTacticsHolder, CTacticsHolder_ClassID)
         || m_penEnemy==NULL) {
       return;
     }
@@ -1418,7 +1422,7 @@ functions:
     
     // return if there is no tactics manager or if it points to wrong type of entity
     // or if there is no enemy
-    if (m_penTacticsHolder==NULL || !IsOfClass(m_penTacticsHolder, "TacticsHolder")
+    if (m_penTacticsHolder==NULL || !IsOfClass(m_penTacticsHolder, CTacticsHolder_ClassID)
         || m_penEnemy==NULL) {
       return;
     }
@@ -1730,7 +1734,7 @@ functions:
   virtual BOOL ShouldBlowUp(void) 
   {
     // exotech larva boss allways blows up
-    if (IsOfClass(this, "ExotechLarva")) { return TRUE; }
+    if (IsOfClass(this, CExotechLarva_ClassID)) { return TRUE; }
     
     // blow up if
     return
@@ -1977,9 +1981,9 @@ functions:
       if( GetCrushHealth() != 0.0f)
       {
         ETouch eTouch = ((ETouch &) ee);
-        if (IsOfClass(eTouch.penOther, "ModelHolder2") ||
+        if (IsOfClass(eTouch.penOther, CModelHolder2_ClassID) ||
             IsOfClass(eTouch.penOther, "MovingBrush") ||
-            IsOfClass(eTouch.penOther, "DestroyableArchitecture") )
+            IsOfClass(eTouch.penOther, CDestroyableArchitecture_ClassID) )
         {
           InflictDirectDamage(eTouch.penOther, this, DMT_EXPLOSION, GetCrushHealth(),
             eTouch.penOther->GetPlacement().pl_PositionVector, -(FLOAT3D&)eTouch.plCollision);
@@ -2108,7 +2112,7 @@ procedures:
   MoveToRandomPatrolPosition(EVoid) 
   {
     // if the marker is invalid
-    if (!IsOfClass(m_penMarker, "Enemy Marker")) {
+    if (!IsOfClass(m_penMarker, CEnemyMarker_ClassID)) {
       // this should not happen
       ASSERT(FALSE);
       // return to caller
@@ -2228,7 +2232,7 @@ procedures:
     GetWatcher()->SendEvent(EStart());
   
     // while there is a valid marker, take values from it
-    while (m_penMarker!=NULL && IsOfClass(m_penMarker, "Enemy Marker")) {
+    while (m_penMarker!=NULL && IsOfClass(m_penMarker, CEnemyMarker_ClassID)) {
       CEnemyMarker *pem = (CEnemyMarker *)&*m_penMarker;
 
       // the marker position is our new start position for attack range
@@ -2767,11 +2771,11 @@ procedures:
 
     // find the one who killed, or other best suitable player
     CEntityPointer penKiller = eDeath.eLastDamage.penInflictor;
-    if (penKiller==NULL || !IsOfClass(penKiller, "Player")) {
+    if (penKiller==NULL || !IsOfClass(penKiller, CPlayer_ClassID)) {
       penKiller = m_penEnemy;
     }
 
-    if (penKiller==NULL || !IsOfClass(penKiller, "Player")) {
+    if (penKiller==NULL || !IsOfClass(penKiller, CPlayer_ClassID)) {
       penKiller = FixupCausedToPlayer(this, penKiller, /*bWarning=*/FALSE);
     }
 
@@ -3148,7 +3152,7 @@ procedures:
     // setup some model parameters that are global for all enemies
     SizeModel();
     // check that max health is properly set
-    ASSERT(m_fMaxHealth==GetHealth() || IsOfClass(this, "Devil") || IsOfClass(this, "ExotechLarva") || IsOfClass(this, "AirElemental") || IsOfClass(this, "Summoner"));
+    ASSERT(m_fMaxHealth==GetHealth() || IsOfClass(this, CDevil_ClassID) || IsOfClass(this, CExotechLarva_ClassID) || IsOfClass(this, CAirElemental_ClassID) || IsOfClass(this, CSummoner_ClassID));
 
     // normalize parameters
     if (m_tmReflexMin<0) {
@@ -3185,7 +3189,7 @@ procedures:
     GetWatcher()->Initialize(eInitWatcher);
 
     // switch to next marker (enemies usually point to the marker they stand on)
-    if (m_penMarker!=NULL && IsOfClass(m_penMarker, "Enemy Marker")) {
+    if (m_penMarker!=NULL && IsOfClass(m_penMarker, CEnemyMarker_ClassID)) {
       CEnemyMarker *pem = (CEnemyMarker *)&*m_penMarker;
       m_penMarker = pem->m_penTarget;
     }
@@ -3259,7 +3263,7 @@ procedures:
       // support for jumping using bouncers
       on (ETouch eTouch) : {
         IfTargetCrushed(eTouch.penOther, (FLOAT3D&)eTouch.plCollision);
-        if (IsOfClass(eTouch.penOther, "Bouncer")) {
+        if (IsOfClass(eTouch.penOther, CBouncer_ClassID)) {
           JumpFromBouncer(this, eTouch.penOther);
         }
         resume;
@@ -50,7 +50,7 @@ properties:
   105 CEntityPointer m_penTarget5  "Target 5"     COLOR(C_dBLUE|0xFF),
 
   {
-    CPathNode *m_ppnNode;  // for pathfinding algorithm
+    INDEX m_iPathNode;  // index in navigation graph
   }
 
 components:
@@ -60,18 +60,19 @@ components:
 functions:
   void CNavigationMarker(void)
   {
-    m_ppnNode = NULL;
+    m_iPathNode = -1;
+    PATH_InvalidateGraph();
   }
   void ~CNavigationMarker(void)
   {
-    ASSERT(m_ppnNode == NULL);
+    PATH_InvalidateGraph();
   }
 
   /* Read from stream. */
   void Read_t( CTStream *istr) // throw char *
   {
     CEntity::Read_t(istr);
-    m_ppnNode = NULL;
+    m_iPathNode = -1;
   }
   
   CEntity *GetTarget(void) const { return m_penTarget0; };
@@ -81,16 +82,6 @@ functions:
     return &eiMarker;
   };
 
-  // get node used for pathfinding algorithm
-  CPathNode *GetPathNode(void)
-  {
-    if (m_ppnNode==NULL) {
-      m_ppnNode = new CPathNode(this);
-    }
-
-    return m_ppnNode;
-  }
-
   CEntityPointer &TargetPointer(INDEX i)
   {
     ASSERT(i>=0 && i<MAX_TARGETS);
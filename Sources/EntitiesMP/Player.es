@@ -17,6 +17,8 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 %{
 
 #include "EntitiesMP/StdH/StdH.h"
+#include "EntitiesMP/Bouncer.h"
+#include "EntitiesMP/Devil.h"
 #include "GameMP/SEColors.h"
 
 #include <Engine/Build.h>
@@ -227,7 +229,7 @@ static void KillAllEnemies(CEntity *penKiller)
   // for each entity in the world
   {FOREACHINDYNAMICCONTAINER(penKiller->GetWorld()->wo_cenEntities, CEntity, iten) {
     CEntity *pen = iten;
-    if (IsDerivedFromClass(pen, "Enemy Base") && !IsOfClass(pen, "Devil")) {
+    if (IsDerivedFromClass(pen, CEnemyBase_ClassID) && !IsOfClass(pen, CDevil_ClassID)) {
       CEnemyBase *penEnemy = (CEnemyBase *)pen;
       if (penEnemy->m_penEnemy==NULL) {
         continue;
@@ -935,7 +937,7 @@ void PrintPlayerDeathMessage(CPlayer *ppl, const EDeath &eDeath)
   // if killed by a valid entity
   if (penKiller!=NULL) {
     // if killed by a player
-    if (IsOfClass(penKiller, "Player")) {
+    if (IsOfClass(penKiller, CPlayer_ClassID)) {
       // if not self
       if (penKiller!=ppl) {
         CTString strKillerName = ((CPlayer*)penKiller)->GetPlayerName();
@@ -972,7 +974,7 @@ void PrintPlayerDeathMessage(CPlayer *ppl, const EDeath &eDeath)
         }
       }
     // if killed by an enemy
-    } else if (IsDerivedFromClass(penKiller, "Enemy Base")) {
+    } else if (IsDerivedFromClass(penKiller, CEnemyBase_ClassID)) {
       // check for telefrag first
       if(eDeath.eLastDamage.dmtType==DMT_TELEPORT) {
         CPrintF(TRANSV("%s was telefragged\n"), (const char *) strMyName);
@@ -3089,7 +3091,7 @@ functions:
 
     // check for friendly fire
     if (!GetSP()->sp_bFriendlyFire && GetSP()->sp_bCooperative) {
-      if (IsOfClass(penInflictor, "Player") && penInflictor!=this) {
+      if (IsOfClass(penInflictor, CPlayer_ClassID) && penInflictor!=this) {
         return;
       }
     }
@@ -3502,14 +3504,14 @@ functions:
     // if hit
     if (pen!=NULL) {
       // check switch/messageholder relaying by moving brush
-      if (IsOfClass( pen, "Moving Brush")) {
+      if (IsOfClass( pen, CMovingBrush_ClassID)) {
         if (((CMovingBrush&)*pen).m_penSwitch!=NULL) {
           pen = ((CMovingBrush&)*pen).m_penSwitch;
         }
       }
 
       // if switch and near enough
-      if (IsOfClass( pen, "Switch") && penWeapons->m_fRayHitDistance < 2.0f) {
+      if (IsOfClass( pen, CSwitch_ClassID) && penWeapons->m_fRayHitDistance < 2.0f) {
         CSwitch &enSwitch = (CSwitch&)*pen;
         // if switch is useable
         if (enSwitch.m_bUseable) {
@@ -3520,7 +3522,7 @@ functions:
       }
 
       // if analyzable
-      if (IsOfClass( pen, "MessageHolder") 
+      if (IsOfClass( pen, CMessageHolder_ClassID) 
         && penWeapons->m_fRayHitDistance<((CMessageHolder*)&*pen)->m_fDistance
         && ((CMessageHolder*)&*pen)->m_bActive) {
         const CTFileName &fnmMessage = ((CMessageHolder*)&*pen)->m_fnmMessage;
@@ -5264,7 +5266,7 @@ functions:
       // start with first message linked to the marker
       CMessageHolder *penMessage = (CMessageHolder *)&*CpmStart.m_penMessage;
       // while there are some messages to add
-      while (penMessage!=NULL && IsOfClass(penMessage, "MessageHolder")) {
+      while (penMessage!=NULL && IsOfClass(penMessage, CMessageHolder_ClassID)) {
         const CTFileName &fnmMessage = penMessage->m_fnmMessage;
         // if player doesn't have that message in database
         if (!HasMessage(fnmMessage)) {
@@ -5501,7 +5503,7 @@ functions:
     }
     // if killed by a player or enemy
     CEntity *penKiller = eDeath.eLastDamage.penInflictor;
-    if (IsOfClass(penKiller, "Player") || IsDerivedFromClass(penKiller, "Enemy Base")) {
+    if (IsOfClass(penKiller, CPlayer_ClassID) || IsDerivedFromClass(penKiller, CEnemyBase_ClassID)) {
       // mark for respawning in place
       m_ulFlags |= PLF_RESPAWNINPLACE;
       m_vDied = GetPlacement().pl_PositionVector;
@@ -5635,7 +5637,7 @@ procedures:
       // if killed by some entity
       if (penKiller!=NULL) {
         // if killed by player
-        if (IsOfClass(penKiller, "Player")) {
+        if (IsOfClass(penKiller, CPlayer_ClassID)) {
           // if someone other then you
           if (penKiller!=this) {
             pplKillerPlayer = (CPlayer*)penKiller;
@@ -6047,7 +6049,7 @@ procedures:
 
     // item appears
     CPlayerActionMarker *ppam = GetActionMarker();
-    if (IsOfClass(ppam->m_penItem, "KeyItem")) {
+    if (IsOfClass(ppam->m_penItem, CKeyItem_ClassID)) {
       CModelObject &moItem = ppam->m_penItem->GetModelObject()->GetAttachmentModel(0)->amo_moModelObject;
       GetPlayerAnimator()->SetItem(&moItem);
     }
@@ -6098,7 +6100,7 @@ procedures:
 
     // item appears
     CPlayerActionMarker *ppam = GetActionMarker();
-    if (IsOfClass(ppam->m_penItem, "KeyItem")) {
+    if (IsOfClass(ppam->m_penItem, CKeyItem_ClassID)) {
       CModelObject &moItem = ppam->m_penItem->GetModelObject()->GetAttachmentModel(0)->amo_moModelObject;
       GetPlayerAnimator()->SetItem(&moItem);
       EPass ePass;
@@ -6349,7 +6351,7 @@ procedures:
     plan.m_bDisableAnimating = TRUE;
 
     // while there is some marker
-    while (m_penActionMarker!=NULL && IsOfClass(m_penActionMarker, "PlayerActionMarker")) {
+    while (m_penActionMarker!=NULL && IsOfClass(m_penActionMarker, CPlayerActionMarker_ClassID)) {
 
       // if should wait
       if (GetActionMarker()->m_paaAction==PAA_WAIT) {
@@ -6743,7 +6745,7 @@ procedures:
       }
       // support for jumping using bouncers
       on (ETouch eTouch) : {
-        if (IsOfClass(eTouch.penOther, "Bouncer")) {
+        if (IsOfClass(eTouch.penOther, CBouncer_ClassID)) {
           JumpFromBouncer(this, eTouch.penOther);
           // play jump sound
           SetDefaultMouthPitch();
@@ -16,6 +16,15 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 402
 %{
 #include "EntitiesMP/StdH/StdH.h"
+#include "EntitiesMP/AirElemental.h"
+#include "EntitiesMP/Beast.h"
+#include "EntitiesMP/Boneman.h"
+#include "EntitiesMP/CannonRotating.h"
+#include "EntitiesMP/CannonStatic.h"
+#include "EntitiesMP/Elemental.h"
+#include "EntitiesMP/Gizmo.h"
+#include "EntitiesMP/Walker.h"
+#include "EntitiesMP/Woman.h"
 #include "GameMP/SEColors.h"
   
 #include <Engine/Build.h>
@@ -1139,7 +1148,7 @@ functions:
     }
 
     // if player
-    if (IsOfClass(penYou, "Player")) {
+    if (IsOfClass(penYou, CPlayer_ClassID)) {
       // if ally player 
       if (GetSP()->sp_bCooperative) {
         // if ally prediction is on and this player is local
@@ -1165,7 +1174,7 @@ functions:
       }
     } else {
       // if enemy prediction is on an it is an enemy
-      if( cli_tmPredictEnemy>0 && IsDerivedFromClass( penYou, "Enemy Base")) {
+      if( cli_tmPredictEnemy>0 && IsDerivedFromClass( penYou, CEnemyBase_ClassID)) {
         // if this player is local
         if (_pNetwork->IsPlayerLocal(penMe)) {
           // set enemy prediction time
@@ -1211,7 +1220,7 @@ functions:
         CheckTargetPrediction(pen);
 
         // if player
-        if( IsOfClass( pen, "Player")) {
+        if( IsOfClass( pen, CPlayer_ClassID)) {
           // rememer when targeting begun  
           if( m_tmTargetingStarted==0) {
             m_penTargeting = pen;
@@ -1234,7 +1243,7 @@ functions:
           m_tmTargetingStarted = 0; 
         }
         // keep enemy health for eventual crosshair coloring
-        if( IsDerivedFromClass( pen, "Enemy Base")) {
+        if( IsDerivedFromClass( pen, CEnemyBase_ClassID)) {
           m_fEnemyHealth = ((CEnemyBase*)pen)->GetHealth() / ((CEnemyBase*)pen)->m_fMaxHealth;
         }
          // cannot snoop while firing
@@ -1247,11 +1256,11 @@ functions:
         m_tmTargetingStarted = 0; 
 
         // check switch relaying by moving brush
-        if( IsOfClass( pen, "Moving Brush") && ((CMovingBrush&)*pen).m_penSwitch!=NULL) {
+        if( IsOfClass( pen, CMovingBrush_ClassID) && ((CMovingBrush&)*pen).m_penSwitch!=NULL) {
           pen = ((CMovingBrush&)*pen).m_penSwitch;
         }
         // if switch and near enough
-        if( IsOfClass( pen, "Switch") && m_fRayHitDistance<2.0f) {
+        if( IsOfClass( pen, CSwitch_ClassID) && m_fRayHitDistance<2.0f) {
           CSwitch &enSwitch = (CSwitch&)*pen;
           // if switch is useable
           if( enSwitch.m_bUseable) {
@@ -1262,7 +1271,7 @@ functions:
           }
         }
         // if analyzable
-        if( IsOfClass( pen, "MessageHolder") 
+        if( IsOfClass( pen, CMessageHolder_ClassID) 
          && m_fRayHitDistance < ((CMessageHolder*)&*pen)->m_fDistance
          && ((CMessageHolder*)&*pen)->m_bActive) {
           const CTFileName &fnmMessage = ((CMessageHolder*)&*pen)->m_fnmMessage;
@@ -1930,7 +1939,7 @@ functions:
             SprayParticlesType sptType=SPT_NONE;
             COLOR colParticles=C_WHITE|CT_OPAQUE;
             FLOAT fPower=4.0f;
-            if( IsOfClass(crRay.cr_penHit, "ModelHolder2"))
+            if( IsOfClass(crRay.cr_penHit, CModelHolder2_ClassID))
             {
               bRender=FALSE;
               CModelDestruction *penDestruction = ((CModelHolder2&)*crRay.cr_penHit).GetDestruction();
@@ -1958,7 +1967,7 @@ functions:
     // if any model hit
     if (penClosest!=NULL) {
       // in deathmatches check for backstab
-      if (!(GetSP()->sp_bCooperative) && IsOfClass(penClosest, "Player")) {
+      if (!(GetSP()->sp_bCooperative) && IsOfClass(penClosest, CPlayer_ClassID)) {
         FLOAT3D vToTarget = penClosest->GetPlacement().pl_PositionVector - m_penPlayer->GetPlacement().pl_PositionVector;
         FLOAT3D vTargetHeading = FLOAT3D(0.0, 0.0, -1.0f)*penClosest->GetRotationMatrix();
         vToTarget.Normalize(); vTargetHeading.Normalize();
@@ -2041,20 +2050,20 @@ functions:
             FLOAT3D vSpillDir=-((CPlayer&)*m_penPlayer).en_vGravityDir*0.5f;
             SprayParticlesType sptType=SPT_BLOOD;
             COLOR colParticles=C_WHITE|CT_OPAQUE;
-            if (!IsDerivedFromClass(crRay.cr_penHit, "Enemy Base")) {
+            if (!IsDerivedFromClass(crRay.cr_penHit, CEnemyBase_ClassID)) {
               sptType=SPT_NONE;
             }
             FLOAT fPower=4.0f;
-            if( IsOfClass(crRay.cr_penHit, "Boneman"))   {sptType=SPT_BONES; fPower=6.0f;}
-            if( IsOfClass(crRay.cr_penHit, "Gizmo") ||
-                IsOfClass(crRay.cr_penHit, "Beast"))     {sptType=SPT_SLIME; fPower=4.0f;}
-            if( IsOfClass(crRay.cr_penHit, "Woman"))     {sptType=SPT_FEATHER; fPower=3.0f;}
-            if( IsOfClass(crRay.cr_penHit, "Elemental")) {sptType=SPT_LAVA_STONES; fPower=3.0f;}
-            if( IsOfClass(crRay.cr_penHit, "Walker"))    {sptType=SPT_ELECTRICITY_SPARKS; fPower=30.0f;}
-            if( IsOfClass(crRay.cr_penHit, "AirElemental"))    {sptType=SPT_AIRSPOUTS; fPower=6.0f;}
-            if( IsOfClass(crRay.cr_penHit, "CannonRotating") ||
-                IsOfClass(crRay.cr_penHit, "CannonStatic"))    {sptType=SPT_WOOD;}
-            if( IsOfClass(crRay.cr_penHit, "ModelHolder2"))
+            if( IsOfClass(crRay.cr_penHit, CBoneman_ClassID))   {sptType=SPT_BONES; fPower=6.0f;}
+            if( IsOfClass(crRay.cr_penHit, CGizmo_ClassID) ||
+                IsOfClass(crRay.cr_penHit, CBeast_ClassID))     {sptType=SPT_SLIME; fPower=4.0f;}
+            if( IsOfClass(crRay.cr_penHit, CWoman_ClassID))     {sptType=SPT_FEATHER; fPower=3.0f;}
+            if( IsOfClass(crRay.cr_penHit, CElemental_ClassID)) {sptType=SPT_LAVA_STONES; fPower=3.0f;}
+            if( IsOfClass(crRay.cr_penHit, CWalker_ClassID))    {sptType=SPT_ELECTRICITY_SPARKS; fPower=30.0f;}
+            if( IsOfClass(crRay.cr_penHit, CAirElemental_ClassID))    {sptType=SPT_AIRSPOUTS; fPower=6.0f;}
+            if( IsOfClass(crRay.cr_penHit, CCannonRotating_ClassID) ||
+                IsOfClass(crRay.cr_penHit, CCannonStatic_ClassID))    {sptType=SPT_WOOD;}
+            if( IsOfClass(crRay.cr_penHit, CModelHolder2_ClassID))
             {
               bRender=FALSE;
               CModelDestruction *penDestruction = ((CModelHolder2&)*crRay.cr_penHit).GetDestruction();
@@ -2535,7 +2544,7 @@ functions:
 
   void CheatOpen(void)
   {
-    if (IsOfClass(m_penRayHit, "Moving Brush")) {
+    if (IsOfClass(m_penRayHit, CMovingBrush_ClassID)) {
       m_penRayHit->SendEvent(ETrigger());
     }
   }
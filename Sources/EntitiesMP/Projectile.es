@@ -16,6 +16,10 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 501
 %{
 #include "EntitiesMP/StdH/StdH.h"
+#include "EntitiesMP/AirElemental.h"
+#include "EntitiesMP/Demon.h"
+#include "EntitiesMP/MovingBrush.h"
+#include "EntitiesMP/Twister.h"
 #include "Models/Weapons/Laser/Projectile/LaserProjectile.h"
 #include "EntitiesMP/EnemyBase.h"
 //#include "EntitiesMP/Dragonman.h"
@@ -843,11 +847,11 @@ functions:
           FLOAT3D vDirLeader=en_vCurrentTranslationAbsolute;
           vDirLeader.Normalize();
           // if last is not flame thrower pipe
-          if(IsOfClass(m_penParticles, "Projectile"))
+          if(IsOfClass(m_penParticles, CProjectile_ClassID))
           {
             CProjectile &prLast=(CProjectile &)*m_penParticles;
             // if pre last is flame thrower pipe
-            if( IsOfClass(prLast.m_penParticles, "Player Weapons"))
+            if( IsOfClass(prLast.m_penParticles, CPlayerWeapons_ClassID))
             {
               CPlayerWeapons &plw=(CPlayerWeapons&)*prLast.m_penParticles;
               if(!(plw.GetPlayer()->GetFlags()&ENF_ALIVE))
@@ -874,7 +878,7 @@ functions:
                                      vDirLeader, vDirFollower, fLeaderLiving, fFollowerLiving, en_ulID, FALSE);
             }
           // draw particles with player weapons
-          } else if (IsOfClass(m_penParticles, "Player Weapons")) {
+          } else if (IsOfClass(m_penParticles, CPlayerWeapons_ClassID)) {
             CPlayerWeapons &plw=(CPlayerWeapons&)*m_penParticles;
             if(!(plw.GetPlayer()->GetFlags()&ENF_ALIVE))
             {
@@ -930,11 +934,11 @@ functions:
         // not NULL or deleted
         if (m_penParticles!=NULL && !(m_penParticles->GetFlags()&ENF_DELETED)) {
           // draw particles with another projectile
-          if (IsOfClass(m_penParticles, "Projectile")) {
+          if (IsOfClass(m_penParticles, CProjectile_ClassID)) {
             fParticlesTimeElapsed = _pTimer->GetLerpedCurrentTick() - ((CProjectile&)*m_penParticles).m_fStartTime;
             Particles_ShooterFlame(GetLerpedPlacement(), m_penParticles->GetLerpedPlacement(),
                                    fTimeElapsed, fParticlesTimeElapsed);
-          } else if (IsOfClass(m_penParticles, "Shooter")) {
+          } else if (IsOfClass(m_penParticles, CShooter_ClassID)) {
             Particles_ShooterFlame(GetLerpedPlacement(),
               ((CShooter&)*m_penParticles).GetPlacement(),
                                    fTimeElapsed, 0.0f);
@@ -1050,7 +1054,7 @@ void PlayerRocketExplosion(void) {
   ese.vStretch = FLOAT3D(1,1,1);
   SpawnEffect(GetPlacement(), ese);
   // spawn sound event in range
-  if( IsDerivedFromClass( m_penLauncher, "Player")) {
+  if( IsDerivedFromClass( m_penLauncher, CPlayer_ClassID)) {
     SpawnRangeSound( m_penLauncher, this, SNDT_PLAYER, m_fSoundRange);
   }
 
@@ -1127,7 +1131,7 @@ void PlayerGrenadeExplosion(void) {
   ese.vStretch = FLOAT3D(1,1,1);
   SpawnEffect(GetPlacement(), ese);
   // spawn sound event in range
-  if( IsDerivedFromClass( m_penLauncher, "Player")) {
+  if( IsDerivedFromClass( m_penLauncher, CPlayer_ClassID)) {
     SpawnRangeSound( m_penLauncher, this, SNDT_PLAYER, m_fSoundRange);
   }
 
@@ -1762,7 +1766,7 @@ void HuanmanProjectile(void) {
  ************************************************************/
 void BeastProjectile(void) {
   // we need target for guied misile
-  if (IsDerivedFromClass(m_penLauncher, "Enemy Base")) {
+  if (IsDerivedFromClass(m_penLauncher, CEnemyBase_ClassID)) {
     m_penTarget = ((CEnemyBase *) &*m_penLauncher)->m_penEnemy;
   }
   // set appearance
@@ -1797,7 +1801,7 @@ void BeastProjectile(void) {
 
 void BeastBigProjectile(void) {
   // we need target for guided misile
-  if (IsDerivedFromClass(m_penLauncher, "Enemy Base")) {
+  if (IsDerivedFromClass(m_penLauncher, CEnemyBase_ClassID)) {
     m_penTarget = ((CEnemyBase *) &*m_penLauncher)->m_penEnemy;
   }
   // set appearance
@@ -2171,7 +2175,7 @@ void DevilRocketExplosion(void) {
   ese.vStretch = FLOAT3D(2,2,2);
   SpawnEffect(GetPlacement(), ese);
   // spawn sound event in range
-  if( IsDerivedFromClass( m_penLauncher, "Player")) {
+  if( IsDerivedFromClass( m_penLauncher, CPlayer_ClassID)) {
     SpawnRangeSound( m_penLauncher, this, SNDT_PLAYER, m_fSoundRange);
   }
 
@@ -2199,7 +2203,7 @@ void DevilRocketExplosion(void) {
 
 void DevilGuidedProjectile(void) {
   // we need target for guied misile
-  if (IsDerivedFromClass(m_penLauncher, "Enemy Base")) {
+  if (IsDerivedFromClass(m_penLauncher, CEnemyBase_ClassID)) {
     m_penTarget = ((CEnemyBase *) &*m_penLauncher)->m_penEnemy;
   }
   // set appearance
@@ -2504,7 +2508,7 @@ void GuffyProjectileExplosion(void) {
 
 void DemonFireball(void) {
   // we need target for guided misile
-  if (IsDerivedFromClass(m_penLauncher, "Enemy Base")) {
+  if (IsDerivedFromClass(m_penLauncher, CEnemyBase_ClassID)) {
     m_penTarget = ((CEnemyBase *) &*m_penLauncher)->m_penEnemy;
   }
   // set appearance
@@ -2634,7 +2638,7 @@ void LarvaPlasmaExplosion(void) {
 void LarvaTail(void) {
   
   // we need target for guied misile
-  if (IsDerivedFromClass(m_penLauncher, "Enemy Base")) {
+  if (IsDerivedFromClass(m_penLauncher, CEnemyBase_ClassID)) {
     m_penTarget = ((CEnemyBase *) &*m_penLauncher)->m_penEnemy;
   }
   // set appearance
@@ -2769,7 +2773,7 @@ void MeteorExplosion() {
   ese.vStretch = FLOAT3D(5,5,5);
   SpawnEffect(GetPlacement(), ese);
   // spawn sound event in range
-  if( IsDerivedFromClass( m_penLauncher, "Player")) {
+  if( IsDerivedFromClass( m_penLauncher, CPlayer_ClassID)) {
     SpawnRangeSound( m_penLauncher, this, SNDT_PLAYER, m_fSoundRange);
   }
 
@@ -2984,7 +2988,7 @@ void ProjectileTouch(CEntityPointer penHit)
     // don't spawn flame on AirElemental
     BOOL bSpawnFlame=TRUE;
     BOOL bInflictDamage=TRUE;
-    if (IsOfClass(penHit, "AirElemental"))
+    if (IsOfClass(penHit, CAirElemental_ClassID))
     {
       bSpawnFlame=FALSE;
     }
@@ -3034,7 +3038,7 @@ void ProjectileHit(void)
         GetPlacement().pl_PositionVector, m_fDamageHotSpotRange, m_fDamageFallOffRange);
   }
   // sound event
-  if (m_fSoundRange>0.0f && IsDerivedFromClass( m_penLauncher, "Player"))
+  if (m_fSoundRange>0.0f && IsDerivedFromClass( m_penLauncher, CPlayer_ClassID))
   {
     ESound eSound;
     eSound.EsndtSound = SNDT_EXPLOSION;
@@ -3103,7 +3107,7 @@ void ReceiveDamage(CEntity *penInflictor, enum DamageType dmtType,
   {
     fDamageAmmount*=10001.0f;
   }
-  if (m_prtType==PRT_FLAME && IsOfClass(penInflictor, "Moving Brush"))
+  if (m_prtType==PRT_FLAME && IsOfClass(penInflictor, CMovingBrush_ClassID))
   {
     Destroy();    
   }
@@ -3137,14 +3141,14 @@ procedures:
         // ignore launcher within 1 second
         bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
         // ignore another projectile of same type
-        bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, "Projectile") &&
+        bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, CProjectile_ClassID) &&
                 ((CProjectile*)&*epass.penOther)->m_prtType==m_prtType));
         // ignore twister
-        bHit &= !IsOfClass(epass.penOther, "Twister");
+        bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
         if (bHit) {
           ProjectileTouch(epass.penOther);
           // player flame passes through enemies
-          //if (m_prtType==PRT_FLAME && IsDerivedFromClass((CEntity *)&*(epass.penOther), "Enemy Base")) { resume; }
+          //if (m_prtType==PRT_FLAME && IsDerivedFromClass((CEntity *)&*(epass.penOther), CEnemyBase_ClassID)) { resume; }
           stop;
         }
         resume;
@@ -3154,7 +3158,7 @@ procedures:
         m_fIgnoreTime = 0.0f;
         // ignore another projectile of same type
         BOOL bHit;
-        bHit = !((!m_bCanHitHimself && IsOfClass(etouch.penOther, "Projectile") &&
+        bHit = !((!m_bCanHitHimself && IsOfClass(etouch.penOther, CProjectile_ClassID) &&
                  ((CProjectile*)&*etouch.penOther)->m_prtType==m_prtType));     
         
         if (bHit) {
@@ -3257,10 +3261,10 @@ procedures:
           // ignore launcher within 1 second
           bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
           // ignore another projectile of same type
-          bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, "Projectile") &&
+          bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, CProjectile_ClassID) &&
                   ((CProjectile*)&*epass.penOther)->m_prtType==m_prtType));
           // ignore twister
-          bHit &= !IsOfClass(epass.penOther, "Twister");
+          bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
           if (bHit) {
             ProjectileTouch(epass.penOther);
             return EEnd();
@@ -3367,9 +3371,9 @@ procedures:
           m_fIgnoreTime = 0.0f;
           // ignore itself and the demon
           BOOL bHit;
-          bHit = !((!m_bCanHitHimself && IsOfClass(etouch.penOther, "Projectile") &&
+          bHit = !((!m_bCanHitHimself && IsOfClass(etouch.penOther, CProjectile_ClassID) &&
             ((CProjectile*)&*etouch.penOther)->m_prtType==m_prtType));     
-          bHit &= !IsOfClass(etouch.penOther, "Demon");
+          bHit &= !IsOfClass(etouch.penOther, CDemon_ClassID);
           FLOAT3D vTrans = en_vCurrentTranslationAbsolute;
           bHit &= Abs(vTrans.Normalize() % FLOAT3D(etouch.plCollision)) > 0.35f;
 
@@ -3385,13 +3389,13 @@ procedures:
           // ignore launcher within 1 second
           bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
           // ignore another projectile of same type
-          bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, "Projectile") &&
+          bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, CProjectile_ClassID) &&
                   ((CProjectile*)&*epass.penOther)->m_prtType==m_prtType));
           // ignore twister
-          bHit &= !IsOfClass(epass.penOther, "Twister");
+          bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
           // if demons projectile, ignore all other projectiles
-          bHit &= !(m_prtType==PRT_DEMON_FIREBALL && IsOfClass(epass.penOther, "Projectile"));
-          bHit &= !(m_prtType==PRT_BEAST_BIG_PROJECTILE && IsOfClass(epass.penOther, "Projectile"));
+          bHit &= !(m_prtType==PRT_DEMON_FIREBALL && IsOfClass(epass.penOther, CProjectile_ClassID));
+          bHit &= !(m_prtType==PRT_BEAST_BIG_PROJECTILE && IsOfClass(epass.penOther, CProjectile_ClassID));
 
           if (bHit) {
             ProjectileTouch(epass.penOther);
@@ -3481,10 +3485,10 @@ procedures:
           // ignore launcher within 1 second
           bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
           // ignore another projectile of same type
-          bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, "Projectile") &&
+          bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, CProjectile_ClassID) &&
                   ((CProjectile*)&*epass.penOther)->m_prtType==m_prtType));
           // ignore twister
-          bHit &= !IsOfClass(epass.penOther, "Twister");
+          bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
           if (bHit) {
             ProjectileTouch(epass.penOther);
             return EEnd();
@@ -3526,21 +3530,21 @@ procedures:
         // ignore launcher within 1 second
         bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
         // ignore another projectile of same type
-        bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, "Projectile") &&
+        bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, CProjectile_ClassID) &&
                 ((CProjectile*)&*epass.penOther)->m_prtType==m_prtType));
         // ignore twister
-        bHit &= !IsOfClass(epass.penOther, "Twister");
+        bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
         if (epass.penOther!=m_penLauncher) {
           // bHit = bHit ; // FIXME: DG: what was this supposed to achieve?
         }
         if (bHit) {
           ProjectileTouch(epass.penOther);
           // player flame passes through enemies
-          if (m_prtType==PRT_FLAME && IsDerivedFromClass((CEntity *)&*(epass.penOther), "Enemy Base")) {
+          if (m_prtType==PRT_FLAME && IsDerivedFromClass((CEntity *)&*(epass.penOther), CEnemyBase_ClassID)) {
             resume;
           }
           // wind blast passes through movable entities
-          if (m_prtType==PRT_AIRELEMENTAL_WIND && IsDerivedFromClass((CEntity *)&*(epass.penOther), "MovableEntity")) {
+          if (m_prtType==PRT_AIRELEMENTAL_WIND && IsDerivedFromClass((CEntity *)&*(epass.penOther), CMovableEntity_ClassID)) {
             resume;
           }
           
@@ -3561,7 +3565,7 @@ procedures:
         }
         if (!bHit) { BounceSound(); }
         // ignore another projectile of same type
-        bHit &= !((!m_bCanHitHimself && IsOfClass(etouch.penOther, "Projectile") &&
+        bHit &= !((!m_bCanHitHimself && IsOfClass(etouch.penOther, CProjectile_ClassID) &&
                   ((CProjectile*)&*etouch.penOther)->m_prtType==m_prtType));
         if (bHit) {
           ProjectileTouch(etouch.penOther);
@@ -3606,10 +3610,10 @@ procedures:
         // ignore launcher within 1 second
         bHit = epass.penOther!=m_penLauncher || _pTimer->CurrentTick()>m_fIgnoreTime;
         // ignore another projectile of same type
-        bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, "Projectile") &&
+        bHit &= !((!m_bCanHitHimself && IsOfClass(epass.penOther, CProjectile_ClassID) &&
                 ((CProjectile*)&*epass.penOther)->m_prtType==m_prtType));
         // ignore twister
-        bHit &= !IsOfClass(epass.penOther, "Twister");
+        bHit &= !IsOfClass(epass.penOther, CTwister_ClassID);
         if (bHit) {
           ProjectileTouch(epass.penOther);
           stop;
@@ -3632,7 +3636,7 @@ procedures:
           m_iRebounds--;
         } else {
           // ignore another projectile of same type
-          bHit = !((!m_bCanHitHimself && IsOfClass(etouch.penOther, "Projectile") &&
+          bHit = !((!m_bCanHitHimself && IsOfClass(etouch.penOther, CProjectile_ClassID) &&
                    ((CProjectile*)&*etouch.penOther)->m_prtType==m_prtType));     
         
           if (bHit) {
@@ -16,6 +16,9 @@ with this program; if not, write to the Free Software Foundation, Inc.,
 507
 %{
 #include "EntitiesMP/StdH/StdH.h"
+#include "EntitiesMP/CannonBall.h"
+#include "EntitiesMP/Item.h"
+#include "EntitiesMP/Player.h"
 #include "ModelsMP/Enemies/AirElemental/Twister.h"
 
 #define ECF_TWISTER ( \
@@ -162,12 +165,12 @@ functions:
   void SpinEntity(CEntity *pen) {
     
     // don't spin air elemental and other twisters and any items
-    if (IsOfClass(pen, "AirElemental") || IsOfClass(pen, "Twister")
-        || IsDerivedFromClass(pen, "Item")) {
+    if (IsOfClass(pen, CAirElemental_ClassID) || IsOfClass(pen, CTwister_ClassID)
+        || IsDerivedFromClass(pen, CItem_ClassID)) {
       return;
     }
     // don't spin air elementals wind blast
-    if (IsOfClass(pen, "Projectile")) {
+    if (IsOfClass(pen, CProjectile_ClassID)) {
       if (((CProjectile *)&*pen)->m_prtType==PRT_AIRELEMENTAL_WIND)
       {
         return; 
@@ -180,7 +183,7 @@ functions:
       // if any other spinner affects the target, skip this spinner
       BOOL bNoSpinner = TRUE;
       {FOREACHINLIST( CEntity, en_lnInParent, pen->en_lhChildren, iten) {
-        if (IsOfClass(iten, "Spinner"))
+        if (IsOfClass(iten, CSpinner_ClassID))
         {
           bNoSpinner = FALSE;
           return;      
@@ -194,7 +197,7 @@ functions:
         esi.bImpulse = FALSE;
 
         // spin projectiles a bit longer but not so high
-        if (IsOfClass(pen, "Projectile"))
+        if (IsOfClass(pen, CProjectile_ClassID))
         {
           switch(((CProjectile &)*pen).m_prtType) {
           case PRT_GRENADE:
@@ -215,12 +218,12 @@ functions:
             break;
           }
         // cannon ball - short but powerfull
-        } else if (IsOfClass(pen, "Cannon ball")){
+        } else if (IsOfClass(pen, CCannonBall_ClassID)){
           esi.tmSpinTime = 0.2f;
           esi.vRotationAngle = ANGLE3D(-m_sgnSpinDir*500.0f, 0, 0);
           esi.fUpSpeed = m_fDiffMultiply*3.0f;          
         // don't take it easy with players
-        } else if (IsOfClass(pen, "Player")){
+        } else if (IsOfClass(pen, CPlayer_ClassID)){
           esi.tmSpinTime = 3.0f;
           esi.vRotationAngle = ANGLE3D(-m_sgnSpinDir*220.0f, 0, 0);
           esi.bImpulse = TRUE;
@@ -326,7 +329,7 @@ procedures:
         on (EPass ep) : {
           if (ep.penOther->GetRenderType()&RT_MODEL &&
             ep.penOther->GetPhysicsFlags()&EPF_MOVABLE &&
-            !IsOfClass(ep.penOther, "Twister")) {
+            !IsOfClass(ep.penOther, CTwister_ClassID)) {
             SpinEntity(ep.penOther);
           }
           resume;
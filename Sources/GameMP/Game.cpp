@@ -2732,6 +2732,8 @@ void CGame::GameMainLoop(void)
     _pfSoundProfile.Reset();
     _pfNetworkProfile.Reset();
     _pfPhysicsProfile.Reset();
+    _pfMemoryProfile.Reset();
+    _pfJobProfile.Reset();
   } else if (_bProfiling) {
     _ctProfileRecording--;
     if (_ctProfileRecording<=0) {
@@ -2774,6 +2776,18 @@ void CGame::GameMainLoop(void)
       _strProfile+=strPhysicsReport;
       _pfPhysicsProfile.Reset();
 
+      /* Memory profile */
+      CTString strMemoryReport;
+      _pfMemoryProfile.Report(strMemoryReport);
+      _strProfile+=strMemoryReport;
+      _pfMemoryProfile.Reset();
+
+      /* Job profile */
+      CTString strJobReport;
+      _pfJobProfile.Report(strJobReport);
+      _strProfile+=strJobReport;
+      _pfJobProfile.Reset();
+
       CPrintF( TRANS("Profiling done.\n"));
     }
   }